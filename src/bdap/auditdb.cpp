@@ -308,29 +308,33 @@ static bool CheckNewAuditTxInputs(const CAudit& audit, const CScript& scriptOp,
     return FlushAuditLevelDB();
 }
 
-bool CheckAuditTx(const CTransactionRef& tx, const CScript& scriptOp, const int& op1, const int& op2, const std::vector<std::vector<unsigned char> >& vvchArgs, 
-                                const bool fJustCheck, const int& nHeight, const uint32_t& nBlockTime, const bool bSanityCheck, std::string& errorMessage) 
+bool CheckAuditTx(const CTransactionRef& tx, const CBDAPTxOperation& operation, 
+                                const bool fJustCheck, const int& nHeight, const int& nTipHeight, const uint32_t& nBlockTime, const bool bSanityCheck, std::string& errorMessage) 
 {
+    const CScript& scriptOp = operation.scriptOp;
+    const int& op1 = operation.op1;
+    const int& op2 = operation.op2;
+    const std::vector<std::vector<unsigned char> >& vvchArgs = operation.vvchArgs;
     if (tx->IsCoinBase() && !fJustCheck && !bSanityCheck) {
         LogPrintf("*Trying to add BDAP audit in coinbase transaction, skipping...");
         return true;
     }
 
-    LogPrint("bdap", "%s -- BDAP nHeight=%d, chainActive.Tip()=%d, op1=%s, op2=%s, hash=%s justcheck=%s\n", __func__, nHeight, chainActive.Tip()->nHeight, BDAPFromOp(op1).c_str(), BDAPFromOp(op2).c_str(), tx->GetHash().ToString().c_str(), fJustCheck ? "JUSTCHECK" : "BLOCK");
+    LogPrint("bdap", "%s -- BDAP nHeight=%d, tip=%d, op1=%s, op2=%s, hash=%s justcheck=%s\n", __func__, nHeight, nTipHeight, BDAPFromOp(op1).c_str(), BDAPFromOp(op2).c_str(), tx->GetHash().ToString().c_str(), fJustCheck ? "JUSTCHECK" : "BLOCK");
 
     // unserialize BDAP from txn, check if the audit is valid and does not conflict with a previous audit
     CAudit audit;
-    std::vector<unsigned char> vchData;
-    std::vector<unsigned char> vchHash;
-    int nDataOut;
-    bool bData = GetBDAPData(tx, vchData, vchHash, nDataOut);
-    if(bData && !audit.UnserializeFromTx(tx, nHeight))
+    if(operation.fData && !audit.UnserializeFromData(operation.vchData, operation.vchHash))
     {
         errorMessage = ("UnserializeFromData data in tx failed!");
         LogPrintf("%s -- %s \n", __func__, errorMessage);
         return error(errorMessage.c_str());
     }
-    const std::string strOperationType = GetBDAPOpTypeString(op1, op2);
+    if (operation.fData) {
+        audit.txHash = tx->GetHash();
+        audit.nHeight = nHeight;
+    }
+    const std::string& strOperationType = operation.strOpType;
     CAmount monthlyFee, oneTimeFee, depositFee;
     if (strOperationType == "bdap_new_audit") {
         if (!audit.ValidateValues(errorMessage))
@@ -349,8 +353,8 @@ bool CheckAuditTx(const CTransactionRef& tx, const CScript& scriptOp, const int&
         }
         LogPrint("bdap", "%s -- nCount %d, oneTimeFee %d\n", __func__, nCount, FormatMoney(oneTimeFee));
         // extract amounts from tx.
-        CAmount dataAmount, opAmount;
-        if (!ExtractAmountsFromTx(tx, dataAmount, opAmount)) {
+        CAmount dataAmount = operation.dataAmount, opAmount = operation.opAmount;
+        if (!operation.fAmounts) {
             errorMessage = "Unable to extract BDAP amounts from transaction";
             return false;
         }
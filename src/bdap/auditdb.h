@@ -9,6 +9,7 @@
 #include "dbwrapper.h"
 #include "sync.h"
 
+class CBDAPTxOperation;
 class CCoinsViewCache;
 class UniValue;
 
@@ -33,8 +34,8 @@ bool AuditExists(const std::vector<unsigned char>& vchAudit);
 bool UndoAddAudit(const CAudit& audit);
 bool CheckAuditDB();
 bool FlushAuditLevelDB();
-bool CheckAuditTx(const CTransactionRef& tx, const CScript& scriptOp, const int& op1, const int& op2, const std::vector<std::vector<unsigned char> >& vvchArgs, 
-                                const bool fJustCheck, const int& nHeight, const uint32_t& nBlockTime, const bool bSanityCheck, std::string& errorMessage);
+bool CheckAuditTx(const CTransactionRef& tx, const CBDAPTxOperation& operation, 
+                                const bool fJustCheck, const int& nHeight, const int& nTipHeight, const uint32_t& nBlockTime, const bool bSanityCheck, std::string& errorMessage);
 
 extern CAuditDB *pAuditDB;
 
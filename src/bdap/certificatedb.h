@@ -9,6 +9,7 @@
 #include "dbwrapper.h"
 #include "sync.h"
 
+class CBDAPTxOperation;
 class CCoinsViewCache;
 class UniValue;
 
@@ -36,8 +37,8 @@ bool GetCertificateSerialNumber(const std::string& strSerialNumber, CX509Certifi
 bool UndoAddCertificate(const CX509Certificate& certificate);
 bool CheckCertificateDB();
 bool FlushCertificateLevelDB();
-bool CheckCertificateTx(const CTransactionRef& tx, const CScript& scriptOp, const int& op1, const int& op2, const std::vector<std::vector<unsigned char> >& vvchArgs, 
-                                const bool fJustCheck, const int& nHeight, const uint32_t& nBlockTime, const bool bSanityCheck, std::string& errorMessage);
+bool CheckCertificateTx(const CTransactionRef& tx, const CBDAPTxOperation& operation, 
+                                const bool fJustCheck, const int& nHeight, const int& nTipHeight, const uint32_t& nBlockTime, const bool bSanityCheck, std::string& errorMessage);
 
 extern CCertificateDB *pCertificateDB;
 
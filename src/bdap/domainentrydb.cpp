@@ -439,7 +439,7 @@ static bool CommonDataCheck(const CDomainEntry& entry, const vchCharString& vvch
 }
 
 static bool CheckNewDomainEntryTxInputs(const CDomainEntry& entry, const CScript& scriptOp, const vchCharString& vvchOpParameters, const uint256& txHash,
-                               std::string& errorMessage, bool fJustCheck)
+                               std::string& errorMessage, bool fJustCheck, CBDAPWriteBatch* pWrites)
 {
     if (!CommonDataCheck(entry, vvchOpParameters, errorMessage))
         return error(errorMessage.c_str());
@@ -466,6 +466,14 @@ static bool CheckNewDomainEntryTxInputs(const CDomainEntry& entry, const CScript
         return error(errorMessage.c_str());
     }
     int op = OP_BDAP_NEW;
+    if (pWrites) {
+        pWrites->Add([entry, op]() {
+            if (!pDomainEntryDB->AddDomainEntry(entry, op))
+                return error("CheckNewDomainEntryTxInputs failed! Error adding new account entry request to LevelDB.");
+            return FlushLevelDB();
+        });
+        return true;
+    }
     if (!pDomainEntryDB->AddDomainEntry(entry, op))
     {
         errorMessage = "CheckNewDomainEntryTxInputs failed! Error adding new account entry request to LevelDB.";
@@ -476,7 +484,7 @@ static bool CheckNewDomainEntryTxInputs(const CDomainEntry& entry, const CScript
 }
 
 static bool CheckDeleteDomainEntryTxInputs(const CDomainEntry& entry, const CScript& scriptOp, const vchCharString& vvchOpParameters,
-                                  std::string& errorMessage, bool fJustCheck)
+                                  std::string& errorMessage, bool fJustCheck, CBDAPWriteBatch* pWrites)
 {
     if (vvchOpParameters.size() == 0) {
         errorMessage = "CheckDeleteDomainEntryTxInputs: - Invalid delete operation parameters. This delete operation failed!";
@@ -521,6 +529,17 @@ static bool CheckDeleteDomainEntryTxInputs(const CDomainEntry& entry, const CScr
         }
     }
 
+    if (pWrites) {
+        const CharString vchPrevPubKey = prevDomainEntry.DHTPublicKey;
+        pWrites->Add([vchFullObjectPath, vchPrevPubKey]() {
+            pDomainEntryDB->EraseDomainEntryPubKey(vchPrevPubKey);
+            if (!pDomainEntryDB->EraseDomainEntry(vchFullObjectPath))
+                return error("CheckDeleteDomainEntryTxInputs: - Error deleting account entry in LevelDB; this delete operation failed!");
+            return FlushLevelDB();
+        });
+        return true;
+    }
+
     //Remove PubKey entry also (2 records in LevelDB for each domainentry)
     pDomainEntryDB->EraseDomainEntryPubKey(prevDomainEntry.DHTPublicKey);
 
@@ -534,7 +553,7 @@ static bool CheckDeleteDomainEntryTxInputs(const CDomainEntry& entry, const CScr
 }
 
 static bool CheckUpdateDomainEntryTxInputs(CDomainEntry& entry, const CScript& scriptOp, const vchCharString& vvchOpParameters, const uint256& txHash, const int& nMonths, const uint32_t& nBlockTime,
-                                  std::string& errorMessage, bool fJustCheck)
+                                  std::string& errorMessage, bool fJustCheck, CBDAPWriteBatch* pWrites)
 {
     //if exists, check for owner's signature
     if (!CommonDataCheck(entry, vvchOpParameters, errorMessage))
@@ -586,6 +605,15 @@ static bool CheckUpdateDomainEntryTxInputs(CDomainEntry& entry, const CScript& s
     entry.nExpireTime = AddMonthsToBlockTime(prevDomainEntry.nExpireTime, nMonths);
     LogPrint("bdap", "%s -- prevDomainEntry.nExpireTime = %d, AddMonthsToBlockTime() = %d, nMonths = %d\n", __func__, 
                     prevDomainEntry.nExpireTime, AddMonthsToBlockTime(prevDomainEntry.nExpireTime, nMonths), nMonths);
+    if (pWrites) {
+        const CDomainEntry updatedEntry = entry;
+        pWrites->Add([updatedEntry]() {
+            if (!pDomainEntryDB->UpdateDomainEntry(updatedEntry.vchFullObjectPath(), updatedEntry))
+                return error("CheckUpdateDomainEntryTxInputs: - Error updating entry in LevelDB; this update operation failed!");
+            return FlushLevelDB();
+        });
+        return true;
+    }
     if (!pDomainEntryDB->UpdateDomainEntry(entry.vchFullObjectPath(), entry))
     {
         errorMessage = "CheckUpdateDomainEntryTxInputs: - Error updating entry in LevelDB; this update operation failed!";
@@ -604,26 +632,27 @@ static bool CheckMoveDomainEntryTxInputs(const CDomainEntry& entry, const CScrip
     return false;
 }
 
-bool CheckDomainEntryTx(const CTransactionRef& tx, const CScript& scriptOp, const int& op1, const int& op2, const std::vector<std::vector<unsigned char> >& vvchArgs, 
-                                const bool fJustCheck, const int& nHeight, const uint32_t& nBlockTime, const bool bSanityCheck, std::string& errorMessage) 
+bool CheckDomainEntryTx(const CTransactionRef& tx, const CBDAPTxOperation& operation, 
+                                const bool fJustCheck, const int& nHeight, const int& nTipHeight, const uint32_t& nBlockTime, const bool bSanityCheck, std::string& errorMessage,
+                                CBDAPWriteBatch* pWrites)
 {
+    const CScript& scriptOp = operation.scriptOp;
+    const int& op1 = operation.op1;
+    const int& op2 = operation.op2;
+    const std::vector<std::vector<unsigned char> >& vvchArgs = operation.vvchArgs;
     if (tx->IsCoinBase() && !fJustCheck && !bSanityCheck)
     {
         LogPrintf("*Trying to add BDAP entry in coinbase transaction, skipping...");
         return true;
     }
 
-    LogPrint("bdap", "%s -- BDAP nHeight=%d, chainActive.Tip()=%d, op1=%s, op2=%s, hash=%s justcheck=%s\n", __func__, nHeight, chainActive.Tip()->nHeight, BDAPFromOp(op1).c_str(), BDAPFromOp(op2).c_str(), tx->GetHash().ToString().c_str(), fJustCheck ? "JUSTCHECK" : "BLOCK");
+    LogPrint("bdap", "%s -- BDAP nHeight=%d, tip=%d, op1=%s, op2=%s, hash=%s justcheck=%s\n", __func__, nHeight, nTipHeight, BDAPFromOp(op1).c_str(), BDAPFromOp(op2).c_str(), tx->GetHash().ToString().c_str(), fJustCheck ? "JUSTCHECK" : "BLOCK");
 
     // unserialize BDAP from txn, check if the entry is valid and does not conflict with a previous entry
     CDomainEntry entry;
-    std::vector<unsigned char> vchData;
-    std::vector<unsigned char> vchHash;
-    int nDataOut;
-    const std::string strOperationType = GetBDAPOpTypeString(op1, op2);
+    const std::string& strOperationType = operation.strOpType;
     if (strOperationType != "bdap_delete_account") {
-        bool bData = GetBDAPData(tx, vchData, vchHash, nDataOut);
-        if(bData && !entry.UnserializeFromData(vchData, vchHash))
+        if(operation.fData && !entry.UnserializeFromData(operation.vchData, operation.vchHash))
         {
             errorMessage = "BDAP_CONSENSUS_ERROR: ERRCODE: 3601 - " + _("UnserializeFromData data in tx failed!");
             LogPrintf("%s -- %s \n", __func__, errorMessage);
@@ -664,8 +693,8 @@ bool CheckDomainEntryTx(const CTransactionRef& tx, const CScript& scriptOp, cons
         LogPrint("bdap", "%s -- nMonths %d, monthlyFee %d, oneTimeFee %d, depositFee %d\n", __func__, 
                                 nMonths, FormatMoney(monthlyFee), FormatMoney(oneTimeFee), FormatMoney(depositFee));
         // extract amounts from tx.
-        CAmount dataAmount, opAmount;
-        if (!ExtractAmountsFromTx(tx, dataAmount, opAmount)) {
+        CAmount dataAmount = operation.dataAmount, opAmount = operation.opAmount;
+        if (!operation.fAmounts) {
             errorMessage = "Unable to extract BDAP amounts from transaction";
             return false;
         }
@@ -692,7 +721,7 @@ bool CheckDomainEntryTx(const CTransactionRef& tx, const CScript& scriptOp, cons
         }
         entry.nExpireTime = AddMonthsToBlockTime(nBlockTime, nMonths);
 
-        return CheckNewDomainEntryTxInputs(entry, scriptOp, vvchArgs, tx->GetHash(), errorMessage, fJustCheck);
+        return CheckNewDomainEntryTxInputs(entry, scriptOp, vvchArgs, tx->GetHash(), errorMessage, fJustCheck, pWrites);
     }
     else if (strOperationType == "bdap_delete_account") {
         uint16_t nMonths = 0;
@@ -701,7 +730,7 @@ bool CheckDomainEntryTx(const CTransactionRef& tx, const CScript& scriptOp, cons
             return false;
         }
 
-        return CheckDeleteDomainEntryTxInputs(entry, scriptOp, vvchArgs, errorMessage, fJustCheck);
+        return CheckDeleteDomainEntryTxInputs(entry, scriptOp, vvchArgs, errorMessage, fJustCheck, pWrites);
     }
     else if (strOperationType == "bdap_update_account") {
         if (vvchArgs.size() != 3) {
@@ -726,8 +755,8 @@ bool CheckDomainEntryTx(const CTransactionRef& tx, const CScript& scriptOp, cons
         LogPrint("bdap", "%s -- nMonths %d, monthlyFee %d, oneTimeFee %d, depositFee %d\n", __func__, 
                                 nMonths, FormatMoney(monthlyFee), FormatMoney(oneTimeFee), FormatMoney(depositFee));
         // extract amounts from tx.
-        CAmount dataAmount, opAmount;
-        if (!ExtractAmountsFromTx(tx, dataAmount, opAmount)) {
+        CAmount dataAmount = operation.dataAmount, opAmount = operation.opAmount;
+        if (!operation.fAmounts) {
             errorMessage = "Unable to extract BDAP amounts from transaction";
             return false;
         }
@@ -751,7 +780,7 @@ bool CheckDomainEntryTx(const CTransactionRef& tx, const CScript& scriptOp, cons
                                 FormatMoney(dataAmount), FormatMoney(monthlyFee));
         }
         // Add previous expire date plus additional months
-        return CheckUpdateDomainEntryTxInputs(entry, scriptOp, vvchArgs, tx->GetHash(), nMonths, nBlockTime, errorMessage, fJustCheck);
+        return CheckUpdateDomainEntryTxInputs(entry, scriptOp, vvchArgs, tx->GetHash(), nMonths, nBlockTime, errorMessage, fJustCheck, pWrites);
     }
     else if (strOperationType == "bdap_move_account") {
         uint16_t nMonths = 0;
@@ -9,6 +9,8 @@
 #include "dbwrapper.h"
 #include "sync.h"
 
+class CBDAPTxOperation;
+class CBDAPWriteBatch;
 class CCoinsViewCache;
 
 static CCriticalSection cs_bdap_entry;
@@ -50,8 +52,9 @@ bool UndoDeleteDomainEntry(const CDomainEntry& entry);
 bool CheckDomainEntryDB();
 bool FlushLevelDB();
 void CleanupLevelDB(int& nRemoved);
-bool CheckDomainEntryTx(const CTransactionRef& tx, const CScript& scriptOp, const int& op1, const int& op2, const std::vector<std::vector<unsigned char> >& vvchArgs, 
-                                const bool fJustCheck, const int& nHeight, const uint32_t& nBlockTime, const bool bSanityCheck, std::string& errorMessage);
+bool CheckDomainEntryTx(const CTransactionRef& tx, const CBDAPTxOperation& operation, 
+                                const bool fJustCheck, const int& nHeight, const int& nTipHeight, const uint32_t& nBlockTime, const bool bSanityCheck, std::string& errorMessage,
+                                CBDAPWriteBatch* pWrites = NULL);
 
 extern CDomainEntryDB *pDomainEntryDB;
 
@@ -126,7 +126,7 @@ static bool CommonLinkParameterCheck(const vchCharString& vvchOpParameters, std:
     return true;
 }
 
-static bool CheckNewLinkTx(const CScript& scriptData, const vchCharString& vvchOpParameters, const uint256& txid, std::string& errorMessage, bool fJustCheck)
+static bool CheckNewLinkTx(const CScript& scriptData, const vchCharString& vvchOpParameters, const uint256& txid, std::string& errorMessage, bool fJustCheck, CBDAPWriteBatch* pWrites)
 {
     if (!CommonLinkParameterCheck(vvchOpParameters, errorMessage))
         return error(errorMessage.c_str());
@@ -150,6 +150,16 @@ static bool CheckNewLinkTx(const CScript& scriptData, const vchCharString& vvchO
         errorMessage = "CheckNewLinkTx failed! Can not open LevelDB BDAP link database.";
         return error(errorMessage.c_str());
     }
+    if (pWrites) {
+        pWrites->Add([vvchOpParameters, txid]() {
+            if (!pLinkDB->AddLinkIndex(vvchOpParameters, txid))
+                return error("CheckNewLinkTx failed! Error adding link index to LevelDB.");
+            if (!FlushLinkDB())
+                return error("CheckNewLinkTx failed! Error flushing link LevelDB.");
+            return true;
+        });
+        return true;
+    }
     if (!pLinkDB->AddLinkIndex(vvchOpParameters, txid))
     {
         errorMessage = "CheckNewLinkTx failed! Error adding link index to LevelDB.";
@@ -163,28 +173,33 @@ static bool CheckNewLinkTx(const CScript& scriptData, const vchCharString& vvchO
     return true;
 }
 
-bool CheckLinkTx(const CTransactionRef& tx, const int& op1, const int& op2, const std::vector<std::vector<unsigned char> >& vvchArgs, 
-                                const bool fJustCheck, const int& nHeight, const uint32_t& nBlockTime, const bool bSanityCheck, std::string& errorMessage) 
+bool CheckLinkTx(const CTransactionRef& tx, const CBDAPTxOperation& operation, 
+                                const bool fJustCheck, const int& nHeight, const int& nTipHeight, const uint32_t& nBlockTime, const bool bSanityCheck, std::string& errorMessage,
+                                CBDAPWriteBatch* pWrites)
 {
+    const int& op1 = operation.op1;
+    const int& op2 = operation.op2;
+    const std::vector<std::vector<unsigned char> >& vvchArgs = operation.vvchArgs;
     if (tx->IsCoinBase() && !fJustCheck && !bSanityCheck) {
         LogPrintf("%s -- Trying to add BDAP link in coinbase transaction, skipping...\n", __func__);
         return true;
     }
 
-    LogPrint("bdap", "%s -- *** BDAP link nHeight=%d, chainActive.Tip()=%d, op1=%s, op2=%s, hash=%s justcheck=%s\n", __func__, nHeight, chainActive.Tip()->nHeight, BDAPFromOp(op1).c_str(), BDAPFromOp(op2).c_str(), tx->GetHash().ToString().c_str(), fJustCheck ? "JUSTCHECK" : "BLOCK");
+    LogPrint("bdap", "%s -- *** BDAP link nHeight=%d, tip=%d, op1=%s, op2=%s, hash=%s justcheck=%s\n", __func__, nHeight, nTipHeight, BDAPFromOp(op1).c_str(), BDAPFromOp(op2).c_str(), tx->GetHash().ToString().c_str(), fJustCheck ? "JUSTCHECK" : "BLOCK");
 
-    CScript scriptData;
-    if (!GetBDAPDataScript(tx, scriptData))
+    if (!operation.fDataScript)
         return false;
 
+    const CScript& scriptData = operation.scriptData;
+
     // extract amounts from tx.
-    CAmount dataAmount, opAmount;
-    if (!ExtractAmountsFromTx(tx, dataAmount, opAmount)) {
+    CAmount dataAmount = operation.dataAmount, opAmount = operation.opAmount;
+    if (!operation.fAmounts) {
         errorMessage = "Unable to extract BDAP amounts from transaction";
         return false;
     }
 
-    const std::string strOperationType = GetBDAPOpTypeString(op1, op2);
+    const std::string& strOperationType = operation.strOpType;
 
     CAmount monthlyFee, oneTimeFee, depositFee;
     if (strOperationType == "bdap_new_link_request") {
@@ -212,7 +227,7 @@ bool CheckLinkTx(const CTransactionRef& tx, const int& op1, const int& op2, cons
             LogPrint("bdap", "%s -- Valid BDAP deposit fee amount for new BDAP request link. Deposit paid %d, should be %d\n", __func__, 
                                     FormatMoney(opAmount), FormatMoney(depositFee));
         }
-        return CheckNewLinkTx(scriptData, vvchArgs, tx->GetHash(), errorMessage, fJustCheck);
+        return CheckNewLinkTx(scriptData, vvchArgs, tx->GetHash(), errorMessage, fJustCheck, pWrites);
     }
     else if (strOperationType == "bdap_new_link_accept") {
         uint16_t nMonths = 0;
@@ -238,7 +253,7 @@ bool CheckLinkTx(const CTransactionRef& tx, const int& op1, const int& op2, cons
             LogPrint("bdap", "%s -- Valid BDAP deposit fee amount for new BDAP accept link. Deposit paid %d, should be %d\n", __func__, 
                                     FormatMoney(opAmount), FormatMoney(depositFee));
         }
-        return CheckNewLinkTx(scriptData, vvchArgs, tx->GetHash(), errorMessage, fJustCheck);
+        return CheckNewLinkTx(scriptData, vvchArgs, tx->GetHash(), errorMessage, fJustCheck, pWrites);
     }
 
     return false;
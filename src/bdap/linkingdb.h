@@ -9,6 +9,8 @@
 #include "dbwrapper.h"
 #include "sync.h"
 
+class CBDAPTxOperation;
+class CBDAPWriteBatch;
 class uint256;
 
 static CCriticalSection cs_link;
@@ -29,8 +31,9 @@ bool UndoLinkData(const std::vector<unsigned char>& vchPubKey, const std::vector
 bool GetLinkIndex(const std::vector<unsigned char>& vchPubKey, uint256& txid);
 bool CheckLinkDB();
 bool FlushLinkDB();
-bool CheckLinkTx(const CTransactionRef& tx, const int& op1, const int& op2, const std::vector<std::vector<unsigned char> >& vvchArgs, 
-                                const bool fJustCheck, const int& nHeight, const uint32_t& nBlockTime, const bool bSanityCheck, std::string& errorMessage);
+bool CheckLinkTx(const CTransactionRef& tx, const CBDAPTxOperation& operation, 
+                                const bool fJustCheck, const int& nHeight, const int& nTipHeight, const uint32_t& nBlockTime, const bool bSanityCheck, std::string& errorMessage,
+                                CBDAPWriteBatch* pWrites = NULL);
 
 bool CheckPreviousLinkInputs(const std::string& strOpType, const CScript& scriptOp, const std::vector<std::vector<unsigned char>>& vvchOpParameters, std::string& errorMessage, bool fJustCheck);
 
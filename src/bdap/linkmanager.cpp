@@ -176,6 +176,7 @@ bool CLinkManager::GetLinkPrivateKey(const std::vector<unsigned char>& vchSender
 
 bool CLinkManager::FindLink(const uint256& id, CLink& link)
 {
+    LOCK(cs);
     if (m_Links.count(id) > 0) {
         link = m_Links.at(id);
         return true;
@@ -185,6 +186,7 @@ bool CLinkManager::FindLink(const uint256& id, CLink& link)
 
 bool CLinkManager::FindLinkBySubjectID(const uint256& subjectID, CLink& getLink)
 {
+    LOCK(cs);
     for (const std::pair<uint256, CLink>& link : m_Links)
     {
         if (link.second.SubjectID == subjectID) // pending request
@@ -202,6 +204,7 @@ void CLinkManager::ProcessQueue()
     if (!pwalletMain)
         return;
 
+    LOCK2(pwalletMain->cs_wallet, cs);
     if (pwalletMain->IsLocked())
         return;
 
@@ -211,7 +214,6 @@ void CLinkManager::ProcessQueue()
     LogPrintf("CLinkManager::%s -- Start links in queue = %d\n", __func__, size);
     while (!linkQueue.empty() && size > counter)
     {
-        // TODO (BDAP): Do we need to lock the queue while processing?
         CLinkStorage storage = linkQueue.front();
         ProcessLink(storage);
         linkQueue.pop();
@@ -230,6 +232,7 @@ void CLinkManager::ProcessQueue()
 
 bool CLinkManager::ListMyPendingRequests(std::vector<CLink>& vchLinks)
 {
+    LOCK(cs);
     for (const std::pair<uint256, CLink>& link : m_Links)
     {
         if (link.second.nLinkState == 1 && link.second.fRequestFromMe) // pending request
@@ -242,6 +245,7 @@ bool CLinkManager::ListMyPendingRequests(std::vector<CLink>& vchLinks)
 
 bool CLinkManager::ListMyPendingAccepts(std::vector<CLink>& vchLinks)
 {
+    LOCK(cs);
     for (const std::pair<uint256, CLink>& link : m_Links)
     {
         //LogPrintf("%s -- link:\n%s\n", __func__, link.second.ToString());
@@ -255,6 +259,7 @@ bool CLinkManager::ListMyPendingAccepts(std::vector<CLink>& vchLinks)
 
 bool CLinkManager::ListMyCompleted(std::vector<CLink>& vchLinks)
 {
+    LOCK(cs);
     for (const std::pair<uint256, CLink>& link : m_Links)
     {
         if (link.second.nLinkState == 2 && !link.second.txHashRequest.IsNull()) // completed link
@@ -269,14 +274,17 @@ bool CLinkManager::ProcessLink(const CLinkStorage& storage, const bool fStoreInQ
 {
 
 #ifndef ENABLE_WALLET
+    LOCK(cs);
     linkQueue.push(storage);
     return true;
 #else
     if (!pwalletMain) {
+        LOCK(cs);
         linkQueue.push(storage);
         return true;
     }
 
+    LOCK2(pwalletMain->cs_wallet, cs);
     if (fStoreInQueueOnly || pwalletMain->IsLocked()) {
         linkQueue.push(storage);
         return true;
@@ -747,6 +755,7 @@ bool CLinkManager::ProcessLink(const CLinkStorage& storage, const bool fStoreInQ
 
 std::vector<CLinkInfo> CLinkManager::GetCompletedLinkInfo(const std::vector<unsigned char>& vchFullObjectPath)
 {
+    LOCK(cs);
     std::vector<CLinkInfo> vchLinkInfo;
     for(const std::pair<uint256, CLink>& link : m_Links)
     {
@@ -784,12 +793,14 @@ int CLinkManager::IsMyMessage(const uint256& subjectID, const uint256& messageID
 
 void CLinkManager::LoadLinkMessageInfo(const uint256& subjectID, const std::vector<unsigned char>& vchPubKey)
 {
+    LOCK(cs);
     if (m_LinkMessageInfo.count(subjectID) == 0)
         m_LinkMessageInfo[subjectID] = vchPubKey;
 }
 
 bool CLinkManager::GetLinkMessageInfo(const uint256& subjectID, std::vector<unsigned char>& vchPubKey)
 {
+    LOCK(cs);
     std::map<uint256, std::vector<unsigned char>>::iterator it = m_LinkMessageInfo.find(subjectID);
     if (it != m_LinkMessageInfo.end()) {
         vchPubKey = it->second;
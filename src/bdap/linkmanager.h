@@ -6,6 +6,7 @@
 #define DYNAMIC_BDAP_LINKMANAGER_H
 
 #include "bdap/linkstorage.h"
+#include "sync.h"
 #include "uint256.h"
 
 #include <array>
@@ -136,6 +137,10 @@ public:
 
 class CLinkManager {
 private:
+    // protects the queue and both maps: links are processed by the wallet
+    // while VGP message workers look up link message info concurrently.
+    // Lock order is cs_wallet -> cs; methods that use the wallet take cs_wallet first.
+    mutable CCriticalSection cs;
     std::queue<CLinkStorage> linkQueue;
     std::map<uint256, CLink> m_Links;
     std::map<uint256, std::vector<unsigned char>> m_LinkMessageInfo;
@@ -147,13 +152,14 @@ public:
 
     inline void SetNull()
     {
+        LOCK(cs);
         std::queue<CLinkStorage> emptyQueue;
         linkQueue = emptyQueue;
         m_Links.clear();
     }
 
-    std::size_t QueueSize() const { return linkQueue.size(); }
-    std::size_t LinkCount() const { return m_Links.size(); }
+    std::size_t QueueSize() const { LOCK(cs); return linkQueue.size(); }
+    std::size_t LinkCount() const { LOCK(cs); return m_Links.size(); }
 
     bool ProcessLink(const CLinkStorage& storage, const bool fStoreInQueueOnly = false);
     void ProcessQueue();
@@ -4,11 +4,13 @@
 
 #include "bdap/utils.h"
 
+#include "cachemap.h"
 #include "chainparams.h"
 #include "coins.h"
 #include "core_io.h"
 #include "policy/policy.h"
 #include "serialize.h"
+#include "sync.h"
 #include "uint256.h"
 #include "validation.h"
 #include "wallet/wallet.h"
@@ -469,6 +471,86 @@ bool GetBDAPOpScript(const CTransactionRef& tx, CScript& scriptBDAPOp)
     return GetBDAPOpScript(tx, scriptBDAPOp, vvchOpParameters, op1, op2);
 }
 
+static const size_t BDAP_TX_OPERATION_CACHE_SIZE = 20000;
+static CacheMap<uint256, CBDAPTxOperationRef> mapBDAPTxOperationCache(BDAP_TX_OPERATION_CACHE_SIZE);
+static CCriticalSection cs_mapBDAPTxOperationCache;
+
+void CBDAPTxOperation::SetNull()
+{
+    fOperation = false;
+    op1 = -1;
+    op2 = -1;
+    scriptOp.clear();
+    vvchArgs.clear();
+    strOpType = "";
+    fData = false;
+    nDataOut = -1;
+    vchData.clear();
+    vchHash.clear();
+    fDataScript = false;
+    scriptData.clear();
+    fAmounts = false;
+    dataAmount = 0;
+    opAmount = 0;
+}
+
+void DecodeBDAPTxOperation(const CTransactionRef& tx, CBDAPTxOperation& operation)
+{
+    operation.SetNull();
+    bool fDataAmount = false, fOpAmount = false;
+    for (unsigned int i = 0; i < tx->vout.size(); i++)
+    {
+        const CTxOut& out = tx->vout[i];
+        int op1, op2;
+        vchCharString vvchArgs;
+        if (DecodeBDAPScript(out.scriptPubKey, op1, op2, vvchArgs)) {
+            if (!operation.fOperation) {
+                operation.fOperation = true;
+                operation.op1 = op1;
+                operation.op2 = op2;
+                operation.scriptOp = out.scriptPubKey;
+                operation.vvchArgs = vvchArgs;
+            }
+            operation.opAmount = out.nValue;
+            fOpAmount = true;
+        }
+        if (out.scriptPubKey.IsUnspendable()) {
+            if (!operation.fDataScript) {
+                operation.fDataScript = true;
+                operation.scriptData = out.scriptPubKey;
+            }
+            if (out.scriptPubKey.size() > 40) {
+                operation.dataAmount = out.nValue;
+                fDataAmount = true;
+            }
+        }
+        if (operation.nDataOut == -1 && IsBDAPDataOutput(out)) {
+            operation.nDataOut = i;
+            operation.fData = GetBDAPData(out.scriptPubKey, operation.vchData, operation.vchHash);
+        }
+    }
+    operation.fAmounts = fDataAmount && fOpAmount;
+    if (operation.fOperation)
+        operation.strOpType = GetBDAPOpTypeString(operation.op1, operation.op2);
+}
+
+CBDAPTxOperationRef GetBDAPTxOperation(const CTransactionRef& tx)
+{
+    const uint256& txHash = tx->GetHash();
+    CBDAPTxOperationRef operation;
+    {
+        LOCK(cs_mapBDAPTxOperationCache);
+        if (mapBDAPTxOperationCache.Get(txHash, operation))
+            return operation;
+    }
+    std::shared_ptr<CBDAPTxOperation> decoded = std::make_shared<CBDAPTxOperation>();
+    DecodeBDAPTxOperation(tx, *decoded);
+    operation = decoded;
+    LOCK(cs_mapBDAPTxOperationCache);
+    mapBDAPTxOperationCache.Insert(txHash, operation);
+    return operation;
+}
+
 bool GetBDAPDataScript(const CTransaction& tx, CScript& scriptBDAPData)
 {
     CTransactionRef ptx = MakeTransactionRef(tx);
@@ -8,6 +8,8 @@
 #include "bdap/bdap.h"
 #include "primitives/transaction.h"
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -29,6 +31,72 @@ namespace BDAP {
     BDAP::ObjectType GetObjectTypeEnum(unsigned int nObjectType);
 }
 
+/** The BDAP operation and data outputs of a transaction, found in a single pass over its outputs.
+ *  Field values match what GetBDAPOpScript, GetBDAPData, GetBDAPDataScript and ExtractAmountsFromTx
+ *  return for the same transaction.
+ */
+class CBDAPTxOperation
+{
+public:
+    // operation output (GetBDAPOpScript)
+    bool fOperation;
+    int op1;
+    int op2;
+    CScript scriptOp;
+    vchCharString vvchArgs;
+    std::string strOpType;
+    // data output (GetBDAPData)
+    bool fData;
+    int nDataOut;
+    CharString vchData;
+    CharString vchHash;
+    // first unspendable output (GetBDAPDataScript)
+    bool fDataScript;
+    CScript scriptData;
+    // output amounts (ExtractAmountsFromTx)
+    bool fAmounts;
+    CAmount dataAmount;
+    CAmount opAmount;
+
+    CBDAPTxOperation()
+    {
+        SetNull();
+    }
+
+    void SetNull();
+};
+
+typedef std::shared_ptr<const CBDAPTxOperation> CBDAPTxOperationRef;
+
+/** BDAP database writes queued during validation so they can be applied later, in block order. */
+class CBDAPWriteBatch
+{
+private:
+    std::vector<std::function<bool()> > vWrites;
+
+public:
+    void Add(const std::function<bool()>& write)
+    {
+        vWrites.push_back(write);
+    }
+
+    size_t Size() const
+    {
+        return vWrites.size();
+    }
+
+    /** Runs the queued writes in the order they were added and stops at the first failure. */
+    bool Apply()
+    {
+        for (const std::function<bool()>& write : vWrites) {
+            if (!write())
+                return false;
+        }
+        vWrites.clear();
+        return true;
+    }
+};
+
 std::string BDAPFromOp(const int op);
 bool IsBDAPDataOutput(const CTxOut& out);
 int GetBDAPDataOutput(const CTransactionRef& tx);
@@ -48,6 +116,8 @@ int GetBDAPOpType(const CTxOut& out);
 std::string GetBDAPOpTypeString(const int& op1, const int& op2);
 bool GetBDAPOpScript(const CTransactionRef& tx, CScript& scriptBDAPOp, vchCharString& vvchOpParameters, int& op1, int& op2);
 bool GetBDAPOpScript(const CTransactionRef& tx, CScript& scriptBDAPOp);
+void DecodeBDAPTxOperation(const CTransactionRef& tx, CBDAPTxOperation& operation);
+CBDAPTxOperationRef GetBDAPTxOperation(const CTransactionRef& tx);
 bool GetBDAPDataScript(const CTransaction& tx, CScript& scriptBDAPData);
 bool GetBDAPDataScript(const CTransactionRef& ptx, CScript& scriptBDAPData);
 bool GetBDAPCreditScript(const CTransactionRef& ptx, CScript& scriptBDAPScredit);
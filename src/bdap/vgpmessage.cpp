@@ -15,22 +15,22 @@
 #include "hash.h"
 #include "key.h"
 #include "net.h" // for g_connman
+#include "net_processing.h" // for Misbehaving
 #include "netmessagemaker.h"
 #include "script/script.h"
 #include "streams.h"
 #include "timedata.h"
 #include "util.h"
+#include "validation.h" // for cs_main
 #include "wallet/wallet.h"
 
 #include <cstdlib>
 
-static std::map<uint256, CVGPMessage> mapMyVGPMessages;
-static CCriticalSection cs_mapMyVGPMessages;
-static int nMyMessageCounter = 0;
+static CVGPMessageStore myVGPMessageStore;
 
-static std::map<uint256, int64_t> mapRecentMessageLog;
-static CCriticalSection cs_mapRecentMessageLog;
-static int nMessageCounter = 0;
+static CVGPMessageLog recentMessageLog(KEEP_MESSAGE_LOG_ALIVE_SECONDS, MESSAGE_LOG_BUCKETS);
+
+static CVGPMessageQueue vgpMessageQueue(MAX_VGP_MESSAGE_QUEUE_SIZE);
 
 class CMessage
 {
@@ -301,12 +301,13 @@ bool CVGPMessage::RelayMessage(CConnman& connman) const
     if (!IsInEffect())
         return false;
 
-    connman.ForEachNode([&connman, this, unsignedMessage](CNode* pnode) {
+    uint256 messageHash = GetHash();
+    connman.ForEachNode([&connman, this, unsignedMessage, messageHash](CNode* pnode) {
         if (pnode->nVersion != 0 && pnode->nVersion >= MIN_VGP_MESSAGE_PEER_PROTO_VERSION)
         {
             CNetMsgMaker msgMaker(pnode->GetSendVersion());
             // returns true if wasn't already contained in the set
-            if (pnode->setKnown.insert(GetHash()).second) {
+            if (pnode->setKnown.insert(messageHash).second) {
                 if (GetAdjustedTime() < unsignedMessage.nRelayUntil) {
                     connman.PushMessage(pnode, msgMaker.Make(NetMsgType::VGPMESSAGE, (*this)));
                 }
@@ -335,14 +336,14 @@ bool CVGPMessage::CheckSignature(const std::vector<unsigned char>& vchPubKey) co
     return true;
 }
 
-int CVGPMessage::ProcessMessage(std::string& strErrorMessage) const
+int CVGPMessage::CheckMessage(const uint256& messageHash, std::string& strErrorMessage) const
 {
     int64_t nCurrentTimeStamp = GetAdjustedTime();
     CUnsignedVGPMessage unsignedMessage(vchMsg);
     // TODO (BDAP): Check pubkey is allowed to broadcast VGP messages, set ban score if not.
     // TODO (BDAP): Check number of messages from this pubkey. make sure it isn't spamming, set ban if too many messages per minute.
     //std::std::vector<unsigned char> vchWalletPubKey = unsignedMessage.vchWalletPubKey;
-    if (ReceivedMessage(GetHash()))
+    if (ReceivedMessage(messageHash))
     {
         strErrorMessage = "Message already received.";
         return -1; // do not relay message again
@@ -382,12 +383,18 @@ int CVGPMessage::ProcessMessage(std::string& strErrorMessage) const
         strErrorMessage = "Wallet pubkey is too large. Adding 100 to ban score.";
         return 100; // this will add 100 to the peer's ban score
     }
+    return 0;
+}
+
+int CVGPMessage::VerifyMessage(const uint256& messageHash, std::string& strErrorMessage) const
+{
+    CUnsignedVGPMessage unsignedMessage(vchMsg);
     if (!CheckSignature(unsignedMessage.vchWalletPubKey))
     {
         strErrorMessage = "VGP message has an invalid signature. Adding 100 to ban score.";
         return 100; // this will add 100 to the peer's ban score
     }
-    if (UintToArith256(unsignedMessage.GetHash()) > UintToArith256(VGP_MESSAGE_MIN_HASH_TARGET))
+    if (UintToArith256(messageHash) > UintToArith256(VGP_MESSAGE_MIN_HASH_TARGET))
     {
         LogPrintf("%s -- message proof hash failed to meet target %s\n", __func__, unsignedMessage.ToString());
         strErrorMessage = "Message proof of work is invalid and under the target.";
@@ -410,13 +417,23 @@ int CVGPMessage::ProcessMessage(std::string& strErrorMessage) const
     return 0; // All checks okay, relay message to peers.
 }
 
-bool CVGPMessage::RelayTo(CNode* pnode, CConnman& connman) const
+int CVGPMessage::ProcessMessage(std::string& strErrorMessage) const
+{
+    uint256 messageHash = GetHash();
+    int nStatus = CheckMessage(messageHash, strErrorMessage);
+    if (nStatus != 0)
+        return nStatus;
+
+    return VerifyMessage(messageHash, strErrorMessage);
+}
+
+bool CVGPMessage::RelayTo(CNode* pnode, CConnman& connman, const uint256& messageHash) const
 {
     if (pnode->nVersion != 0 && pnode->nVersion >= MIN_VGP_MESSAGE_PEER_PROTO_VERSION)
     {
         CNetMsgMaker msgMaker(pnode->GetSendVersion());
         CUnsignedVGPMessage unsignedMessage(vchMsg);
-        if (pnode->setKnown.insert(GetHash()).second) {
+        if (pnode->setKnown.insert(messageHash).second) {
             if (GetAdjustedTime() < unsignedMessage.nRelayUntil) {
                 connman.PushMessage(pnode, msgMaker.Make(NetMsgType::VGPMESSAGE, (*this)));
             }
@@ -458,6 +475,241 @@ void CVGPMessage::MineMessage()
     LogPrintf("%s -- Milliseconds %d, nNonce %d, Hash %s\n", __func__, GetTimeMillis() - nStart, message.nNonce, GetHash().ToString());
 }
 
+bool CVGPMessageStore::AddInternal(const CVGPMessage& message)
+{
+    AssertLockHeld(cs);
+    uint256 messageHash = message.GetHash();
+    if (mapMessages.count(messageHash) > 0)
+        return false;
+
+    CUnsignedVGPMessage unsignedMessage(message.vchMsg);
+    CStoredMessage stored;
+    stored.message = message;
+    stored.SubjectID = unsignedMessage.SubjectID;
+    stored.nTimeStamp = unsignedMessage.nTimeStamp;
+    stored.fEncrypted = unsignedMessage.fEncrypted;
+    stored.fKeepLast = false;
+    if (stored.fEncrypted)
+    {
+        // only the subject is readable until the message is decrypted
+        mapMessages[messageHash] = stored;
+        mapBySubject[stored.SubjectID].insert(messageHash);
+        setEncrypted.insert(messageHash);
+        return true;
+    }
+
+    CMessage data(unsignedMessage.vchMessageData);
+    stored.vchType = data.vchMessageType;
+    stored.vchSenderFQDN = data.vchSenderFQDN;
+    stored.fKeepLast = data.fKeepLast;
+    TypeSenderPair pairTypeSender = std::make_pair(stored.vchType, stored.vchSenderFQDN);
+    if (stored.fKeepLast)
+    {
+        std::map<TypeSenderPair, uint256>::iterator itLast = mapKeepLast.find(pairTypeSender);
+        if (itLast != mapKeepLast.end())
+        {
+            if (mapMessages[itLast->second].nTimeStamp >= stored.nTimeStamp)
+                return false; // we already have a newer message from this sender and type
+
+            RemoveInternal(itLast->second);
+        }
+        mapKeepLast[pairTypeSender] = messageHash;
+    }
+    else
+    {
+        setByTime.insert(std::make_pair(stored.nTimeStamp, messageHash));
+    }
+    mapMessages[messageHash] = stored;
+    mapBySubject[stored.SubjectID].insert(messageHash);
+    mapByTypeSender[stored.vchType][stored.vchSenderFQDN].insert(messageHash);
+    mapBySubjectSender[std::make_pair(stored.SubjectID, stored.vchSenderFQDN)].insert(messageHash);
+    return true;
+}
+
+void CVGPMessageStore::RemoveInternal(const uint256& messageHash)
+{
+    AssertLockHeld(cs);
+    std::map<uint256, CStoredMessage>::iterator it = mapMessages.find(messageHash);
+    if (it == mapMessages.end())
+        return;
+
+    const CStoredMessage& stored = it->second;
+    std::map<uint256, std::set<uint256> >::iterator itSubject = mapBySubject.find(stored.SubjectID);
+    if (itSubject != mapBySubject.end()) {
+        itSubject->second.erase(messageHash);
+        if (itSubject->second.empty())
+            mapBySubject.erase(itSubject);
+    }
+    if (stored.fEncrypted) {
+        setEncrypted.erase(messageHash);
+        mapMessages.erase(it);
+        return;
+    }
+
+    auto itType = mapByTypeSender.find(stored.vchType);
+    if (itType != mapByTypeSender.end()) {
+        auto itSender = itType->second.find(stored.vchSenderFQDN);
+        if (itSender != itType->second.end()) {
+            itSender->second.erase(messageHash);
+            if (itSender->second.empty())
+                itType->second.erase(itSender);
+        }
+        if (itType->second.empty())
+            mapByTypeSender.erase(itType);
+    }
+    auto itSubjectSender = mapBySubjectSender.find(std::make_pair(stored.SubjectID, stored.vchSenderFQDN));
+    if (itSubjectSender != mapBySubjectSender.end()) {
+        itSubjectSender->second.erase(messageHash);
+        if (itSubjectSender->second.empty())
+            mapBySubjectSender.erase(itSubjectSender);
+    }
+    if (stored.fKeepLast) {
+        auto itLast = mapKeepLast.find(std::make_pair(stored.vchType, stored.vchSenderFQDN));
+        if (itLast != mapKeepLast.end() && itLast->second == messageHash)
+            mapKeepLast.erase(itLast);
+    }
+    else {
+        setByTime.erase(std::make_pair(stored.nTimeStamp, messageHash));
+    }
+    mapMessages.erase(it);
+}
+
+void CVGPMessageStore::DecryptPending()
+{
+#ifdef ENABLE_WALLET
+    if (!pwalletMain || !pLinkManager || pwalletMain->IsLocked())
+        return;
+
+    std::vector<std::pair<uint256, CUnsignedVGPMessage> > vPending;
+    {
+        LOCK(cs);
+        for (const uint256& messageHash : setEncrypted)
+            vPending.push_back(std::make_pair(messageHash, CUnsignedVGPMessage(mapMessages[messageHash].message.vchMsg)));
+    }
+    if (vPending.empty())
+        return;
+
+    // decrypt with the store unlocked so wallet access doesn't block the message workers
+    std::vector<std::pair<uint256, CVGPMessage> > vDecrypted;
+    for (std::pair<uint256, CUnsignedVGPMessage>& pending : vPending)
+    {
+        if (DecryptMessage(pending.second))
+            vDecrypted.push_back(std::make_pair(pending.first, CVGPMessage(pending.second)));
+    }
+
+    LOCK(cs);
+    for (const std::pair<uint256, CVGPMessage>& decrypted : vDecrypted)
+    {
+        // another caller may have replaced or expired it in the meantime
+        if (setEncrypted.count(decrypted.first) == 0)
+            continue;
+
+        RemoveInternal(decrypted.first);
+        AddInternal(decrypted.second);
+    }
+#endif // ENABLE_WALLET
+}
+
+bool CVGPMessageStore::Add(const CVGPMessage& message)
+{
+    LOCK(cs);
+    return AddInternal(message);
+}
+
+void CVGPMessageStore::Expire(const int64_t nCurrentTime)
+{
+    LOCK(cs);
+    while (!setByTime.empty() && nCurrentTime > setByTime.begin()->first + KEEP_MY_MESSAGE_ALIVE_SECONDS)
+    {
+        RemoveInternal(setByTime.begin()->second);
+    }
+}
+
+size_t CVGPMessageStore::Size() const
+{
+    LOCK(cs);
+    return mapMessages.size();
+}
+
+void CVGPMessageStore::Clear()
+{
+    LOCK(cs);
+    mapMessages.clear();
+    mapBySubject.clear();
+    mapByTypeSender.clear();
+    mapBySubjectSender.clear();
+    mapKeepLast.clear();
+    setByTime.clear();
+    setEncrypted.clear();
+}
+
+void CVGPMessageStore::GetBySubject(const uint256& subjectID, std::vector<CUnsignedVGPMessage>& vMessages)
+{
+    DecryptPending();
+    LOCK(cs);
+    std::map<uint256, std::set<uint256> >::const_iterator itSubject = mapBySubject.find(subjectID);
+    if (itSubject == mapBySubject.end())
+        return;
+
+    for (const uint256& messageHash : itSubject->second)
+    {
+        const CStoredMessage& stored = mapMessages[messageHash];
+        if (!stored.fEncrypted)
+            vMessages.push_back(CUnsignedVGPMessage(stored.message.vchMsg));
+    }
+}
+
+void CVGPMessageStore::GetByType(const std::vector<unsigned char>& vchType, const std::vector<unsigned char>& vchRecipientFQDN, std::vector<CVGPMessage>& vMessages, bool& fKeepLast)
+{
+    DecryptPending();
+    LOCK(cs);
+    auto itType = vchType.size() == 0 ? mapByTypeSender.begin() : mapByTypeSender.find(vchType);
+    while (itType != mapByTypeSender.end())
+    {
+        for (const auto& senderHashes : itType->second)
+        {
+            // skip messages the recipient sent
+            if (senderHashes.first == vchRecipientFQDN)
+                continue;
+
+            for (const uint256& messageHash : senderHashes.second)
+            {
+                const CStoredMessage& stored = mapMessages[messageHash];
+                if (stored.fKeepLast)
+                    fKeepLast = true;
+
+                vMessages.push_back(stored.message);
+            }
+        }
+        if (vchType.size() > 0)
+            break;
+
+        ++itType;
+    }
+}
+
+void CVGPMessageStore::GetBySubjectAndSender(const uint256& subjectID, const std::vector<unsigned char>& vchSenderFQDN,
+                                                const std::vector<unsigned char>& vchType, std::vector<CVGPMessage>& vMessages, bool& fKeepLast)
+{
+    DecryptPending();
+    LOCK(cs);
+    auto itSubjectSender = mapBySubjectSender.find(std::make_pair(subjectID, vchSenderFQDN));
+    if (itSubjectSender == mapBySubjectSender.end())
+        return;
+
+    for (const uint256& messageHash : itSubjectSender->second)
+    {
+        const CStoredMessage& stored = mapMessages[messageHash];
+        if (vchType.size() > 0 && vchType != stored.vchType)
+            continue;
+
+        if (stored.fKeepLast)
+            fKeepLast = true;
+
+        vMessages.push_back(stored.message);
+    }
+}
+
 #ifdef ENABLE_WALLET
 bool GetSecretSharedKey(const std::string& strSenderFQDN, const std::string& strRecipientFQDN, CKeyEd25519& key, std::string& strErrorMessage)
 {
@@ -492,83 +744,230 @@ uint256 GetSubjectIDFromKey(const CKeyEd25519& key)
     return Hash(vchPubKey.begin(), vchPubKey.end());
 }
 
-void CleanupRecentMessageLog()
+CVGPMessageLog::CVGPMessageLog(const int64_t nKeepAliveSeconds, const unsigned int nBuckets) : nLookups(0), nHits(0)
+{
+    nBucketSeconds = (nKeepAliveSeconds + nBuckets - 1) / nBuckets;
+    if (nBucketSeconds < 1)
+        nBucketSeconds = 1;
+    // one extra bucket so a hash is always kept for at least nKeepAliveSeconds
+    vBuckets.resize(nBuckets + 1);
+    for (CBucket& bucket : vBuckets)
+        bucket.nEpoch = -1;
+}
+
+CVGPMessageLog::CBucket& CVGPMessageLog::GetBucket(const int64_t nEpoch)
+{
+    CBucket& bucket = vBuckets[nEpoch % vBuckets.size()];
+    if (bucket.nEpoch != nEpoch) {
+        // this bucket's time window has passed, drop all of its hashes at once
+        bucket.setHashes.clear();
+        bucket.nEpoch = nEpoch;
+    }
+    return bucket;
+}
+
+bool CVGPMessageLog::CheckAndInsert(const uint256& messageHash, const int64_t nCurrentTime)
 {
-    int64_t nCurrentTimeStamp =  GetAdjustedTime();
-    std::map<uint256, int64_t>::iterator itr = mapRecentMessageLog.begin();
-    while (itr != mapRecentMessageLog.end())
+    LOCK(cs);
+    nLookups++;
+    int64_t nEpoch = nCurrentTime / nBucketSeconds;
+    int64_t nOldestEpoch = nEpoch - (int64_t)vBuckets.size() + 1;
+    for (const CBucket& bucket : vBuckets)
     {
-        int64_t nTimeStamp = (*itr).second;
-        if (nCurrentTimeStamp > nTimeStamp + KEEP_MESSAGE_LOG_ALIVE_SECONDS)
-        {
-           itr = mapRecentMessageLog.erase(itr);
+        if (bucket.nEpoch >= nOldestEpoch && bucket.nEpoch <= nEpoch && bucket.setHashes.count(messageHash) > 0) {
+            nHits++;
+            return true;
         }
-        else
-        {
-           ++itr;
+    }
+    GetBucket(nEpoch).setHashes.insert(messageHash);
+    return false;
+}
+
+void CVGPMessageLog::Erase(const uint256& messageHash)
+{
+    LOCK(cs);
+    for (CBucket& bucket : vBuckets)
+        bucket.setHashes.erase(messageHash);
+}
+
+void CVGPMessageLog::GetStats(const int64_t nCurrentTime, size_t& nEntries, uint64_t& nLookupsOut, uint64_t& nHitsOut)
+{
+    LOCK(cs);
+    int64_t nEpoch = nCurrentTime / nBucketSeconds;
+    int64_t nOldestEpoch = nEpoch - (int64_t)vBuckets.size() + 1;
+    nEntries = 0;
+    for (CBucket& bucket : vBuckets)
+    {
+        if (bucket.nEpoch < nOldestEpoch || bucket.nEpoch > nEpoch) {
+            bucket.setHashes.clear();
+            bucket.nEpoch = -1;
         }
+        nEntries += bucket.setHashes.size();
     }
+    nLookupsOut = nLookups;
+    nHitsOut = nHits;
 }
 
 bool ReceivedMessage(const uint256& messageHash)
 {
-    LOCK(cs_mapRecentMessageLog);
-    std::map<uint256, int64_t>::iterator iMessage = mapRecentMessageLog.find(messageHash);
-    if (iMessage != mapRecentMessageLog.end()) 
+    return recentMessageLog.CheckAndInsert(messageHash, GetAdjustedTime());
+}
+
+static void HandleMessageStatus(const NodeId nodeId, const CVGPMessage& message, const uint256& messageHash, const int statusBan,
+                                    const std::string& strErrorMessage, CConnman& connman)
+{
+    CUnsignedVGPMessage unsignedMessage(message.vchMsg);
+    if (strErrorMessage.size() > 0)
     {
-        return true;
+        LogPrint("bdap", "%s -- Error processing message. Hash %s,  MessageID %s, SubjectID %s, Error %s\n", __func__, 
+                            messageHash.ToString(), unsignedMessage.MessageID.ToString(), unsignedMessage.SubjectID.ToString(), strErrorMessage);
+    }
+    if (statusBan == 0)
+    {
+        // Relay
+        connman.ForNode(nodeId, [&messageHash](CNode* pnode) {
+            pnode->setKnown.insert(messageHash);
+            return true;
+        });
+        connman.ForEachNode([&message, &messageHash, &connman](CNode* pnode) {
+            message.RelayTo(pnode, connman, messageHash);
+        });
+    }
+    else if (statusBan > 0)
+    {
+        LOCK(cs_main);
+        Misbehaving(nodeId, statusBan);
+    }
+    else if (statusBan == -1)
+    {
+        LogPrint("bdap", "%s -- Duplicate message recieved. Hash %s,  MessageID %s, SubjectID %s\n", __func__, 
+                            messageHash.ToString(), unsignedMessage.MessageID.ToString(), unsignedMessage.SubjectID.ToString());
+    }
+    else if (statusBan == -2)
+    {
+        LogPrint("bdap", "%s -- Message either too old or timestamp is in the future. Hash %s,  MessageID %s, SubjectID %s\n", __func__, 
+                            messageHash.ToString(), unsignedMessage.MessageID.ToString(), unsignedMessage.SubjectID.ToString());
+    }
+    else if (statusBan == -3)
+    {
+        LogPrint("bdap", "%s -- Timestamp is greater than relay until time. Hash %s,  MessageID %s, SubjectID %s\n", __func__, 
+                            messageHash.ToString(), unsignedMessage.MessageID.ToString(), unsignedMessage.SubjectID.ToString());
+        LOCK(cs_main);
+        Misbehaving(nodeId, 10); // there is no reason to have a timestamp greater than the relay until time so ban node.
+    }
+    else if (statusBan == -4)
+    {
+        LogPrint("bdap", "%s -- Relay time is too much.  max relay is 120 seconds. Hash %s,  MessageID %s, SubjectID %s\n", __func__, 
+                            messageHash.ToString(), unsignedMessage.MessageID.ToString(), unsignedMessage.SubjectID.ToString());
+        LOCK(cs_main);
+        Misbehaving(nodeId, 10); // there is no reason to have longer relay until time span so ban node.
     }
     else
     {
-        int64_t nTimeStamp =  GetAdjustedTime();
-        mapRecentMessageLog[messageHash] = nTimeStamp;
-        nMessageCounter++;
-        if ((nMessageCounter % 10) == 0)
-            CleanupRecentMessageLog();
+        LogPrintf("%s -- Unkown ProcessMessage status. Hash %s,  MessageID %s, SubjectID %s\n", __func__, 
+                            messageHash.ToString(), unsignedMessage.MessageID.ToString(), unsignedMessage.SubjectID.ToString());
     }
-    return false;
 }
 
-void CleanupMyMessageMap()
+CVGPMessageQueue::PushResult CVGPMessageQueue::Push(const NodeId nodeId, const uint256& messageHash, const CVGPMessage& message)
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    if (nWorkers == 0)
+        return PUSH_NO_WORKERS;
+    if (queue.size() >= nMaxSize)
+        return PUSH_FULL;
+
+    CQueuedMessage queued;
+    queued.nodeId = nodeId;
+    queued.messageHash = messageHash;
+    queued.message = message;
+    queue.push_back(queued);
+    condWorker.notify_one();
+    return PUSH_QUEUED;
+}
+
+void CVGPMessageQueue::Thread(const Handler& handler)
 {
-    // map with message type, message sender and timestamp.  Used to keep last message from a sender/type pair.
-    std::map<std::pair<std::vector<unsigned char>, std::vector<unsigned char>>, int64_t> mapMessageTypeFromTimestamp;
-    int64_t nCurrentTimeStamp =  GetAdjustedTime();
-    std::map<uint256, CVGPMessage>::iterator itr = mapMyVGPMessages.begin();
-    while (itr != mapMyVGPMessages.end())
     {
-        CVGPMessage message = (*itr).second;
-        CUnsignedVGPMessage unsignedMessage(message.vchMsg);
-        if (!unsignedMessage.fEncrypted && nCurrentTimeStamp > unsignedMessage.nTimeStamp + KEEP_MY_MESSAGE_ALIVE_SECONDS)
+        boost::unique_lock<boost::mutex> lock(mutex);
+        nWorkers++;
+    }
+    try {
+        while (true)
         {
-            CMessage message(unsignedMessage.vchMessageData);
-            std::pair<std::vector<unsigned char>, std::vector<unsigned char>> pairTypeFrom = std::make_pair(message.vchMessageType, message.vchSenderFQDN);
-            if (!message.fKeepLast) {
-                itr = mapMyVGPMessages.erase(itr);
-            }
-            else {
-                std::map<std::pair<std::vector<unsigned char>, std::vector<unsigned char>>, int64_t>::iterator itTypeFrom = mapMessageTypeFromTimestamp.find(pairTypeFrom);
-                if (itTypeFrom != mapMessageTypeFromTimestamp.end()) {
-                    if (itTypeFrom->second > unsignedMessage.nTimeStamp) {
-                        itr = mapMyVGPMessages.erase(itr);
-                    }
-                    else {
-                        mapMessageTypeFromTimestamp[pairTypeFrom] = unsignedMessage.nTimeStamp;
-                        ++itr;
-                    }
-                }
-                else {
-                    mapMessageTypeFromTimestamp[pairTypeFrom] = unsignedMessage.nTimeStamp;
-                    ++itr;
-                }
+            CQueuedMessage queued;
+            {
+                boost::unique_lock<boost::mutex> lock(mutex);
+                while (queue.empty())
+                    condWorker.wait(lock); // interruption point on shutdown
+                queued = queue.front();
+                queue.pop_front();
             }
+            handler(queued.nodeId, queued.messageHash, queued.message);
         }
-        else
-        {
-           ++itr;
-        }
+    } catch (...) {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        nWorkers--;
+        throw;
+    }
+}
+
+static void VerifyQueuedMessage(const NodeId nodeId, const uint256& messageHash, const CVGPMessage& message)
+{
+    std::string strErrorMessage = "";
+    int statusBan = message.VerifyMessage(messageHash, strErrorMessage);
+    if (g_connman)
+        HandleMessageStatus(nodeId, message, messageHash, statusBan, strErrorMessage, *g_connman);
+}
+
+void ThreadVGPMessageVerify()
+{
+    RenameThread("dynamic-vgpmsg");
+    vgpMessageQueue.Thread(VerifyQueuedMessage);
+}
+
+CVGPMessageQueue::PushResult QueueVGPMessage(CVGPMessageQueue& queue, CVGPMessageLog& log, const NodeId nodeId, const uint256& messageHash, const CVGPMessage& message)
+{
+    CVGPMessageQueue::PushResult result = queue.Push(nodeId, messageHash, message);
+    if (result == CVGPMessageQueue::PUSH_FULL) {
+        // forget the hash so the message is checked again if a peer resends it
+        log.Erase(messageHash);
+        LogPrint("bdap", "%s -- Verification queue is full, dropping message %s\n", __func__, messageHash.ToString());
+    }
+    return result;
+}
+
+void ProcessVGPMessage(const NodeId nodeId, const CVGPMessage& message, CConnman& connman)
+{
+    uint256 messageHash = message.GetHash();
+    CUnsignedVGPMessage unsignedMessage(message.vchMsg);
+    LogPrint("bdap", "%s -- VGP message received: size = %d, SubjectID = %s, MessageID = %s, HashID = %s \n", 
+                    __func__, message.vchMsg.size(), unsignedMessage.SubjectID.ToString(), unsignedMessage.MessageID.ToString(), messageHash.ToString());
+
+    // dedup and cheap sanity checks stay on the message handler thread
+    std::string strErrorMessage = "";
+    int statusBan = message.CheckMessage(messageHash, strErrorMessage);
+    if (statusBan == 0)
+    {
+        CVGPMessageQueue::PushResult result = QueueVGPMessage(vgpMessageQueue, recentMessageLog, nodeId, messageHash, message);
+        if (result != CVGPMessageQueue::PUSH_NO_WORKERS)
+            return;
+
+        // no verification threads running, verify in place
+        statusBan = message.VerifyMessage(messageHash, strErrorMessage);
     }
-    LogPrintf("%s -- Size %d\n", __func__, mapMyVGPMessages.size());
+    HandleMessageStatus(nodeId, message, messageHash, statusBan, strErrorMessage, connman);
+}
+
+void GetRecentMessageLogStats(size_t& nEntries, uint64_t& nLookups, uint64_t& nHits)
+{
+    recentMessageLog.GetStats(GetAdjustedTime(), nEntries, nLookups, nHits);
+}
+
+void CleanupMyMessageMap()
+{
+    myVGPMessageStore.Expire(GetAdjustedTime());
+    LogPrint("bdap", "%s -- Size %d\n", __func__, myVGPMessageStore.Size());
 }
 
 #ifdef ENABLE_WALLET
@@ -628,80 +1027,24 @@ void AddMyMessage(const CVGPMessage& message)
     {
         storeMessage = message;
     }
-    LOCK(cs_mapMyVGPMessages);
-    mapMyVGPMessages[storeMessage.GetHash()] = storeMessage;
-    nMyMessageCounter++;
-    if ((nMyMessageCounter % 10) == 0)
-        CleanupMyMessageMap();
+    myVGPMessageStore.Add(storeMessage);
+    CleanupMyMessageMap();
 }
 
 void GetMyLinkMessages(const uint256& subjectID, std::vector<CUnsignedVGPMessage>& vMessages)
 {
-    LOCK(cs_mapMyVGPMessages);
-    std::map<uint256, CVGPMessage>::iterator itr = mapMyVGPMessages.begin();
-    while (itr != mapMyVGPMessages.end())
-    {
-        CVGPMessage message = (*itr).second;
-        CUnsignedVGPMessage unsignedMessage(message.vchMsg);
-        if (unsignedMessage.SubjectID == subjectID)
-        {
-            if (unsignedMessage.fEncrypted)
-            {
-                if (pwalletMain && !pwalletMain->IsLocked() && DecryptMessage(unsignedMessage))
-                {
-                    vMessages.push_back(unsignedMessage);
-                }
-            }
-            else
-            {
-                vMessages.push_back(unsignedMessage);
-            }
-        }
-        itr++;
-    }
+    myVGPMessageStore.GetBySubject(subjectID, vMessages);
 }
 
 void GetMyLinkMessagesByType(const std::vector<unsigned char>& vchType, const std::vector<unsigned char>& vchRecipientFQDN, std::vector<CVGPMessage>& vMessages, bool& fKeepLast)
 {
-    LOCK(cs_mapMyVGPMessages);
-    std::map<uint256, CVGPMessage>::iterator itr = mapMyVGPMessages.begin();
-    while (itr != mapMyVGPMessages.end())
-    {
-        CVGPMessage messageWrapper = (*itr).second;
-        CUnsignedVGPMessage unsignedMessage(messageWrapper.vchMsg);
-        if (unsignedMessage.fEncrypted && pwalletMain && !pwalletMain->IsLocked())
-        {
-            DecryptMessage(unsignedMessage);
-        }
-        if (!unsignedMessage.fEncrypted && (vchType.size() == 0 || vchType == unsignedMessage.Type()) && unsignedMessage.SenderFQDN() != vchRecipientFQDN)
-        {
-            if (unsignedMessage.KeepLast())
-                fKeepLast = true;
-
-            vMessages.push_back(unsignedMessage);
-        }
-        itr++;
-    }
+    myVGPMessageStore.GetByType(vchType, vchRecipientFQDN, vMessages, fKeepLast);
 }
 
 void GetMyLinkMessagesBySubjectAndSender(const uint256& subjectID, const std::vector<unsigned char>& vchSenderFQDN, 
                                             const std::vector<unsigned char>& vchType, std::vector<CVGPMessage>& vchMessages, bool& fKeepLast)
 {
-    LOCK(cs_mapMyVGPMessages);
-    std::map<uint256, CVGPMessage>::iterator itr = mapMyVGPMessages.begin();
-    while (itr != mapMyVGPMessages.end())
-    {
-        CVGPMessage messageWrapper = (*itr).second;
-        CUnsignedVGPMessage unsignedMessage(messageWrapper.vchMsg);
-        if (unsignedMessage.SubjectID == subjectID && unsignedMessage.SenderFQDN() == vchSenderFQDN && (vchType.size() == 0 || vchType == unsignedMessage.Type()))
-        {
-            if (unsignedMessage.KeepLast())
-                fKeepLast = true;
-
-            vchMessages.push_back(messageWrapper);
-        }
-        itr++;
-    }
+    myVGPMessageStore.GetBySubjectAndSender(subjectID, vchSenderFQDN, vchType, vchMessages, fKeepLast);
 }
 #endif // ENABLE_WALLET
 
@@ -7,16 +7,24 @@
 #ifndef DYNAMIC_BDAP_VGPMESSAGE_H
 #define DYNAMIC_BDAP_VGPMESSAGE_H
 
+#include "net.h" // for NodeId
+#include "saltedhasher.h"
 #include "serialize.h"
 #include "sync.h"
 #include "uint256.h"
 
+#include <deque>
+#include <functional>
 #include <map>
 #include <set>
 #include <stdint.h>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
 class CConnman;
 class CKey;
 class CKeyEd25519;
@@ -30,6 +38,10 @@ static constexpr uint32_t MIN_CLIENT_VERSION = 2040000;
 static constexpr size_t MAX_SIGNATURE_SIZE = 72;
 static constexpr size_t MAX_WALLET_PUBKEY_SIZE = 40;
 static constexpr int KEEP_MESSAGE_LOG_ALIVE_SECONDS = 300; // 5 minutes.
+static constexpr unsigned int MESSAGE_LOG_BUCKETS = 10; // 30 second buckets
+static constexpr int DEFAULT_VGP_MESSAGE_THREADS = 2;
+static constexpr int MAX_VGP_MESSAGE_THREADS = 16;
+static constexpr size_t MAX_VGP_MESSAGE_QUEUE_SIZE = 1000;
 static constexpr int KEEP_MY_MESSAGE_ALIVE_SECONDS = 240; // 4 minutes.
 static constexpr int MAX_MESAGGE_DRIFT_SECONDS = 90; // 1.5 minutes.
 static constexpr int MAX_MESAGGE_RELAY_SECONDS = 120; // 2 minutes.
@@ -170,18 +182,143 @@ public:
     bool RelayMessage(CConnman& connman) const;
     bool Sign(const CKey& key);
     bool CheckSignature(const std::vector<unsigned char>& vchPubKey) const;
+    int CheckMessage(const uint256& messageHash, std::string& strErrorMessage) const;
+    int VerifyMessage(const uint256& messageHash, std::string& strErrorMessage) const;
     int ProcessMessage(std::string& strErrorMessage) const;
-    bool RelayTo(CNode* pnode, CConnman& connman) const;
+    bool RelayTo(CNode* pnode, CConnman& connman, const uint256& messageHash) const;
     int Version() const;
     void MineMessage();
 
 };
 
+/** Bounded queue of received VGP messages that passed the cheap checks in CVGPMessage::CheckMessage.
+ *  Worker threads verify the signature and proof of work, decrypt and store messages addressed to us
+ *  and relay or penalize the sending peer, so message bursts don't hold up the message handler thread.
+ */
+class CVGPMessageQueue
+{
+private:
+    struct CQueuedMessage
+    {
+        NodeId nodeId;
+        uint256 messageHash;
+        CVGPMessage message;
+    };
+
+    boost::mutex mutex;
+    boost::condition_variable condWorker;
+    std::deque<CQueuedMessage> queue;
+    size_t nMaxSize;
+    int nWorkers;
+
+public:
+    enum PushResult {
+        PUSH_QUEUED,
+        PUSH_FULL,
+        PUSH_NO_WORKERS
+    };
+
+    typedef std::function<void(const NodeId, const uint256&, const CVGPMessage&)> Handler;
+
+    CVGPMessageQueue(const size_t nMaxSizeIn) : nMaxSize(nMaxSizeIn), nWorkers(0) {}
+
+    PushResult Push(const NodeId nodeId, const uint256& messageHash, const CVGPMessage& message);
+    //! Worker thread, runs the handler for each message in the order they were pushed
+    void Thread(const Handler& handler);
+};
+
+/** Remembers the hashes of recently received VGP messages so they are not processed or relayed twice.
+ *  Hashes are kept in fixed time buckets and a lookup checks each live bucket. The oldest bucket is
+ *  dropped as a whole when its time window passes, so there is no per entry expiry scan.
+ */
+class CVGPMessageLog
+{
+private:
+    struct CBucket
+    {
+        int64_t nEpoch;
+        std::unordered_set<uint256, SaltedTxidHasher> setHashes;
+    };
+
+    mutable CCriticalSection cs;
+    int64_t nBucketSeconds;
+    std::vector<CBucket> vBuckets;
+    uint64_t nLookups;
+    uint64_t nHits;
+
+    CBucket& GetBucket(const int64_t nEpoch);
+
+public:
+    CVGPMessageLog(const int64_t nKeepAliveSeconds, const unsigned int nBuckets);
+
+    //! Returns true if the hash was already seen, otherwise records it
+    bool CheckAndInsert(const uint256& messageHash, const int64_t nCurrentTime);
+    //! Forgets a hash so the message is processed again when it is resent
+    void Erase(const uint256& messageHash);
+    //! Drops expired buckets, then returns the live entry count and the lookup counters at one moment
+    void GetStats(const int64_t nCurrentTime, size_t& nEntries, uint64_t& nLookupsOut, uint64_t& nHitsOut);
+};
+
+/** Stores VGP messages addressed to this node's links.
+ *  Messages are indexed by SubjectID, by message type and sender and by SubjectID and sender so link
+ *  message queries don't scan the whole store. Expiry walks a timestamp ordered index, and keep-last
+ *  messages replace the older message from the same sender and type when they are added.
+ */
+class CVGPMessageStore
+{
+private:
+    struct CStoredMessage
+    {
+        CVGPMessage message;
+        uint256 SubjectID;
+        int64_t nTimeStamp;
+        bool fEncrypted;
+        std::vector<unsigned char> vchType;
+        std::vector<unsigned char> vchSenderFQDN;
+        bool fKeepLast;
+    };
+
+    typedef std::pair<std::vector<unsigned char>, std::vector<unsigned char> > TypeSenderPair;
+    typedef std::pair<uint256, std::vector<unsigned char> > SubjectSenderPair;
+
+    mutable CCriticalSection cs;
+    std::map<uint256, CStoredMessage> mapMessages;
+    std::map<uint256, std::set<uint256> > mapBySubject;
+    // message type -> sender FQDN -> message hashes
+    std::map<std::vector<unsigned char>, std::map<std::vector<unsigned char>, std::set<uint256> > > mapByTypeSender;
+    std::map<SubjectSenderPair, std::set<uint256> > mapBySubjectSender;
+    // latest keep-last message for each type and sender pair. These never expire until replaced.
+    std::map<TypeSenderPair, uint256> mapKeepLast;
+    // decrypted messages that are not keep-last, ordered by timestamp for expiry
+    std::set<std::pair<int64_t, uint256> > setByTime;
+    // messages we could not decrypt yet because the wallet was locked
+    std::set<uint256> setEncrypted;
+
+    bool AddInternal(const CVGPMessage& message);
+    void RemoveInternal(const uint256& messageHash);
+    //! Decrypts messages received while the wallet was locked. Takes cs itself and releases it around the decryption
+    void DecryptPending();
+
+public:
+    bool Add(const CVGPMessage& message);
+    void Expire(const int64_t nCurrentTime);
+    size_t Size() const;
+    void Clear();
+
+    void GetBySubject(const uint256& subjectID, std::vector<CUnsignedVGPMessage>& vMessages);
+    void GetByType(const std::vector<unsigned char>& vchType, const std::vector<unsigned char>& vchRecipientFQDN, std::vector<CVGPMessage>& vMessages, bool& fKeepLast);
+    void GetBySubjectAndSender(const uint256& subjectID, const std::vector<unsigned char>& vchSenderFQDN,
+                                const std::vector<unsigned char>& vchType, std::vector<CVGPMessage>& vMessages, bool& fKeepLast);
+};
+
 bool GetSecretSharedKey(const std::string& strSenderFQDN, const std::string& strRecipientFQDN, CKeyEd25519& key, std::string& strErrorMessage);
 uint256 GetSubjectIDFromKey(const CKeyEd25519& key);
 
 bool ReceivedMessage(const uint256& messageHash);
-void CleanupRecentMessageLog();
+CVGPMessageQueue::PushResult QueueVGPMessage(CVGPMessageQueue& queue, CVGPMessageLog& log, const NodeId nodeId, const uint256& messageHash, const CVGPMessage& message);
+void ProcessVGPMessage(const NodeId nodeId, const CVGPMessage& message, CConnman& connman);
+void ThreadVGPMessageVerify();
+void GetRecentMessageLogStats(size_t& nEntries, uint64_t& nLookups, uint64_t& nHits);
 void CleanupMyMessageMap();
 
 #ifdef ENABLE_WALLET
@@ -0,0 +1,56 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "hash.h"
+#include "primitives/block.h"
+#include "utilstrencodings.h"
+
+// Phase 1 parameters with the default allocator, as every hash did before the arena
+static int Argon2dPhase1Malloc(const void* in, const size_t size, const void* out)
+{
+    argon2_context context;
+    context.out = (uint8_t*)out;
+    context.outlen = (uint32_t)OUTPUT_BYTES;
+    context.pwd = (uint8_t*)in;
+    context.pwdlen = (uint32_t)size;
+    context.salt = (uint8_t*)in;
+    context.saltlen = (uint32_t)size;
+    context.secret = NULL;
+    context.secretlen = 0;
+    context.ad = NULL;
+    context.adlen = 0;
+    context.allocate_cbk = NULL;
+    context.free_cbk = NULL;
+    context.flags = DEFAULT_ARGON2_FLAG;
+    context.m_cost = 500;
+    context.lanes = 8;
+    context.threads = 1;
+    context.t_cost = 2;
+
+    return argon2_ctx(&context, Argon2_d);
+}
+
+static void Argon2dHeaderMalloc(benchmark::State& state)
+{
+    CBlockHeader header;
+    uint256 hash;
+    while (state.KeepRunning()) {
+        header.nNonce++;
+        Argon2dPhase1Malloc(BEGIN(header.nVersion), END(header.nNonce) - BEGIN(header.nVersion), hash.begin());
+    }
+}
+
+static void Argon2dHeaderArena(benchmark::State& state)
+{
+    CBlockHeader header;
+    uint256 hash;
+    while (state.KeepRunning()) {
+        header.nNonce++;
+        hash = hash_Argon2d(BEGIN(header.nVersion), END(header.nNonce), 1);
+    }
+}
+
+BENCHMARK(Argon2dHeaderMalloc);
+BENCHMARK(Argon2dHeaderArena);
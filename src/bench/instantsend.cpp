@@ -0,0 +1,68 @@
+// Copyright (c) 2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "checkqueue.h"
+#include "instantsend.h"
+#include "key.h"
+#include "random.h"
+
+#include <boost/thread/thread.hpp>
+
+// lock votes verified per iteration, votes per second is this over the time per iteration
+static const int VOTE_BATCH_SIZE = 100;
+static const int VOTE_CHECK_THREADS = 4;
+
+static void MakeTxLockVotes(std::vector<CTxLockVote>& vecVotes, CPubKey& pubKeyRet)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    pubKeyRet = key.GetPubKey();
+    COutPoint outpointDynode(GetRandHash(), 0);
+    for (int i = 0; i < VOTE_BATCH_SIZE; i++) {
+        CTxLockVote vote(GetRandHash(), COutPoint(GetRandHash(), 0), outpointDynode);
+        vote.Sign(key, pubKeyRet);
+        vecVotes.push_back(vote);
+    }
+}
+
+// one signature at a time, as on the message handler thread
+static void TxLockVoteVerify(benchmark::State& state)
+{
+    std::vector<CTxLockVote> vecVotes;
+    CPubKey pubKey;
+    MakeTxLockVotes(vecVotes, pubKey);
+    while (state.KeepRunning()) {
+        for (const CTxLockVote& vote : vecVotes)
+            assert(vote.CheckSignature(pubKey));
+    }
+}
+
+// the same votes as one batch on the lock vote check threads
+static void TxLockVoteVerifyBatch(benchmark::State& state)
+{
+    std::vector<CTxLockVote> vecVotes;
+    CPubKey pubKey;
+    MakeTxLockVotes(vecVotes, pubKey);
+
+    CCheckQueue<CTxLockVoteCheck> queue(128);
+    boost::thread_group threadGroup;
+    for (int i = 0; i < VOTE_CHECK_THREADS - 1; i++)
+        threadGroup.create_thread([&queue] { queue.Thread(); });
+
+    std::unique_ptr<bool[]> pfValid(new bool[VOTE_BATCH_SIZE]);
+    while (state.KeepRunning()) {
+        CCheckQueueControl<CTxLockVoteCheck> control(&queue);
+        std::vector<CTxLockVoteCheck> vChecks;
+        for (int i = 0; i < VOTE_BATCH_SIZE; i++)
+            vChecks.push_back(CTxLockVoteCheck(vecVotes[i], pubKey, pfValid[i]));
+        control.Add(vChecks);
+        control.Wait();
+    }
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+}
+
+BENCHMARK(TxLockVoteVerify);
+BENCHMARK(TxLockVoteVerifyBatch);
@@ -286,6 +286,8 @@ public:
         block.nTime = nTime;
         block.nBits = nBits;
         block.nNonce = nNonce;
+        if (phashBlock)
+            block.CacheHash(*phashBlock);
         return block;
     }
 
@@ -8,6 +8,8 @@
 #ifndef DYNAMIC_CHECKQUEUE_H
 #define DYNAMIC_CHECKQUEUE_H
 
+#include "sync.h"
+
 #include <algorithm>
 #include <vector>
 
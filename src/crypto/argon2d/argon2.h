@@ -309,6 +309,19 @@ ARGON2_PUBLIC const char* argon2_error_message(int error_code);
  */
 ARGON2_PUBLIC size_t argon2_encodedlen(uint32_t t_cost, uint32_t m_cost, uint32_t parallelism, uint32_t saltlen, uint32_t hashlen, argon2_type type);
 
+/**
+ * Selects the fastest fill-block kernel supported by the CPU, falling back to
+ * the baseline kernel if the faster one does not reproduce its output. Not
+ * thread safe, call once at startup before hashing on other threads.
+ * @return  The name of the selected kernel
+ */
+ARGON2_PUBLIC const char* argon2d_select_impl(void);
+
+/**
+ * Returns the name of the fill-block kernel in use
+ */
+ARGON2_PUBLIC const char* argon2d_impl_name(void);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -219,6 +219,17 @@ void finalize(const argon2_context *context, argon2_instance_t *instance);
 void fill_segment(const argon2_instance_t *instance,
                   argon2_position_t position);
 
+/*
+ * Fill-block kernels built for different instruction sets, fill_segment
+ * dispatches to the one selected by argon2d_select_impl
+ */
+void fill_segment_base(const argon2_instance_t *instance,
+                       argon2_position_t position);
+void fill_segment_avx2(const argon2_instance_t *instance,
+                       argon2_position_t position);
+void fill_segment_avx512f(const argon2_instance_t *instance,
+                          argon2_position_t position);
+
 /*
  * Function that fills the entire memory t_cost times based on the first two
  * blocks in each lane
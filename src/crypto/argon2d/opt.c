@@ -17,248 +17,141 @@
 
 #include <stdint.h>
 #include <string.h>
-#include <stdlib.h>
 
 #include "argon2.h"
 #include "core.h"
 
-#include "../blake2/blake2.h"
-#include "../blake2/blamka-round-opt.h"
-
-/*
- * Function fills a new memory block and optionally XORs the old block over the new one.
- * Memory must be initialized.
- * @param state Pointer to the just produced block. Content will be updated(!)
- * @param ref_block Pointer to the reference block
- * @param next_block Pointer to the block to be XORed over. May coincide with @ref_block
- * @param with_xor Whether to XOR into the new block (1) or just overwrite (0)
- * @pre all block pointers must be valid
- */
-#if defined(__AVX512F__)
-static void fill_block(__m512i *state, const block *ref_block,
-                       block *next_block, int with_xor) {
-    __m512i block_XY[ARGON2_512BIT_WORDS_IN_BLOCK];
-    unsigned int i;
-
-    if (with_xor) {
-        for (i = 0; i < ARGON2_512BIT_WORDS_IN_BLOCK; i++) {
-            state[i] = _mm512_xor_si512(
-                state[i], _mm512_loadu_si512((const __m512i *)ref_block->v + i));
-            block_XY[i] = _mm512_xor_si512(
-                state[i], _mm512_loadu_si512((const __m512i *)next_block->v + i));
-        }
-    } else {
-        for (i = 0; i < ARGON2_512BIT_WORDS_IN_BLOCK; i++) {
-            block_XY[i] = state[i] = _mm512_xor_si512(
-                state[i], _mm512_loadu_si512((const __m512i *)ref_block->v + i));
-        }
-    }
-
-    for (i = 0; i < 2; ++i) {
-        BLAKE2_ROUND_1(
-            state[8 * i + 0], state[8 * i + 1], state[8 * i + 2], state[8 * i + 3],
-            state[8 * i + 4], state[8 * i + 5], state[8 * i + 6], state[8 * i + 7]);
-    }
-
-    for (i = 0; i < 2; ++i) {
-        BLAKE2_ROUND_2(
-            state[2 * 0 + i], state[2 * 1 + i], state[2 * 2 + i], state[2 * 3 + i],
-            state[2 * 4 + i], state[2 * 5 + i], state[2 * 6 + i], state[2 * 7 + i]);
-    }
-
-    for (i = 0; i < ARGON2_512BIT_WORDS_IN_BLOCK; i++) {
-        state[i] = _mm512_xor_si512(state[i], block_XY[i]);
-        _mm512_storeu_si512((__m512i *)next_block->v + i, state[i]);
-    }
-}
-#elif defined(__AVX2__)
-static void fill_block(__m256i *state, const block *ref_block,
-                       block *next_block, int with_xor) {
-    __m256i block_XY[ARGON2_HWORDS_IN_BLOCK];
-    unsigned int i;
-
-    if (with_xor) {
-        for (i = 0; i < ARGON2_HWORDS_IN_BLOCK; i++) {
-            state[i] = _mm256_xor_si256(
-                state[i], _mm256_loadu_si256((const __m256i *)ref_block->v + i));
-            block_XY[i] = _mm256_xor_si256(
-                state[i], _mm256_loadu_si256((const __m256i *)next_block->v + i));
-        }
-    } else {
-        for (i = 0; i < ARGON2_HWORDS_IN_BLOCK; i++) {
-            block_XY[i] = state[i] = _mm256_xor_si256(
-                state[i], _mm256_loadu_si256((const __m256i *)ref_block->v + i));
-        }
-    }
-
-    for (i = 0; i < 4; ++i) {
-        BLAKE2_ROUND_1(state[8 * i + 0], state[8 * i + 4], state[8 * i + 1], state[8 * i + 5],
-                       state[8 * i + 2], state[8 * i + 6], state[8 * i + 3], state[8 * i + 7]);
-    }
-
-    for (i = 0; i < 4; ++i) {
-        BLAKE2_ROUND_2(state[ 0 + i], state[ 4 + i], state[ 8 + i], state[12 + i],
-                       state[16 + i], state[20 + i], state[24 + i], state[28 + i]);
-    }
-
-    for (i = 0; i < ARGON2_HWORDS_IN_BLOCK; i++) {
-        state[i] = _mm256_xor_si256(state[i], block_XY[i]);
-        _mm256_storeu_si256((__m256i *)next_block->v + i, state[i]);
-    }
-}
-#else
-static void fill_block(__m128i *state, const block *ref_block,
-                       block *next_block, int with_xor) {
-    __m128i block_XY[ARGON2_OWORDS_IN_BLOCK];
-    unsigned int i;
-
-    if (with_xor) {
-        for (i = 0; i < ARGON2_OWORDS_IN_BLOCK; i++) {
-            state[i] = _mm_xor_si128(
-                state[i], _mm_loadu_si128((const __m128i *)ref_block->v + i));
-            block_XY[i] = _mm_xor_si128(
-                state[i], _mm_loadu_si128((const __m128i *)next_block->v + i));
-        }
-    } else {
-        for (i = 0; i < ARGON2_OWORDS_IN_BLOCK; i++) {
-            block_XY[i] = state[i] = _mm_xor_si128(
-                state[i], _mm_loadu_si128((const __m128i *)ref_block->v + i));
-        }
-    }
-
-    for (i = 0; i < 8; ++i) {
-        BLAKE2_ROUND(state[8 * i + 0], state[8 * i + 1], state[8 * i + 2],
-            state[8 * i + 3], state[8 * i + 4], state[8 * i + 5],
-            state[8 * i + 6], state[8 * i + 7]);
-    }
-
-    for (i = 0; i < 8; ++i) {
-        BLAKE2_ROUND(state[8 * 0 + i], state[8 * 1 + i], state[8 * 2 + i],
-            state[8 * 3 + i], state[8 * 4 + i], state[8 * 5 + i],
-            state[8 * 6 + i], state[8 * 7 + i]);
-    }
+#if defined(HAVE_CONFIG_H)
+#include "config/dynamic-config.h"
+#endif
 
-    for (i = 0; i < ARGON2_OWORDS_IN_BLOCK; i++) {
-        state[i] = _mm_xor_si128(state[i], block_XY[i]);
-        _mm_storeu_si128((__m128i *)next_block->v + i, state[i]);
-    }
-}
+#if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
+#include <cpuid.h>
+#define ARGON2D_HAVE_CPUID
 #endif
 
-static void next_addresses(block *address_block, block *input_block) {
-    /*Temporary zero-initialized blocks*/
 #if defined(__AVX512F__)
-    __m512i zero_block[ARGON2_512BIT_WORDS_IN_BLOCK];
-    __m512i zero2_block[ARGON2_512BIT_WORDS_IN_BLOCK];
+#define ARGON2D_BASE_NAME "avx512f"
 #elif defined(__AVX2__)
-    __m256i zero_block[ARGON2_HWORDS_IN_BLOCK];
-    __m256i zero2_block[ARGON2_HWORDS_IN_BLOCK];
+#define ARGON2D_BASE_NAME "avx2"
+#elif defined(__SSSE3__)
+#define ARGON2D_BASE_NAME "ssse3"
 #else
-    __m128i zero_block[ARGON2_OWORDS_IN_BLOCK];
-    __m128i zero2_block[ARGON2_OWORDS_IN_BLOCK];
+#define ARGON2D_BASE_NAME "sse2"
 #endif
 
-    memset(zero_block, 0, sizeof(zero_block));
-    memset(zero2_block, 0, sizeof(zero2_block));
-
-    /*Increasing index counter*/
-    input_block->v[6]++;
+/* The dispatched kernels are only linked into the main crypto library */
+#if defined(BUILD_DYNAMIC_INTERNAL)
+#undef ENABLE_ARGON2D_AVX2
+#undef ENABLE_ARGON2D_AVX512F
+#endif
 
-    /*First iteration of G*/
-    fill_block(zero_block, input_block, address_block, 0);
+typedef void (*fill_segment_fptr)(const argon2_instance_t *instance,
+                                  argon2_position_t position);
 
-    /*Second iteration of G*/
-    fill_block(zero2_block, address_block, address_block, 0);
-}
+static fill_segment_fptr fill_segment_impl = fill_segment_base;
+static const char *fill_segment_impl_name = ARGON2D_BASE_NAME;
 
 void fill_segment(const argon2_instance_t *instance,
                   argon2_position_t position) {
-    block *ref_block = NULL, *curr_block = NULL;
-    block address_block, input_block;
-    uint64_t pseudo_rand, ref_index, ref_lane;
-    uint32_t prev_offset, curr_offset;
-    uint32_t starting_index, i;
-#if defined(__AVX512F__)
-    __m512i state[ARGON2_512BIT_WORDS_IN_BLOCK];
-#elif defined(__AVX2__)
-    __m256i state[ARGON2_HWORDS_IN_BLOCK];
-#else
-    __m128i state[ARGON2_OWORDS_IN_BLOCK];
-#endif
-    int data_independent_addressing;
-
-    if (instance == NULL) {
-        return;
-    }
+    fill_segment_impl(instance, position);
+}
 
-    data_independent_addressing =
-        (instance->type == Argon2_i) ||
-        (instance->type == Argon2_id && (position.pass == 0) &&
-         (position.slice < ARGON2_SYNC_POINTS / 2));
+#if defined(ARGON2D_HAVE_CPUID) && (defined(ENABLE_ARGON2D_AVX2) || defined(ENABLE_ARGON2D_AVX512F))
+/* We can't use cpuid.h's __get_cpuid as it does not support subleafs. */
+static void argon2d_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t *a,
+                          uint32_t *b, uint32_t *c, uint32_t *d) {
+    __cpuid_count(leaf, subleaf, *a, *b, *c, *d);
+}
 
-    starting_index = 0;
+/* Register state the OS saves on context switches */
+static uint32_t argon2d_xgetbv(void) {
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return a;
+}
 
-    if ((0 == position.pass) && (0 == position.slice)) {
-        starting_index = 2; /* we have already generated the first two blocks */
+/* Hashes a small fixed input with the given kernel */
+static int argon2d_test_hash(fill_segment_fptr impl, uint8_t *out) {
+    uint8_t input[16];
+    argon2_context context;
+    fill_segment_fptr previous = fill_segment_impl;
+    int result;
+
+    memset(input, 0x5a, sizeof(input));
+    memset(&context, 0, sizeof(context));
+    context.out = out;
+    context.outlen = 32;
+    context.pwd = input;
+    context.pwdlen = sizeof(input);
+    context.salt = input;
+    context.saltlen = sizeof(input);
+    context.flags = ARGON2_DEFAULT_FLAGS;
+    context.m_cost = 64;
+    context.lanes = 4;
+    context.threads = 1;
+    context.t_cost = 2;
+
+    fill_segment_impl = impl;
+    result = argon2_ctx(&context, Argon2_d);
+    fill_segment_impl = previous;
+    return result;
+}
 
-        /* Don't forget to generate the first block of addresses: */
-        if (data_independent_addressing) {
-            next_addresses(&address_block, &input_block);
-        }
+/* Checks that impl produces the same hash as the baseline kernel */
+static int argon2d_self_test(fill_segment_fptr impl) {
+    uint8_t expected[32], actual[32];
+    if (argon2d_test_hash(fill_segment_base, expected) != ARGON2_OK ||
+        argon2d_test_hash(impl, actual) != ARGON2_OK) {
+        return 0;
     }
+    return memcmp(expected, actual, sizeof(expected)) == 0;
+}
+#endif
 
-    /* Offset of the current block */
-    curr_offset = position.lane * instance->lane_length +
-                  position.slice * instance->segment_length + starting_index;
-
-    if (0 == curr_offset % instance->lane_length) {
-        /* Last block in this lane */
-        prev_offset = curr_offset + instance->lane_length - 1;
-    } else {
-        /* Previous block */
-        prev_offset = curr_offset - 1;
+const char *argon2d_select_impl(void) {
+    fill_segment_fptr impl = fill_segment_base;
+    const char *name = ARGON2D_BASE_NAME;
+#if defined(ARGON2D_HAVE_CPUID) && (defined(ENABLE_ARGON2D_AVX2) || defined(ENABLE_ARGON2D_AVX512F))
+    uint32_t eax, ebx, ecx, edx;
+    uint32_t xcr0 = 0;
+    int have_avx2 = 0;
+    int have_avx512f = 0;
+
+    argon2d_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    /* OSXSAVE and AVX */
+    if (((ecx >> 27) & 1) && ((ecx >> 28) & 1)) {
+        xcr0 = argon2d_xgetbv();
+    }
+    argon2d_cpuid(0, 0, &eax, &ebx, &ecx, &edx);
+    if (eax >= 7) {
+        argon2d_cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+        /* AVX2 needs the SSE and AVX state enabled, AVX-512 also the opmask and ZMM state */
+        have_avx2 = ((ebx >> 5) & 1) && (xcr0 & 0x6) == 0x6;
+        have_avx512f = ((ebx >> 16) & 1) && (xcr0 & 0xe6) == 0xe6;
+    }
+    (void)have_avx2;
+    (void)have_avx512f;
+
+#if defined(ENABLE_ARGON2D_AVX2)
+    if (have_avx2 && argon2d_self_test(fill_segment_avx2)) {
+        impl = fill_segment_avx2;
+        name = "avx2";
     }
+#endif
+#if defined(ENABLE_ARGON2D_AVX512F)
+    if (have_avx512f && argon2d_self_test(fill_segment_avx512f)) {
+        impl = fill_segment_avx512f;
+        name = "avx512f";
+    }
+#endif
+#endif
 
-    memcpy(state, ((instance->memory + prev_offset)->v), ARGON2_BLOCK_SIZE);
-
-    for (i = starting_index; i < instance->segment_length;
-         ++i, ++curr_offset, ++prev_offset) {
-        /*1.1 Rotating prev_offset if needed */
-        if (curr_offset % instance->lane_length == 1) {
-            prev_offset = curr_offset - 1;
-        }
-
-        /* 1.2 Computing the index of the reference block */
-        /* 1.2.1 Taking pseudo-random value from the previous block */
-        if (data_independent_addressing) {
-            if (i % ARGON2_ADDRESSES_IN_BLOCK == 0) {
-                next_addresses(&address_block, &input_block);
-            }
-            pseudo_rand = address_block.v[i % ARGON2_ADDRESSES_IN_BLOCK];
-        } else {
-            pseudo_rand = instance->memory[prev_offset].v[0];
-        }
-
-        /* 1.2.2 Computing the lane of the reference block */
-        ref_lane = ((pseudo_rand >> 32)) % instance->lanes;
-
-        if ((position.pass == 0) && (position.slice == 0)) {
-            /* Can not reference other lanes yet */
-            ref_lane = position.lane;
-        }
-
-        /* 1.2.3 Computing the number of possible reference block within the
-         * lane.
-         */
-        position.index = i;
-        ref_index = index_alpha(instance, &position, pseudo_rand & 0xFFFFFFFF,
-                                ref_lane == position.lane);
-
-        /* 2 Creating a new block */
-        ref_block =
-            instance->memory + instance->lane_length * ref_lane + ref_index;
-        curr_block = instance->memory + curr_offset;
+    fill_segment_impl = impl;
+    fill_segment_impl_name = name;
+    return fill_segment_impl_name;
+}
 
-        fill_block(state, ref_block, curr_block, 0);   
-    }
+const char *argon2d_impl_name(void) {
+    return fill_segment_impl_name;
 }
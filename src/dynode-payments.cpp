@@ -218,27 +218,266 @@ std::string GetRequiredPaymentsString(int nBlockHeight)
     return dnpayments.GetRequiredPaymentsString(nBlockHeight);
 }
 
+void CDynodeCoinbasePayees::GetBlockPayees(const CBlock& block, int nBlockHeight, std::vector<CScript>& vecPayeesRet)
+{
+    vecPayeesRet.clear();
+    if (block.vtx.empty())
+        return;
+
+    CAmount nDynodePayment = GetFluidDynodeReward(nBlockHeight);
+    for (const auto& txout : block.vtx[0]->vout)
+        if (txout.nValue == nDynodePayment)
+            vecPayeesRet.push_back(txout.scriptPubKey);
+}
+
+void CDynodeCoinbasePayees::AddBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    if (!pindex || vecRing.empty())
+        return;
+
+    CDynodeCoinbasePayee payee;
+    payee.nHeight = pindex->nHeight;
+    payee.blockHash = pindex->GetBlockHash();
+    GetBlockPayees(block, pindex->nHeight, payee.vecPayees);
+
+    LOCK(cs);
+    vecRing[pindex->nHeight % vecRing.size()] = payee;
+}
+
+bool CDynodeCoinbasePayees::GetPayees(const CBlockIndex* pindex, std::vector<CScript>& vecPayeesRet) const
+{
+    if (!pindex || vecRing.empty())
+        return false;
+
+    LOCK(cs);
+    const CDynodeCoinbasePayee& payee = vecRing[pindex->nHeight % vecRing.size()];
+    // the slot may hold an older height or a block from another branch
+    if (payee.nHeight != pindex->nHeight || payee.blockHash != pindex->GetBlockHash())
+        return false;
+
+    vecPayeesRet = payee.vecPayees;
+    return true;
+}
+
 void CDynodePayments::Clear()
 {
     LOCK2(cs_mapDynodeBlocks, cs_mapDynodePaymentVotes);
-    mapDynodeBlocks.clear();
     mapDynodePaymentVotes.clear();
+    vecBlockRing.assign(vecBlockRing.size(), CDynodeBlockPayees());
+    nBlockCount = 0;
+    vecVoters.clear();
+    vecFreeVoterIds.clear();
+    mapVoterIds.clear();
+    setDirtyVoteHashes.clear();
+}
+
+void CDynodePayments::GrowBlockRing(size_t nSize)
+{
+    AssertLockHeld(cs_mapDynodeBlocks);
+
+    if (vecBlockRing.size() >= nSize)
+        return;
+
+    // heights in a smaller ring are less than its size apart, so they can't share a slot in a larger one
+    std::vector<CDynodeBlockPayees> vecRing(nSize);
+    for (auto& blockPayees : vecBlockRing) {
+        if (blockPayees.nBlockHeight >= 0)
+            vecRing[blockPayees.nBlockHeight % nSize] = std::move(blockPayees);
+    }
+    vecBlockRing.swap(vecRing);
+}
+
+CDynodeBlockPayees* CDynodePayments::GetBlockSlot(int nBlockHeight)
+{
+    AssertLockHeld(cs_mapDynodeBlocks);
+    AssertLockHeld(cs_mapDynodePaymentVotes);
+
+    if (nBlockHeight < 0)
+        return NULL;
+
+    CDynodeBlockPayees& blockPayees = vecBlockRing[nBlockHeight % vecBlockRing.size()];
+    if (blockPayees.nBlockHeight == nBlockHeight)
+        return &blockPayees;
+    if (blockPayees.nBlockHeight > nBlockHeight)
+        return NULL;
+
+    EvictBlock(blockPayees);
+    blockPayees.nBlockHeight = nBlockHeight;
+    return &blockPayees;
+}
+
+void CDynodePayments::EvictBlock(CDynodeBlockPayees& blockPayees)
+{
+    AssertLockHeld(cs_mapDynodeBlocks);
+    AssertLockHeld(cs_mapDynodePaymentVotes);
+
+    if (blockPayees.nBlockHeight < 0)
+        return;
+
+    LogPrint("dnpayments", "CDynodePayments::EvictBlock -- Removing %d old Dynode payments: nBlockHeight=%d\n", (int)blockPayees.vecVoteHashes.size(), blockPayees.nBlockHeight);
+    for (const auto& nVoteHash : blockPayees.vecVoteHashes) {
+        mapDynodePaymentVotes.erase(nVoteHash);
+        setDirtyVoteHashes.erase(nVoteHash);
+    }
+    if (!blockPayees.vecPayees.empty())
+        nBlockCount--;
+    blockPayees = CDynodeBlockPayees();
+}
+
+uint32_t CDynodePayments::InternVoter(const COutPoint& outpoint, int nBlockHeight)
+{
+    AssertLockHeld(cs_mapDynodePaymentVotes);
+
+    auto res = mapVoterIds.emplace(outpoint, 0);
+    if (res.second) {
+        if (vecFreeVoterIds.empty()) {
+            res.first->second = vecVoters.size();
+            vecVoters.push_back(voter_t());
+        } else {
+            res.first->second = vecFreeVoterIds.back();
+            vecFreeVoterIds.pop_back();
+        }
+        vecVoters[res.first->second].outpoint = outpoint;
+    }
+
+    voter_t& voter = vecVoters[res.first->second];
+    voter.nMaxVoteHeight = std::max(voter.nMaxVoteHeight, nBlockHeight);
+    return res.first->second;
+}
+
+CDynodePaymentVote* CDynodePayments::StoreVote(const uint256& nVoteHash, const CDynodePaymentVote& vote, bool& fNewRet)
+{
+    AssertLockHeld(cs_mapDynodeBlocks);
+    AssertLockHeld(cs_mapDynodePaymentVotes);
+
+    fNewRet = false;
+    CDynodeBlockPayees* pblockPayees = GetBlockSlot(vote.nBlockHeight);
+    if (!pblockPayees)
+        return NULL;
+
+    auto res = mapDynodePaymentVotes.emplace(nVoteHash, vote);
+    if (res.second) {
+        pblockPayees->vecVoteHashes.push_back(nVoteHash);
+    }
+    fNewRet = res.second;
+    return &res.first->second;
+}
+
+void CDynodePayments::AddVoteToBlock(const CDynodePaymentVote& vote)
+{
+    AssertLockHeld(cs_mapDynodeBlocks);
+    AssertLockHeld(cs_mapDynodePaymentVotes);
+
+    // stored by StoreVote, so the slot holds the vote's height
+    CDynodeBlockPayees& blockPayees = vecBlockRing[vote.nBlockHeight % vecBlockRing.size()];
+    if (blockPayees.vecPayees.empty())
+        nBlockCount++;
+    blockPayees.AddPayee(vote.payee, InternVoter(vote.dynodeOutpoint, vote.nBlockHeight));
+}
+
+void CDynodePayments::GetStoredVotes(std::map<uint256, CDynodePaymentVote>& mapVotesRet, stored_blocks_t& mapBlocksRet) const
+{
+    LOCK2(cs_mapDynodeBlocks, cs_mapDynodePaymentVotes);
+
+    mapVotesRet.clear();
+    mapBlocksRet.clear();
+    mapVotesRet.insert(mapDynodePaymentVotes.begin(), mapDynodePaymentVotes.end());
+
+    for (const auto& blockPayees : vecBlockRing) {
+        if (blockPayees.vecPayees.empty())
+            continue;
+        auto& blockpair = mapBlocksRet[blockPayees.nBlockHeight];
+        blockpair.first = blockPayees.nBlockHeight;
+        for (const auto& payee : blockPayees.vecPayees) {
+            stored_payee_t storedPayee;
+            storedPayee.scriptPubKey = payee.GetPayee();
+            blockpair.second.push_back(storedPayee);
+        }
+        // every verified vote at the height was counted for its payee
+        for (const auto& nVoteHash : blockPayees.vecVoteHashes) {
+            const auto it = mapDynodePaymentVotes.find(nVoteHash);
+            if (it == mapDynodePaymentVotes.end() || !it->second.IsVerified())
+                continue;
+            for (auto& storedPayee : blockpair.second) {
+                if (storedPayee.scriptPubKey == it->second.payee) {
+                    storedPayee.vecVoteHashes.push_back(nVoteHash);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void CDynodePayments::LoadStoredVotes(const std::map<uint256, CDynodePaymentVote>& mapVotes, const stored_blocks_t& mapBlocks)
+{
+    int nRingSize = GetStorageLimit() + DNPAYMENTS_FUTURE_BLOCKS + 1;
+
+    LOCK2(cs_mapDynodeBlocks, cs_mapDynodePaymentVotes);
+
+    Clear();
+    GrowBlockRing(nRingSize);
+
+    for (const auto& votepair : mapVotes) {
+        bool fNew;
+        StoreVote(votepair.first, votepair.second, fNew);
+    }
+
+    // tallies are rebuilt in the order they were stored, so ties between payees resolve as before
+    for (const auto& blockpair : mapBlocks) {
+        for (const auto& storedPayee : blockpair.second.second) {
+            for (const auto& nVoteHash : storedPayee.vecVoteHashes) {
+                const auto it = mapDynodePaymentVotes.find(nVoteHash);
+                if (it != mapDynodePaymentVotes.end() && it->second.IsVerified() && it->second.nBlockHeight == blockpair.first)
+                    AddVoteToBlock(it->second);
+            }
+        }
+    }
+}
+
+void CDynodePayments::AddJournalVote(const CDynodePaymentVote& vote)
+{
+    LOCK2(cs_mapDynodeBlocks, cs_mapDynodePaymentVotes);
+
+    bool fNew;
+    CDynodePaymentVote* pvote = StoreVote(vote.GetHash(), vote, fNew);
+    if (!pvote)
+        return;
+
+    // a vote verified after it was first written, count it like AddOrUpdatePaymentVote does
+    if (vote.IsVerified() && (fNew || !pvote->IsVerified())) {
+        *pvote = vote;
+        AddVoteToBlock(vote);
+    }
+}
+
+void CDynodePayments::ClearJournal()
+{
+    LOCK(cs_mapDynodePaymentVotes);
+    setDirtyVoteHashes.clear();
 }
 
 bool CDynodePayments::UpdateLastVote(const CDynodePaymentVote& vote)
 {
     LOCK(cs_mapDynodePaymentVotes);
 
-    const auto it = mapDynodesLastVote.find(vote.dynodeOutpoint);
-    if (it != mapDynodesLastVote.end()) {
-        if (it->second == vote.nBlockHeight)
-            return false;
-        it->second = vote.nBlockHeight;
-        return true;
-    }
+    voter_t& voter = vecVoters[InternVoter(vote.dynodeOutpoint, vote.nBlockHeight)];
+    if (voter.nLastVoteHeight == vote.nBlockHeight)
+        return false;
 
     //record this dynode voted
-    mapDynodesLastVote.emplace(vote.dynodeOutpoint, vote.nBlockHeight);
+    voter.nLastVoteHeight = vote.nBlockHeight;
+    return true;
+}
+
+bool CDynodePayments::GetLastVote(const COutPoint& outpoint, int& nBlockHeightRet) const
+{
+    LOCK(cs_mapDynodePaymentVotes);
+
+    const auto it = mapVoterIds.find(outpoint);
+    if (it == mapVoterIds.end() || vecVoters[it->second].nLastVoteHeight < 0)
+        return false;
+
+    nBlockHeightRet = vecVoters[it->second].nLastVoteHeight;
     return true;
 }
 
@@ -315,15 +554,16 @@ void CDynodePayments::ProcessMessage(CNode* pfrom, const std::string& strCommand
             vRecv >> nCountNeeded;
         }
 
+        static const int nPaymentSyncRequestId = CNetFulfilledRequestManager::GetRequestId(NetMsgType::DYNODEPAYMENTSYNC);
 
-        if (netfulfilledman.HasFulfilledRequest(pfrom->addr, NetMsgType::DYNODEPAYMENTSYNC)) {
+        if (netfulfilledman.HasFulfilledRequest(pfrom->addr, nPaymentSyncRequestId)) {
             // Asking for the payments list multiple times in a short period of time is no good
             LogPrintf("DYNODEPAYMENTSYNC -- peer already asked me for the list, peer=%d\n", pfrom->id);
             Misbehaving(pfrom->GetId(), 20);
             return;
         }
 
-        netfulfilledman.AddFulfilledRequest(pfrom->addr, NetMsgType::DYNODEPAYMENTSYNC);
+        netfulfilledman.AddFulfilledRequest(pfrom->addr, nPaymentSyncRequestId);
 
         Sync(pfrom, connman);
         LogPrintf("DYNODEPAYMENTSYNC -- Sent Dynode payment votes to peer %d\n", pfrom->id);
@@ -349,13 +589,28 @@ void CDynodePayments::ProcessMessage(CNode* pfrom, const std::string& strCommand
         if (!dynodeSync.IsDynodeListSynced())
             return;
 
+        // checked before the vote is stored, so it can't take the ring slot of a height in the window
+        int nFirstBlock = nCachedBlockHeight - GetStorageLimit();
+        if (vote.nBlockHeight < nFirstBlock || vote.nBlockHeight > nCachedBlockHeight + DNPAYMENTS_FUTURE_BLOCKS) {
+            LogPrint("dnpayments", "DYNODEPAYMENTVOTE -- vote out of range: nFirstBlock=%d, nBlockHeight=%d, nHeight=%d\n", nFirstBlock, vote.nBlockHeight, nCachedBlockHeight);
+            return;
+        }
+
         {
-            LOCK(cs_mapDynodePaymentVotes);
+            LOCK2(cs_mapDynodeBlocks, cs_mapDynodePaymentVotes);
 
-            auto res = mapDynodePaymentVotes.emplace(nHash, vote);
+            bool fNew;
+            CDynodePaymentVote* pvote = StoreVote(nHash, vote, fNew);
+            if (!pvote) {
+                LogPrint("dnpayments", "DYNODEPAYMENTVOTE -- no slot for vote: nBlockHeight=%d, nHeight=%d\n", vote.nBlockHeight, nCachedBlockHeight);
+                return;
+            }
+            if (fNew) {
+                setDirtyVoteHashes.insert(nHash);
+            }
 
             // Avoid processing same vote multiple times if it was already verified earlier
-            if (!res.second && res.first->second.IsVerified()) {
+            if (!fNew && pvote->IsVerified()) {
                 LogPrint("dnpayments", "DYNODEPAYMENTVOTE -- hash=%s, nBlockHeight=%d/%d seen\n",
                     nHash.ToString(), vote.nBlockHeight, nCachedBlockHeight);
                 return;
@@ -363,13 +618,7 @@ void CDynodePayments::ProcessMessage(CNode* pfrom, const std::string& strCommand
 
             // Mark vote as non-verified when it's seen for the first time,
             // AddOrUpdatePaymentVote() below should take care of it if vote is actually ok
-            res.first->second.MarkAsNotVerified();
-        }
-
-        int nFirstBlock = nCachedBlockHeight - GetStorageLimit();
-        if (vote.nBlockHeight < nFirstBlock || vote.nBlockHeight > nCachedBlockHeight + 20) {
-            LogPrint("dnpayments", "DYNODEPAYMENTVOTE -- vote out of range: nFirstBlock=%d, nBlockHeight=%d, nHeight=%d\n", nFirstBlock, vote.nBlockHeight, nCachedBlockHeight);
-            return;
+            pvote->MarkAsNotVerified();
         }
 
         std::string strError = "";
@@ -479,32 +728,37 @@ bool CDynodePayments::GetBlockPayee(int nBlockHeight, CScript& payeeRet) const
 {
     LOCK(cs_mapDynodeBlocks);
 
-    auto it = mapDynodeBlocks.find(nBlockHeight);
-    return it != mapDynodeBlocks.end() && it->second.GetBestPayee(payeeRet);
+    const CDynodeBlockPayees* pblockPayees = GetBlockPayees(nBlockHeight);
+    return pblockPayees && pblockPayees->GetBestPayee(payeeRet);
 }
 
 // Is this Dynode scheduled to get paid soon?
 // -- Only look ahead up to 8 blocks to allow for propagation of the latest 2 blocks of votes
 bool CDynodePayments::IsScheduled(const dynode_info_t& dnInfo, int nNotBlockHeight) const
+{
+    std::set<CScript> setPayees;
+    GetScheduledPayees(nNotBlockHeight, setPayees);
+
+    return setPayees.count(GetScriptForDestination(dnInfo.pubKeyCollateralAddress.GetID())) > 0;
+}
+
+void CDynodePayments::GetScheduledPayees(int nNotBlockHeight, std::set<CScript>& setPayeesRet) const
 {
     LOCK(cs_mapDynodeBlocks);
 
-    if (!dynodeSync.IsDynodeListSynced())
-        return false;
+    setPayeesRet.clear();
 
-    CScript dnpayee;
-    dnpayee = GetScriptForDestination(dnInfo.pubKeyCollateralAddress.GetID());
+    if (!dynodeSync.IsDynodeListSynced())
+        return;
 
     CScript payee;
     for (int64_t h = nCachedBlockHeight; h <= nCachedBlockHeight + 8; h++) {
         if (h == nNotBlockHeight)
             continue;
-        if (GetBlockPayee(h, payee) && dnpayee == payee) {
-            return true;
+        if (GetBlockPayee(h, payee)) {
+            setPayeesRet.insert(payee);
         }
     }
-
-    return false;
 }
 
 bool CDynodePayments::AddOrUpdatePaymentVote(const CDynodePaymentVote& vote)
@@ -520,16 +774,26 @@ bool CDynodePayments::AddOrUpdatePaymentVote(const CDynodePaymentVote& vote)
 
     LOCK2(cs_mapDynodeBlocks, cs_mapDynodePaymentVotes);
 
-    mapDynodePaymentVotes[nVoteHash] = vote;
+    bool fNew;
+    CDynodePaymentVote* pvote = StoreVote(nVoteHash, vote, fNew);
+    if (!pvote)
+        return false;
+    *pvote = vote;
+    setDirtyVoteHashes.insert(nVoteHash);
 
-    auto it = mapDynodeBlocks.emplace(vote.nBlockHeight, CDynodeBlockPayees(vote.nBlockHeight)).first;
-    it->second.AddPayee(vote);
+    AddVoteToBlock(vote);
 
     LogPrint("dnpayments", "CDynodePayments::AddOrUpdatePaymentVote -- added, hash=%s\n", nVoteHash.ToString());
 
     return true;
 }
 
+bool CDynodePayments::HasPaymentVote(const uint256& hashIn) const
+{
+    LOCK(cs_mapDynodePaymentVotes);
+    return mapDynodePaymentVotes.count(hashIn);
+}
+
 bool CDynodePayments::HasVerifiedPaymentVote(const uint256& hashIn) const
 {
     LOCK(cs_mapDynodePaymentVotes);
@@ -537,19 +801,58 @@ bool CDynodePayments::HasVerifiedPaymentVote(const uint256& hashIn) const
     return it != mapDynodePaymentVotes.end() && it->second.IsVerified();
 }
 
-void CDynodeBlockPayees::AddPayee(const CDynodePaymentVote& vote)
+bool CDynodePayments::GetVerifiedPaymentVote(const uint256& hashIn, CDynodePaymentVote& voteRet) const
 {
-    LOCK(cs_vecPayees);
+    LOCK(cs_mapDynodePaymentVotes);
+    const auto it = mapDynodePaymentVotes.find(hashIn);
+    if (it == mapDynodePaymentVotes.end() || !it->second.IsVerified())
+        return false;
 
-    uint256 nVoteHash = vote.GetHash();
+    voteRet = it->second;
+    return true;
+}
+
+bool CDynodePayments::GetBlockVotes(int nBlockHeight, std::vector<CDynodePaymentVote>& vecVotesRet) const
+{
+    LOCK2(cs_mapDynodeBlocks, cs_mapDynodePaymentVotes);
+
+    vecVotesRet.clear();
+    const CDynodeBlockPayees* pblockPayees = GetBlockPayees(nBlockHeight);
+    if (!pblockPayees)
+        return false;
+
+    for (const auto& nVoteHash : pblockPayees->vecVoteHashes) {
+        const auto it = mapDynodePaymentVotes.find(nVoteHash);
+        if (it != mapDynodePaymentVotes.end() && it->second.IsVerified())
+            vecVotesRet.push_back(it->second);
+    }
+    return true;
+}
+
+const CDynodeBlockPayees* CDynodePayments::GetBlockPayees(int nBlockHeight) const
+{
+    AssertLockHeld(cs_mapDynodeBlocks);
+
+    if (nBlockHeight < 0)
+        return NULL;
+
+    const CDynodeBlockPayees& blockPayees = vecBlockRing[nBlockHeight % vecBlockRing.size()];
+    if (blockPayees.nBlockHeight != nBlockHeight || blockPayees.vecPayees.empty())
+        return NULL;
+    return &blockPayees;
+}
+
+void CDynodeBlockPayees::AddPayee(const CScript& payeeIn, uint32_t nVoterId)
+{
+    LOCK(cs_vecPayees);
 
     for (auto& payee : vecPayees) {
-        if (payee.GetPayee() == vote.payee) {
-            payee.AddVoteHash(nVoteHash);
+        if (payee.GetPayee() == payeeIn) {
+            payee.AddVoter(nVoterId);
             return;
         }
     }
-    CDynodePayee payeeNew(vote.payee, nVoteHash);
+    CDynodePayee payeeNew(payeeIn, nVoterId);
     vecPayees.push_back(payeeNew);
 }
 
@@ -659,16 +962,16 @@ std::string CDynodePayments::GetRequiredPaymentsString(int nBlockHeight) const
 {
     LOCK(cs_mapDynodeBlocks);
 
-    const auto it = mapDynodeBlocks.find(nBlockHeight);
-    return it == mapDynodeBlocks.end() ? "Unknown" : it->second.GetRequiredPaymentsString();
+    const CDynodeBlockPayees* pblockPayees = GetBlockPayees(nBlockHeight);
+    return pblockPayees ? pblockPayees->GetRequiredPaymentsString() : "Unknown";
 }
 
 bool CDynodePayments::IsTransactionValid(const CTransaction& txNew, int nBlockHeight) const
 {
     LOCK(cs_mapDynodeBlocks);
 
-    const auto it = mapDynodeBlocks.find(nBlockHeight);
-    return it == mapDynodeBlocks.end() ? true : it->second.IsTransactionValid(txNew, nBlockHeight);
+    const CDynodeBlockPayees* pblockPayees = GetBlockPayees(nBlockHeight);
+    return pblockPayees ? pblockPayees->IsTransactionValid(txNew, nBlockHeight) : true;
 }
 
 void CDynodePayments::CheckAndRemove()
@@ -676,21 +979,27 @@ void CDynodePayments::CheckAndRemove()
     if (!dynodeSync.IsBlockchainSynced())
         return;
 
+    int nStorageLimit = GetStorageLimit();
+    int nFirstBlock = nCachedBlockHeight - nStorageLimit;
+
     LOCK2(cs_mapDynodeBlocks, cs_mapDynodePaymentVotes);
 
-    int nLimit = GetStorageLimit();
+    // the window grows with the Dynode count, the ring has to hold all of it
+    GrowBlockRing(nStorageLimit + DNPAYMENTS_FUTURE_BLOCKS + 1);
 
-    std::map<uint256, CDynodePaymentVote>::iterator it = mapDynodePaymentVotes.begin();
-    while (it != mapDynodePaymentVotes.end()) {
-        CDynodePaymentVote vote = (*it).second;
+    for (auto& blockPayees : vecBlockRing) {
+        if (blockPayees.nBlockHeight >= 0 && blockPayees.nBlockHeight < nFirstBlock)
+            EvictBlock(blockPayees);
+    }
 
-        if (nCachedBlockHeight - vote.nBlockHeight > nLimit) {
-            LogPrint("dnpayments", "CDynodePayments::CheckAndRemove -- Removing old Dynode payment: nBlockHeight=%d\n", vote.nBlockHeight);
-            mapDynodePaymentVotes.erase(it++);
-            mapDynodeBlocks.erase(vote.nBlockHeight);
-        } else {
-            ++it;
-        }
+    // votes below the window are rejected anyway, so their voters need no tracking
+    for (uint32_t nVoterId = 0; nVoterId < vecVoters.size(); nVoterId++) {
+        voter_t& voter = vecVoters[nVoterId];
+        if (voter.outpoint.IsNull() || voter.nMaxVoteHeight >= nFirstBlock)
+            continue;
+        mapVoterIds.erase(voter.outpoint);
+        voter = voter_t();
+        vecFreeVoterIds.push_back(nVoterId);
     }
     LogPrint("dnpayments", "CDynodePayments::CheckAndRemove -- %s\n", ToString());
 }
@@ -837,28 +1146,26 @@ void CDynodePayments::CheckBlockVotes(int nBlockHeight)
 
     LOCK2(cs_mapDynodeBlocks, cs_mapDynodePaymentVotes);
 
+    // Payees voted for at this height, by voter
+    std::map<COutPoint, CScript> mapVoterPayees;
+    const CDynodeBlockPayees* pblockPayees = GetBlockPayees(nBlockHeight);
+    if (pblockPayees) {
+        for (const auto& p : pblockPayees->vecPayees) {
+            for (const auto nVoterId : p.GetVoterIds()) {
+                mapVoterPayees.emplace(vecVoters[nVoterId].outpoint, p.GetPayee());
+            }
+        }
+    }
+
     int i{0};
     for (const auto& dn : dns) {
         CScript payee;
         bool found = false;
 
-        const auto it = mapDynodeBlocks.find(nBlockHeight);
-        if (it != mapDynodeBlocks.end()) {
-            for (const auto& p : it->second.vecPayees) {
-                for (const auto& voteHash : p.GetVoteHashes()) {
-                    const auto itVote = mapDynodePaymentVotes.find(voteHash);
-                    if (itVote == mapDynodePaymentVotes.end()) {
-                        debugStr += strprintf("    - could not find vote %s\n",
-                            voteHash.ToString());
-                        continue;
-                    }
-                    if (itVote->second.dynodeOutpoint == dn.second.outpoint) {
-                        payee = itVote->second.payee;
-                        found = true;
-                        break;
-                    }
-                }
-            }
+        const auto itVoter = mapVoterPayees.find(dn.second.outpoint);
+        if (itVoter != mapVoterPayees.end()) {
+            payee = itVoter->second;
+            found = true;
         }
 
         if (found) {
@@ -970,16 +1277,13 @@ void CDynodePayments::Sync(CNode* pnode, CConnman& connman) const
     int nInvCount = 0;
 
     for (int h = nCachedBlockHeight; h < nCachedBlockHeight + 20; h++) {
-        const auto it = mapDynodeBlocks.find(h);
-        if (it != mapDynodeBlocks.end()) {
-            for (const auto& payee : it->second.vecPayees) {
-                std::vector<uint256> vecVoteHashes = payee.GetVoteHashes();
-                for (const auto& hash : vecVoteHashes) {
-                    if (!HasVerifiedPaymentVote(hash))
-                        continue;
-                    pnode->PushInventory(CInv(MSG_DYNODE_PAYMENT_VOTE, hash));
-                    nInvCount++;
-                }
+        const CDynodeBlockPayees* pblockPayees = GetBlockPayees(h);
+        if (pblockPayees) {
+            for (const auto& hash : pblockPayees->vecVoteHashes) {
+                if (!HasVerifiedPaymentVote(hash))
+                    continue;
+                pnode->PushInventory(CInv(MSG_DYNODE_PAYMENT_VOTE, hash));
+                nInvCount++;
             }
         }
     }
@@ -994,36 +1298,43 @@ void CDynodePayments::RequestLowDataPaymentBlocks(CNode* pnode, CConnman& connma
     if (!dynodeSync.IsDynodeListSynced())
         return;
 
+    std::vector<CInv> vToFetch;
+    GetLowDataPaymentBlocks(vToFetch);
+
     CNetMsgMaker msgMaker(pnode->GetSendVersion());
+    // We should not violate GETDATA rules
+    for (size_t nBatchStart = 0; nBatchStart < vToFetch.size(); nBatchStart += MAX_INV_SZ) {
+        std::vector<CInv> vBatch(vToFetch.begin() + nBatchStart, vToFetch.begin() + std::min(vToFetch.size(), nBatchStart + MAX_INV_SZ));
+        LogPrint("dnpayments", "CDynodePayments::SyncLowDataPaymentBlocks -- asking peer %d for %d payment blocks\n", pnode->id, vBatch.size());
+        connman.PushMessage(pnode, msgMaker.Make(NetMsgType::GETDATA, vBatch));
+    }
+}
+
+void CDynodePayments::GetLowDataPaymentBlocks(std::vector<CInv>& vToFetchRet) const
+{
     LOCK2(cs_main, cs_mapDynodeBlocks);
 
-    std::vector<CInv> vToFetch;
+    vToFetchRet.clear();
     int nLimit = GetStorageLimit();
 
     const CBlockIndex* pindex = chainActive.Tip();
 
-    while (nCachedBlockHeight - pindex->nHeight < nLimit) {
-        if (!mapDynodeBlocks.count(pindex->nHeight)) {
+    while (pindex && nCachedBlockHeight - pindex->nHeight < nLimit) {
+        if (!GetBlockPayees(pindex->nHeight)) {
             // We have no idea about this block height, let's ask
-            vToFetch.push_back(CInv(MSG_DYNODE_PAYMENT_BLOCK, pindex->GetBlockHash()));
-            // We should not violate GETDATA rules
-            if (vToFetch.size() == MAX_INV_SZ) {
-                LogPrint("dnpayments", "CDynodePayments::SyncLowDataPaymentBlocks -- asking peer %d for %d blocks\n", pnode->id, MAX_INV_SZ);
-                connman.PushMessage(pnode, msgMaker.Make(NetMsgType::GETDATA, vToFetch));
-                // Start filling new batch
-                vToFetch.clear();
-            }
+            vToFetchRet.push_back(CInv(MSG_DYNODE_PAYMENT_BLOCK, pindex->GetBlockHash()));
         }
-        if (!pindex->pprev)
-            break;
         pindex = pindex->pprev;
     }
 
-    for (auto& dnBlockPayees : mapDynodeBlocks) {
-        int nBlockHeight = dnBlockPayees.first;
+    // only the heights in the storage window are visited, older ones are left to CheckAndRemove
+    for (int nBlockHeight = std::max(nCachedBlockHeight - nLimit, 0); nBlockHeight <= nCachedBlockHeight + DNPAYMENTS_FUTURE_BLOCKS; nBlockHeight++) {
+        const CDynodeBlockPayees* pblockPayees = GetBlockPayees(nBlockHeight);
+        if (!pblockPayees)
+            continue;
         int nTotalVotes = 0;
         bool fFound = false;
-        for (const auto& payee : dnBlockPayees.second.vecPayees) {
+        for (const auto& payee : pblockPayees->vecPayees) {
             if (payee.GetVoteCount() >= DNPAYMENTS_SIGNATURES_REQUIRED) {
                 fFound = true;
                 break;
@@ -1040,30 +1351,18 @@ void CDynodePayments::RequestLowDataPaymentBlocks(CNode* pnode, CConnman& connma
         DBG(
             // Let's see why this failed
             for (const auto& payee
-                 : dnBlockPayees.second.vecPayees) {
+                 : pblockPayees->vecPayees) {
                 CTxDestination address1;
                 ExtractDestination(payee.GetPayee(), address1);
                 CDynamicAddress address2(address1);
                 printf("payee %s votes %d\n", address2.ToString().c_str(), payee.GetVoteCount());
-            } printf("block %d votes total %d\n", it->first, nTotalVotes);)
+            } printf("block %d votes total %d\n", nBlockHeight, nTotalVotes);)
         // END DEBUG
         // Low data block found, let's try to sync it
         uint256 hash;
         if (GetBlockHash(hash, nBlockHeight)) {
-            vToFetch.push_back(CInv(MSG_DYNODE_PAYMENT_BLOCK, hash));
+            vToFetchRet.push_back(CInv(MSG_DYNODE_PAYMENT_BLOCK, hash));
         }
-        // We should not violate GETDATA rules
-        if (vToFetch.size() == MAX_INV_SZ) {
-            LogPrint("dnpayments", "CDynodePayments::SyncLowDataPaymentBlocks -- asking peer %d for %d payment blocks\n", pnode->id, MAX_INV_SZ);
-            connman.PushMessage(pnode, msgMaker.Make(NetMsgType::GETDATA, vToFetch));
-            // Start filling new batch
-            vToFetch.clear();
-        }
-    }
-    // Ask for the rest of it
-    if (!vToFetch.empty()) {
-        LogPrint("dnpayments", "CDynodePayments::SyncLowDataPaymentBlocks -- asking peer %d for %d payment blocks\n", pnode->id, vToFetch.size());
-        connman.PushMessage(pnode, msgMaker.Make(NetMsgType::GETDATA, vToFetch));
     }
 }
 
@@ -1071,7 +1370,7 @@ std::string CDynodePayments::ToString() const
 {
     std::ostringstream info;
 
-    info << "Votes: " << (int)mapDynodePaymentVotes.size() << ", Blocks: " << (int)mapDynodeBlocks.size();
+    info << "Votes: " << (int)mapDynodePaymentVotes.size() << ", Blocks: " << nBlockCount;
 
     return info.str();
 }
@@ -6,19 +6,25 @@
 #ifndef DYNAMIC_DYNODE_PAYMENTS_H
 #define DYNAMIC_DYNODE_PAYMENTS_H
 
+#include "coins.h"
 #include "core_io.h"
 #include "dynode.h"
 #include "key.h"
 #include "net_processing.h"
+#include "saltedhasher.h"
 #include "util.h"
 #include "utilstrencodings.h"
 
+#include <unordered_map>
+
 class CDynodeBlockPayees;
 class CDynodePayments;
 class CDynodePaymentVote;
 
 static const int DNPAYMENTS_SIGNATURES_REQUIRED = 10;
 static const int DNPAYMENTS_SIGNATURES_TOTAL = 20;
+// votes are accepted for up to this many blocks past the tip
+static const int DNPAYMENTS_FUTURE_BLOCKS = 20;
 
 //! minimum peer version that can receive and send dynode payment messages,
 //  vote for dynode and be elected as a payment winner
@@ -27,9 +33,12 @@ static const int DNPAYMENTS_SIGNATURES_TOTAL = 20;
 static const int MIN_DYNODE_PAYMENT_PROTO_VERSION_1 = 70900;
 static const int MIN_DYNODE_PAYMENT_PROTO_VERSION_2 = 71050; // Only Dynodes > v2.4.4.0 will get paid after Spork 10 activation
 
+// number of recent blocks whose coinbase dynode payees are kept in memory
+static const int DYNODE_COINBASE_PAYEES_SIZE = 10000;
+
 extern CCriticalSection cs_vecPayees;
 extern CCriticalSection cs_mapDynodeBlocks;
-extern CCriticalSection cs_mapDynodePayeeVotes;
+extern CCriticalSection cs_mapDynodePaymentVotes;
 
 extern CDynodePayments dnpayments;
 
@@ -43,62 +52,50 @@ class CDynodePayee
 {
 private:
     CScript scriptPubKey;
-    std::vector<uint256> vecVoteHashes;
+    // interned outpoints of the Dynodes which voted for this payee, see CDynodePayments::InternVoter
+    std::vector<uint32_t> vecVoterIds;
 
 public:
     CDynodePayee() : scriptPubKey(),
-                     vecVoteHashes()
+                     vecVoterIds()
     {
     }
 
-    CDynodePayee(CScript payee, uint256 hashIn) : scriptPubKey(payee),
-                                                  vecVoteHashes()
-    {
-        vecVoteHashes.push_back(hashIn);
-    }
-
-    ADD_SERIALIZE_METHODS;
-
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream& s, Operation ser_action)
+    CDynodePayee(const CScript& payee, uint32_t nVoterId) : scriptPubKey(payee),
+                                                            vecVoterIds()
     {
-        READWRITE(*(CScriptBase*)(&scriptPubKey));
-        READWRITE(vecVoteHashes);
+        vecVoterIds.push_back(nVoterId);
     }
 
     CScript GetPayee() const { return scriptPubKey; }
 
-    void AddVoteHash(uint256 hashIn) { vecVoteHashes.push_back(hashIn); }
-    std::vector<uint256> GetVoteHashes() const { return vecVoteHashes; }
-    int GetVoteCount() const { return vecVoteHashes.size(); }
+    void AddVoter(uint32_t nVoterId) { vecVoterIds.push_back(nVoterId); }
+    const std::vector<uint32_t>& GetVoterIds() const { return vecVoterIds; }
+    int GetVoteCount() const { return vecVoterIds.size(); }
 };
 
-// Keep track of votes for payees from Dynodes
+// Keep track of votes for payees from Dynodes at one block height
 class CDynodeBlockPayees
 {
 public:
+    // -1 while the ring slot holding it is unused
     int nBlockHeight;
     std::vector<CDynodePayee> vecPayees;
+    // every vote stored for this height, verified or not
+    std::vector<uint256> vecVoteHashes;
 
-    CDynodeBlockPayees() : nBlockHeight(0),
-                           vecPayees()
+    CDynodeBlockPayees() : nBlockHeight(-1),
+                           vecPayees(),
+                           vecVoteHashes()
     {
     }
     CDynodeBlockPayees(int nBlockHeightIn) : nBlockHeight(nBlockHeightIn),
-                                             vecPayees()
-    {
-    }
-
-    ADD_SERIALIZE_METHODS;
-
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream& s, Operation ser_action)
+                                             vecPayees(),
+                                             vecVoteHashes()
     {
-        READWRITE(nBlockHeight);
-        READWRITE(vecPayees);
     }
 
-    void AddPayee(const CDynodePaymentVote& vote);
+    void AddPayee(const CScript& payee, uint32_t nVoterId);
     bool GetBestPayee(CScript& payeeRet) const;
     bool HasPayeeWithVotes(const CScript& payeeIn, int nVotesReq) const;
 
@@ -173,14 +170,80 @@ public:
     std::string ToString() const;
 };
 
+// Dynode payees found in the coinbase of one connected block
+class CDynodeCoinbasePayee
+{
+public:
+    int nHeight;
+    uint256 blockHash;
+    // coinbase outputs paying the dynode reward of the block
+    std::vector<CScript> vecPayees;
+
+    CDynodeCoinbasePayee() : nHeight(-1), blockHash(), vecPayees() {}
+};
+
+//
+// Coinbase dynode payees of recently connected blocks, kept in a fixed size ring
+// indexed by height so last paid blocks can be found without reading blocks back
+//
+class CDynodeCoinbasePayees
+{
+private:
+    mutable CCriticalSection cs;
+    std::vector<CDynodeCoinbasePayee> vecRing;
+
+public:
+    CDynodeCoinbasePayees(size_t nSize) : vecRing(nSize) {}
+
+    static void GetBlockPayees(const CBlock& block, int nBlockHeight, std::vector<CScript>& vecPayeesRet);
+
+    void AddBlock(const CBlock& block, const CBlockIndex* pindex);
+    // Returns false if the block was overwritten or never added
+    bool GetPayees(const CBlockIndex* pindex, std::vector<CScript>& vecPayeesRet) const;
+};
+
 //
 // Dynode Payments Class
 // Keeps track of who should get paid for which blocks
 //
+// Vote tallies of the heights in the storage window are kept in a ring indexed by height,
+// a slot is evicted with all its votes when its height falls out of the window or a newer
+// height takes it over. Tallies refer to the Dynodes which voted by interned ids, which are
+// released once a Dynode has no votes left in the window.
+//
 
 class CDynodePayments
 {
 private:
+    // a Dynode which voted at a height in the window
+    struct voter_t {
+        // null while the id is free
+        COutPoint outpoint;
+        // height of the last vote processed from it, see UpdateLastVote
+        int nLastVoteHeight;
+        // highest height it voted at
+        int nMaxVoteHeight;
+
+        voter_t() : outpoint(), nLastVoteHeight(-1), nMaxVoteHeight(-1) {}
+    };
+
+    // a payee with the hashes of its votes, the form tallies are stored in on disk
+    struct stored_payee_t {
+        CScript scriptPubKey;
+        std::vector<uint256> vecVoteHashes;
+
+        ADD_SERIALIZE_METHODS;
+
+        template <typename Stream, typename Operation>
+        inline void SerializationOp(Stream& s, Operation ser_action)
+        {
+            READWRITE(*(CScriptBase*)(&scriptPubKey));
+            READWRITE(vecVoteHashes);
+        }
+    };
+    // height -> (height, payees), serialized like the map of CDynodeBlockPayees it replaced
+    typedef std::map<int, std::pair<int, std::vector<stored_payee_t> > > stored_blocks_t;
+
     // Dynode count times nStorageCoeff payments blocks should be stored ...
     const float nStorageCoeff;
     // ... but at least nMinBlocksToStore (payments blocks)
@@ -189,39 +252,118 @@ private:
     // Keep track of current block height
     int nCachedBlockHeight;
 
+    std::unordered_map<uint256, CDynodePaymentVote, SaltedTxidHasher> mapDynodePaymentVotes;
+    // vote tallies by height modulo the ring size, a slot belongs to the height it holds
+    std::vector<CDynodeBlockPayees> vecBlockRing;
+    // slots with at least one payee
+    int nBlockCount;
+
+    std::vector<voter_t> vecVoters;
+    std::vector<uint32_t> vecFreeVoterIds;
+    std::unordered_map<COutPoint, uint32_t, SaltedOutpointHasher> mapVoterIds;
+
+    // Votes added or verified since they were last written to disk
+    std::set<uint256> setDirtyVoteHashes;
+
+    void GrowBlockRing(size_t nSize);
+    // Returns NULL if a newer height holds the slot of nBlockHeight, evicts an older one
+    CDynodeBlockPayees* GetBlockSlot(int nBlockHeight);
+    void EvictBlock(CDynodeBlockPayees& blockPayees);
+    uint32_t InternVoter(const COutPoint& outpoint, int nBlockHeight);
+    // Returns NULL if the vote's height can't be stored, fNewRet is false if the hash was known
+    CDynodePaymentVote* StoreVote(const uint256& nVoteHash, const CDynodePaymentVote& vote, bool& fNewRet);
+    void AddVoteToBlock(const CDynodePaymentVote& vote);
+
+    void GetStoredVotes(std::map<uint256, CDynodePaymentVote>& mapVotesRet, stored_blocks_t& mapBlocksRet) const;
+    void LoadStoredVotes(const std::map<uint256, CDynodePaymentVote>& mapVotes, const stored_blocks_t& mapBlocks);
+
 public:
-    std::map<uint256, CDynodePaymentVote> mapDynodePaymentVotes;
-    std::map<int, CDynodeBlockPayees> mapDynodeBlocks;
-    std::map<COutPoint, int> mapDynodesLastVote;
     std::map<COutPoint, int> mapDynodesDidNotVote;
-
-    CDynodePayments() : nStorageCoeff(1.25), nMinBlocksToStore(5000) {}
+    CDynodeCoinbasePayees coinbasePayees;
+
+    CDynodePayments() : nStorageCoeff(1.25),
+                        nMinBlocksToStore(5000),
+                        nCachedBlockHeight(0),
+                        vecBlockRing(nMinBlocksToStore + DNPAYMENTS_FUTURE_BLOCKS + 1),
+                        nBlockCount(0),
+                        coinbasePayees(DYNODE_COINBASE_PAYEES_SIZE)
+    {
+    }
 
     ADD_SERIALIZE_METHODS;
 
+    // stored as votes ordered by hash and tallies by height, as before the ring and the hashed vote map
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action)
     {
-        READWRITE(mapDynodePaymentVotes);
-        READWRITE(mapDynodeBlocks);
+        std::map<uint256, CDynodePaymentVote> mapVotes;
+        stored_blocks_t mapBlocks;
+        if (!ser_action.ForRead()) {
+            GetStoredVotes(mapVotes, mapBlocks);
+        }
+        READWRITE(mapVotes);
+        READWRITE(mapBlocks);
+        if (ser_action.ForRead()) {
+            LoadStoredVotes(mapVotes, mapBlocks);
+        }
+    }
+
+    template <typename Stream>
+    void SerializeJournal(Stream& s)
+    {
+        LOCK(cs_mapDynodePaymentVotes);
+        std::vector<CDynodePaymentVote> vecVotes;
+        for (const auto& nVoteHash : setDirtyVoteHashes) {
+            const auto it = mapDynodePaymentVotes.find(nVoteHash);
+            // evicted since, nothing to write
+            if (it != mapDynodePaymentVotes.end())
+                vecVotes.push_back(it->second);
+        }
+        s << vecVotes;
+        setDirtyVoteHashes.clear();
     }
 
+    template <typename Stream>
+    void UnserializeJournal(Stream& s)
+    {
+        std::vector<CDynodePaymentVote> vecVotes;
+        s >> vecVotes;
+        for (const auto& vote : vecVotes) {
+            AddJournalVote(vote);
+        }
+    }
+
+    void AddJournalVote(const CDynodePaymentVote& vote);
+    void ClearJournal();
+
     void Clear();
 
     bool AddOrUpdatePaymentVote(const CDynodePaymentVote& vote);
+    bool HasPaymentVote(const uint256& hashIn) const;
     bool HasVerifiedPaymentVote(const uint256& hashIn) const;
+    bool GetVerifiedPaymentVote(const uint256& hashIn, CDynodePaymentVote& voteRet) const;
+    /// Get the verified votes at nBlockHeight, false if no payee was voted for at it
+    bool GetBlockVotes(int nBlockHeight, std::vector<CDynodePaymentVote>& vecVotesRet) const;
+    /// Get the payees voted for at nBlockHeight or NULL, cs_mapDynodeBlocks must be held while it is used
+    const CDynodeBlockPayees* GetBlockPayees(int nBlockHeight) const;
     bool ProcessBlock(int nBlockHeight, CConnman& connman);
     void CheckBlockVotes(int nBlockHeight);
 
     void Sync(CNode* node, CConnman& connman) const;
     void RequestLowDataPaymentBlocks(CNode* pnode, CConnman& connman) const;
+    /// Get the payment blocks in the window we know nothing or too little about
+    void GetLowDataPaymentBlocks(std::vector<CInv>& vToFetchRet) const;
     void CheckAndRemove();
 
     bool GetBlockPayee(int nBlockHeight, CScript& payeeRet) const;
     bool IsTransactionValid(const CTransaction& txNew, int nBlockHeight) const;
     bool IsScheduled(const dynode_info_t& dnInfo, int nNotBlockHeight) const;
+    /// Get the payees of the next 8 blocks, except the one at nNotBlockHeight
+    void GetScheduledPayees(int nNotBlockHeight, std::set<CScript>& setPayeesRet) const;
 
     bool UpdateLastVote(const CDynodePaymentVote& vote);
+    /// Get the height of the last vote processed from a Dynode, false once it has no votes in the window
+    bool GetLastVote(const COutPoint& outpoint, int& nBlockHeightRet) const;
 
     int GetMinDynodePaymentsProto() const;
     void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman);
@@ -229,7 +371,7 @@ public:
     void FillBlockPayee(CMutableTransaction& txNew, int nBlockHeight, CAmount blockReward, CTxOut& txoutDynodeRet) const;
     std::string ToString() const;
 
-    int GetBlockCount() const { return mapDynodeBlocks.size(); }
+    int GetBlockCount() const { return nBlockCount; }
     int GetVoteCount() const { return mapDynodePaymentVotes.size(); }
 
     bool IsEnoughData() const;
@@ -104,7 +104,8 @@ void CDynodeSync::SwitchToNextAsset(CConnman& connman)
         // if(lockRecv) { ... }
 
         connman.ForEachNode(CConnman::AllNodes, [](CNode* pnode) {
-            netfulfilledman.AddFulfilledRequest(pnode->addr, "full-sync");
+            static const int nFullSyncRequestId = CNetFulfilledRequestManager::GetRequestId("full-sync");
+            netfulfilledman.AddFulfilledRequest(pnode->addr, nFullSyncRequestId);
         });
         LogPrint("dynode", "CDynodeSync::SwitchToNextAsset -- Sync has finished\n");
 
@@ -171,6 +172,12 @@ void CDynodeSync::ProcessTick(CConnman& connman)
     static int nTick = 0;
     nTick++;
 
+    static const int nFullSyncRequestId = CNetFulfilledRequestManager::GetRequestId("full-sync");
+    static const int nSporkSyncRequestId = CNetFulfilledRequestManager::GetRequestId("spork-sync");
+    static const int nDynodeListSyncRequestId = CNetFulfilledRequestManager::GetRequestId("dynode-list-sync");
+    static const int nDynodePaymentSyncRequestId = CNetFulfilledRequestManager::GetRequestId("dynode-payment-sync");
+    static const int nGovernanceSyncRequestId = CNetFulfilledRequestManager::GetRequestId("governance-sync");
+
     // reset the sync process if the last call to this function was more than 60 minutes ago (client was in sleep mode)
     static int64_t nTimeLastProcess = GetTime();
     if (GetTime() - nTimeLastProcess > 60 * 60) {
@@ -239,7 +246,7 @@ void CDynodeSync::ProcessTick(CConnman& connman)
 
         // NORMAL NETWORK MODE - TESTNET/MAINNET
         {
-            if (netfulfilledman.HasFulfilledRequest(pnode->addr, "full-sync")) {
+            if (netfulfilledman.HasFulfilledRequest(pnode->addr, nFullSyncRequestId)) {
                 // We already fully synced from this node recently,
                 // disconnect to free this connection slot for another peer.
                 pnode->fDisconnect = true;
@@ -249,9 +256,9 @@ void CDynodeSync::ProcessTick(CConnman& connman)
 
             // SPORK : ALWAYS ASK FOR SPORKS AS WE SYNC
 
-            if (!netfulfilledman.HasFulfilledRequest(pnode->addr, "spork-sync")) {
+            if (!netfulfilledman.HasFulfilledRequest(pnode->addr, nSporkSyncRequestId)) {
                 // always get sporks first, only request once from each peer
-                netfulfilledman.AddFulfilledRequest(pnode->addr, "spork-sync");
+                netfulfilledman.AddFulfilledRequest(pnode->addr, nSporkSyncRequestId);
                 // get current network sporks
                 connman.PushMessage(pnode, msgMaker.Make(NetMsgType::GETSPORKS));
                 LogPrint("dynode", "CDynodeSync::ProcessTick -- nTick %d nRequestedDynodeAssets %d -- requesting sporks from peer %d\n", nTick, nRequestedDynodeAssets, pnode->id);
@@ -299,9 +306,9 @@ void CDynodeSync::ProcessTick(CConnman& connman)
                 }
 
                 // only request once from each peer
-                if (netfulfilledman.HasFulfilledRequest(pnode->addr, "dynode-list-sync"))
+                if (netfulfilledman.HasFulfilledRequest(pnode->addr, nDynodeListSyncRequestId))
                     continue;
-                netfulfilledman.AddFulfilledRequest(pnode->addr, "dynode-list-sync");
+                netfulfilledman.AddFulfilledRequest(pnode->addr, nDynodeListSyncRequestId);
 
                 if (pnode->nVersion < dnpayments.GetMinDynodePaymentsProto())
                     continue;
@@ -350,9 +357,9 @@ void CDynodeSync::ProcessTick(CConnman& connman)
                 }
 
                 // only request once from each peer
-                if (netfulfilledman.HasFulfilledRequest(pnode->addr, "dynode-payment-sync"))
+                if (netfulfilledman.HasFulfilledRequest(pnode->addr, nDynodePaymentSyncRequestId))
                     continue;
-                netfulfilledman.AddFulfilledRequest(pnode->addr, "dynode-payment-sync");
+                netfulfilledman.AddFulfilledRequest(pnode->addr, nDynodePaymentSyncRequestId);
 
                 if (pnode->nVersion < dnpayments.GetMinDynodePaymentsProto())
                     continue;
@@ -387,7 +394,7 @@ void CDynodeSync::ProcessTick(CConnman& connman)
                     return;
                 }
                 // only request obj sync once from each peer, then request votes on per-obj basis
-                if (netfulfilledman.HasFulfilledRequest(pnode->addr, "governance-sync")) {
+                if (netfulfilledman.HasFulfilledRequest(pnode->addr, nGovernanceSyncRequestId)) {
                     governance.RequestGovernanceObjectVotes(pnode, connman);
                     int nObjsLeftToAsk = governance.RequestGovernanceObjectVotes(pnode, connman);
                     static int64_t nTimeNoObjectsLeft = 0;
@@ -421,7 +428,7 @@ void CDynodeSync::ProcessTick(CConnman& connman)
                     continue;
                 }
 
-                netfulfilledman.AddFulfilledRequest(pnode->addr, "governance-sync");
+                netfulfilledman.AddFulfilledRequest(pnode->addr, nGovernanceSyncRequestId);
 
                 if (pnode->nVersion < MIN_GOVERNANCE_PEER_PROTO_VERSION)
                     continue;
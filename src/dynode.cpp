@@ -80,10 +80,9 @@ bool CDynode::UpdateFromNewBroadcast(CDynodeBroadcast& dnb, CConnman& connman)
     // if it matches our Dynode privkey...
     if (fDynodeMode && pubKeyDynode == activeDynode.pubKeyDynode) {
         nPoSeBanScore = -DYNODE_POSE_BAN_MAX_SCORE;
-        if (nProtocolVersion == PROTOCOL_VERSION) {
-            // ... and PROTOCOL_VERSION, then we've been remotely activated ...
-            activeDynode.ManageState(connman);
-        } else {
+        // ... and PROTOCOL_VERSION, then we've been remotely activated, dnodeman calls ManageState
+        // once it has re-indexed this entry by its new key ...
+        if (nProtocolVersion != PROTOCOL_VERSION) {
             // ... otherwise we need to reactivate our node, do not add it to the list and do not relay
             // but also do not ban the node we get this message from
             LogPrintf("CDynode::UpdateFromNewBroadcast -- wrong PROTOCOL_VERSION, re-activate your DN: message nProtocolVersion=%d  PROTOCOL_VERSION=%d\n", nProtocolVersion, PROTOCOL_VERSION);
@@ -337,48 +336,6 @@ std::string CDynode::GetStatus() const
     return GetStateString();
 }
 
-void CDynode::UpdateLastPaid(const CBlockIndex* pindex, int nMaxBlocksToScanBack)
-{
-    if (!pindex)
-        return;
-
-    const CBlockIndex* BlockReading = pindex;
-
-    CScript dnpayee = GetScriptForDestination(pubKeyCollateralAddress.GetID());
-    // LogPrint("dynode", "CDynode::UpdateLastPaidBlock -- searching for block with payment to %s\n", vin.prevout.ToStringShort());
-
-    LOCK(cs_mapDynodeBlocks);
-
-    for (int i = 0; BlockReading && BlockReading->nHeight > nBlockLastPaid && i < nMaxBlocksToScanBack; i++) {
-        if (dnpayments.mapDynodeBlocks.count(BlockReading->nHeight) &&
-            dnpayments.mapDynodeBlocks[BlockReading->nHeight].HasPayeeWithVotes(dnpayee, 2)) {
-            CBlock block;
-            if (!ReadBlockFromDisk(block, BlockReading, Params().GetConsensus())) // shouldn't really happen
-                continue;
-
-            CAmount nDynodePayment = GetFluidDynodeReward(BlockReading->nHeight);
-
-            for (const auto& txout : block.vtx[0]->vout)
-                if (dnpayee == txout.scriptPubKey && nDynodePayment == txout.nValue) {
-                    nBlockLastPaid = BlockReading->nHeight;
-                    nTimeLastPaid = BlockReading->nTime;
-                    LogPrint("dynode", "CDynode::UpdateLastPaidBlock -- searching for block with payment to %s -- found new %d\n", outpoint.ToStringShort(), nBlockLastPaid);
-                    return;
-                }
-        }
-
-        if (BlockReading->pprev == nullptr) {
-            assert(BlockReading);
-            break;
-        }
-        BlockReading = BlockReading->pprev;
-    }
-
-    // Last payment for this Dynode wasn't found in latest dnpayments blocks
-    // or it was found in dnpayments blocks but wasn't found in the blockchain.
-    // LogPrint("dynode", "CDynode::UpdateLastPaidBlock -- searching for block with payment to %s -- keeping old %d\n", vin.prevout.ToStringShort(), nBlockLastPaid);
-}
-
 #ifdef ENABLE_WALLET
 bool CDynodeBroadcast::Create(const std::string strService, const std::string strKeyDynode, const std::string strTxHash, const std::string strOutputIndex, std::string& strErrorRet, CDynodeBroadcast& dnbRet, bool fOffline)
 {
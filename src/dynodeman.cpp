@@ -31,14 +31,6 @@ CDynodeMan dnodeman;
 const std::string CDynodeMan::SERIALIZATION_VERSION_STRING = "CDynodeMan-Version-5";
 const int CDynodeMan::LAST_PAID_SCAN_BLOCKS = 100;
 
-struct CompareLastPaidBlock {
-    bool operator()(const std::pair<int, const CDynode*>& t1,
-        const std::pair<int, const CDynode*>& t2) const
-    {
-        return (t1.first != t2.first) ? (t1.first < t2.first) : (t1.second->outpoint < t2.second->outpoint);
-    }
-};
-
 struct CompareScoreDN {
     bool operator()(const std::pair<arith_uint256, const CDynode*>& t1,
         const std::pair<arith_uint256, const CDynode*>& t2) const
@@ -47,15 +39,16 @@ struct CompareScoreDN {
     }
 };
 
-struct CompareByAddr
-
+template <typename Index, typename Key>
+static void EraseFromIndex(Index& index, const Key& key, const COutPoint& outpoint)
 {
-    bool operator()(const CDynode* t1,
-        const CDynode* t2) const
-    {
-        return t1->addr < t2->addr;
-    }
-};
+    auto it = index.find(key);
+    if (it == index.end())
+        return;
+    it->second.erase(outpoint);
+    if (it->second.empty())
+        index.erase(it);
+}
 
 CDynodeMan::CDynodeMan()
     : cs(),
@@ -71,6 +64,11 @@ CDynodeMan::CDynodeMan()
       fDynodesRemoved(false),
       vecDirtyGovernanceObjectHashes(),
       nLastSentinelPingTime(0),
+      cacheRankTables(RANK_TABLE_CACHE_SIZE),
+      mapIndexByPubKey(),
+      mapIndexByPayee(),
+      mapIndexByAddr(),
+      setPaymentQueue(),
       mapSeenDynodeBroadcast(),
       mapSeenDynodePing(),
       nPsqCount(0)
@@ -86,6 +84,8 @@ bool CDynodeMan::Add(CDynode& dn)
 
     LogPrint("dynode", "CDynodeMan::Add -- Adding new Dynode: addr=%s, %i now\n", dn.addr.ToString(), size() + 1);
     mapDynodes[dn.outpoint] = dn;
+    AddToIndexes(dn);
+    cacheRankTables.Clear();
     fDynodesAdded = true;
     return true;
 }
@@ -208,7 +208,9 @@ void CDynodeMan::CheckAndRemove(CConnman& connman)
                 mWeAskedForDynodeListEntry.erase(it->first);
                 // and finally remove it from the list
                 it->second.FlagGovernanceItemsAsDirty();
+                RemoveFromIndexes(it->second);
                 mapDynodes.erase(it++);
+                cacheRankTables.Clear();
                 fDynodesRemoved = true;
             } else {
                 bool fAsk = (nAskForDnbRecovery > 0) &&
@@ -365,6 +367,11 @@ void CDynodeMan::Clear()
 {
     LOCK(cs);
     mapDynodes.clear();
+    mapIndexByPubKey.clear();
+    mapIndexByPayee.clear();
+    mapIndexByAddr.clear();
+    setPaymentQueue.clear();
+    cacheRankTables.Clear();
     mAskedUsForDynodeList.clear();
     mWeAskedForDynodeList.clear();
     mWeAskedForDynodeListEntry.clear();
@@ -455,6 +462,92 @@ CDynode* CDynodeMan::Find(const COutPoint& outpoint)
     return it == mapDynodes.end() ? nullptr : &(it->second);
 }
 
+CDynode* CDynodeMan::Find(const CPubKey& pubKeyDynode)
+{
+    LOCK(cs);
+    auto itIndex = mapIndexByPubKey.find(pubKeyDynode.GetID());
+    if (itIndex == mapIndexByPubKey.end())
+        return nullptr;
+    for (const auto& outpoint : itIndex->second) {
+        auto it = mapDynodes.find(outpoint);
+        if (it == mapDynodes.end()) {
+            LogPrintf("CDynodeMan::%s -- ERROR: indexed Dynode %s is not in the list\n", __func__, outpoint.ToStringShort());
+            continue;
+        }
+        if (it->second.pubKeyDynode == pubKeyDynode)
+            return &(it->second);
+    }
+    return nullptr;
+}
+
+void CDynodeMan::AddToIndexes(const CDynode& dn)
+{
+    AssertLockHeld(cs);
+    mapIndexByPubKey[dn.pubKeyDynode.GetID()].insert(dn.outpoint);
+    mapIndexByPayee[GetScriptForDestination(dn.pubKeyCollateralAddress.GetID())].insert(dn.outpoint);
+    mapIndexByAddr[dn.addr].insert(dn.outpoint);
+    setPaymentQueue.insert(std::make_pair(dn.nBlockLastPaid, dn.outpoint));
+}
+
+void CDynodeMan::RemoveFromIndexes(const CDynode& dn)
+{
+    AssertLockHeld(cs);
+    EraseFromIndex(mapIndexByPubKey, dn.pubKeyDynode.GetID(), dn.outpoint);
+    EraseFromIndex(mapIndexByPayee, GetScriptForDestination(dn.pubKeyCollateralAddress.GetID()), dn.outpoint);
+    EraseFromIndex(mapIndexByAddr, dn.addr, dn.outpoint);
+    setPaymentQueue.erase(std::make_pair(dn.nBlockLastPaid, dn.outpoint));
+}
+
+void CDynodeMan::RebuildIndexes()
+{
+    AssertLockHeld(cs);
+    mapIndexByPubKey.clear();
+    mapIndexByPayee.clear();
+    mapIndexByAddr.clear();
+    setPaymentQueue.clear();
+    for (const auto& dnpair : mapDynodes) {
+        AddToIndexes(dnpair.second);
+    }
+}
+
+std::set<COutPoint> CDynodeMan::GetOutpointsByAddr(const CService& addr) const
+{
+    AssertLockHeld(cs);
+    auto it = mapIndexByAddr.find(addr);
+    return it == mapIndexByAddr.end() ? std::set<COutPoint>() : it->second;
+}
+
+bool CDynodeMan::CheckIndexes()
+{
+    LOCK(cs);
+
+    auto mapIndexByPubKeyWas = mapIndexByPubKey;
+    auto mapIndexByPayeeWas = mapIndexByPayee;
+    auto mapIndexByAddrWas = mapIndexByAddr;
+    auto setPaymentQueueWas = setPaymentQueue;
+    RebuildIndexes();
+
+    bool fConsistent = mapIndexByPubKeyWas == mapIndexByPubKey &&
+                       mapIndexByPayeeWas == mapIndexByPayee &&
+                       mapIndexByAddrWas == mapIndexByAddr &&
+                       setPaymentQueueWas == setPaymentQueue;
+    if (!fConsistent)
+        LogPrintf("CDynodeMan::%s -- ERROR: lookup indexes or payment queue are out of date\n", __func__);
+
+    for (const auto& item : cacheRankTables.GetItemList()) {
+        score_pair_vec_t vecDynodeScores;
+        GetDynodeScores(item.key.first, vecDynodeScores, item.key.second);
+        bool fMatch = vecDynodeScores.size() == item.value->vecOutpoints.size();
+        for (size_t i = 0; fMatch && i < vecDynodeScores.size(); i++)
+            fMatch = vecDynodeScores[i].second->outpoint == item.value->vecOutpoints[i];
+        if (!fMatch) {
+            LogPrintf("CDynodeMan::%s -- ERROR: cached rank table at %s is out of date\n", __func__, item.key.first.ToString());
+            fConsistent = false;
+        }
+    }
+    return fConsistent;
+}
+
 bool CDynodeMan::Get(const COutPoint& outpoint, CDynode& dynodeRet)
 {
     // Theses mutexes are recursive so double locking by the same thread is safe.
@@ -482,24 +575,27 @@ bool CDynodeMan::GetDynodeInfo(const COutPoint& outpoint, dynode_info_t& dnInfoR
 bool CDynodeMan::GetDynodeInfo(const CPubKey& pubKeyDynode, dynode_info_t& dnInfoRet)
 {
     LOCK(cs);
-    for (auto& dnpair : mapDynodes) {
-        if (dnpair.second.pubKeyDynode == pubKeyDynode) {
-            dnInfoRet = dnpair.second.GetInfo();
-            return true;
-        }
-    }
-    return false;
+    CDynode* pdn = Find(pubKeyDynode);
+    if (!pdn)
+        return false;
+    dnInfoRet = pdn->GetInfo();
+    return true;
 }
 
 bool CDynodeMan::GetDynodeInfo(const CScript& payee, dynode_info_t& dnInfoRet)
 {
     LOCK(cs);
-    for (const auto& dnpair : mapDynodes) {
-        CScript scriptCollateralAddress = GetScriptForDestination(dnpair.second.pubKeyCollateralAddress.GetID());
-        if (scriptCollateralAddress == payee) {
-            dnInfoRet = dnpair.second.GetInfo();
-            return true;
+    auto itIndex = mapIndexByPayee.find(payee);
+    if (itIndex == mapIndexByPayee.end())
+        return false;
+    for (const auto& outpoint : itIndex->second) {
+        auto it = mapDynodes.find(outpoint);
+        if (it == mapDynodes.end()) {
+            LogPrintf("CDynodeMan::%s -- ERROR: indexed Dynode %s is not in the list\n", __func__, outpoint.ToStringShort());
+            continue;
         }
+        dnInfoRet = it->second.GetInfo();
+        return true;
     }
     return false;
 }
@@ -531,46 +627,61 @@ bool CDynodeMan::GetNextDynodeInQueueForPayment(int nBlockHeight, bool fFilterSi
     // Need LOCK2 here to ensure consistent locking order because the GetBlockHash call below locks cs_main
     LOCK2(cs_main, cs);
 
-    std::vector<std::pair<int, const CDynode*> > vecDynodeLastPaid;
+    int nDnCount = CountDynodes();
+    int nTenthNetwork = nDnCount / 10;
+
+    // Dynodes in the list (up to 8 entries ahead of current block to allow propagation) are skipped
+    std::set<CScript> setScheduledPayees;
+    dnpayments.GetScheduledPayees(nBlockHeight, setScheduledPayees);
+    std::set<COutPoint> setScheduled;
+    for (const auto& payee : setScheduledPayees) {
+        auto itIndex = mapIndexByPayee.find(payee);
+        if (itIndex != mapIndexByPayee.end())
+            setScheduled.insert(itIndex->second.begin(), itIndex->second.end());
+    }
 
     /*
-        Make a vector with all of the last paid times
+        Walk the queue oldest payment first, keeping 1/10 of the eligible Dynodes
     */
 
-    int nDnCount = CountDynodes();
+    std::vector<const CDynode*> vecOldestDynodes;
 
-    for (const auto& dnpair : mapDynodes) {
-        if (!dnpair.second.IsValidForPayment())
+    for (const auto& queuepair : setPaymentQueue) {
+        auto it = mapDynodes.find(queuepair.second);
+        if (it == mapDynodes.end()) {
+            LogPrintf("CDynodeMan::%s -- ERROR: queued Dynode %s is not in the list\n", __func__, queuepair.second.ToStringShort());
+            continue;
+        }
+        const CDynode& dn = it->second;
+
+        if (!dn.IsValidForPayment())
             continue;
 
         // //check protocol version
-        if (dnpair.second.nProtocolVersion < dnpayments.GetMinDynodePaymentsProto())
+        if (dn.nProtocolVersion < dnpayments.GetMinDynodePaymentsProto())
             continue;
 
-        //it's in the list (up to 8 entries ahead of current block to allow propagation) -- so let's skip it
-        if (dnpayments.IsScheduled(dnpair.second, nBlockHeight))
+        //it's in the list -- so let's skip it
+        if (setScheduled.count(dn.outpoint))
             continue;
 
         //it's too new, wait for a cycle
-        if (fFilterSigTime && dnpair.second.sigTime + (nDnCount * 2.6 * 60) > GetAdjustedTime())
+        if (fFilterSigTime && dn.sigTime + (nDnCount * 2.6 * 60) > GetAdjustedTime())
             continue;
 
         //make sure it has at least as many confirmations as there are Dynodes
-        if (GetUTXOConfirmations(dnpair.first) < nDnCount)
+        if (GetUTXOConfirmations(dn.outpoint) < nDnCount)
             continue;
 
-        vecDynodeLastPaid.push_back(std::make_pair(dnpair.second.GetLastPaidBlock(), &dnpair.second));
+        nCountRet++;
+        if ((int)vecOldestDynodes.size() < std::max(1, nTenthNetwork))
+            vecOldestDynodes.push_back(&dn);
     }
 
-    nCountRet = (int)vecDynodeLastPaid.size();
-
     //when the network is in the process of upgrading, don't penalize nodes that recently restarted
     if (fFilterSigTime && nCountRet < nDnCount / 3)
         return GetNextDynodeInQueueForPayment(nBlockHeight, false, nCountRet, dnInfoRet);
 
-    // Sort them low to high
-    sort(vecDynodeLastPaid.begin(), vecDynodeLastPaid.end(), CompareLastPaidBlock());
-
     uint256 blockHash;
     if (!GetBlockHash(blockHash, nBlockHeight - 101)) {
         LogPrintf("CDynode::GetNextDynodeInQueueForPayment -- ERROR: GetBlockHash() failed at nBlockHeight %d\n", nBlockHeight - 101);
@@ -580,19 +691,14 @@ bool CDynodeMan::GetNextDynodeInQueueForPayment(int nBlockHeight, bool fFilterSi
     //  -- This doesn't look at who is being paid in the +8-10 blocks, allowing for double payments very rarely
     //  -- 1/100 payments should be a double payment on mainnet - (1/(3000/10))*2
     //  -- (chance per block * chances before IsScheduled will fire)
-    int nTenthNetwork = nDnCount / 10;
-    int nCountTenth = 0;
     arith_uint256 nHighest = 0;
     const CDynode* pBestDynode = nullptr;
-    for (const auto& s : vecDynodeLastPaid) {
-        arith_uint256 nScore = s.second->CalculateScore(blockHash);
+    for (const CDynode* pdn : vecOldestDynodes) {
+        arith_uint256 nScore = pdn->CalculateScore(blockHash);
         if (nScore > nHighest) {
             nHighest = nScore;
-            pBestDynode = s.second;
+            pBestDynode = pdn;
         }
-        nCountTenth++;
-        if (nCountTenth >= nTenthNetwork)
-            break;
     }
     if (pBestDynode) {
         dnInfoRet = pBestDynode->GetInfo();
@@ -669,6 +775,35 @@ bool CDynodeMan::GetDynodeScores(const uint256& nBlockHash, CDynodeMan::score_pa
     return !vecDynodeScoresRet.empty();
 }
 
+std::shared_ptr<const CDynodeMan::rank_table_t> CDynodeMan::GetRankTable(const uint256& nBlockHash, int nMinProtocol)
+{
+    AssertLockHeld(cs);
+
+    rank_table_key_t key(nBlockHash, nMinProtocol);
+    std::shared_ptr<const rank_table_t> pRankTable;
+    if (cacheRankTables.Get(key, pRankTable)) {
+        // move it to the front, so the least recently used table is dropped first
+        cacheRankTables.Erase(key);
+        cacheRankTables.Insert(key, pRankTable);
+        return pRankTable;
+    }
+
+    score_pair_vec_t vecDynodeScores;
+    if (!GetDynodeScores(nBlockHash, vecDynodeScores, nMinProtocol))
+        return nullptr;
+
+    std::shared_ptr<rank_table_t> pNewRankTable = std::make_shared<rank_table_t>();
+    pNewRankTable->vecOutpoints.reserve(vecDynodeScores.size());
+    int nRank = 0;
+    for (const auto& scorePair : vecDynodeScores) {
+        nRank++;
+        pNewRankTable->vecOutpoints.push_back(scorePair.second->outpoint);
+        pNewRankTable->mapRanks.emplace(scorePair.second->outpoint, nRank);
+    }
+    cacheRankTables.Insert(key, pNewRankTable);
+    return pNewRankTable;
+}
+
 bool CDynodeMan::GetDynodeRank(const COutPoint& outpoint, int& nRankRet, int nBlockHeight, int nMinProtocol)
 {
     nRankRet = -1;
@@ -685,20 +820,16 @@ bool CDynodeMan::GetDynodeRank(const COutPoint& outpoint, int& nRankRet, int nBl
 
     LOCK(cs);
 
-    score_pair_vec_t vecDynodeScores;
-    if (!GetDynodeScores(nBlockHash, vecDynodeScores, nMinProtocol))
+    std::shared_ptr<const rank_table_t> pRankTable = GetRankTable(nBlockHash, nMinProtocol);
+    if (!pRankTable)
         return false;
 
-    int nRank = 0;
-    for (const auto& scorePair : vecDynodeScores) {
-        nRank++;
-        if (scorePair.second->outpoint == outpoint) {
-            nRankRet = nRank;
-            return true;
-        }
-    }
+    std::map<COutPoint, int>::const_iterator it = pRankTable->mapRanks.find(outpoint);
+    if (it == pRankTable->mapRanks.end())
+        return false;
 
-    return false;
+    nRankRet = it->second;
+    return true;
 }
 
 bool CDynodeMan::GetDynodeRanks(CDynodeMan::rank_pair_vec_t& vecDynodeRanksRet, int nBlockHeight, int nMinProtocol)
@@ -717,14 +848,20 @@ bool CDynodeMan::GetDynodeRanks(CDynodeMan::rank_pair_vec_t& vecDynodeRanksRet,
 
     LOCK(cs);
 
-    score_pair_vec_t vecDynodeScores;
-    if (!GetDynodeScores(nBlockHash, vecDynodeScores, nMinProtocol))
+    std::shared_ptr<const rank_table_t> pRankTable = GetRankTable(nBlockHash, nMinProtocol);
+    if (!pRankTable)
         return false;
 
     int nRank = 0;
-    for (const auto& scorePair : vecDynodeScores) {
+    for (const COutPoint& outpoint : pRankTable->vecOutpoints) {
         nRank++;
-        vecDynodeRanksRet.push_back(std::make_pair(nRank, *scorePair.second));
+        // tables are dropped on every list change, so this should never miss
+        auto it = mapDynodes.find(outpoint);
+        if (it == mapDynodes.end()) {
+            LogPrintf("CDynodeMan::%s -- ERROR: ranked Dynode %s is not in the list\n", __func__, outpoint.ToStringShort());
+            continue;
+        }
+        vecDynodeRanksRet.push_back(std::make_pair(nRank, it->second));
     }
 
     return true;
@@ -1077,13 +1214,6 @@ void CDynodeMan::DoFullVerificationStep(CConnman& connman)
     if (nOffset >= (int)vecDynodeRanks.size())
         return;
 
-    std::vector<const CDynode*> vSortedByAddr;
-    for (const auto& dnpair : mapDynodes) {
-        vSortedByAddr.push_back(&dnpair.second);
-    }
-
-    sort(vSortedByAddr.begin(), vSortedByAddr.end(), CompareByAddr());
-
     auto it = vecDynodeRanks.begin() + nOffset;
     while (it != vecDynodeRanks.end()) {
         if (it->second.IsPoSeVerified() || it->second.IsPoSeBanned()) {
@@ -1100,7 +1230,7 @@ void CDynodeMan::DoFullVerificationStep(CConnman& connman)
         }
         LogPrint("dynode", "CDynodeMan::DoFullVerificationStep -- Verifying Dynode %s rank %d/%d address %s\n",
             it->second.outpoint.ToStringShort(), it->first, nRanksTotal, it->second.addr.ToString());
-        if (SendVerifyRequest(CAddress(it->second.addr, NODE_NETWORK), vSortedByAddr, connman)) {
+        if (SendVerifyRequest(CAddress(it->second.addr, NODE_NETWORK), connman)) {
             nCount++;
             if (nCount >= MAX_POSE_CONNECTIONS)
                 break;
@@ -1125,32 +1255,35 @@ void CDynodeMan::CheckSameAddr()
         return;
 
     std::vector<CDynode*> vBan;
-    std::vector<CDynode*> vSortedByAddr;
 
     {
         LOCK(cs);
 
-        CDynode* pprevDynode = nullptr;
-        CDynode* pverifiedDynode = nullptr;
-
-        for (auto& dnpair : mapDynodes) {
-            vSortedByAddr.push_back(&dnpair.second);
-        }
+        for (const auto& addrpair : mapIndexByAddr) {
+            // a single Dynode at this addr has nothing to be compared with
+            if (addrpair.second.size() < 2)
+                continue;
 
-        sort(vSortedByAddr.begin(), vSortedByAddr.end(), CompareByAddr());
+            CDynode* pprevDynode = nullptr;
+            CDynode* pverifiedDynode = nullptr;
 
-        for (const auto& pdn : vSortedByAddr) {
-            // check only (pre)enabled Dynodes
-            if (!pdn->IsEnabled() && !pdn->IsPreEnabled())
-                continue;
-            // initial step
-            if (!pprevDynode) {
-                pprevDynode = pdn;
-                pverifiedDynode = pdn->IsPoSeVerified() ? pdn : nullptr;
-                continue;
-            }
-            // second+ step
-            if (pdn->addr == pprevDynode->addr) {
+            for (const auto& outpoint : addrpair.second) {
+                auto it = mapDynodes.find(outpoint);
+                if (it == mapDynodes.end()) {
+                    LogPrintf("CDynodeMan::%s -- ERROR: indexed Dynode %s is not in the list\n", __func__, outpoint.ToStringShort());
+                    continue;
+                }
+                CDynode* pdn = &(it->second);
+                // check only (pre)enabled Dynodes
+                if (!pdn->IsEnabled() && !pdn->IsPreEnabled())
+                    continue;
+                // initial step
+                if (!pprevDynode) {
+                    pprevDynode = pdn;
+                    pverifiedDynode = pdn->IsPoSeVerified() ? pdn : nullptr;
+                    continue;
+                }
+                // second+ step
                 if (pverifiedDynode) {
                     // another Dynode with the same ip is verified, ban this one
                     vBan.push_back(pdn);
@@ -1160,10 +1293,8 @@ void CDynodeMan::CheckSameAddr()
                     // and keep a reference to be able to ban following Dynodes with the same ip
                     pverifiedDynode = pdn;
                 }
-            } else {
-                pverifiedDynode = pdn->IsPoSeVerified() ? pdn : nullptr;
+                pprevDynode = pdn;
             }
-            pprevDynode = pdn;
         }
     }
 
@@ -1174,9 +1305,11 @@ void CDynodeMan::CheckSameAddr()
     }
 }
 
-bool CDynodeMan::SendVerifyRequest(const CAddress& addr, const std::vector<const CDynode*>& vSortedByAddr, CConnman& connman)
+bool CDynodeMan::SendVerifyRequest(const CAddress& addr, CConnman& connman)
 {
-    if (netfulfilledman.HasFulfilledRequest(addr, strprintf("%s", NetMsgType::DNVERIFY) + "-request")) {
+    static const int nDnvRequestId = CNetFulfilledRequestManager::GetRequestId(strprintf("%s-request", NetMsgType::DNVERIFY));
+
+    if (netfulfilledman.HasFulfilledRequest(addr, nDnvRequestId)) {
         // we already asked for verification, not a good idea to do this too often, skip it
         LogPrint("dynode", "CDynodeMan::SendVerifyRequest -- too many requests, skipping... addr=%s\n", addr.ToString());
         return false;
@@ -1196,13 +1329,15 @@ bool CDynodeMan::SendVerifyRequest(const CAddress& addr, const std::vector<const
 
 void CDynodeMan::ProcessPendingDnvRequests(CConnman& connman)
 {
+    static const int nDnvRequestId = CNetFulfilledRequestManager::GetRequestId(strprintf("%s-request", NetMsgType::DNVERIFY));
+
     LOCK(cs_mapPendingDNV);
 
     std::map<CService, std::pair<int64_t, CDynodeVerification> >::iterator itPendingDNV = mapPendingDNV.begin();
 
     while (itPendingDNV != mapPendingDNV.end()) {
         bool fDone = connman.ForNode(itPendingDNV->first, [&](CNode* pnode) {
-            netfulfilledman.AddFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::DNVERIFY) + "-request");
+            netfulfilledman.AddFulfilledRequest(pnode->addr, nDnvRequestId);
             // use random nonce, store it and require node to reply with correct one later
             mWeAskedForVerification[pnode->addr] = itPendingDNV->second.second;
             LogPrint("dynode", "-- verifying node using nonce %d addr=%s\n", itPendingDNV->second.second.nonce, pnode->addr.ToString());
@@ -1225,6 +1360,8 @@ void CDynodeMan::ProcessPendingDnvRequests(CConnman& connman)
 
 void CDynodeMan::SendVerifyReply(CNode* pnode, CDynodeVerification& dnv, CConnman& connman)
 {
+    static const int nDnvReplyId = CNetFulfilledRequestManager::GetRequestId(strprintf("%s-reply", NetMsgType::DNVERIFY));
+
     AssertLockHeld(cs_main);
 
     // only Dynodes can sign this, why would someone ask regular node?
@@ -1234,7 +1371,7 @@ void CDynodeMan::SendVerifyReply(CNode* pnode, CDynodeVerification& dnv, CConnma
         return;
     }
 
-    if (netfulfilledman.HasFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::DNVERIFY) + "-reply")) {
+    if (netfulfilledman.HasFulfilledRequest(pnode->addr, nDnvReplyId)) {
         // peer should not ask us that often
         LogPrintf("CDynodeMan::SendVerifyReply -- ERROR: peer already asked me recently, peer=%d\n", pnode->id);
         Misbehaving(pnode->id, 20);
@@ -1277,17 +1414,20 @@ void CDynodeMan::SendVerifyReply(CNode* pnode, CDynodeVerification& dnv, CConnma
 
     CNetMsgMaker msgMaker(pnode->GetSendVersion());
     connman.PushMessage(pnode, msgMaker.Make(NetMsgType::DNVERIFY, dnv));
-    netfulfilledman.AddFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::DNVERIFY) + "-reply");
+    netfulfilledman.AddFulfilledRequest(pnode->addr, nDnvReplyId);
 }
 
 void CDynodeMan::ProcessVerifyReply(CNode* pnode, CDynodeVerification& dnv)
 {
+    static const int nDnvRequestId = CNetFulfilledRequestManager::GetRequestId(strprintf("%s-request", NetMsgType::DNVERIFY));
+    static const int nDnvDoneId = CNetFulfilledRequestManager::GetRequestId(strprintf("%s-done", NetMsgType::DNVERIFY));
+
     AssertLockHeld(cs_main);
 
     std::string strError;
 
     // did we even ask for it? if that's the case we should have matching fulfilled request
-    if (!netfulfilledman.HasFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::DNVERIFY) + "-request")) {
+    if (!netfulfilledman.HasFulfilledRequest(pnode->addr, nDnvRequestId)) {
         LogPrintf("CDynodeMan::ProcessVerifyReply -- ERROR: we didn't ask for verification of %s, peer=%d\n", pnode->addr.ToString(), pnode->id);
         Misbehaving(pnode->id, 20);
         return;
@@ -1317,7 +1457,7 @@ void CDynodeMan::ProcessVerifyReply(CNode* pnode, CDynodeVerification& dnv)
     }
 
     // we already verified this address, why node is spamming?
-    if (netfulfilledman.HasFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::DNVERIFY) + "-done")) {
+    if (netfulfilledman.HasFulfilledRequest(pnode->addr, nDnvDoneId)) {
         LogPrintf("CDynodeMan::ProcessVerifyReply -- ERROR: already verified %s recently\n", pnode->addr.ToString());
         Misbehaving(pnode->id, 20);
         return;
@@ -1332,67 +1472,66 @@ void CDynodeMan::ProcessVerifyReply(CNode* pnode, CDynodeVerification& dnv)
         uint256 hash1 = dnv.GetSignatureHash1(blockHash);
         std::string strMessage1 = strprintf("%s%d%s", pnode->addr.ToString(false), dnv.nonce, blockHash.ToString());
 
-        for (auto& dnpair : mapDynodes) {
-            if (CAddress(dnpair.second.addr, NODE_NETWORK) == pnode->addr) {
-                bool fFound = false;
-                if (sporkManager.IsSporkActive(SPORK_6_NEW_SIGS)) {
-                    fFound = CHashSigner::VerifyHash(hash1, dnpair.second.pubKeyDynode, dnv.vchSig1, strError);
-                    // we don't care about dnv with signature in old format
-                } else {
-                    fFound = CMessageSigner::VerifyMessage(dnpair.second.pubKeyDynode, dnv.vchSig1, strMessage1, strError);
+        for (const auto& outpoint : GetOutpointsByAddr(pnode->addr)) {
+            auto& dnpair = *mapDynodes.find(outpoint);
+            bool fFound = false;
+            if (sporkManager.IsSporkActive(SPORK_6_NEW_SIGS)) {
+                fFound = CHashSigner::VerifyHash(hash1, dnpair.second.pubKeyDynode, dnv.vchSig1, strError);
+                // we don't care about dnv with signature in old format
+            } else {
+                fFound = CMessageSigner::VerifyMessage(dnpair.second.pubKeyDynode, dnv.vchSig1, strMessage1, strError);
+            }
+            if (fFound) {
+                // found it!
+                prealDynode = &dnpair.second;
+                if (!dnpair.second.IsPoSeVerified()) {
+                    dnpair.second.DecreasePoSeBanScore();
                 }
-                if (fFound) {
-                    // found it!
-                    prealDynode = &dnpair.second;
-                    if (!dnpair.second.IsPoSeVerified()) {
-                        dnpair.second.DecreasePoSeBanScore();
-                    }
-                    netfulfilledman.AddFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::DNVERIFY) + "-done");
+                netfulfilledman.AddFulfilledRequest(pnode->addr, nDnvDoneId);
+
+                // we can only broadcast it if we are an activated dynode
+                if (activeDynode.outpoint.IsNull())
+                    continue;
+                // update ...
+                dnv.addr = dnpair.second.addr;
+                dnv.dynodeOutpoint1 = dnpair.second.outpoint;
+                dnv.dynodeOutpoint2 = activeDynode.outpoint;
+                // ... and sign it
+                std::string strError;
 
-                    // we can only broadcast it if we are an activated dynode
-                    if (activeDynode.outpoint.IsNull())
-                        continue;
-                    // update ...
-                    dnv.addr = dnpair.second.addr;
-                    dnv.dynodeOutpoint1 = dnpair.second.outpoint;
-                    dnv.dynodeOutpoint2 = activeDynode.outpoint;
-                    // ... and sign it
-                    std::string strError;
-
-                    if (sporkManager.IsSporkActive(SPORK_6_NEW_SIGS)) {
-                        uint256 hash2 = dnv.GetSignatureHash2(blockHash);
-
-                        if (!CHashSigner::SignHash(hash2, activeDynode.keyDynode, dnv.vchSig2)) {
-                            LogPrintf("DynodeMan::ProcessVerifyReply -- SignHash() failed\n");
-                            return;
-                        }
-
-                        if (!CHashSigner::VerifyHash(hash2, activeDynode.pubKeyDynode, dnv.vchSig2, strError)) {
-                            LogPrintf("DynodeMan::ProcessVerifyReply -- VerifyHash() failed, error: %s\n", strError);
-                            return;
-                        }
-                    } else {
-                        std::string strMessage2 = strprintf("%s%d%s%s%s", dnv.addr.ToString(false), dnv.nonce, blockHash.ToString(),
-                            dnv.dynodeOutpoint1.ToStringShort(), dnv.dynodeOutpoint2.ToStringShort());
+                if (sporkManager.IsSporkActive(SPORK_6_NEW_SIGS)) {
+                    uint256 hash2 = dnv.GetSignatureHash2(blockHash);
 
-                        if (!CMessageSigner::SignMessage(strMessage2, dnv.vchSig2, activeDynode.keyDynode)) {
-                            LogPrintf("DynodeMan::ProcessVerifyReply -- SignMessage() failed\n");
-                            return;
-                        }
+                    if (!CHashSigner::SignHash(hash2, activeDynode.keyDynode, dnv.vchSig2)) {
+                        LogPrintf("DynodeMan::ProcessVerifyReply -- SignHash() failed\n");
+                        return;
+                    }
 
-                        if (!CMessageSigner::VerifyMessage(activeDynode.pubKeyDynode, dnv.vchSig2, strMessage2, strError)) {
-                            LogPrintf("DynodeMan::ProcessVerifyReply -- VerifyMessage() failed, error: %s\n", strError);
-                            return;
-                        }
+                    if (!CHashSigner::VerifyHash(hash2, activeDynode.pubKeyDynode, dnv.vchSig2, strError)) {
+                        LogPrintf("DynodeMan::ProcessVerifyReply -- VerifyHash() failed, error: %s\n", strError);
+                        return;
                     }
+                } else {
+                    std::string strMessage2 = strprintf("%s%d%s%s%s", dnv.addr.ToString(false), dnv.nonce, blockHash.ToString(),
+                        dnv.dynodeOutpoint1.ToStringShort(), dnv.dynodeOutpoint2.ToStringShort());
 
-                    mWeAskedForVerification[pnode->addr] = dnv;
-                    mapSeenDynodeVerification.insert(std::make_pair(dnv.GetHash(), dnv));
-                    dnv.Relay();
+                    if (!CMessageSigner::SignMessage(strMessage2, dnv.vchSig2, activeDynode.keyDynode)) {
+                        LogPrintf("DynodeMan::ProcessVerifyReply -- SignMessage() failed\n");
+                        return;
+                    }
 
-                } else {
-                    vpDynodesToBan.push_back(&dnpair.second);
+                    if (!CMessageSigner::VerifyMessage(activeDynode.pubKeyDynode, dnv.vchSig2, strMessage2, strError)) {
+                        LogPrintf("DynodeMan::ProcessVerifyReply -- VerifyMessage() failed, error: %s\n", strError);
+                        return;
+                    }
                 }
+
+                mWeAskedForVerification[pnode->addr] = dnv;
+                mapSeenDynodeVerification.insert(std::make_pair(dnv.GetHash(), dnv));
+                dnv.Relay();
+
+            } else {
+                vpDynodesToBan.push_back(&dnpair.second);
             }
         }
         // no real Dynode found?...
@@ -1525,9 +1664,10 @@ void CDynodeMan::ProcessVerifyBroadcast(CNode* pnode, const CDynodeVerification&
 
         // increase ban score for everyone else with the same addr
         int nCount = 0;
-        for (auto& dnpair : mapDynodes) {
-            if (dnpair.second.addr != dnv.addr || dnpair.first == dnv.dynodeOutpoint1)
+        for (const auto& outpoint : GetOutpointsByAddr(dnv.addr)) {
+            if (outpoint == dnv.dynodeOutpoint1)
                 continue;
+            auto& dnpair = *mapDynodes.find(outpoint);
             dnpair.second.IncreasePoSeBanScore();
             nCount++;
             LogPrint("dynode", "CDynodeMan::ProcessVerifyBroadcast -- increased PoSe ban score for %s addr %s, new score %d\n",
@@ -1603,13 +1743,23 @@ bool CDynodeMan::CheckDnbAndUpdateDynodeList(CNode* pfrom, CDynodeBroadcast dnb,
         CDynode* pdn = Find(dnb.outpoint);
         if (pdn) {
             CDynodeBroadcast dnbOld = mapSeenDynodeBroadcast[CDynodeBroadcast(*pdn).GetHash()].second;
-            if (!dnb.Update(pdn, nDos, connman)) {
+            // the update may change the protocol version the rank tables were filtered by
+            cacheRankTables.Clear();
+            // ... and the key and addr this entry is indexed by
+            RemoveFromIndexes(*pdn);
+            bool fUpdated = dnb.Update(pdn, nDos, connman);
+            AddToIndexes(*pdn);
+            if (!fUpdated) {
                 LogPrint("dynode", "CDynodeMan::CheckDnbAndUpdateDynodeList -- Update() failed, dynode=%s\n", dnb.outpoint.ToStringShort());
                 return false;
             }
             if (hash != dnbOld.GetHash()) {
                 mapSeenDynodeBroadcast.erase(dnbOld.GetHash());
             }
+            // if the update took our Dynode broadcast with PROTOCOL_VERSION, we've been remotely activated
+            if (fDynodeMode && pdn->pubKeyDynode == activeDynode.pubKeyDynode && pdn->sigTime == dnb.sigTime && pdn->nProtocolVersion == PROTOCOL_VERSION) {
+                activeDynode.ManageState(connman);
+            }
             return true;
         }
     }
@@ -1656,8 +1806,62 @@ void CDynodeMan::UpdateLastPaid(const CBlockIndex* pindex)
     LogPrint("dynode", "CDynodeMan::UpdateLastPaid -- nCachedBlockHeight=%d, nLastRunBlockHeight=%d, nMaxBlocksToScanBack=%d\n",
         nCachedBlockHeight, nLastRunBlockHeight, nMaxBlocksToScanBack);
 
+    if (!pindex)
+        return;
+
+    // Dynodes that may have been paid since their last known payment, by collateral payee
+    std::map<CScript, std::vector<CDynode*> > mapPending;
+    int nMinBlockLastPaid = pindex->nHeight;
     for (auto& dnpair : mapDynodes) {
-        dnpair.second.UpdateLastPaid(pindex, nMaxBlocksToScanBack);
+        CDynode& dn = dnpair.second;
+        if (dn.nBlockLastPaid >= pindex->nHeight)
+            continue;
+        mapPending[GetScriptForDestination(dn.pubKeyCollateralAddress.GetID())].push_back(&dn);
+        nMinBlockLastPaid = std::min(nMinBlockLastPaid, dn.nBlockLastPaid);
+    }
+
+    LOCK(cs_mapDynodeBlocks);
+
+    // Walk back once for all dynodes, the most recent paid block found for each one wins
+    const CBlockIndex* BlockReading = pindex;
+    for (int i = 0; BlockReading && !mapPending.empty() && BlockReading->nHeight > nMinBlockLastPaid && i < nMaxBlocksToScanBack; i++) {
+        const CDynodeBlockPayees* pblockPayees = dnpayments.GetBlockPayees(BlockReading->nHeight);
+        if (pblockPayees) {
+            std::vector<CScript> vecPayees;
+            if (!dnpayments.coinbasePayees.GetPayees(BlockReading, vecPayees)) {
+                // Blocks connected before startup are not in the ring, read them only if a pending payee has votes
+                bool fHasVotes = false;
+                for (const auto& pendingpair : mapPending) {
+                    if (pblockPayees->HasPayeeWithVotes(pendingpair.first, 2)) {
+                        fHasVotes = true;
+                        break;
+                    }
+                }
+                CBlock block;
+                if (fHasVotes && ReadBlockFromDisk(block, BlockReading, Params().GetConsensus()))
+                    CDynodeCoinbasePayees::GetBlockPayees(block, BlockReading->nHeight, vecPayees);
+            }
+
+            for (const auto& payee : vecPayees) {
+                auto itPending = mapPending.find(payee);
+                if (itPending == mapPending.end() || !pblockPayees->HasPayeeWithVotes(payee, 2))
+                    continue;
+                for (CDynode* pdn : itPending->second) {
+                    // a dynode stops looking once it reaches its last known payment
+                    if (BlockReading->nHeight <= pdn->nBlockLastPaid)
+                        continue;
+                    // keep the payment queue ordered by the new last paid block
+                    setPaymentQueue.erase(std::make_pair(pdn->nBlockLastPaid, pdn->outpoint));
+                    pdn->nBlockLastPaid = BlockReading->nHeight;
+                    setPaymentQueue.insert(std::make_pair(pdn->nBlockLastPaid, pdn->outpoint));
+                    pdn->nTimeLastPaid = BlockReading->nTime;
+                    LogPrint("dynode", "CDynodeMan::UpdateLastPaid -- searching for block with payment to %s -- found new %d\n", pdn->outpoint.ToStringShort(), pdn->nBlockLastPaid);
+                }
+                mapPending.erase(itPending);
+            }
+        }
+
+        BlockReading = BlockReading->pprev;
     }
 
     nLastRunBlockHeight = nCachedBlockHeight;
@@ -1698,11 +1902,9 @@ void CDynodeMan::RemoveGovernanceObject(uint256 nGovernanceObjectHash)
 void CDynodeMan::CheckDynode(const CPubKey& pubKeyDynode, bool fForce)
 {
     LOCK(cs);
-    for (auto& dnpair : mapDynodes) {
-        if (dnpair.second.pubKeyDynode == pubKeyDynode) {
-            dnpair.second.Check(fForce);
-            return;
-        }
+    CDynode* pdn = Find(pubKeyDynode);
+    if (pdn) {
+        pdn->Check(fForce);
     }
 }
 
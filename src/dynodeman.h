@@ -6,14 +6,34 @@
 #ifndef DYNAMIC_DYNODEMAN_H
 #define DYNAMIC_DYNODEMAN_H
 
+#include "cachemap.h"
 #include "dynode.h"
+#include "saltedhasher.h"
 #include "sync.h"
 
+#include <memory>
+#include <unordered_map>
+
 class CDynodeMan;
 class CConnman;
 
 extern CDynodeMan dnodeman;
 
+/** Salted hasher for the Dynode lookup indexes, so peers can't announce colliding keys */
+class SaltedDynodeIndexHasher : private SaltedHasherBase
+{
+public:
+    size_t operator()(const CKeyID& keyID) const
+    {
+        return GetHasher().Write(keyID.begin(), keyID.size()).Finalize();
+    }
+
+    size_t operator()(const CScript& script) const
+    {
+        return GetHasher().Write(script.data(), script.size()).Finalize();
+    }
+};
+
 class CDynodeMan
 {
 public:
@@ -22,6 +42,13 @@ public:
     typedef std::pair<int, const CDynode> rank_pair_t;
     typedef std::vector<rank_pair_t> rank_pair_vec_t;
 
+    /// Dynodes ranked by their score at one block, the best one first
+    struct rank_table_t {
+        std::vector<COutPoint> vecOutpoints;
+        std::map<COutPoint, int> mapRanks;
+    };
+    typedef std::pair<uint256, int> rank_table_key_t;
+
 private:
     static const std::string SERIALIZATION_VERSION_STRING;
 
@@ -41,6 +68,8 @@ private:
     static const int DNB_RECOVERY_RETRY_SECONDS = 3 * 60 * 60;
     // the minimun active Dynodes before using InstandSend
     static const int INSTANTSEND_MIN_ACTIVE_DYNODE_COUNT = 25;
+    // rank tables kept for recently queried (block hash, min protocol) pairs
+    static const int RANK_TABLE_CACHE_SIZE = 16;
     // critical section to protect the inner data structures
     mutable CCriticalSection cs;
 
@@ -77,11 +106,32 @@ private:
 
     int64_t nLastSentinelPingTime;
 
+    /// Recently computed rank tables, cleared whenever an entry is added, removed or updated
+    CacheMap<rank_table_key_t, std::shared_ptr<const rank_table_t> > cacheRankTables;
+
+    // Lookup indexes into mapDynodes, each key maps to its entries in mapDynodes order
+    std::unordered_map<CKeyID, std::set<COutPoint>, SaltedDynodeIndexHasher> mapIndexByPubKey;
+    std::unordered_map<CScript, std::set<COutPoint>, SaltedDynodeIndexHasher> mapIndexByPayee;
+    std::map<CService, std::set<COutPoint> > mapIndexByAddr;
+    // All entries ordered by their last paid block, oldest first
+    std::set<std::pair<int, COutPoint> > setPaymentQueue;
+
     friend class CDynodeSync;
     /// Find an entry
     CDynode* Find(const COutPoint& outpoint);
+    /// Find the first entry using pubKeyDynode
+    CDynode* Find(const CPubKey& pubKeyDynode);
+
+    /// Add an entry to / remove an entry from the lookup indexes
+    void AddToIndexes(const CDynode& dn);
+    void RemoveFromIndexes(const CDynode& dn);
+    void RebuildIndexes();
+    /// Outpoints of all entries announcing addr
+    std::set<COutPoint> GetOutpointsByAddr(const CService& addr) const;
 
     bool GetDynodeScores(const uint256& nBlockHash, score_pair_vec_t& vecDynodeScoresRet, int nMinProtocol = 0);
+    /// Get the rank table at nBlockHash from the cache, computing it on a miss. Returns null if there is none.
+    std::shared_ptr<const rank_table_t> GetRankTable(const uint256& nBlockHash, int nMinProtocol);
 
     void SyncSingle(CNode* pnode, const COutPoint& outpoint, CConnman& connman);
     void SyncAll(CNode* pnode, CConnman& connman);
@@ -124,6 +174,10 @@ public:
 
         READWRITE(mapSeenDynodeBroadcast);
         READWRITE(mapSeenDynodePing);
+        if (ser_action.ForRead()) {
+            cacheRankTables.Clear();
+            RebuildIndexes();
+        }
         if (ser_action.ForRead() && (strVersion != SERIALIZATION_VERSION_STRING)) {
             Clear();
         }
@@ -194,7 +248,7 @@ public:
 
     void DoFullVerificationStep(CConnman& connman);
     void CheckSameAddr();
-    bool SendVerifyRequest(const CAddress& addr, const std::vector<const CDynode*>& vSortedByAddr, CConnman& connman);
+    bool SendVerifyRequest(const CAddress& addr, CConnman& connman);
     void ProcessPendingDnvRequests(CConnman& connman);
     void SendVerifyReply(CNode* pnode, CDynodeVerification& dnv, CConnman& connman);
     void ProcessVerifyReply(CNode* pnode, CDynodeVerification& dnv);
@@ -203,6 +257,9 @@ public:
     /// Return the number of (unique) Dynodes
     int size() { return mapDynodes.size(); }
 
+    /// Returns false if the lookup indexes, payment queue or cached rank tables differ from ones built from scratch
+    bool CheckIndexes();
+
     std::string ToString() const;
 
     /// Perform complete check and only then update list and maps
@@ -24,7 +24,7 @@
 template <typename T>
 class CFlatDB
 {
-private:
+protected:
     enum ReadResult {
         Ok,
         FileError,
@@ -53,11 +53,15 @@ private:
         uint256 hash = Hash(ssObj.begin(), ssObj.end());
         ssObj << hash;
 
+        // write to a temporary file first and move it into place once it is complete,
+        // so a crash while writing never leaves a truncated file behind
+        boost::filesystem::path pathTmp = GetDataDir() / (strFilename + ".new");
+
         // open output file, and associate with CAutoFile
-        FILE* file = fopen(pathDB.string().c_str(), "wb");
+        FILE* file = fopen(pathTmp.string().c_str(), "wb");
         CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
         if (fileout.IsNull())
-            return error("%s: Failed to open file %s", __func__, pathDB.string());
+            return error("%s: Failed to open file %s", __func__, pathTmp.string());
 
         // Write and commit header, data
         try {
@@ -65,14 +69,65 @@ private:
         } catch (const std::exception& e) {
             return error("%s: Serialize or I/O error - %s", __func__, e.what());
         }
+        FileCommit(fileout.Get());
         fileout.fclose();
 
+        if (!RenameOver(pathTmp, pathDB))
+            return error("%s: Rename-into-place failed", __func__);
+
         LogPrintf("Written info to %s  %dms\n", strFilename, GetTimeMillis() - nStart);
         LogPrintf("     %s\n", objToSave.ToString());
 
         return true;
     }
 
+    // Check only the file header, without reading the data
+    ReadResult ReadHeader() const
+    {
+        FILE* file = fopen(pathDB.string().c_str(), "rb");
+        CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
+            return FileError;
+
+        unsigned char pchMsgTmp[4];
+        std::string strMagicMessageTmp;
+        try {
+            filein >> strMagicMessageTmp;
+            if (strMagicMessage != strMagicMessageTmp) {
+                error("%s: Invalid magic message", __func__);
+                return IncorrectMagicMessage;
+            }
+
+            filein >> FLATDATA(pchMsgTmp);
+            if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp))) {
+                error("%s: Invalid network magic number", __func__);
+                return IncorrectMagicNumber;
+            }
+        } catch (const std::exception& e) {
+            error("%s: Deserialize or I/O error - %s", __func__, e.what());
+            return IncorrectFormat;
+        }
+
+        return Ok;
+    }
+
+    // Returns false if the file exists but can't be overwritten safely
+    bool CheckReadResult(ReadResult readResult) const
+    {
+        if (readResult == FileError)
+            LogPrintf("Missing file %s, will try to recreate\n", strFilename);
+        else if (readResult != Ok) {
+            LogPrintf("Error reading %s: ", strFilename);
+            if (readResult == IncorrectFormat) {
+                LogPrintf("%s: Magic is ok but data has invalid format, will try to recreate\n", __func__);
+            } else {
+                LogPrintf("%s: File format is unknown or invalid, please fix it manually\n", __func__);
+                return false;
+            }
+        }
+        return true;
+    }
+
     ReadResult Read(T& objToLoad, bool fDryRun = false)
     {
         //LOCK(objToLoad.cs);
@@ -170,41 +225,21 @@ public:
     {
         LogPrintf("Reading info from %s...\n", strFilename);
         ReadResult readResult = Read(objToLoad);
-        if (readResult == FileError)
-            LogPrintf("Missing file %s, will try to recreate\n", strFilename);
-        else if (readResult != Ok) {
-            LogPrintf("Error reading %s: ", strFilename);
-            if (readResult == IncorrectFormat) {
-                LogPrintf("%s: Magic is ok but data has invalid format, will try to recreate\n", __func__);
-            } else {
-                LogPrintf("%s: File format is unknown or invalid, please fix it manually\n", __func__);
-                // program should exit with an error
-                return false;
-            }
-        }
-        return true;
+        // program should exit with an error if the file is unusable
+        return CheckReadResult(readResult);
     }
 
     bool Dump(T& objToSave)
     {
         int64_t nStart = GetTimeMillis();
 
+        // the file is replaced atomically, so only make sure it is ours before replacing it
         LogPrintf("Verifying %s format...\n", strFilename);
-        T tmpObjToLoad;
-        ReadResult readResult = Read(tmpObjToLoad, true);
+        ReadResult readResult = ReadHeader();
 
         // there was an error and it was not an error on file opening => do not proceed
-        if (readResult == FileError)
-            LogPrintf("Missing file %s, will try to recreate\n", strFilename);
-        else if (readResult != Ok) {
-            LogPrintf("Error reading %s: ", strFilename);
-            if (readResult == IncorrectFormat)
-                LogPrintf("%s: Magic is ok but data has invalid format, will try to recreate\n", __func__);
-            else {
-                LogPrintf("%s: File format is unknown or invalid, please fix it manually\n", __func__);
-                return false;
-            }
-        }
+        if (!CheckReadResult(readResult))
+            return false;
 
         LogPrintf("Writing info to %s...\n", strFilename);
         Write(objToSave);
@@ -214,5 +249,217 @@ public:
     }
 };
 
+/**
+*   Journaled Dumping and Loading
+*   -----------------------------
+*
+*   Keeps an append-only journal next to the snapshot written by CFlatDB. Dumps append
+*   what changed since the last dump to the journal, and the snapshot is only rewritten
+*   (dropping the journal) once the journal has grown as large as the snapshot. Entries are
+*   only appended to the snapshot this process loaded or wrote last, anything else is replaced.
+*
+*   T keeps track of its changes and provides
+*     SerializeJournal(s)   - write the changes since they were last written and forget them
+*     UnserializeJournal(s) - apply changes read back from the journal
+*     ClearJournal()        - forget the changes, called before a snapshot is written
+*/
+
+template <typename T>
+class CFlatJournalDB : public CFlatDB<T>
+{
+private:
+    typedef typename CFlatDB<T>::ReadResult ReadResult;
+
+    boost::filesystem::path pathJournal;
+
+    // checksum of the snapshot of T last loaded or written by this process
+    static uint256& SnapshotHashInSync()
+    {
+        static uint256 hashSnapshot;
+        return hashSnapshot;
+    }
+
+    // Journal entries only apply on top of the snapshot with this checksum
+    bool ReadSnapshotHash(uint256& hashRet) const
+    {
+        FILE* file = fopen(this->pathDB.string().c_str(), "rb");
+        CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull() || fseek(filein.Get(), -(long)sizeof(uint256), SEEK_END) != 0)
+            return false;
+
+        try {
+            filein >> hashRet;
+        } catch (const std::exception& e) {
+            return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+        }
+        return true;
+    }
+
+    bool AppendJournal(T& objToSave, const uint256& hashSnapshot)
+    {
+        int64_t nStart = GetTimeMillis();
+
+        CDataStream ssEntry(SER_DISK, CLIENT_VERSION);
+        ssEntry << this->strMagicMessage;
+        ssEntry << FLATDATA(Params().MessageStart());
+        ssEntry << hashSnapshot;
+        objToSave.SerializeJournal(ssEntry);
+
+        FILE* file = fopen(pathJournal.string().c_str(), "ab");
+        CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
+        if (fileout.IsNull())
+            return error("%s: Failed to open file %s", __func__, pathJournal.string());
+
+        // a torn entry fails its checksum and is ignored on load, with everything after it
+        try {
+            fileout << (uint32_t)ssEntry.size();
+            fileout << ssEntry;
+            fileout << Hash(ssEntry.begin(), ssEntry.end());
+        } catch (const std::exception& e) {
+            return error("%s: Serialize or I/O error - %s", __func__, e.what());
+        }
+        FileCommit(fileout.Get());
+        fileout.fclose();
+
+        LogPrintf("Appended %u bytes to %s  %dms\n", ssEntry.size(), pathJournal.filename().string(), GetTimeMillis() - nStart);
+        return true;
+    }
+
+    int ReadJournal(T& objToLoad, const uint256& hashSnapshot)
+    {
+        FILE* file = fopen(pathJournal.string().c_str(), "rb");
+        CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
+            return 0;
+
+        uint64_t nFileSize = boost::filesystem::file_size(pathJournal);
+        uint64_t nValidSize = 0;
+        int nEntries = 0;
+        while (nValidSize < nFileSize) {
+            uint32_t nSize;
+            std::vector<unsigned char> vchData;
+            uint256 hashIn;
+            try {
+                filein >> nSize;
+                if (nSize > nFileSize)
+                    break;
+                vchData.resize(nSize);
+                filein.read((char*)vchData.data(), nSize);
+                filein >> hashIn;
+            } catch (const std::exception& e) {
+                // an entry that was not written completely
+                break;
+            }
+
+            CDataStream ssEntry(vchData, SER_DISK, CLIENT_VERSION);
+            if (hashIn != Hash(ssEntry.begin(), ssEntry.end())) {
+                error("%s: Checksum mismatch, ignoring the rest of %s", __func__, pathJournal.filename().string());
+                break;
+            }
+
+            unsigned char pchMsgTmp[4];
+            std::string strMagicMessageTmp;
+            uint256 hashSnapshotTmp;
+            try {
+                ssEntry >> strMagicMessageTmp;
+                ssEntry >> FLATDATA(pchMsgTmp);
+                ssEntry >> hashSnapshotTmp;
+                if (strMagicMessageTmp != this->strMagicMessage || memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp)))
+                    break;
+                // entries left over from before the snapshot was last rewritten are skipped
+                if (hashSnapshotTmp == hashSnapshot) {
+                    objToLoad.UnserializeJournal(ssEntry);
+                    nEntries++;
+                }
+            } catch (const std::exception& e) {
+                error("%s: Deserialize or I/O error - %s", __func__, e.what());
+                break;
+            }
+            nValidSize += sizeof(nSize) + nSize + sizeof(hashIn);
+        }
+        filein.fclose();
+
+        // cut off what could not be read, so later entries are not appended behind it
+        if (nValidSize < nFileSize) {
+            LogPrintf("%s: Truncating %s from %u to %u bytes\n", __func__, pathJournal.filename().string(), nFileSize, nValidSize);
+            boost::filesystem::resize_file(pathJournal, nValidSize);
+        }
+
+        return nEntries;
+    }
+
+public:
+    CFlatJournalDB(std::string strFilenameIn, std::string strMagicMessageIn) : CFlatDB<T>(strFilenameIn, strMagicMessageIn)
+    {
+        pathJournal = GetDataDir() / (strFilenameIn + ".log");
+    }
+
+    bool Load(T& objToLoad)
+    {
+        LogPrintf("Reading info from %s...\n", this->strFilename);
+        ReadResult readResult = this->Read(objToLoad, true);
+        if (!this->CheckReadResult(readResult))
+            return false;
+
+        // without a valid snapshot the journal has nothing to apply to, the next dump replaces both
+        if (readResult == CFlatDB<T>::IncorrectFormat)
+            boost::filesystem::remove(this->pathDB);
+        uint256 hashSnapshot;
+        SnapshotHashInSync().SetNull();
+        if (readResult == CFlatDB<T>::Ok && ReadSnapshotHash(hashSnapshot)) {
+            SnapshotHashInSync() = hashSnapshot;
+            int64_t nStart = GetTimeMillis();
+            int nEntries = ReadJournal(objToLoad, hashSnapshot);
+            LogPrintf("Loaded %d entries from %s  %dms\n", nEntries, pathJournal.filename().string(), GetTimeMillis() - nStart);
+            LogPrintf("     %s\n", objToLoad.ToString());
+        }
+
+        LogPrintf("%s: Cleaning....\n", __func__);
+        objToLoad.CheckAndRemove();
+        LogPrintf("     %s\n", objToLoad.ToString());
+
+        // everything loaded is on disk already
+        objToLoad.ClearJournal();
+        return true;
+    }
+
+    bool Dump(T& objToSave)
+    {
+        int64_t nStart = GetTimeMillis();
+
+        LogPrintf("Verifying %s format...\n", this->strFilename);
+        ReadResult readResult = this->ReadHeader();
+        if (!this->CheckReadResult(readResult))
+            return false;
+
+        // a snapshot this process did not load or write may not hold what the journal builds on
+        uint256 hashSnapshot;
+        bool fCompact = readResult != CFlatDB<T>::Ok || !ReadSnapshotHash(hashSnapshot) || hashSnapshot != SnapshotHashInSync();
+        if (!fCompact && boost::filesystem::exists(pathJournal)) {
+            fCompact = boost::filesystem::file_size(pathJournal) >= boost::filesystem::file_size(this->pathDB);
+        }
+
+        if (!fCompact) {
+            LogPrintf("Appending info to %s...\n", pathJournal.filename().string());
+            // the changes were taken for the entry, so they can only be saved with a new snapshot now
+            fCompact = !AppendJournal(objToSave, hashSnapshot);
+        }
+
+        if (fCompact) {
+            LogPrintf("Writing info to %s...\n", this->strFilename);
+            // changes made while the snapshot is written are journaled by the next dump
+            objToSave.ClearJournal();
+            SnapshotHashInSync().SetNull();
+            if (!this->Write(objToSave))
+                return false;
+            boost::filesystem::remove(pathJournal);
+            if (ReadSnapshotHash(hashSnapshot))
+                SnapshotHashInSync() = hashSnapshot;
+        }
+        LogPrintf("%s dump finished  %dms\n", this->strFilename, GetTimeMillis() - nStart);
+
+        return true;
+    }
+};
 
 #endif // DYNAMIC_FLAT_DATABASE_H
@@ -5,8 +5,11 @@
 #include "bdap/domainentry.h"
 #include "bdap/domainentrydb.h"
 #include "bdap/utils.h"
+#include "cachemap.h"
 #include "chain.h"
 #include "core_io.h"
+#include "fluidindex.h"
+#include "hash.h"
 #include "keepass.h"
 #include "net.h"
 #include "netbase.h"
@@ -20,6 +23,8 @@
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
 
+#include <unordered_set>
+
 CFluid fluid;
 
 #ifdef ENABLE_WALLET
@@ -57,6 +62,13 @@ int GetFluidOpCode(const CScript& fluidScript)
     return 0;
 }
 
+/** Hash of a fluid instruction without its opcode, two scripts carry the same instruction if their hashes match */
+uint256 GetFluidInstructionHash(const CScript& fluidScript)
+{
+    std::string strInstruction = GetRidOfScriptStatement(ScriptToAsmStr(fluidScript));
+    return Hash(strInstruction.begin(), strInstruction.end());
+}
+
 /** Initialise sovereign identities that are able to run fluid commands */
 std::vector<std::pair<std::string, CDynamicAddress> > CFluidParameters::InitialiseSovereignIdentities()
 {
@@ -190,21 +202,11 @@ bool CFluid::CheckFluidOperationScript(const CScript& fluidScriptPubKey, const i
 /** Checks whether fluid transaction is in the memory pool already */
 bool CFluid::CheckIfExistsInMemPool(const CTxMemPool& pool, const CScript& fluidScriptPubKey, std::string& errorMessage)
 {
-    for (const CTxMemPoolEntry& e : pool.mapTx) {
-        const CTransaction& tx = e.GetTx();
-        for (const CTxOut& txOut : tx.vout) {
-            if (IsTransactionFluid(txOut.scriptPubKey)) {
-                std::string strNewFluidScript = ScriptToAsmStr(fluidScriptPubKey);
-                std::string strMemPoolFluidScript = ScriptToAsmStr(txOut.scriptPubKey);
-                std::string strNewTxWithoutOpCode = GetRidOfScriptStatement(strNewFluidScript);
-                std::string strMemPoolTxWithoutOpCode = GetRidOfScriptStatement(strMemPoolFluidScript);
-                if (strNewTxWithoutOpCode == strMemPoolTxWithoutOpCode) {
-                    errorMessage = "CheckIfExistsInMemPool: fluid transaction is already in the memory pool!";
-                    LogPrintf("CheckIfExistsInMemPool: fluid transaction, %s is already in the memory pool! %s\n", tx.GetHash().ToString(), strNewTxWithoutOpCode);
-                    return true;
-                }
-            }
-        }
+    uint256 txid;
+    if (pool.existsFluidInstruction(fluidScriptPubKey, txid)) {
+        errorMessage = "CheckIfExistsInMemPool: fluid transaction is already in the memory pool!";
+        LogPrintf("CheckIfExistsInMemPool: fluid transaction, %s is already in the memory pool! %s\n", txid.ToString(), GetRidOfScriptStatement(ScriptToAsmStr(fluidScriptPubKey)));
+        return true;
     }
 
     return false;
@@ -244,49 +246,58 @@ bool CFluid::CheckAccountBanScript(const CScript& fluidScript, const uint256& tx
 /** Checks whether as to parties have actually signed it - please use this with ones with the OP_CODE */
 bool CFluid::CheckIfQuorumExists(const std::string& consentToken, std::string& message, const bool individual)
 {
-    std::vector<std::string> fluidSovereigns;
-    std::pair<CDynamicAddress, bool> keyOne;
-    std::pair<CDynamicAddress, bool> keyTwo;
-    std::pair<CDynamicAddress, bool> keyThree;
-    keyOne.second = false, keyTwo.second = false;
-    keyThree.second = false;
+    //TODO fluid
+    std::vector<std::string> fluidSovereigns = InitialiseAddresses();
 
-    GetLastBlockIndex(chainActive.Tip());
-    CBlockIndex* pindex = chainActive.Tip();
+    std::vector<CDynamicAddress> vKeys;
+    bool fQuorum = CheckTokenQuorum(consentToken, fluidSovereigns, message, individual, vKeys);
 
-    if (pindex != NULL) {
-        //TODO fluid
-        fluidSovereigns = InitialiseAddresses();
-    } else
-        fluidSovereigns = InitialiseAddresses();
+    if (!vKeys.empty())
+        LogPrintf("CheckIfQuorumExists(): Addresses validating this consent token are: %s, %s and %s\n", vKeys[0].ToString(), vKeys[1].ToString(), vKeys[2].ToString());
 
-    for (const std::string& address : fluidSovereigns) {
-        CDynamicAddress attemptKey, xAddress(address);
+    return fQuorum;
+}
 
+/**
+ * Matches the three signers of a consent token against the sovereign addresses. Each signer is
+ * recovered once per token instead of once per sovereign address. vKeys receives the matching
+ * sovereign address for each digest position, or an empty address.
+ */
+bool CFluid::CheckTokenQuorum(const std::string& consentToken, const std::vector<std::string>& fluidSovereigns, std::string& message, const bool individual, std::vector<CDynamicAddress>& vKeys)
+{
+    vKeys.clear();
+    std::unordered_set<std::string> setSovereigns;
+    for (const std::string& address : fluidSovereigns) {
+        CDynamicAddress xAddress(address);
         if (!xAddress.IsValid())
             return false;
+        setSovereigns.insert(xAddress.ToString());
+    }
+    if (setSovereigns.empty())
+        return false;
 
-        if (GenericVerifyInstruction(consentToken, attemptKey, message, 1) && xAddress == attemptKey) {
-            keyOne = std::make_pair(attemptKey.ToString(), true);
-        }
-
-        if (GenericVerifyInstruction(consentToken, attemptKey, message, 2) && xAddress == attemptKey) {
-            keyTwo = std::make_pair(attemptKey.ToString(), true);
-        }
-
-        if (GenericVerifyInstruction(consentToken, attemptKey, message, 3) && xAddress == attemptKey) {
-            keyThree = std::make_pair(attemptKey.ToString(), true);
+    CFluidTokenSigners signers;
+    GetTokenSigners(consentToken, signers);
+    message = signers.messageTokenKey;
+
+    vKeys.resize(3);
+    bool fAnySigned = false;
+    bool fAllSigned = true;
+    for (unsigned int i = 0; i < vKeys.size(); i++) {
+        if (i < signers.vSigners.size() && setSovereigns.count(signers.vSigners[i].ToString())) {
+            vKeys[i] = signers.vSigners[i];
+            fAnySigned = true;
+        } else {
+            fAllSigned = false;
         }
     }
 
-    bool fValid = (keyOne.first.ToString() != keyTwo.first.ToString() && keyTwo.first.ToString() != keyThree.first.ToString() && keyOne.first.ToString() != keyThree.first.ToString());
-
-    LogPrintf("CheckIfQuorumExists(): Addresses validating this consent token are: %s, %s and %s\n", keyOne.first.ToString(), keyTwo.first.ToString(), keyThree.first.ToString());
+    bool fValid = (vKeys[0].ToString() != vKeys[1].ToString() && vKeys[1].ToString() != vKeys[2].ToString() && vKeys[0].ToString() != vKeys[2].ToString());
 
     if (individual)
-        return (keyOne.second || keyTwo.second || keyThree.second);
+        return fAnySigned;
     else if (fValid)
-        return (keyOne.second && keyTwo.second && keyThree.second);
+        return fAllSigned;
 
     return false;
 }
@@ -408,7 +419,7 @@ CDynamicAddress CFluid::GetAddressFromDigestSignature(const std::string& digestS
 
     if (fInvalid) {
         LogPrintf("GetAddressFromDigestSignature(): Digest Signature Found Invalid, Signature: %s \n", digestSignature);
-        return nullptr;
+        return CDynamicAddress();
     }
 
     CHashWriter ss(SER_GETHASH, 0);
@@ -419,13 +430,42 @@ CDynamicAddress CFluid::GetAddressFromDigestSignature(const std::string& digestS
 
     if (!pubkey.RecoverCompact(ss.GetHash(), vchSig)) {
         LogPrintf("GetAddressFromDigestSignature(): Public Key Recovery Failed! Hash: %s\n", ss.GetHash().ToString());
-        return nullptr;
+        return CDynamicAddress();
     }
     CDynamicAddress newAddress;
     newAddress.Set(pubkey.GetID());
     return newAddress;
 }
 
+static CCriticalSection cs_mapTokenSigners;
+static CacheMap<uint256, CFluidTokenSigners> mapTokenSigners(FLUID_TOKEN_SIGNERS_CACHE_SIZE);
+
+/** Recovers the signers of a consent token, reusing the result when the token was seen before */
+void CFluid::GetTokenSigners(const std::string& consentToken, CFluidTokenSigners& signers)
+{
+    uint256 hash = Hash(consentToken.begin(), consentToken.end());
+    {
+        LOCK(cs_mapTokenSigners);
+        if (mapTokenSigners.Get(hash, signers))
+            return;
+    }
+
+    std::string consentTokenNoScript = GetRidOfScriptStatement(consentToken);
+    std::vector<std::string> strs;
+
+    ConvertToString(consentTokenNoScript);
+    SeparateString(consentTokenNoScript, strs, false);
+
+    signers.messageTokenKey = strs.at(0);
+    signers.vSigners.clear();
+    for (int whereToLook = 1; whereToLook <= 3 && whereToLook < (int)strs.size(); whereToLook++) {
+        signers.vSigners.push_back(GetAddressFromDigestSignature(strs.at(whereToLook), signers.messageTokenKey));
+    }
+
+    LOCK(cs_mapTokenSigners);
+    mapTokenSigners.Insert(hash, signers);
+}
+
 /** Individually checks the validity of an instruction */
 bool CFluid::GenericVerifyInstruction(const std::string& consentToken, CDynamicAddress& signer, std::string& messageTokenKey, const int& whereToLook)
 {
@@ -503,17 +543,23 @@ bool GetFluidBlock(const CBlockIndex* pblockindex, CBlock& block)
 
 bool CFluid::GetMintingInstructions(const CBlockIndex* pblockindex, CDynamicAddress& toMintAddress, CAmount& mintAmount)
 {
-    CBlock block;
-    if (GetFluidBlock(pblockindex, block)) {
-        for (const CTransactionRef& tx : block.vtx) {
-            for (const CTxOut& txout : tx->vout) {
-                if (txout.scriptPubKey.IsProtocolInstruction(MINT_TX)) {
-                    std::string message;
-                    if (CheckIfQuorumExists(ScriptToAsmStr(txout.scriptPubKey), message))
-                        return ParseMintKey(block.nTime, toMintAddress, mintAmount, ScriptToAsmStr(txout.scriptPubKey));
-                }
-            }
-        }
+    CFluidBlockInstructions instructions;
+    bool fIndexed = false;
+    {
+        LOCK(cs_main);
+        fIndexed = pblockindex && chainActive.Contains(pblockindex) && fluidIndex.GetBlockInstructions(pblockindex->nHeight, instructions);
+    }
+    if (!fIndexed) {
+        CBlock block;
+        if (!GetFluidBlock(pblockindex, block))
+            return false;
+        instructions.SetBlock(block);
+    }
+
+    for (const CScript& scriptMint : instructions.vMintScripts) {
+        std::string message;
+        if (CheckIfQuorumExists(ScriptToAsmStr(scriptMint), message))
+            return ParseMintKey(instructions.nBlockTime, toMintAddress, mintAmount, ScriptToAsmStr(scriptMint));
     }
     return false;
 }
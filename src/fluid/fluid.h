@@ -24,6 +24,18 @@ class CTxMemPool;
 struct CBlockTemplate;
 class CTransaction;
 
+/** Number of consent tokens whose recovered signers are kept in memory */
+static const unsigned int FLUID_TOKEN_SIGNERS_CACHE_SIZE = 1000;
+
+/** The addresses recovered from the digest signatures of a consent token */
+class CFluidTokenSigners
+{
+public:
+    std::string messageTokenKey;
+    // one entry per digest signature present, at most three
+    std::vector<CDynamicAddress> vSigners;
+};
+
 /** Configuration Framework */
 class CFluidParameters
 {
@@ -52,12 +64,14 @@ public:
     bool CheckFluidOperationScript(const CScript& fluidScriptPubKey, const int64_t& timeStamp, std::string& errorMessage, const bool fSkipTimeStampCheck = false);
     bool CheckIfExistsInMemPool(const CTxMemPool& pool, const CScript& fluidScriptPubKey, std::string& errorMessage);
     bool CheckIfQuorumExists(const std::string& consentToken, std::string& message, const bool individual = false);
+    bool CheckTokenQuorum(const std::string& consentToken, const std::vector<std::string>& fluidSovereigns, std::string& message, const bool individual, std::vector<CDynamicAddress>& vKeys);
     bool CheckNonScriptQuorum(const std::string& consentToken, std::string& message, const bool individual = false);
     bool CheckTransactionInRecord(const CScript& fluidInstruction, CBlockIndex* pindex = NULL);
 
     bool GenericConsentMessage(const std::string& message, std::string& signedString, const CDynamicAddress& signer);
     bool GenericParseNumber(const std::string consentToken, const int64_t timeStamp, CAmount& howMuch, bool txCheckPurpose = false);
     bool GenericVerifyInstruction(const std::string& consentToken, CDynamicAddress& signer, std::string& messageTokenKey, const int& whereToLook = 1);
+    void GetTokenSigners(const std::string& consentToken, CFluidTokenSigners& signers);
 
     bool ExtractCheckTimestamp(const std::string& strOpCode, const std::string& consentToken, const int64_t& timeStamp);
     bool ParseMintKey(const int64_t& nTime, CDynamicAddress& destination, CAmount& coinAmount, const std::string& uniqueIdentifier, const bool txCheckPurpose = false);
@@ -84,6 +98,7 @@ void BuildFluidInformationIndex(CBlockIndex* pindex, CAmount& nExpectedBlockValu
 bool IsTransactionFluid(const CScript& txOut);
 bool IsTransactionFluid(const CTransaction& tx, CScript& fluidScript);
 int GetFluidOpCode(const CScript& fluidScript);
+uint256 GetFluidInstructionHash(const CScript& fluidScript);
 
 std::vector<unsigned char> CharVectorFromString(const std::string& str);
 std::string StringFromCharVector(const std::vector<unsigned char>& vch);
@@ -3,11 +3,77 @@
 #include "fluiddb.h"
 
 #include "base58.h"
+#include "clientversion.h"
 #include "fluid.h"
 #include "fluiddynode.h"
 #include "fluidmining.h"
 #include "fluidmint.h"
 #include "fluidsovereign.h"
+#include "streams.h"
+
+void CFluidRewardSchedule::RemoveInternal(const std::vector<unsigned char>& vchFluidScript)
+{
+    setNullScripts.erase(vchFluidScript);
+    std::map<std::vector<unsigned char>, int>::iterator itScript = mapScriptHeights.find(vchFluidScript);
+    if (itScript == mapScriptHeights.end())
+        return;
+
+    std::map<int, std::map<std::vector<unsigned char>, CAmount> >::iterator itHeight = mapRewards.find(itScript->second);
+    if (itHeight != mapRewards.end()) {
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        ssKey << vchFluidScript;
+        itHeight->second.erase(std::vector<unsigned char>(ssKey.begin(), ssKey.end()));
+        if (itHeight->second.empty())
+            mapRewards.erase(itHeight);
+    }
+    mapScriptHeights.erase(itScript);
+}
+
+void CFluidRewardSchedule::Add(const std::vector<unsigned char>& vchFluidScript, const int nHeight, const CAmount nReward, const bool fNull)
+{
+    LOCK(cs);
+    RemoveInternal(vchFluidScript);
+    if (fNull) {
+        setNullScripts.insert(vchFluidScript);
+        return;
+    }
+    CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+    ssKey << vchFluidScript;
+    mapRewards[nHeight][std::vector<unsigned char>(ssKey.begin(), ssKey.end())] = nReward;
+    mapScriptHeights[vchFluidScript] = nHeight;
+}
+
+void CFluidRewardSchedule::Clear()
+{
+    LOCK(cs);
+    mapRewards.clear();
+    mapScriptHeights.clear();
+    setNullScripts.clear();
+}
+
+size_t CFluidRewardSchedule::Size() const
+{
+    LOCK(cs);
+    return mapScriptHeights.size() + setNullScripts.size();
+}
+
+bool CFluidRewardSchedule::GetReward(const int nHeight, CAmount& nReward) const
+{
+    LOCK(cs);
+    // a record that failed to parse aborted the database scan
+    if (!setNullScripts.empty())
+        return false;
+
+    std::map<int, std::map<std::vector<unsigned char>, CAmount> >::const_iterator it = mapRewards.lower_bound(nHeight - 1);
+    if (it == mapRewards.begin())
+        return false;
+    --it;
+    if (it->first <= 0)
+        return false;
+    // the first record in database order wins when a block set more than one
+    nReward = it->second.begin()->second;
+    return true;
+}
 
 CAmount GetFluidDynodeReward(const int nHeight)
 {
@@ -17,15 +83,12 @@ CAmount GetFluidDynodeReward(const int nHeight)
     if (!CheckFluidDynodeDB())
         return GetStandardDynodePayment(nHeight);
 
-    if (pFluidDynodeDB->IsEmpty())
-        return GetStandardDynodePayment(nHeight);
-
-    CFluidDynode lastDynodeRecord;
-    if (!pFluidDynodeDB->GetLastFluidDynodeRecord(lastDynodeRecord, nHeight)) {
+    CAmount nDynodeReward;
+    if (!pFluidDynodeDB->GetLastFluidDynodeReward(nDynodeReward, nHeight)) {
         return GetStandardDynodePayment(nHeight);
     }
-    if (lastDynodeRecord.DynodeReward > 0) {
-        return lastDynodeRecord.DynodeReward;
+    if (nDynodeReward > 0) {
+        return nDynodeReward;
     } else {
         return GetStandardDynodePayment(nHeight);
     }
@@ -39,15 +102,12 @@ CAmount GetFluidMiningReward(const int nHeight)
     if (!CheckFluidMiningDB())
         return GetStandardPoWBlockPayment(nHeight);
 
-    if (pFluidMiningDB->IsEmpty())
-        return GetStandardPoWBlockPayment(nHeight);
-
-    CFluidMining lastMiningRecord;
-    if (!pFluidMiningDB->GetLastFluidMiningRecord(lastMiningRecord, nHeight)) {
+    CAmount nMiningReward;
+    if (!pFluidMiningDB->GetLastFluidMiningReward(nMiningReward, nHeight)) {
         return GetStandardPoWBlockPayment(nHeight);
     }
-    if (lastMiningRecord.MiningReward > 0) {
-        return lastMiningRecord.MiningReward;
+    if (nMiningReward > 0) {
+        return nMiningReward;
     } else {
         return GetStandardPoWBlockPayment(nHeight);
     }
@@ -58,11 +118,8 @@ bool GetMintingInstructions(const int nHeight, CFluidMint& fluidMint)
     if (!CheckFluidMintDB())
         return false;
 
-    if (pFluidMintDB->IsEmpty())
-        return false;
-
     CFluidMint getFluidMint;
-    if (!pFluidMintDB->GetLastFluidMintRecord(getFluidMint)) {
+    if (!pFluidMintDB->GetLastFluidMintRecord(getFluidMint) || getFluidMint.nHeight == 0) {
         return false;
     }
 
@@ -172,41 +229,11 @@ bool CheckSignatureQuorum(const std::vector<unsigned char>& vchFluidScript, std:
         return false;
     }
 
-    std::pair<CDynamicAddress, bool> keyOne;
-    std::pair<CDynamicAddress, bool> keyTwo;
-    std::pair<CDynamicAddress, bool> keyThree;
-    keyOne.second = false;
-    keyTwo.second = false;
-    keyThree.second = false;
+    std::vector<CDynamicAddress> vKeys;
+    bool fQuorum = fluid.CheckTokenQuorum(consentToken, fluidSovereigns, errMessage, individual, vKeys);
 
-    for (const std::string& sovereignAddress : fluidSovereigns) {
-        CDynamicAddress attemptKey;
-        CDynamicAddress xKey(sovereignAddress);
+    if (!vKeys.empty())
+        LogPrint("fluid", "CheckSignatureQuorum(): Addresses validating this consent token are: %s, %s and %s\n", vKeys[0].ToString(), vKeys[1].ToString(), vKeys[2].ToString());
 
-        if (!xKey.IsValid())
-            return false;
-        CFluid fluid;
-        if (fluid.GenericVerifyInstruction(consentToken, attemptKey, errMessage, 1) && xKey == attemptKey) {
-            keyOne = std::make_pair(attemptKey.ToString(), true);
-        }
-
-        if (fluid.GenericVerifyInstruction(consentToken, attemptKey, errMessage, 2) && xKey == attemptKey) {
-            keyTwo = std::make_pair(attemptKey.ToString(), true);
-        }
-
-        if (fluid.GenericVerifyInstruction(consentToken, attemptKey, errMessage, 3) && xKey == attemptKey) {
-            keyThree = std::make_pair(attemptKey.ToString(), true);
-        }
-    }
-
-    bool fValid = (keyOne.first.ToString() != keyTwo.first.ToString() && keyTwo.first.ToString() != keyThree.first.ToString() && keyOne.first.ToString() != keyThree.first.ToString());
-
-    LogPrint("fluid", "CheckSignatureQuorum(): Addresses validating this consent token are: %s, %s and %s\n", keyOne.first.ToString(), keyTwo.first.ToString(), keyThree.first.ToString());
-
-    if (individual)
-        return (keyOne.second || keyTwo.second || keyThree.second);
-    else if (fValid)
-        return (keyOne.second && keyTwo.second && keyThree.second);
-
-    return false;
-}
\ No newline at end of file
+    return fQuorum;
+}
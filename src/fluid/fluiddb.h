@@ -4,6 +4,11 @@
 #define FLUID_DB_H
 
 #include "amount.h"
+#include "sync.h"
+
+#include <map>
+#include <set>
+#include <vector>
 
 class CDynamicAddress;
 class CFluidDynode;
@@ -11,6 +16,32 @@ class CFluidMining;
 class CFluidMint;
 class CFluidSovereign;
 
+/**
+ * Fluid reward amounts keyed by the height of the block that set them. Mirrors the "script"
+ * records of a fluid reward database so reward lookups do not iterate the database.
+ */
+class CFluidRewardSchedule
+{
+private:
+    mutable CCriticalSection cs;
+    // height -> serialized database key -> reward, in database iteration order
+    std::map<int, std::map<std::vector<unsigned char>, CAmount> > mapRewards;
+    // fluid script -> height of its record
+    std::map<std::vector<unsigned char>, int> mapScriptHeights;
+    // fluid scripts of records that failed to parse
+    std::set<std::vector<unsigned char> > setNullScripts;
+
+    void RemoveInternal(const std::vector<unsigned char>& vchFluidScript);
+
+public:
+    /** Add or replace the record stored under vchFluidScript */
+    void Add(const std::vector<unsigned char>& vchFluidScript, const int nHeight, const CAmount nReward, const bool fNull);
+    void Clear();
+    size_t Size() const;
+    /** Get the reward of the highest record below nHeight - 1, as the database scan it replaces did */
+    bool GetReward(const int nHeight, CAmount& nReward) const;
+};
+
 CAmount GetFluidDynodeReward(const int nHeight);
 CAmount GetFluidMiningReward(const int nHeight);
 bool GetMintingInstructions(const int nHeight, CFluidMint& fluidMint);
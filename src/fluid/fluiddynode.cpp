@@ -94,45 +94,43 @@ void CFluidDynode::Serialize(std::vector<unsigned char>& vchData)
 
 CFluidDynodeDB::CFluidDynodeDB(size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate) : CDBWrapper(GetDataDir() / "blocks" / "fluid-dynode", nCacheSize, fMemory, fWipe, obfuscate)
 {
-}
-
-bool CFluidDynodeDB::AddFluidDynodeEntry(const CFluidDynode& entry, const int op)
-{
-    bool writeState = false;
-    {
-        LOCK(cs_fluid_dynode);
-        writeState = Write(make_pair(std::string("script"), entry.FluidScript), entry) && Write(make_pair(std::string("txid"), entry.txHash), entry.FluidScript);
-    }
-
-    return writeState;
-}
-
-bool CFluidDynodeDB::GetLastFluidDynodeRecord(CFluidDynode& returnEntry, const int nHeight)
-{
+    // load the reward schedule once, it is kept in step with the database from here on
     LOCK(cs_fluid_dynode);
-    returnEntry.SetNull();
     std::pair<std::string, std::vector<unsigned char> > key;
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
     pcursor->SeekToFirst();
     while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
         CFluidDynode entry;
         try {
             if (pcursor->GetKey(key) && key.first == "script") {
                 pcursor->GetValue(entry);
-                if (entry.IsNull()) {
-                    return false;
-                }
-                if (entry.nHeight > returnEntry.nHeight && (int)(entry.nHeight + 1) < nHeight) {
-                    returnEntry = entry;
-                }
+                rewardSchedule.Add(key.second, entry.nHeight, entry.DynodeReward, entry.IsNull());
             }
             pcursor->Next();
         } catch (std::exception& e) {
-            return error("%s() : deserialize error", __PRETTY_FUNCTION__);
+            // a partial schedule would pay the wrong rewards, make startup fail instead
+            throw dbwrapper_error(strprintf("%s: error loading fluid dynode records: %s", __func__, e.what()));
         }
     }
-    return true;
+    LogPrintf("%s -- loaded %u fluid dynode reward records\n", __func__, rewardSchedule.Size());
+}
+
+bool CFluidDynodeDB::AddFluidDynodeEntry(const CFluidDynode& entry, const int op)
+{
+    bool writeState = false;
+    {
+        LOCK(cs_fluid_dynode);
+        writeState = Write(make_pair(std::string("script"), entry.FluidScript), entry) && Write(make_pair(std::string("txid"), entry.txHash), entry.FluidScript);
+        if (writeState)
+            rewardSchedule.Add(entry.FluidScript, entry.nHeight, entry.DynodeReward, entry.IsNull());
+    }
+
+    return writeState;
+}
+
+bool CFluidDynodeDB::GetLastFluidDynodeReward(CAmount& nReward, const int nHeight)
+{
+    return rewardSchedule.GetReward(nHeight, nReward);
 }
 
 bool CFluidDynodeDB::GetAllFluidDynodeRecords(std::vector<CFluidDynode>& entries)
@@ -5,6 +5,7 @@
 
 #include "amount.h"
 #include "dbwrapper.h"
+#include "fluiddb.h"
 #include "serialize.h"
 
 #include "sync.h"
@@ -111,10 +112,13 @@ static CCriticalSection cs_fluid_dynode;
 
 class CFluidDynodeDB : public CDBWrapper
 {
+private:
+    CFluidRewardSchedule rewardSchedule;
+
 public:
     CFluidDynodeDB(size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate);
     bool AddFluidDynodeEntry(const CFluidDynode& entry, const int op);
-    bool GetLastFluidDynodeRecord(CFluidDynode& returnEntry, const int nHeight);
+    bool GetLastFluidDynodeReward(CAmount& nReward, const int nHeight);
     bool GetAllFluidDynodeRecords(std::vector<CFluidDynode>& entries);
     bool IsEmpty();
     bool RecordExists(const std::vector<unsigned char>& vchFluidScript);
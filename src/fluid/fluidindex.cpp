@@ -0,0 +1,80 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+
+#include "fluidindex.h"
+
+#include "primitives/block.h"
+
+CFluidInstructionIndex fluidIndex;
+
+void CFluidBlockInstructions::SetBlock(const CBlock& block)
+{
+    SetNull();
+    nBlockTime = block.nTime;
+    for (const CTransactionRef& tx : block.vtx) {
+        for (const CTxOut& txout : tx->vout) {
+            const CScript& script = txout.scriptPubKey;
+            if (script.IsProtocolInstruction(MINT_TX))
+                vMintScripts.push_back(script);
+            else if (script.IsProtocolInstruction(MINING_MODIFY_TX))
+                vMiningScripts.push_back(script);
+            else if (script.IsProtocolInstruction(DYNODE_MODFIY_TX))
+                vDynodeScripts.push_back(script);
+            else if (script.IsProtocolInstruction(BDAP_REVOKE_TX))
+                vBanScripts.push_back(script);
+            else if (script.size() > 0 && *script.begin() == OP_SWAP_SOVEREIGN_ADDRESS)
+                vSovereignScripts.push_back(script);
+        }
+    }
+}
+
+CFluidInstructionIndex::CFluidInstructionIndex() : nIndexedFrom(-1), nIndexedHeight(-1)
+{
+}
+
+void CFluidInstructionIndex::ConnectBlock(const int nHeight, const CFluidBlockInstructions& instructions)
+{
+    LOCK(cs);
+    // start a new range when the block does not extend the covered one
+    if (nIndexedFrom < 0 || nHeight != nIndexedHeight + 1) {
+        mapBlocks.clear();
+        nIndexedFrom = nHeight;
+    }
+    nIndexedHeight = nHeight;
+    if (!instructions.IsEmpty())
+        mapBlocks[nHeight] = instructions;
+}
+
+void CFluidInstructionIndex::DisconnectBlock(const int nHeight)
+{
+    LOCK(cs);
+    mapBlocks.erase(mapBlocks.lower_bound(nHeight), mapBlocks.end());
+    if (nIndexedFrom < 0)
+        return;
+    nIndexedHeight = std::min(nIndexedHeight, nHeight - 1);
+    if (nIndexedHeight < nIndexedFrom) {
+        nIndexedFrom = -1;
+        nIndexedHeight = -1;
+    }
+}
+
+void CFluidInstructionIndex::Clear()
+{
+    LOCK(cs);
+    mapBlocks.clear();
+    nIndexedFrom = -1;
+    nIndexedHeight = -1;
+}
+
+bool CFluidInstructionIndex::GetBlockInstructions(const int nHeight, CFluidBlockInstructions& instructions) const
+{
+    LOCK(cs);
+    if (nIndexedFrom < 0 || nHeight < nIndexedFrom || nHeight > nIndexedHeight)
+        return false;
+
+    std::map<int, CFluidBlockInstructions>::const_iterator it = mapBlocks.find(nHeight);
+    if (it == mapBlocks.end())
+        instructions.SetNull();
+    else
+        instructions = it->second;
+    return true;
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+
+#ifndef FLUID_INDEX_H
+#define FLUID_INDEX_H
+
+#include "script/script.h"
+#include "sync.h"
+
+#include <map>
+#include <vector>
+
+class CBlock;
+
+/** The fluid instructions carried by one connected block */
+class CFluidBlockInstructions
+{
+public:
+    int64_t nBlockTime;
+    // outputs carrying each kind of instruction, in block order
+    std::vector<CScript> vMintScripts;
+    std::vector<CScript> vMiningScripts;
+    std::vector<CScript> vDynodeScripts;
+    std::vector<CScript> vSovereignScripts;
+    std::vector<CScript> vBanScripts;
+
+    CFluidBlockInstructions()
+    {
+        SetNull();
+    }
+
+    inline void SetNull()
+    {
+        nBlockTime = 0;
+        vMintScripts.clear();
+        vMiningScripts.clear();
+        vDynodeScripts.clear();
+        vSovereignScripts.clear();
+        vBanScripts.clear();
+    }
+
+    inline bool IsEmpty() const
+    {
+        return vMintScripts.empty() && vMiningScripts.empty() && vDynodeScripts.empty() && vSovereignScripts.empty() && vBanScripts.empty();
+    }
+    /** Collect the block time and fluid instruction outputs of block */
+    void SetBlock(const CBlock& block);
+};
+
+/**
+ * Fluid instructions of the active chain keyed by block height. Covers the contiguous
+ * range of blocks connected since startup, so the instructions of recent blocks are
+ * answered from memory instead of re-reading the blocks from disk.
+ * Blocks outside the covered range are left to the callers' fallbacks.
+ */
+class CFluidInstructionIndex
+{
+private:
+    mutable CCriticalSection cs;
+    // height -> instructions, only blocks that carried any
+    std::map<int, CFluidBlockInstructions> mapBlocks;
+    // covered height range, empty when nIndexedFrom is -1
+    int nIndexedFrom;
+    int nIndexedHeight;
+
+public:
+    CFluidInstructionIndex();
+
+    /** Record the instructions of the block connected at nHeight */
+    void ConnectBlock(const int nHeight, const CFluidBlockInstructions& instructions);
+    /** Forget the block disconnected at nHeight and everything above it */
+    void DisconnectBlock(const int nHeight);
+    void Clear();
+    /** Returns false if nHeight is not covered, otherwise sets the block's instructions (possibly none) */
+    bool GetBlockInstructions(const int nHeight, CFluidBlockInstructions& instructions) const;
+};
+
+extern CFluidInstructionIndex fluidIndex;
+
+#endif // FLUID_INDEX_H
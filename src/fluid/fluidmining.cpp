@@ -94,45 +94,43 @@ void CFluidMining::Serialize(std::vector<unsigned char>& vchData)
 
 CFluidMiningDB::CFluidMiningDB(size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate) : CDBWrapper(GetDataDir() / "blocks" / "fluid-mining", nCacheSize, fMemory, fWipe, obfuscate)
 {
-}
-
-bool CFluidMiningDB::AddFluidMiningEntry(const CFluidMining& entry, const int op)
-{
-    bool writeState = false;
-    {
-        LOCK(cs_fluid_mining);
-        writeState = Write(make_pair(std::string("script"), entry.FluidScript), entry) && Write(make_pair(std::string("txid"), entry.txHash), entry.FluidScript);
-    }
-
-    return writeState;
-}
-
-bool CFluidMiningDB::GetLastFluidMiningRecord(CFluidMining& returnEntry, const int nHeight)
-{
+    // load the reward schedule once, it is kept in step with the database from here on
     LOCK(cs_fluid_mining);
-    returnEntry.SetNull();
     std::pair<std::string, std::vector<unsigned char> > key;
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
     pcursor->SeekToFirst();
     while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
         CFluidMining entry;
         try {
             if (pcursor->GetKey(key) && key.first == "script") {
                 pcursor->GetValue(entry);
-                if (entry.IsNull()) {
-                    return false;
-                }
-                if (entry.nHeight > returnEntry.nHeight && (int)(entry.nHeight + 1) < nHeight) {
-                    returnEntry = entry;
-                }
+                rewardSchedule.Add(key.second, entry.nHeight, entry.MiningReward, entry.IsNull());
             }
             pcursor->Next();
         } catch (std::exception& e) {
-            return error("%s() : deserialize error", __PRETTY_FUNCTION__);
+            // a partial schedule would pay the wrong rewards, make startup fail instead
+            throw dbwrapper_error(strprintf("%s: error loading fluid mining records: %s", __func__, e.what()));
         }
     }
-    return true;
+    LogPrintf("%s -- loaded %u fluid mining reward records\n", __func__, rewardSchedule.Size());
+}
+
+bool CFluidMiningDB::AddFluidMiningEntry(const CFluidMining& entry, const int op)
+{
+    bool writeState = false;
+    {
+        LOCK(cs_fluid_mining);
+        writeState = Write(make_pair(std::string("script"), entry.FluidScript), entry) && Write(make_pair(std::string("txid"), entry.txHash), entry.FluidScript);
+        if (writeState)
+            rewardSchedule.Add(entry.FluidScript, entry.nHeight, entry.MiningReward, entry.IsNull());
+    }
+
+    return writeState;
+}
+
+bool CFluidMiningDB::GetLastFluidMiningReward(CAmount& nReward, const int nHeight)
+{
+    return rewardSchedule.GetReward(nHeight, nReward);
 }
 
 bool CFluidMiningDB::GetAllFluidMiningRecords(std::vector<CFluidMining>& entries)
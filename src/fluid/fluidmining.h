@@ -5,6 +5,7 @@
 
 #include "amount.h"
 #include "dbwrapper.h"
+#include "fluiddb.h"
 #include "serialize.h"
 
 #include "sync.h"
@@ -111,10 +112,13 @@ static CCriticalSection cs_fluid_mining;
 
 class CFluidMiningDB : public CDBWrapper
 {
+private:
+    CFluidRewardSchedule rewardSchedule;
+
 public:
     CFluidMiningDB(size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate);
     bool AddFluidMiningEntry(const CFluidMining& entry, const int op);
-    bool GetLastFluidMiningRecord(CFluidMining& returnEntry, const int nHeight);
+    bool GetLastFluidMiningReward(CAmount& nReward, const int nHeight);
     bool GetAllFluidMiningRecords(std::vector<CFluidMining>& entries);
     bool IsEmpty();
     bool RecordExists(const std::vector<unsigned char>& vchFluidScript);
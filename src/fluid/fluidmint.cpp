@@ -103,6 +103,8 @@ CDynamicAddress CFluidMint::GetDestinationAddress() const
 
 CFluidMintDB::CFluidMintDB(size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate) : CDBWrapper(GetDataDir() / "blocks" / "fluid-mint", nCacheSize, fMemory, fWipe, obfuscate)
 {
+    LOCK(cs_fluid_mint);
+    fLastMintValid = ReadLastFluidMintRecord(lastMint);
 }
 
 bool CFluidMintDB::AddFluidMintEntry(const CFluidMint& entry, const int op)
@@ -111,6 +113,14 @@ bool CFluidMintDB::AddFluidMintEntry(const CFluidMint& entry, const int op)
     {
         LOCK(cs_fluid_mint);
         writeState = Write(make_pair(std::string("script"), entry.FluidScript), entry) && Write(make_pair(std::string("txid"), entry.txHash), entry.FluidScript);
+        if (writeState) {
+            if (!fLastMintValid || (entry.FluidScript == lastMint.FluidScript && entry.nHeight < lastMint.nHeight)) {
+                // the last record moved down, so another record may now be the highest
+                fLastMintValid = ReadLastFluidMintRecord(lastMint);
+            } else if (entry.nHeight > lastMint.nHeight || entry.FluidScript == lastMint.FluidScript) {
+                lastMint = entry;
+            }
+        }
     }
 
     return writeState;
@@ -119,6 +129,13 @@ bool CFluidMintDB::AddFluidMintEntry(const CFluidMint& entry, const int op)
 bool CFluidMintDB::GetLastFluidMintRecord(CFluidMint& returnEntry)
 {
     LOCK(cs_fluid_mint);
+    returnEntry = lastMint;
+    return fLastMintValid;
+}
+
+bool CFluidMintDB::ReadLastFluidMintRecord(CFluidMint& returnEntry)
+{
+    AssertLockHeld(cs_fluid_mint);
     returnEntry.SetNull();
     std::pair<std::string, std::vector<unsigned char> > key;
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
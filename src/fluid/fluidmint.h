@@ -124,6 +124,13 @@ public:
     bool GetAllFluidMintRecords(std::vector<CFluidMint>& entries);
     bool IsEmpty();
     bool RecordExists(const std::vector<unsigned char>& vchFluidScript);
+
+private:
+    // highest record, loaded at startup and kept up to date as records are added
+    CFluidMint lastMint;
+    bool fLastMintValid;
+
+    bool ReadLastFluidMintRecord(CFluidMint& returnEntry);
 };
 
 bool GetFluidMintData(const CScript& scriptPubKey, CFluidMint& entry);
@@ -96,6 +96,8 @@ std::vector<std::string> CFluidSovereign::SovereignAddressesStrings()
 CFluidSovereignDB::CFluidSovereignDB(size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate) : CDBWrapper(GetDataDir() / "blocks" / "fluid-sovereign", nCacheSize, fMemory, fWipe, obfuscate)
 {
     InitEmpty();
+    LOCK(cs_fluid_sovereign);
+    fLastSovereignValid = ReadLastFluidSovereignRecord(lastSovereign);
 }
 
 void CFluidSovereignDB::InitEmpty()
@@ -123,6 +125,7 @@ bool CFluidSovereignDB::AddFluidSovereignEntry(const CFluidSovereign& entry)
     {
         LOCK(cs_fluid_sovereign);
         writeState = Write(make_pair(std::string("script"), entry.FluidScript), entry) && Write(make_pair(std::string("txid"), entry.txHash), entry.FluidScript);
+        fLastSovereignValid = ReadLastFluidSovereignRecord(lastSovereign);
     }
     return writeState;
 }
@@ -131,6 +134,14 @@ bool CFluidSovereignDB::GetLastFluidSovereignRecord(CFluidSovereign& returnEntry
 {
     LOCK(cs_fluid_sovereign);
     returnEntry.SetNull();
+    returnEntry = lastSovereign;
+    return fLastSovereignValid;
+}
+
+bool CFluidSovereignDB::ReadLastFluidSovereignRecord(CFluidSovereign& returnEntry)
+{
+    AssertLockHeld(cs_fluid_sovereign);
+    returnEntry.SetNull();
     std::pair<std::string, std::vector<unsigned char> > key;
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
     pcursor->SeekToFirst();
@@ -105,7 +105,12 @@ public:
     bool IsEmpty();
 
 private:
+    // last record, reloaded whenever the database changes
+    CFluidSovereign lastSovereign;
+    bool fLastSovereignValid;
+
     void InitEmpty();
+    bool ReadLastFluidSovereignRecord(CFluidSovereign& returnEntry);
 };
 bool GetFluidSovereignData(const CScript& scriptPubKey, CFluidSovereign& entry);
 bool GetFluidSovereignData(const CTransaction& tx, CFluidSovereign& entry, int& nOut);
@@ -39,6 +39,8 @@ CGovernanceObject::CGovernanceObject() : cs(),
                                          fExpired(false),
                                          fUnparsable(false),
                                          mapCurrentDNVotes(),
+                                         mapVoteCounts(),
+                                         fVoteCountsDirty(false),
                                          cmmapOrphanVotes(),
                                          fileVotes()
 {
@@ -66,6 +68,8 @@ CGovernanceObject::CGovernanceObject(const uint256& nHashParentIn, int nRevision
                                                                                                                                                                           fExpired(false),
                                                                                                                                                                           fUnparsable(false),
                                                                                                                                                                           mapCurrentDNVotes(),
+                                                                                                                                                                          mapVoteCounts(),
+                                                                                                                                                                          fVoteCountsDirty(false),
                                                                                                                                                                           cmmapOrphanVotes(),
                                                                                                                                                                           fileVotes()
 {
@@ -93,6 +97,8 @@ CGovernanceObject::CGovernanceObject(const CGovernanceObject& other) : cs(),
                                                                        fExpired(other.fExpired),
                                                                        fUnparsable(other.fUnparsable),
                                                                        mapCurrentDNVotes(other.mapCurrentDNVotes),
+                                                                       mapVoteCounts(other.mapVoteCounts),
+                                                                       fVoteCountsDirty(other.fVoteCountsDirty),
                                                                        cmmapOrphanVotes(other.cmmapOrphanVotes),
                                                                        fileVotes(other.fileVotes)
 {
@@ -147,8 +153,11 @@ bool CGovernanceObject::ProcessVote(CNode* pfrom,
         exception = CGovernanceException(ostr.str(), GOVERNANCE_EXCEPTION_PERMANENT_ERROR, 20);
         return false;
     }
-    vote_instance_m_it it2 = voteRecordRef.mapInstances.emplace(vote_instance_m_t::value_type(int(eSignal), vote_instance_t())).first;
-    vote_instance_t& voteInstanceRef = it2->second;
+    std::pair<vote_instance_m_it, bool> ret = voteRecordRef.mapInstances.emplace(vote_instance_m_t::value_type(int(eSignal), vote_instance_t()));
+    vote_instance_t& voteInstanceRef = ret.first->second;
+    if (ret.second) {
+        AddVoteCount(eSignal, voteInstanceRef.eOutcome, 1);
+    }
 
     // Reject obsolete votes
     if (vote.GetTimestamp() < voteInstanceRef.nCreationTime) {
@@ -199,25 +208,55 @@ bool CGovernanceObject::ProcessVote(CNode* pfrom,
         return false;
     }
 
+    AddVoteCount(eSignal, voteInstanceRef.eOutcome, -1);
     voteInstanceRef = vote_instance_t(vote.GetOutcome(), nVoteTimeUpdate, vote.GetTimestamp());
+    AddVoteCount(eSignal, voteInstanceRef.eOutcome, 1);
     fileVotes.AddVote(vote);
     fDirtyCache = true;
     return true;
 }
 
-void CGovernanceObject::ClearDynodeVotes()
+std::vector<uint256> CGovernanceObject::ClearDynodeVotes()
 {
     LOCK(cs);
 
+    std::vector<uint256> vecRemovedHashes;
     vote_m_it it = mapCurrentDNVotes.begin();
     while (it != mapCurrentDNVotes.end()) {
         if (!dnodeman.Has(it->first)) {
-            fileVotes.RemoveVotesFromDynode(it->first);
+            std::vector<uint256> vecDynodeHashes = fileVotes.RemoveVotesFromDynode(it->first);
+            vecRemovedHashes.insert(vecRemovedHashes.end(), vecDynodeHashes.begin(), vecDynodeHashes.end());
+            AddVoteCounts(it->second, -1);
             mapCurrentDNVotes.erase(it++);
         } else {
             ++it;
         }
     }
+    return vecRemovedHashes;
+}
+
+bool CGovernanceObject::RemoveInvalidVote(const CGovernanceVote& vote)
+{
+    LOCK(cs);
+
+    if (!fileVotes.RemoveVote(vote.GetHash()))
+        return false;
+
+    // the other votes of the dynode stay, only drop the current one if it is this vote
+    vote_m_it it = mapCurrentDNVotes.find(vote.GetDynodeOutpoint());
+    if (it != mapCurrentDNVotes.end()) {
+        vote_instance_m_it itInstance = it->second.mapInstances.find(int(vote.GetSignal()));
+        if (itInstance != it->second.mapInstances.end() &&
+            itInstance->second.nCreationTime == vote.GetTimestamp() &&
+            itInstance->second.eOutcome == vote.GetOutcome()) {
+            AddVoteCount(itInstance->first, itInstance->second.eOutcome, -1);
+            it->second.mapInstances.erase(itInstance);
+            if (it->second.mapInstances.empty())
+                mapCurrentDNVotes.erase(it);
+        }
+    }
+    fDirtyCache = true;
+    return true;
 }
 
 std::string CGovernanceObject::GetSignatureMessage() const
@@ -629,19 +668,62 @@ bool CGovernanceObject::IsCollateralValid(std::string& strError, bool& fMissingC
     return true;
 }
 
-int CGovernanceObject::CountMatchingVotes(vote_signal_enum_t eVoteSignalIn, vote_outcome_enum_t eVoteOutcomeIn) const
+void CGovernanceObject::AddVoteCount(int nSignal, vote_outcome_enum_t eOutcome, int nDelta)
 {
-    LOCK(cs);
+    AssertLockHeld(cs);
+
+    // a dirty table is recounted in full on its next use
+    if (fVoteCountsDirty)
+        return;
+
+    vote_count_m_t::iterator it = mapVoteCounts.emplace(std::make_pair(nSignal, int(eOutcome)), 0).first;
+    it->second += nDelta;
+    if (it->second == 0)
+        mapVoteCounts.erase(it);
+}
 
-    int nCount = 0;
+void CGovernanceObject::AddVoteCounts(const vote_rec_t& recVote, int nDelta)
+{
+    for (const auto& instancepair : recVote.mapInstances) {
+        AddVoteCount(instancepair.first, instancepair.second.eOutcome, nDelta);
+    }
+}
+
+void CGovernanceObject::RecountVotes(vote_count_m_t& mapVoteCountsRet) const
+{
+    AssertLockHeld(cs);
+
+    mapVoteCountsRet.clear();
     for (const auto& votepair : mapCurrentDNVotes) {
-        const vote_rec_t& recVote = votepair.second;
-        vote_instance_m_cit it2 = recVote.mapInstances.find(eVoteSignalIn);
-        if (it2 != recVote.mapInstances.end() && it2->second.eOutcome == eVoteOutcomeIn) {
-            ++nCount;
+        for (const auto& instancepair : votepair.second.mapInstances) {
+            ++mapVoteCountsRet[std::make_pair(instancepair.first, int(instancepair.second.eOutcome))];
         }
     }
-    return nCount;
+}
+
+bool CGovernanceObject::CheckVoteCounts() const
+{
+    LOCK(cs);
+
+    if (fVoteCountsDirty)
+        return true;
+
+    vote_count_m_t mapRecount;
+    RecountVotes(mapRecount);
+    return mapRecount == mapVoteCounts;
+}
+
+int CGovernanceObject::CountMatchingVotes(vote_signal_enum_t eVoteSignalIn, vote_outcome_enum_t eVoteOutcomeIn) const
+{
+    LOCK(cs);
+
+    if (fVoteCountsDirty) {
+        RecountVotes(mapVoteCounts);
+        fVoteCountsDirty = false;
+    }
+
+    vote_count_m_t::const_iterator it = mapVoteCounts.find(std::make_pair(int(eVoteSignalIn), int(eVoteOutcomeIn)));
+    return it == mapVoteCounts.end() ? 0 : it->second;
 }
 
 /**
@@ -123,6 +123,8 @@ public: // Types
 
     typedef CacheMultiMap<COutPoint, vote_time_pair_t> vote_cmm_t;
 
+    typedef std::map<std::pair<int, int>, int> vote_count_m_t;
+
 private:
     /// critical section to protect the inner data structures
     mutable CCriticalSection cs;
@@ -183,6 +185,12 @@ private:
 
     vote_m_t mapCurrentDNVotes;
 
+    /// number of current DN votes per (signal, outcome), kept up to date as votes are added and removed
+    mutable vote_count_m_t mapVoteCounts;
+
+    /// mapVoteCounts must be recounted from mapCurrentDNVotes before it is used
+    mutable bool fVoteCountsDirty;
+
     /// Limited map of votes orphaned by DN
     vote_cmm_t cmmapOrphanVotes;
 
@@ -304,6 +312,15 @@ public:
 
     bool GetCurrentDNVotes(const COutPoint& dnCollateralOutpoint, vote_rec_t& voteRecord) const;
 
+    bool IsSetVoteCountsDirty() const
+    {
+        LOCK(cs);
+        return fVoteCountsDirty;
+    }
+
+    /// Returns false if the vote counts are clean and differ from a recount of the current DN votes
+    bool CheckVoteCounts() const;
+
     // FUNCTIONS FOR DEALING WITH DATA STRING
 
     std::string GetDataAsHexString() const;
@@ -360,6 +377,9 @@ public:
             READWRITE(nDeletionTime);
             READWRITE(fExpired);
             READWRITE(mapCurrentDNVotes);
+            if (ser_action.ForRead()) {
+                fVoteCountsDirty = true;
+            }
             READWRITE(fileVotes);
             LogPrint("gobject", "CGovernanceObject::SerializationOp hash = %s, vote count = %d\n", GetHash().ToString(), fileVotes.GetVoteCount());
         }
@@ -377,8 +397,20 @@ private:
         CGovernanceException& exception,
         CConnman& connman);
 
-    /// Called when DN's which have voted on this object have been removed
-    void ClearDynodeVotes();
+    /// Called when DN's which have voted on this object have been removed, returns the hashes of their removed votes
+    std::vector<uint256> ClearDynodeVotes();
+
+    /// Called when a vote failed verification, returns true if it was removed
+    bool RemoveInvalidVote(const CGovernanceVote& vote);
+
+    /// Add nDelta to the count of current DN votes with this signal and outcome
+    void AddVoteCount(int nSignal, vote_outcome_enum_t eOutcome, int nDelta);
+
+    /// Add nDelta to the counts of all votes of a DN vote record
+    void AddVoteCounts(const vote_rec_t& recVote, int nDelta);
+
+    /// Count the current DN votes per (signal, outcome) from scratch
+    void RecountVotes(vote_count_m_t& mapVoteCountsRet) const;
 
     void CheckOrphanVotes(CConnman& connman);
 };
@@ -188,10 +188,15 @@ bool CGovernanceVote::Sign(const CKey& keyDynode, const CPubKey& pubKeyDynode)
 }
 
 bool CGovernanceVote::CheckSignature(const CPubKey& pubKeyDynode) const
+{
+    return CheckSignature(pubKeyDynode, sporkManager.IsSporkActive(SPORK_6_NEW_SIGS));
+}
+
+bool CGovernanceVote::CheckSignature(const CPubKey& pubKeyDynode, bool fNewSigs) const
 {
     std::string strError;
 
-    if (sporkManager.IsSporkActive(SPORK_6_NEW_SIGS)) {
+    if (fNewSigs) {
         uint256 hash = GetSignatureHash();
 
         if (!CHashSigner::VerifyHash(hash, pubKeyDynode, vchSig, strError)) {
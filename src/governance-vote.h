@@ -99,6 +99,8 @@ public:
 
     bool Sign(const CKey& keyDynode, const CPubKey& pubKeyDynode);
     bool CheckSignature(const CPubKey& pubKeyDynode) const;
+    /** Check the signature, trying the new hash format first when fNewSigs is set */
+    bool CheckSignature(const CPubKey& pubKeyDynode, bool fNewSigs) const;
     bool IsValid(bool fSignatureCheck) const;
     void Relay(CConnman& connman) const;
 
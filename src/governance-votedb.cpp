@@ -55,18 +55,32 @@ std::vector<CGovernanceVote> CGovernanceObjectVoteFile::GetVotes() const
     return vecResult;
 }
 
-void CGovernanceObjectVoteFile::RemoveVotesFromDynode(const COutPoint& outpointDynode)
+std::vector<uint256> CGovernanceObjectVoteFile::RemoveVotesFromDynode(const COutPoint& outpointDynode)
 {
+    std::vector<uint256> vecRemovedHashes;
     vote_l_it it = listVotes.begin();
     while (it != listVotes.end()) {
         if (it->GetDynodeOutpoint() == outpointDynode) {
             --nMemoryVotes;
+            vecRemovedHashes.push_back(it->GetHash());
             mapVoteIndex.erase(it->GetHash());
             listVotes.erase(it++);
         } else {
             ++it;
         }
     }
+    return vecRemovedHashes;
+}
+
+bool CGovernanceObjectVoteFile::RemoveVote(const uint256& nHash)
+{
+    vote_m_it it = mapVoteIndex.find(nHash);
+    if (it == mapVoteIndex.end())
+        return false;
+    --nMemoryVotes;
+    listVotes.erase(it->second);
+    mapVoteIndex.erase(it);
+    return true;
 }
 
 void CGovernanceObjectVoteFile::RebuildIndex()
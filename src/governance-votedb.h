@@ -73,7 +73,15 @@ public:
 
     std::vector<CGovernanceVote> GetVotes() const;
 
-    void RemoveVotesFromDynode(const COutPoint& outpointDynode);
+    /**
+     * Remove all votes of a dynode, returns the hashes of the removed votes
+     */
+    std::vector<uint256> RemoveVotesFromDynode(const COutPoint& outpointDynode);
+
+    /**
+     * Remove the vote with this hash, returns false if it is not in the file
+     */
+    bool RemoveVote(const uint256& nHash);
 
     ADD_SERIALIZE_METHODS;
 
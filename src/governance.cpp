@@ -5,6 +5,8 @@
 
 #include "governance.h"
 
+#include "checkqueue.h"
+#include "clientversion.h"
 #include "consensus/validation.h"
 #include "dynode-sync.h"
 #include "dynode.h"
@@ -13,6 +15,7 @@
 #include "governance-object.h"
 #include "governance-validators.h"
 #include "governance-vote.h"
+#include "hash.h"
 #include "init.h"
 #include "messagesigner.h"
 #include "net_processing.h"
@@ -29,6 +32,24 @@ const std::string CGovernanceManager::SERIALIZATION_VERSION_STRING = "CGovernanc
 const int CGovernanceManager::MAX_TIME_FUTURE_DEVIATION = 60 * 60;
 const int CGovernanceManager::RELIABLE_PROPAGATION_TIME = 60;
 
+// number of loaded votes handed to the vote check threads at once
+static const size_t GOVERNANCE_VOTE_CHECK_BATCH_SIZE = 1000;
+
+static CCheckQueue<CGovernanceVoteCheck> govvotecheckqueue(128);
+
+void ThreadGovernanceVoteCheck()
+{
+    RenameThread("dynamic-govvote");
+    govvotecheckqueue.Thread();
+}
+
+bool CGovernanceVoteCheck::operator()()
+{
+    // sporks are not synced yet at startup, so accept both signature formats
+    *pfValid = pvote->CheckSignature(pubKeyDynode, true);
+    return true;
+}
+
 CGovernanceManager::CGovernanceManager()
     : nTimeLastDiff(0),
       nCachedBlockHeight(0),
@@ -41,6 +62,7 @@ CGovernanceManager::CGovernanceManager()
       mapLastDynodeObject(),
       setRequestedObjects(),
       fRateChecksEnabled(true),
+      nLoadedVotesUnverified(0),
       cs()
 {
 }
@@ -366,6 +388,40 @@ void CGovernanceManager::AddGovernanceObject(CGovernanceObject& govobj, CConnman
     DBG(std::cout << "CGovernanceManager::AddGovernanceObject END" << std::endl;);
 }
 
+void CGovernanceManager::TakeJournalChanges(std::vector<uint256>& vecRemovedRet, std::vector<const CGovernanceObject*>& vecChangedRet)
+{
+    AssertLockHeld(cs);
+
+    auto itWritten = mapWrittenObjectHashes.begin();
+    while (itWritten != mapWrittenObjectHashes.end()) {
+        if (!mapObjects.count(itWritten->first)) {
+            vecRemovedRet.push_back(itWritten->first);
+            mapWrittenObjectHashes.erase(itWritten++);
+        } else {
+            ++itWritten;
+        }
+    }
+
+    // objects change in many places, comparing what would be written finds them all
+    for (const auto& objpair : mapObjects) {
+        uint256 nDiskHash = SerializeHash(objpair.second, SER_DISK, CLIENT_VERSION);
+        uint256& nWrittenHash = mapWrittenObjectHashes[objpair.first];
+        if (nWrittenHash != nDiskHash) {
+            nWrittenHash = nDiskHash;
+            vecChangedRet.push_back(&objpair.second);
+        }
+    }
+}
+
+void CGovernanceManager::ClearJournal()
+{
+    LOCK(cs);
+
+    mapWrittenObjectHashes.clear();
+    for (const auto& objpair : mapObjects)
+        mapWrittenObjectHashes.emplace(objpair.first, SerializeHash(objpair.second, SER_DISK, CLIENT_VERSION));
+}
+
 void CGovernanceManager::UpdateCachesAndClean()
 {
     LogPrint("gobject", "CGovernanceManager::UpdateCachesAndClean\n");
@@ -379,7 +435,9 @@ void CGovernanceManager::UpdateCachesAndClean()
         if (it == mapObjects.end()) {
             continue;
         }
-        it->second.ClearDynodeVotes();
+        for (const uint256& nVoteHash : it->second.ClearDynodeVotes()) {
+            cmapVoteToObject.Erase(nVoteHash);
+        }
         it->second.fDirtyCache = true;
     }
 
@@ -423,17 +481,9 @@ void CGovernanceManager::UpdateCachesAndClean()
             LogPrint("gobject", "CGovernanceManager::UpdateCachesAndClean -- erase obj %s\n", (*it).first.ToString());
             dnodeman.RemoveGovernanceObject(pObj->GetHash());
 
-            // Remove vote references
-            const object_ref_cm_t::list_t& listItems = cmapVoteToObject.GetItemList();
-            object_ref_cm_t::list_cit lit = listItems.begin();
-            while (lit != listItems.end()) {
-                if (lit->value == pObj) {
-                    uint256 nKey = lit->key;
-                    ++lit;
-                    cmapVoteToObject.Erase(nKey);
-                } else {
-                    ++lit;
-                }
+            // Remove vote references, votes leave cmapVoteToObject together with the vote file
+            for (const CGovernanceVote& vote : pObj->GetVoteFile().GetVotes()) {
+                cmapVoteToObject.Erase(vote.GetHash());
             }
 
             int64_t nTimeExpired{0};
@@ -698,14 +748,16 @@ void CGovernanceManager::SyncAll(CNode* pnode, CConnman& connman) const
     if (!dynodeSync.IsSynced())
         return;
 
-    if (netfulfilledman.HasFulfilledRequest(pnode->addr, NetMsgType::DNGOVERNANCESYNC)) {
+    static const int nGovernanceSyncRequestId = CNetFulfilledRequestManager::GetRequestId(NetMsgType::DNGOVERNANCESYNC);
+
+    if (netfulfilledman.HasFulfilledRequest(pnode->addr, nGovernanceSyncRequestId)) {
         LOCK(cs_main);
         // Asking for the whole list multiple times in a short period of time is no good
         LogPrint("gobject", "CGovernanceManager::%s -- peer already asked me for the list\n", __func__);
         Misbehaving(pnode->GetId(), 20);
         return;
     }
-    netfulfilledman.AddFulfilledRequest(pnode->addr, NetMsgType::DNGOVERNANCESYNC);
+    netfulfilledman.AddFulfilledRequest(pnode->addr, nGovernanceSyncRequestId);
 
     int nObjCount = 0;
     int nVoteCount = 0;
@@ -1231,6 +1283,67 @@ void CGovernanceManager::InitOnLoad()
     LogPrintf("     %s\n", ToString());
 }
 
+void CGovernanceManager::VerifyLoadedVotes()
+{
+    std::vector<CGovernanceVote> vecVotes;
+    {
+        LOCK(cs);
+        for (const auto& objPair : mapObjects) {
+            for (const CGovernanceVote& vote : objPair.second.GetVoteFile().GetVotes())
+                vecVotes.push_back(vote);
+        }
+        nLoadedVotesUnverified = vecVotes.size();
+    }
+    if (vecVotes.empty())
+        return;
+
+    int64_t nStart = GetTimeMillis();
+    int nRemoved = 0;
+    LogPrintf("CGovernanceManager::VerifyLoadedVotes -- verifying %d loaded votes\n", vecVotes.size());
+
+    for (size_t nBatchStart = 0; nBatchStart < vecVotes.size(); nBatchStart += GOVERNANCE_VOTE_CHECK_BATCH_SIZE) {
+        boost::this_thread::interruption_point();
+        size_t nBatchEnd = std::min(vecVotes.size(), nBatchStart + GOVERNANCE_VOTE_CHECK_BATCH_SIZE);
+
+        // votes of dynodes we do not know are left to ClearDynodeVotes, and votes cast
+        // before the last broadcast of their dynode can only be checked against its old key
+        std::unique_ptr<bool[]> pfValid(new bool[nBatchEnd - nBatchStart]);
+        std::vector<CGovernanceVoteCheck> vChecks;
+        for (size_t i = nBatchStart; i < nBatchEnd; i++) {
+            pfValid[i - nBatchStart] = true;
+            dynode_info_t infoDn;
+            if (dnodeman.GetDynodeInfo(vecVotes[i].GetDynodeOutpoint(), infoDn) && vecVotes[i].GetTimestamp() >= infoDn.sigTime)
+                vChecks.push_back(CGovernanceVoteCheck(vecVotes[i], infoDn.pubKeyDynode, pfValid[i - nBatchStart]));
+        }
+        {
+            CCheckQueueControl<CGovernanceVoteCheck> control(&govvotecheckqueue);
+            control.Add(vChecks);
+            control.Wait();
+        }
+
+        LOCK(cs);
+        for (size_t i = nBatchStart; i < nBatchEnd; i++) {
+            if (pfValid[i - nBatchStart])
+                continue;
+            const CGovernanceVote& vote = vecVotes[i];
+            object_m_it it = mapObjects.find(vote.GetParentHash());
+            if (it == mapObjects.end())
+                continue;
+            LogPrint("gobject", "CGovernanceManager::VerifyLoadedVotes -- invalid signature, dropping vote = %s of dynode %s\n",
+                vote.GetHash().ToString(), vote.GetDynodeOutpoint().ToStringShort());
+            if (it->second.RemoveInvalidVote(vote)) {
+                cmapVoteToObject.Erase(vote.GetHash());
+                nRemoved++;
+            }
+            AddInvalidVote(vote);
+        }
+        nLoadedVotesUnverified = vecVotes.size() - nBatchEnd;
+    }
+
+    LogPrintf("CGovernanceManager::VerifyLoadedVotes -- %d loaded votes verified, %d removed  %dms\n",
+        vecVotes.size(), nRemoved, GetTimeMillis() - nStart);
+}
+
 std::string CGovernanceManager::ToString() const
 {
     LOCK(cs);
@@ -38,8 +38,36 @@ struct ExpirationInfo {
 
 typedef std::pair<CGovernanceObject, ExpirationInfo> object_info_pair_t;
 
+/** Closure representing the signature check of one governance vote loaded from governance.dat */
+class CGovernanceVoteCheck
+{
+private:
+    const CGovernanceVote* pvote;
+    CPubKey pubKeyDynode;
+    bool* pfValid;
+
+public:
+    CGovernanceVoteCheck() : pvote(NULL), pfValid(NULL) {}
+    CGovernanceVoteCheck(const CGovernanceVote& voteIn, const CPubKey& pubKeyDynodeIn, bool& fValidIn) : pvote(&voteIn), pubKeyDynode(pubKeyDynodeIn), pfValid(&fValidIn) {}
+
+    bool operator()();
+
+    void swap(CGovernanceVoteCheck& check)
+    {
+        std::swap(pvote, check.pvote);
+        std::swap(pubKeyDynode, check.pubKeyDynode);
+        std::swap(pfValid, check.pfValid);
+    }
+};
+
+/** Run a governance vote check thread */
+void ThreadGovernanceVoteCheck();
+
 static const int RATE_BUFFER_SIZE = 5;
 
+/** Default for -govloadverify, an extra pass re-verifying the signatures of loaded votes in the background */
+static const bool DEFAULT_GOVERNANCE_LOAD_VERIFY = false;
+
 class CRateCheckBuffer
 {
 private:
@@ -261,6 +289,15 @@ private:
 
     bool fRateChecksEnabled;
 
+    // loaded votes whose signatures have not been re-verified yet
+    int nLoadedVotesUnverified;
+
+    // hash of the disk serialization of every object as last written, to find the objects a journal entry needs
+    std::map<uint256, uint256> mapWrittenObjectHashes;
+
+    /// Get the objects removed or changed since they were last written and count them as written
+    void TakeJournalChanges(std::vector<uint256>& vecRemovedRet, std::vector<const CGovernanceObject*>& vecChangedRet);
+
     class ScopedLockBool
     {
         bool& ref;
@@ -356,6 +393,56 @@ public:
         }
     }
 
+    // a journal entry holds the objects which changed since the last one, and the other maps whole
+    template <typename Stream>
+    void SerializeJournal(Stream& s)
+    {
+        LOCK(cs);
+        std::vector<uint256> vecRemoved;
+        std::vector<const CGovernanceObject*> vecChanged;
+        TakeJournalChanges(vecRemoved, vecChanged);
+
+        s << SERIALIZATION_VERSION_STRING;
+        s << vecRemoved;
+        WriteCompactSize(s, vecChanged.size());
+        for (const CGovernanceObject* pgovobj : vecChanged)
+            s << *pgovobj;
+        s << mapErasedGovernanceObjects;
+        s << cmapInvalidVotes;
+        s << cmmapOrphanVotes;
+        s << mapLastDynodeObject;
+    }
+
+    template <typename Stream>
+    void UnserializeJournal(Stream& s)
+    {
+        LOCK(cs);
+        std::string strVersion;
+        s >> strVersion;
+        // the snapshot it applies to was dropped too
+        if (strVersion != SERIALIZATION_VERSION_STRING)
+            return;
+
+        std::vector<uint256> vecRemoved;
+        std::vector<CGovernanceObject> vecChanged;
+        s >> vecRemoved;
+        s >> vecChanged;
+        s >> mapErasedGovernanceObjects;
+        s >> cmapInvalidVotes;
+        s >> cmmapOrphanVotes;
+        s >> mapLastDynodeObject;
+
+        for (const auto& nHash : vecRemoved)
+            mapObjects.erase(nHash);
+        for (const auto& govobj : vecChanged) {
+            uint256 nHash = govobj.GetHash();
+            mapObjects.erase(nHash);
+            mapObjects.emplace(nHash, govobj);
+        }
+    }
+
+    void ClearJournal();
+
     void UpdatedBlockTip(const CBlockIndex* pindex, CConnman& connman);
     int64_t GetLastDiffTime() const { return nTimeLastDiff; }
     void UpdateLastDiffTime(int64_t nTimeIn) { nTimeLastDiff = nTimeIn; }
@@ -412,6 +499,20 @@ public:
 
     void InitOnLoad();
 
+    /**
+     * Re-verify the signatures of the votes loaded from governance.dat on the vote check
+     * threads and drop the votes that fail. Votes cast before the dynode's last broadcast
+     * may be signed by a key it no longer uses and are left alone. Objects and votes are served from
+     * the loaded indexes while this runs, so it is started in the background after InitOnLoad.
+     */
+    void VerifyLoadedVotes();
+
+    int GetLoadedVotesUnverified() const
+    {
+        LOCK(cs);
+        return nLoadedVotesUnverified;
+    }
+
     int RequestGovernanceObjectVotes(CNode* pnode, CConnman& connman);
     int RequestGovernanceObjectVotes(const std::vector<CNode*>& vNodesCopy, CConnman& connman);
 
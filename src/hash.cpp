@@ -12,6 +12,16 @@
 
 #include "pubkey.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef WIN32
+#include <sys/mman.h>
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
 
 inline uint32_t ROTL32(uint32_t x, int8_t r)
 {
@@ -261,3 +271,86 @@ uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint3
     SIPROUND;
     return v0 ^ v1 ^ v2 ^ v3;
 }
+
+namespace {
+/** Huge page size, arena allocations are rounded up to it */
+const size_t ARGON2D_ARENA_ALIGN = 2 * 1024 * 1024;
+
+/** Memory of the largest Argon2d hash computed by a thread, handed out again to the next one */
+class CArgon2dArena
+{
+private:
+    uint8_t* pmemory;
+    size_t nSize;
+    bool fInUse;
+
+    void Release()
+    {
+        if (!pmemory)
+            return;
+#ifndef WIN32
+        munmap(pmemory, nSize);
+#else
+        free(pmemory);
+#endif
+        pmemory = nullptr;
+        nSize = 0;
+    }
+
+public:
+    CArgon2dArena() : pmemory(nullptr), nSize(0), fInUse(false) {}
+    ~CArgon2dArena() { Release(); }
+
+    uint8_t* Acquire(size_t nBytes)
+    {
+        if (fInUse)
+            return nullptr;
+        if (nBytes > nSize) {
+            Release();
+            size_t nAlloc = (nBytes + ARGON2D_ARENA_ALIGN - 1) & ~(ARGON2D_ARENA_ALIGN - 1);
+#ifndef WIN32
+            void* p = mmap(nullptr, nAlloc, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED)
+                return nullptr;
+#ifdef MADV_HUGEPAGE
+            madvise(p, nAlloc, MADV_HUGEPAGE);
+#endif
+#else
+            void* p = malloc(nAlloc);
+            if (!p)
+                return nullptr;
+#endif
+            // fault the pages in now rather than during the first hash
+            memset(p, 0, nAlloc);
+            pmemory = (uint8_t*)p;
+            nSize = nAlloc;
+        }
+        fInUse = true;
+        return pmemory;
+    }
+
+    bool Return(uint8_t* memory)
+    {
+        if (!fInUse || memory != pmemory)
+            return false;
+        fInUse = false;
+        return true;
+    }
+};
+
+thread_local CArgon2dArena argon2dArena;
+} // namespace
+
+int Argon2dArenaAllocate(uint8_t** memory, size_t nBytes)
+{
+    *memory = argon2dArena.Acquire(nBytes);
+    if (!*memory)
+        *memory = (uint8_t*)malloc(nBytes);
+    return *memory ? ARGON2_OK : ARGON2_MEMORY_ALLOCATION_ERROR;
+}
+
+void Argon2dArenaFree(uint8_t* memory, size_t nBytes)
+{
+    if (!argon2dArena.Return(memory))
+        free(memory);
+}
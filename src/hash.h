@@ -293,6 +293,11 @@ uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint3
 /// A memory cost, which defines the memory usage, given in kibibytes (1 kibibytes = kilobytes 1.024)
 /// A parallelism degree, which defines the number of parallel threads
 
+/// Argon2d memory blocks are taken from a per-thread arena that is kept between
+/// hashes, so repeated header hashing does not allocate and fault in fresh memory.
+int Argon2dArenaAllocate(uint8_t** memory, size_t nBytes);
+void Argon2dArenaFree(uint8_t* memory, size_t nBytes);
+
 /// Argon2d Phase 1 Hash parameters
 /// Salt and password are the block header.
 /// Output length: 32 bytes.
@@ -321,8 +326,8 @@ inline int Argon2d_Phase1_Hash(const void* in, const size_t size, const void* ou
     context.secretlen = 0;
     context.ad = NULL;
     context.adlen = 0;
-    context.allocate_cbk = NULL;
-    context.free_cbk = NULL;
+    context.allocate_cbk = Argon2dArenaAllocate;
+    context.free_cbk = Argon2dArenaFree;
     context.flags = DEFAULT_ARGON2_FLAG; // = ARGON2_DEFAULT_FLAGS
     // main configurable Argon2 hash parameters
     context.m_cost = 500; // Memory in KiB (512KB)
@@ -361,8 +366,8 @@ inline int Argon2d_Phase2_Hash(const void* in, const size_t size, const void* ou
     context.secretlen = 0;
     context.ad = NULL;
     context.adlen = 0;
-    context.allocate_cbk = NULL;
-    context.free_cbk = NULL;
+    context.allocate_cbk = Argon2dArenaAllocate;
+    context.free_cbk = Argon2dArenaFree;
     context.flags = DEFAULT_ARGON2_FLAG; // = ARGON2_DEFAULT_FLAGS
     // main configurable Argon2 hash parameters
     context.m_cost = 8000; // Memory in KiB (~8192KB)
@@ -24,6 +24,7 @@
 #include "bdap/domainentrydb.h"
 #include "bdap/linkingdb.h"
 #include "bdap/linkmanager.h"
+#include "bdap/vgpmessage.h"
 #include "dht/ed25519.h"
 #include "dynode-payments.h"
 #include "dynode-sync.h"
@@ -36,6 +37,7 @@
 #include "fluid/fluidmint.h"
 #include "fluid/fluidsovereign.h"
 #include "governance.h"
+#include "hash.h"
 #include "httprpc.h"
 #include "httpserver.h"
 #include "instantsend.h"
@@ -140,6 +142,7 @@ enum BindFlags {
 };
 
 static const char* FEE_ESTIMATES_FILENAME = "fee_estimates.dat";
+static const int64_t JOURNALED_CACHES_DUMP_SECONDS = 15 * 60;
 
 //////////////////////////////////////////////////////////////////////////////
 //
@@ -271,6 +274,15 @@ void SwapMnemonicWalletFile()
 } // SwapMnemonicWalletFile
 #endif // ENABLE_WALLET
 
+/** Append what changed in the payment and governance caches to their journals, on shutdown and every JOURNALED_CACHES_DUMP_SECONDS */
+static void DumpJournaledCaches()
+{
+    CFlatJournalDB<CDynodePayments> flatdb2("dnpayments.dat", "magicDynodePaymentsCache");
+    flatdb2.Dump(dnpayments);
+    CFlatJournalDB<CGovernanceManager> flatdb3("governance.dat", "magicGovernanceCache");
+    flatdb3.Dump(governance);
+}
+
 /** Preparing steps before shutting down or restarting the wallet */
 void PrepareShutdown()
 {
@@ -313,10 +325,7 @@ void PrepareShutdown()
     g_connman.reset();
 
     if (!fLiteMode && !fRPCInWarmup) {
-        CFlatDB<CDynodePayments> flatdb2("dnpayments.dat", "magicDynodePaymentsCache");
-        flatdb2.Dump(dnpayments);
-        CFlatDB<CGovernanceManager> flatdb3("governance.dat", "magicGovernanceCache");
-        flatdb3.Dump(governance);
+        DumpJournaledCaches();
         CFlatDB<CNetFulfilledRequestManager> flatdb4("netfulfilled.dat", "magicFulfilledCache");
         flatdb4.Dump(netfulfilledman);
         if (fEnableInstantSend) {
@@ -518,6 +527,8 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-mempoolexpiry=<n>", strprintf(_("Do not keep transactions in the mempool longer than <n> hours (default: %u)"), DEFAULT_MEMPOOL_EXPIRY));
     strUsage += HelpMessageOpt("-par=<n>", strprintf(_("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
                                                -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS));
+    strUsage += HelpMessageOpt("-vgpmessagethreads=<n>", strprintf(_("Set the number of VGP message verification threads (0 to %d, 0 = verify on the message handler thread, default: %d)"),
+                                               MAX_VGP_MESSAGE_THREADS, DEFAULT_VGP_MESSAGE_THREADS));
 #ifndef WIN32
     strUsage += HelpMessageOpt("-pid=<file>", strprintf(_("Specify pid file (default: %s)"), DYNAMIC_PID_FILENAME));
 #endif
@@ -657,6 +668,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-dnconf=<file>", strprintf(_("Specify Dynode configuration file (default: %s)"), "dynode.conf"));
     strUsage += HelpMessageOpt("-dnconflock=<n>", strprintf(_("Lock Dynodes from Dynode configuration file (default: %u)"), 1));
     strUsage += HelpMessageOpt("-dynodepairingkey=<n>", _("Set the Dynode private key"));
+    strUsage += HelpMessageOpt("-govloadverify=<n>", strprintf(_("Re-verify the signatures of the governance votes loaded from governance.dat in the background after startup and drop the ones that fail, votes cast before the last broadcast of their Dynode are not checked (0-1, default: %u)"), DEFAULT_GOVERNANCE_LOAD_VERIFY));
 
 #ifdef ENABLE_WALLET
     strUsage += HelpMessageGroup(_("PrivateSend options:"));
@@ -1451,6 +1463,7 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     LogPrintf("Using data directory %s\n", GetDataDir().string());
     LogPrintf("Using config file %s\n", GetConfigFile(GetArg("-conf", DYNAMIC_CONF_FILENAME)).string());
     LogPrintf("Using at most %i connections (%i file descriptors available)\n", nMaxConnections, nFD);
+    LogPrintf("Using Argon2d %s implementation\n", argon2d_select_impl());
     std::ostringstream strErrors;
 
     InitSignatureCache();
@@ -1459,8 +1472,27 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     if (nScriptCheckThreads) {
         for (int i = 0; i < nScriptCheckThreads - 1; i++)
             threadGroup.create_thread(&ThreadScriptCheck);
+        // BDAP operations in connected blocks are validated with the same level of concurrency
+        for (int i = 0; i < nScriptCheckThreads - 1; i++)
+            threadGroup.create_thread(&ThreadBDAPCheck);
+        // as are the proof-of-work hashes of incoming block headers
+        for (int i = 0; i < nScriptCheckThreads - 1; i++)
+            threadGroup.create_thread(&ThreadHeaderHashCheck);
+        // as are the signatures of InstantSend lock votes received in batches
+        for (int i = 0; i < nScriptCheckThreads - 1; i++)
+            threadGroup.create_thread(&ThreadTxLockVoteCheck);
+        // and the signatures of governance votes loaded at startup
+        if (GetBoolArg("-govloadverify", DEFAULT_GOVERNANCE_LOAD_VERIFY)) {
+            for (int i = 0; i < nScriptCheckThreads - 1; i++)
+                threadGroup.create_thread(&ThreadGovernanceVoteCheck);
+        }
     }
 
+    int nVGPMessageThreads = std::max(0, std::min((int)GetArg("-vgpmessagethreads", DEFAULT_VGP_MESSAGE_THREADS), MAX_VGP_MESSAGE_THREADS));
+    LogPrintf("Using %u threads for VGP message verification\n", nVGPMessageThreads);
+    for (int i = 0; i < nVGPMessageThreads; i++)
+        threadGroup.create_thread(&ThreadVGPMessageVerify);
+
     std::vector<std::string> vSporkAddresses;
     if (mapMultiArgs.count("-sporkaddr")) {
         vSporkAddresses = mapMultiArgs.at("-sporkaddr");
@@ -2009,6 +2041,11 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
 
     fEnableInstantSend = GetBoolArg("-enableinstantsend", 1);
 
+    // batches the lock votes received from peers for the lock vote check threads,
+    // without it votes are checked in place as they arrive
+    if (!fLiteMode && fEnableInstantSend)
+        threadGroup.create_thread(&ThreadTxLockVoteQueue);
+
     LogPrintf("fLiteMode %d\n", fLiteMode);
 #ifdef ENABLE_WALLET
     LogPrintf("PrivateSend liquidityprovider: %d\n", privateSendClient.nLiquidityProvider);
@@ -2029,22 +2066,24 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
         if (dnodeman.size()) {
             strDBName = "dnpayments.dat";
             uiInterface.InitMessage(_("Loading Dynode payment cache..."));
-            CFlatDB<CDynodePayments> flatdb2(strDBName, "magicDynodePaymentsCache");
+            CFlatJournalDB<CDynodePayments> flatdb2(strDBName, "magicDynodePaymentsCache");
             if (!flatdb2.Load(dnpayments)) {
                 return InitError(_("Failed to load Dynode payments cache from") + "\n" + (pathDB / strDBName).string());
             }
 
             strDBName = "governance.dat";
             uiInterface.InitMessage(_("Loading governance cache..."));
-            CFlatDB<CGovernanceManager> flatdb3(strDBName, "magicGovernanceCache");
+            CFlatJournalDB<CGovernanceManager> flatdb3(strDBName, "magicGovernanceCache");
             if (!flatdb3.Load(governance)) {
                 return InitError(_("Failed to load governance cache from") + "\n" + (pathDB / strDBName).string());
             }
-            governance.InitOnLoad();
         } else {
             uiInterface.InitMessage(_("Dynode cache is empty, skipping payments and governance cache..."));
         }
         governance.InitOnLoad();
+        // loaded objects and votes are served right away, -govloadverify re-verifies their vote signatures in the background
+        if (GetBoolArg("-govloadverify", DEFAULT_GOVERNANCE_LOAD_VERIFY))
+            threadGroup.create_thread(std::bind(&TraceThread<std::function<void()> >, "govverify", std::function<void()>(std::bind(&CGovernanceManager::VerifyLoadedVotes, &governance))));
 
         strDBName = "netfulfilled.dat";
         uiInterface.InitMessage(_("Loading fulfilled requests cache..."));
@@ -2080,6 +2119,7 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
 
         scheduler.scheduleEvery(std::bind(&CDynodePayments::DoMaintenance, std::ref(dnpayments)), 60);
         scheduler.scheduleEvery(std::bind(&CGovernanceManager::DoMaintenance, std::ref(governance), std::ref(*g_connman)), 60 * 5);
+        scheduler.scheduleEvery(DumpJournaledCaches, JOURNALED_CACHES_DUMP_SECONDS);
 
         scheduler.scheduleEvery(std::bind(&CInstantSend::DoMaintenance, std::ref(instantsend)), 60);
 
@@ -6,6 +6,7 @@
 #include "instantsend.h"
 
 #include "activedynode.h"
+#include "checkqueue.h"
 #include "consensus/validation.h"
 #include "dynode-payments.h"
 #include "dynode-sync.h"
@@ -44,6 +45,15 @@ const double CInstantSend::AUTO_IX_MEMPOOL_THRESHOLD = 0.1;
 CInstantSend instantsend;
 const std::string CInstantSend::SERIALIZATION_VERSION_STRING = "CInstantSend-Version-1";
 
+// lock votes waiting for signature checks, and how many are checked at once at most
+static const size_t TXLOCKVOTE_QUEUE_SIZE = 10000;
+static const size_t TXLOCKVOTE_BATCH_SIZE = 500;
+// how many checked votes are applied per cs_main/cs_instantsend lock
+static const size_t TXLOCKVOTE_APPLY_SIZE = 50;
+
+static CTxLockVoteQueue txLockVoteQueue(TXLOCKVOTE_QUEUE_SIZE, TXLOCKVOTE_BATCH_SIZE);
+static CCheckQueue<CTxLockVoteCheck> txlockvotecheckqueue(128);
+
 // Transaction Locks
 //
 // step 1) Some node announces intention to lock transaction inputs via "txlreg" message
@@ -91,6 +101,10 @@ void CInstantSend::ProcessMessage(CNode* pfrom, const std::string& strCommand, C
                 return;
         }
 
+        // signatures are checked in batches off the message handler thread while the queue thread runs
+        if (txLockVoteQueue.Push(pfrom->id, vote))
+            return;
+
         ProcessNewTxLockVote(pfrom, vote, connman);
 
         return;
@@ -174,9 +188,11 @@ bool CInstantSend::CreateTxLockCandidate(const CTxLockRequest& txLockRequest)
             txLockCandidate.AddOutPointLock(txin.prevout);
         }
         mapTxLockCandidates.insert(std::make_pair(txHash, txLockCandidate));
+        UpdateLockIndex(txLockCandidate);
     } else if (!itLockCandidate->second.txLockRequest) {
         // i.e. empty Transaction Lock Candidate was created earlier, let's update it with actual data
         itLockCandidate->second.txLockRequest = txLockRequest;
+        UpdateLockIndex(itLockCandidate->second);
         if (itLockCandidate->second.IsTimedOut()) {
             LogPrintf("CInstantSend::CreateTxLockCandidate -- timed out, txid=%s\n", txHash.ToString());
             return false;
@@ -187,6 +203,7 @@ bool CInstantSend::CreateTxLockCandidate(const CTxLockRequest& txLockRequest)
         for (const auto& txin : txLockRequest.tx->vin) {
             itLockCandidate->second.AddOutPointLock(txin.prevout);
         }
+        UpdateLockIndex(itLockCandidate->second);
     } else {
         LogPrint("instantsend", "CInstantSend::CreateTxLockCandidate -- seen, txid=%s\n", txHash.ToString());
     }
@@ -328,7 +345,6 @@ void CInstantSend::Vote(CTxLockCandidate& txLockCandidate, CConnman& connman)
 bool CInstantSend::ProcessNewTxLockVote(CNode* pfrom, const CTxLockVote& vote, CConnman& connman)
 {
     uint256 txHash = vote.GetTxHash();
-    uint256 nVoteHash = vote.GetHash();
 
     if (!vote.IsValid(pfrom, connman)) {
         // could be because of missing DN
@@ -345,6 +361,77 @@ bool CInstantSend::ProcessNewTxLockVote(CNode* pfrom, const CTxLockVote& vote, C
 #endif
     LOCK2(mempool.cs, cs_instantsend);
 
+    return ProcessValidTxLockVote(vote);
+}
+
+void CInstantSend::ProcessTxLockVoteBatch(const std::vector<std::pair<NodeId, CTxLockVote> >& vecVotes, CConnman& connman)
+{
+    // everything but the signatures is checked one vote at a time
+    std::unique_ptr<bool[]> pfValid(new bool[vecVotes.size()]);
+    std::vector<CTxLockVoteCheck> vChecks;
+    for (size_t i = 0; i < vecVotes.size(); i++) {
+        const CTxLockVote& vote = vecVotes[i].second;
+        pfValid[i] = false;
+        // IsValid takes cs_main, so it must not run under cs_vNodes
+        dynode_info_t infoDn;
+        if (vote.IsValid(NULL, connman, false) && dnodeman.GetDynodeInfo(vote.GetDynodeOutpoint(), infoDn)) {
+            vChecks.push_back(CTxLockVoteCheck(vote, infoDn.pubKeyDynode, pfValid[i]));
+        } else {
+            // could be because of missing DN
+            LogPrint("instantsend", "CInstantSend::%s -- Vote is invalid, txid=%s\n", __func__, vote.GetTxHash().ToString());
+            if (!dnodeman.Has(vote.GetDynodeOutpoint())) {
+                connman.ForNode(vecVotes[i].first, [&](CNode* pnode) {
+                    dnodeman.AskForDN(pnode, vote.GetDynodeOutpoint(), connman);
+                    return true;
+                });
+            }
+        }
+    }
+
+    {
+        CCheckQueueControl<CTxLockVoteCheck> control(&txlockvotecheckqueue);
+        control.Add(vChecks);
+        control.Wait();
+    }
+
+    // relay valid votes asap
+    for (size_t i = 0; i < vecVotes.size(); i++) {
+        if (pfValid[i])
+            vecVotes[i].second.Relay(connman);
+    }
+
+    // in arrival order, so a lock completes with the vote that reaches the quorum,
+    // a slice at a time so the locks are not held for the whole batch
+    for (size_t nStart = 0; nStart < vecVotes.size(); nStart += TXLOCKVOTE_APPLY_SIZE) {
+        size_t nEnd = std::min(vecVotes.size(), nStart + TXLOCKVOTE_APPLY_SIZE);
+
+        LOCK(cs_main);
+#ifdef ENABLE_WALLET
+        LOCK(pwalletMain ? &pwalletMain->cs_wallet : NULL);
+#endif
+        LOCK2(mempool.cs, cs_instantsend);
+
+        for (size_t i = nStart; i < nEnd; i++) {
+            if (pfValid[i])
+                ProcessValidTxLockVote(vecVotes[i].second);
+        }
+    }
+}
+
+bool CInstantSend::ProcessValidTxLockVote(const CTxLockVote& vote)
+{
+    // cs_main, cs_wallet, mempool.cs and cs_instantsend should be already locked
+    AssertLockHeld(cs_main);
+#ifdef ENABLE_WALLET
+    if (pwalletMain)
+        AssertLockHeld(pwalletMain->cs_wallet);
+#endif
+    AssertLockHeld(mempool.cs);
+    AssertLockHeld(cs_instantsend);
+
+    uint256 txHash = vote.GetTxHash();
+    uint256 nVoteHash = vote.GetHash();
+
     // Dynodes will sometimes propagate votes before the transaction is known to the client,
     // will actually process only after the lock request itself has arrived
 
@@ -566,18 +653,63 @@ void CInstantSend::LockTransactionInputs(const CTxLockCandidate& txLockCandidate
 
     for (const auto& pair : txLockCandidate.mapOutPointLocks) {
         mapLockedOutpoints.insert(std::make_pair(pair.first, txHash));
+        lockIndex.LockOutpoint(pair.first, txHash);
     }
     LogPrint("instantsend", "CInstantSend::LockTransactionInputs -- done, txid=%s\n", txHash.ToString());
 }
 
 bool CInstantSend::GetLockedOutPointTxHash(const COutPoint& outpoint, uint256& hashRet)
+{
+    return lockIndex.GetLockedOutPointTxHash(outpoint, hashRet);
+}
+
+static std::vector<COutPoint> GetLockCandidateInputs(const CTxLockCandidate& txLockCandidate)
+{
+    std::vector<COutPoint> vOutpoints;
+    for (const auto& pair : txLockCandidate.mapOutPointLocks) {
+        vOutpoints.push_back(pair.first);
+    }
+    return vOutpoints;
+}
+
+void CInstantSend::UpdateLockIndex(const CTxLockCandidate& txLockCandidate)
+{
+    AssertLockHeld(cs_instantsend);
+
+    if (!txLockCandidate.txLockRequest)
+        return;
+
+    lockIndex.SetRequestInputs(txLockCandidate.GetHash(), GetLockCandidateInputs(txLockCandidate));
+}
+
+void CInstantSend::BuildLockIndex(CInstantSendLockIndex& lockIndexRet) const
+{
+    AssertLockHeld(cs_instantsend);
+
+    for (const auto& pair : mapTxLockCandidates) {
+        if (pair.second.txLockRequest)
+            lockIndexRet.SetRequestInputs(pair.second.GetHash(), GetLockCandidateInputs(pair.second));
+    }
+    for (const auto& pair : mapLockedOutpoints) {
+        lockIndexRet.LockOutpoint(pair.first, pair.second);
+    }
+}
+
+void CInstantSend::RebuildLockIndex()
 {
     LOCK(cs_instantsend);
-    std::map<COutPoint, uint256>::iterator it = mapLockedOutpoints.find(outpoint);
-    if (it == mapLockedOutpoints.end())
-        return false;
-    hashRet = it->second;
-    return true;
+
+    lockIndex.Clear();
+    BuildLockIndex(lockIndex);
+}
+
+bool CInstantSend::CheckLockIndex()
+{
+    LOCK(cs_instantsend);
+
+    CInstantSendLockIndex lockIndexBuilt;
+    BuildLockIndex(lockIndexBuilt);
+    return lockIndex == lockIndexBuilt;
 }
 
 bool CInstantSend::ResolveConflicts(const CTxLockCandidate& txLockCandidate)
@@ -691,8 +823,10 @@ void CInstantSend::CheckAndRemove()
 
             for (const auto& pair : txLockCandidate.mapOutPointLocks) {
                 mapLockedOutpoints.erase(pair.first);
+                lockIndex.UnlockOutpoint(pair.first);
                 mapVotedOutpoints.erase(pair.first);
             }
+            lockIndex.RemoveRequest(txHash);
             mapLockRequestAccepted.erase(txHash);
             mapLockRequestRejected.erase(txHash);
             mapTxLockCandidates.erase(itLockCandidate++);
@@ -774,8 +908,7 @@ void CInstantSend::RejectLockRequest(const CTxLockRequest& txLockRequest)
 
 bool CInstantSend::HasTxLockRequest(const uint256& txHash)
 {
-    CTxLockRequest txLockRequestTmp;
-    return GetTxLockRequest(txHash, txLockRequestTmp);
+    return lockIndex.HasRequest(txHash);
 }
 
 bool CInstantSend::GetTxLockRequest(const uint256& txHash, CTxLockRequest& txLockRequestRet)
@@ -813,6 +946,7 @@ void CInstantSend::Clear()
     mapTxLockCandidates.clear();
     mapVotedOutpoints.clear();
     mapLockedOutpoints.clear();
+    lockIndex.Clear();
     mapDynodeOrphanVotes.clear();
     nCachedBlockHeight = 0;
 }
@@ -823,25 +957,7 @@ bool CInstantSend::IsLockedInstantSendTransaction(const uint256& txHash)
         !sporkManager.IsSporkActive(SPORK_3_INSTANTSEND_BLOCK_FILTERING))
         return false;
 
-    LOCK(cs_instantsend);
-
-    // there must be a lock candidate
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
-    if (itLockCandidate == mapTxLockCandidates.end())
-        return false;
-
-    // which should have outpoints
-    if (itLockCandidate->second.mapOutPointLocks.empty())
-        return false;
-
-    // and all of these outputs must be included in mapLockedOutpoints with correct hash
-    for (const auto& pair : itLockCandidate->second.mapOutPointLocks) {
-        uint256 hashLocked;
-        if (!GetLockedOutPointTxHash(pair.first, hashLocked) || hashLocked != txHash)
-            return false;
-    }
-
-    return true;
+    return lockIndex.IsLocked(txHash);
 }
 
 int CInstantSend::GetTransactionLockSignatures(const uint256& txHash)
@@ -963,6 +1079,172 @@ bool CInstantSend::CanAutoLock()
     return (mempool.UsedMemoryShare() < AUTO_IX_MEMPOOL_THRESHOLD);
 }
 
+//
+// CInstantSendLockIndex
+//
+
+void CInstantSendLockIndex::LockOutpoint(const COutPoint& outpoint, const uint256& txHash)
+{
+    outpoint_shard_t& shard = GetShard(outpoint);
+    LOCK(shard.cs);
+    shard.mapLockedOutpoints.insert(std::make_pair(outpoint, txHash));
+}
+
+void CInstantSendLockIndex::UnlockOutpoint(const COutPoint& outpoint)
+{
+    outpoint_shard_t& shard = GetShard(outpoint);
+    LOCK(shard.cs);
+    shard.mapLockedOutpoints.erase(outpoint);
+}
+
+bool CInstantSendLockIndex::GetLockedOutPointTxHash(const COutPoint& outpoint, uint256& hashRet) const
+{
+    const outpoint_shard_t& shard = GetShard(outpoint);
+    LOCK(shard.cs);
+    std::map<COutPoint, uint256>::const_iterator it = shard.mapLockedOutpoints.find(outpoint);
+    if (it == shard.mapLockedOutpoints.end())
+        return false;
+    hashRet = it->second;
+    return true;
+}
+
+void CInstantSendLockIndex::SetRequestInputs(const uint256& txHash, const std::vector<COutPoint>& vOutpoints)
+{
+    request_shard_t& shard = GetShard(txHash);
+    LOCK(shard.cs);
+    shard.mapRequestInputs[txHash] = vOutpoints;
+}
+
+void CInstantSendLockIndex::RemoveRequest(const uint256& txHash)
+{
+    request_shard_t& shard = GetShard(txHash);
+    LOCK(shard.cs);
+    shard.mapRequestInputs.erase(txHash);
+}
+
+bool CInstantSendLockIndex::HasRequest(const uint256& txHash) const
+{
+    const request_shard_t& shard = GetShard(txHash);
+    LOCK(shard.cs);
+    return shard.mapRequestInputs.count(txHash);
+}
+
+bool CInstantSendLockIndex::IsLocked(const uint256& txHash) const
+{
+    std::vector<COutPoint> vOutpoints;
+    {
+        const request_shard_t& shard = GetShard(txHash);
+        LOCK(shard.cs);
+        std::map<uint256, std::vector<COutPoint> >::const_iterator it = shard.mapRequestInputs.find(txHash);
+        if (it == shard.mapRequestInputs.end())
+            return false;
+        vOutpoints = it->second;
+    }
+
+    // the candidate should have outpoints
+    if (vOutpoints.empty())
+        return false;
+
+    // and all of them must be locked to this transaction
+    for (const COutPoint& outpoint : vOutpoints) {
+        uint256 hashLocked;
+        if (!GetLockedOutPointTxHash(outpoint, hashLocked) || hashLocked != txHash)
+            return false;
+    }
+
+    return true;
+}
+
+void CInstantSendLockIndex::Clear()
+{
+    for (int i = 0; i < SHARD_COUNT; i++) {
+        LOCK(vOutpointShards[i].cs);
+        vOutpointShards[i].mapLockedOutpoints.clear();
+    }
+    for (int i = 0; i < SHARD_COUNT; i++) {
+        LOCK(vRequestShards[i].cs);
+        vRequestShards[i].mapRequestInputs.clear();
+    }
+}
+
+bool CInstantSendLockIndex::operator==(const CInstantSendLockIndex& other) const
+{
+    for (int i = 0; i < SHARD_COUNT; i++) {
+        LOCK2(vOutpointShards[i].cs, other.vOutpointShards[i].cs);
+        if (vOutpointShards[i].mapLockedOutpoints != other.vOutpointShards[i].mapLockedOutpoints)
+            return false;
+    }
+    for (int i = 0; i < SHARD_COUNT; i++) {
+        LOCK2(vRequestShards[i].cs, other.vRequestShards[i].cs);
+        if (vRequestShards[i].mapRequestInputs != other.vRequestShards[i].mapRequestInputs)
+            return false;
+    }
+    return true;
+}
+
+//
+// CTxLockVoteQueue
+//
+
+bool CTxLockVoteQueue::Push(const NodeId nodeId, const CTxLockVote& vote)
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    if (nWorkers == 0 || queue.size() >= nMaxSize)
+        return false;
+
+    queue.push_back(std::make_pair(nodeId, vote));
+    condWorker.notify_one();
+    return true;
+}
+
+void CTxLockVoteQueue::Thread()
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        nWorkers++;
+    }
+    try {
+        while (true) {
+            std::vector<std::pair<NodeId, CTxLockVote> > vecVotes;
+            {
+                boost::unique_lock<boost::mutex> lock(mutex);
+                while (queue.empty())
+                    condWorker.wait(lock); // interruption point on shutdown
+                while (!queue.empty() && vecVotes.size() < nMaxBatchSize) {
+                    vecVotes.push_back(queue.front());
+                    queue.pop_front();
+                }
+            }
+            if (g_connman)
+                instantsend.ProcessTxLockVoteBatch(vecVotes, *g_connman);
+        }
+    } catch (...) {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        nWorkers--;
+        throw;
+    }
+}
+
+void ThreadTxLockVoteQueue()
+{
+    RenameThread("dynamic-txlvotes");
+    txLockVoteQueue.Thread();
+}
+
+void ThreadTxLockVoteCheck()
+{
+    RenameThread("dynamic-txlvcheck");
+    txlockvotecheckqueue.Thread();
+}
+
+bool CTxLockVoteCheck::operator()()
+{
+    *pfValid = pvote->CheckSignature(pubKeyDynode);
+    if (!*pfValid)
+        LogPrintf("CTxLockVoteCheck::%s -- Signature invalid\n", __func__);
+    return true;
+}
+
 //
 // CTxLockRequest
 //
@@ -1046,11 +1328,12 @@ bool CTxLockRequest::IsSimple() const
 // CTxLockVote
 //
 
-bool CTxLockVote::IsValid(CNode* pnode, CConnman& connman) const
+bool CTxLockVote::IsValid(CNode* pnode, CConnman& connman, bool fSignatureCheck) const
 {
     if (!dnodeman.Has(outpointDynode)) {
         LogPrint("instantsend", "CTxLockVote::IsValid -- Unknown dynode %s\n", outpointDynode.ToStringShort());
-        dnodeman.AskForDN(pnode, outpointDynode, connman);
+        if (pnode)
+            dnodeman.AskForDN(pnode, outpointDynode, connman);
         return false;
     }
 
@@ -1078,7 +1361,7 @@ bool CTxLockVote::IsValid(CNode* pnode, CConnman& connman) const
         return false;
     }
 
-    if (!CheckSignature()) {
+    if (fSignatureCheck && !CheckSignature()) {
         LogPrintf("CTxLockVote::IsValid -- Signature invalid\n");
         return false;
     }
@@ -1098,8 +1381,6 @@ uint256 CTxLockVote::GetSignatureHash() const
 
 bool CTxLockVote::CheckSignature() const
 {
-    std::string strError;
-
     dynode_info_t infoDn;
 
     if (!dnodeman.GetDynodeInfo(outpointDynode, infoDn)) {
@@ -1107,13 +1388,20 @@ bool CTxLockVote::CheckSignature() const
         return false;
     }
 
+    return CheckSignature(infoDn.pubKeyDynode);
+}
+
+bool CTxLockVote::CheckSignature(const CPubKey& pubKeyDynode) const
+{
+    std::string strError;
+
     if (sporkManager.IsSporkActive(SPORK_6_NEW_SIGS)) {
         uint256 hash = GetSignatureHash();
 
-        if (!CHashSigner::VerifyHash(hash, infoDn.pubKeyDynode, vchDynodeSignature, strError)) {
+        if (!CHashSigner::VerifyHash(hash, pubKeyDynode, vchDynodeSignature, strError)) {
             // could be a signature in old format
             std::string strMessage = txHash.ToString() + outpoint.ToStringShort();
-            if (!CMessageSigner::VerifyMessage(infoDn.pubKeyDynode, vchDynodeSignature, strMessage, strError)) {
+            if (!CMessageSigner::VerifyMessage(pubKeyDynode, vchDynodeSignature, strMessage, strError)) {
                 // nope, not in old format either
                 LogPrintf("CTxLockVote::CheckSignature -- VerifyMessage() failed, error: %s\n", strError);
                 return false;
@@ -1121,7 +1409,7 @@ bool CTxLockVote::CheckSignature() const
         }
     } else {
         std::string strMessage = txHash.ToString() + outpoint.ToStringShort();
-        if (!CMessageSigner::VerifyMessage(infoDn.pubKeyDynode, vchDynodeSignature, strMessage, strError)) {
+        if (!CMessageSigner::VerifyMessage(pubKeyDynode, vchDynodeSignature, strMessage, strError)) {
             LogPrintf("CTxLockVote::CheckSignature -- VerifyMessage() failed, error: %s\n", strError);
             return false;
         }
@@ -1131,30 +1419,35 @@ bool CTxLockVote::CheckSignature() const
 }
 
 bool CTxLockVote::Sign()
+{
+    return Sign(activeDynode.keyDynode, activeDynode.pubKeyDynode);
+}
+
+bool CTxLockVote::Sign(const CKey& keyDynode, const CPubKey& pubKeyDynode)
 {
     std::string strError;
 
     if (sporkManager.IsSporkActive(SPORK_6_NEW_SIGS)) {
         uint256 hash = GetSignatureHash();
 
-        if (!CHashSigner::SignHash(hash, activeDynode.keyDynode, vchDynodeSignature)) {
+        if (!CHashSigner::SignHash(hash, keyDynode, vchDynodeSignature)) {
             LogPrintf("CTxLockVote::Sign -- SignHash() failed\n");
             return false;
         }
 
-        if (!CHashSigner::VerifyHash(hash, activeDynode.pubKeyDynode, vchDynodeSignature, strError)) {
+        if (!CHashSigner::VerifyHash(hash, pubKeyDynode, vchDynodeSignature, strError)) {
             LogPrintf("CTxLockVote::Sign -- VerifyHash() failed, error: %s\n", strError);
             return false;
         }
     } else {
         std::string strMessage = txHash.ToString() + outpoint.ToStringShort();
 
-        if (!CMessageSigner::SignMessage(strMessage, vchDynodeSignature, activeDynode.keyDynode)) {
+        if (!CMessageSigner::SignMessage(strMessage, vchDynodeSignature, keyDynode)) {
             LogPrintf("CTxLockVote::Sign -- SignMessage() failed\n");
             return false;
         }
 
-        if (!CMessageSigner::VerifyMessage(activeDynode.pubKeyDynode, vchDynodeSignature, strMessage, strError)) {
+        if (!CMessageSigner::VerifyMessage(pubKeyDynode, vchDynodeSignature, strMessage, strError)) {
             LogPrintf("CTxLockVote::Sign -- VerifyMessage() failed, error: %s\n", strError);
             return false;
         }
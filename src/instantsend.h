@@ -7,9 +7,15 @@
 #define INSTANTSEND_H
 
 #include "chain.h"
+#include "key.h"
 #include "net.h"
 #include "primitives/transaction.h"
 
+#include <deque>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
 class CTxLockVote;
 class COutPointLock;
 class CTxLockRequest;
@@ -42,6 +48,59 @@ static const int INSTANTSEND_FAILED_TIMEOUT_SECONDS = 60;
 extern bool fEnableInstantSend;
 extern int nCompleteTXLocks;
 
+/**
+ * The InstantSend lock state read by the mempool and validation threads: the transaction
+ * each locked outpoint is locked to and the inputs of each lock candidate that has its lock
+ * request. The entries are split into shards by hash, each with its own lock, so these
+ * lookups do not wait for cs_instantsend while lock votes are processed. Every change is
+ * made under cs_instantsend together with the CInstantSend maps it mirrors.
+ *
+ * A lookup takes the shard locks it needs one at a time, so it is not an atomic snapshot of
+ * that state: IsLocked may see the inputs of a lock being locked or unlocked only in part,
+ * and two lookups may see different states. Callers that need a consistent view across
+ * lookups hold cs_instantsend.
+ */
+class CInstantSendLockIndex
+{
+private:
+    static const int SHARD_COUNT = 16;
+
+    struct outpoint_shard_t {
+        mutable CCriticalSection cs;
+        std::map<COutPoint, uint256> mapLockedOutpoints; // utxo - tx hash
+    };
+
+    struct request_shard_t {
+        mutable CCriticalSection cs;
+        std::map<uint256, std::vector<COutPoint> > mapRequestInputs; // tx hash - inputs of its lock candidate
+    };
+
+    outpoint_shard_t vOutpointShards[SHARD_COUNT];
+    request_shard_t vRequestShards[SHARD_COUNT];
+
+    outpoint_shard_t& GetShard(const COutPoint& outpoint) { return vOutpointShards[(outpoint.hash.GetCheapHash() + outpoint.n) % SHARD_COUNT]; }
+    const outpoint_shard_t& GetShard(const COutPoint& outpoint) const { return vOutpointShards[(outpoint.hash.GetCheapHash() + outpoint.n) % SHARD_COUNT]; }
+    request_shard_t& GetShard(const uint256& txHash) { return vRequestShards[txHash.GetCheapHash() % SHARD_COUNT]; }
+    const request_shard_t& GetShard(const uint256& txHash) const { return vRequestShards[txHash.GetCheapHash() % SHARD_COUNT]; }
+
+public:
+    /// Lock outpoint to txHash unless it is already locked
+    void LockOutpoint(const COutPoint& outpoint, const uint256& txHash);
+    void UnlockOutpoint(const COutPoint& outpoint);
+    bool GetLockedOutPointTxHash(const COutPoint& outpoint, uint256& hashRet) const;
+
+    /// Set the inputs of the lock candidate for txHash once its lock request is known
+    void SetRequestInputs(const uint256& txHash, const std::vector<COutPoint>& vOutpoints);
+    void RemoveRequest(const uint256& txHash);
+    bool HasRequest(const uint256& txHash) const;
+    /// True if the candidate for txHash has inputs and all of them are locked to it
+    bool IsLocked(const uint256& txHash) const;
+
+    void Clear();
+
+    bool operator==(const CInstantSendLockIndex& other) const;
+};
+
 class CInstantSend
 {
 private:
@@ -64,6 +123,9 @@ private:
     std::map<COutPoint, std::set<uint256> > mapVotedOutpoints; // utxo - tx hash set
     std::map<COutPoint, uint256> mapLockedOutpoints;           // utxo - tx hash
 
+    // what the mempool and validation threads look up, see CInstantSendLockIndex
+    CInstantSendLockIndex lockIndex;
+
     //track dynodes who voted with no txreq (for DOS protection)
     std::map<COutPoint, int64_t> mapDynodeOrphanVotes; // dn outpoint - time
 
@@ -73,12 +135,21 @@ private:
 
     /// Process consensus vote message
     bool ProcessNewTxLockVote(CNode* pfrom, const CTxLockVote& vote, CConnman& connman);
+    /// Add a vote that passed all checks to its lock candidate
+    bool ProcessValidTxLockVote(const CTxLockVote& vote);
 
     void UpdateVotedOutpoints(const CTxLockVote& vote, CTxLockCandidate& txLockCandidate);
     bool ProcessOrphanTxLockVote(const CTxLockVote& vote);
     void ProcessOrphanTxLockVotes();
     int64_t GetAverageDynodeOrphanVoteTime();
 
+    /// Mirror the lock request and inputs of a lock candidate into lockIndex
+    void UpdateLockIndex(const CTxLockCandidate& txLockCandidate);
+    /// Fill lockIndexRet from the lock candidates and locked outpoints
+    void BuildLockIndex(CInstantSendLockIndex& lockIndexRet) const;
+    /// Rebuild lockIndex from the lock candidates and locked outpoints
+    void RebuildLockIndex();
+
     void TryToFinalizeLockCandidate(const CTxLockCandidate& txLockCandidate);
     void LockTransactionInputs(const CTxLockCandidate& txLockCandidate);
     /// Update UI and notify external script if any
@@ -113,6 +184,8 @@ public:
 
         if (ser_action.ForRead() && (strVersion != SERIALIZATION_VERSION_STRING)) {
             Clear();
+        } else if (ser_action.ForRead()) {
+            RebuildLockIndex();
         }
     }
 
@@ -121,26 +194,34 @@ public:
     void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman);
 
     bool ProcessTxLockRequest(const CTxLockRequest& txLockRequest, CConnman& connman);
+    /// Check a batch of received lock votes, their signatures in parallel, and process the valid ones in order
+    void ProcessTxLockVoteBatch(const std::vector<std::pair<NodeId, CTxLockVote> >& vecVotes, CConnman& connman);
     void Vote(const uint256& txHash, CConnman& connman);
 
     bool AlreadyHave(const uint256& hash);
 
     void AcceptLockRequest(const CTxLockRequest& txLockRequest);
     void RejectLockRequest(const CTxLockRequest& txLockRequest);
+    /// Read from lockIndex without cs_instantsend, one shard lock at a time
     bool HasTxLockRequest(const uint256& txHash);
     bool GetTxLockRequest(const uint256& txHash, CTxLockRequest& txLockRequestRet);
 
     bool GetTxLockVote(const uint256& hash, CTxLockVote& txLockVoteRet);
 
+    /// Read from lockIndex without cs_instantsend, one shard lock at a time
     bool GetLockedOutPointTxHash(const COutPoint& outpoint, uint256& hashRet);
 
-    /// Verify if transaction is currently locked
+    /// Verify if transaction is currently locked, read from lockIndex without cs_instantsend.
+    /// The request and each input are looked up under their own shard locks, so this is not
+    /// an atomic snapshot, see CInstantSendLockIndex
     bool IsLockedInstantSendTransaction(const uint256& txHash);
     /// Get the actual number of accepted lock signatures
     int GetTransactionLockSignatures(const uint256& txHash);
 
     /// Remove expired entries from maps
     void CheckAndRemove();
+    /// Returns false if lockIndex differs from one built from scratch
+    bool CheckLockIndex();
     /// Verify if transaction lock timed out
     bool IsTxLockCandidateTimedOut(const uint256& txHash);
 
@@ -279,18 +360,73 @@ public:
     COutPoint GetOutpoint() const { return outpoint; }
     COutPoint GetDynodeOutpoint() const { return outpointDynode; }
 
-    bool IsValid(CNode* pnode, CConnman& connman) const;
+    /// pnode is asked for an unknown dynode if set
+    bool IsValid(CNode* pnode, CConnman& connman, bool fSignatureCheck = true) const;
     void SetConfirmedHeight(int nConfirmedHeightIn) { nConfirmedHeight = nConfirmedHeightIn; }
     bool IsExpired(int nHeight) const;
     bool IsTimedOut() const;
     bool IsFailed() const;
 
     bool Sign();
+    bool Sign(const CKey& keyDynode, const CPubKey& pubKeyDynode);
     bool CheckSignature() const;
+    bool CheckSignature(const CPubKey& pubKeyDynode) const;
 
     void Relay(CConnman& connman) const;
 };
 
+/** Closure representing the signature check of one InstantSend lock vote */
+class CTxLockVoteCheck
+{
+private:
+    const CTxLockVote* pvote;
+    CPubKey pubKeyDynode;
+    bool* pfValid;
+
+public:
+    CTxLockVoteCheck() : pvote(NULL), pfValid(NULL) {}
+    CTxLockVoteCheck(const CTxLockVote& voteIn, const CPubKey& pubKeyDynodeIn, bool& fValidIn) : pvote(&voteIn), pubKeyDynode(pubKeyDynodeIn), pfValid(&fValidIn) {}
+
+    bool operator()();
+
+    void swap(CTxLockVoteCheck& check)
+    {
+        std::swap(pvote, check.pvote);
+        std::swap(pubKeyDynode, check.pubKeyDynode);
+        std::swap(pfValid, check.pfValid);
+    }
+};
+
+/**
+ * Lock votes received from peers, waiting for their signatures to be checked. The queue
+ * thread takes everything queued so far as one batch for CInstantSend::ProcessTxLockVoteBatch,
+ * so busy vote traffic is verified on the lock vote check threads instead of one signature
+ * at a time on the message handler thread.
+ */
+class CTxLockVoteQueue
+{
+private:
+    boost::mutex mutex;
+    boost::condition_variable condWorker;
+    std::deque<std::pair<NodeId, CTxLockVote> > queue;
+    size_t nMaxSize;
+    size_t nMaxBatchSize;
+    int nWorkers;
+
+public:
+    CTxLockVoteQueue(const size_t nMaxSizeIn, const size_t nMaxBatchSizeIn) : nMaxSize(nMaxSizeIn), nMaxBatchSize(nMaxBatchSizeIn), nWorkers(0) {}
+
+    //! Returns false if the queue is full or there is no queue thread
+    bool Push(const NodeId nodeId, const CTxLockVote& vote);
+    //! Queue thread
+    void Thread();
+};
+
+/** Run the lock vote queue thread */
+void ThreadTxLockVoteQueue();
+/** Run a lock vote signature check thread */
+void ThreadTxLockVoteCheck();
+
 /**
  * An InstantSend OutpointLock.
  */
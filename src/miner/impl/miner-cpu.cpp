@@ -4,25 +4,41 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "miner/impl/miner-cpu.h"
+#include "hash.h"
 #include "primitives/block.h"
 
+#include <string.h>
+
 
 CPUMiner::CPUMiner(MinerContextRef ctx, std::size_t device_index)
     : MinerBase(ctx, device_index){};
 
 int64_t CPUMiner::TryMineBlock(CBlock& block)
 {
+    // The header is copied once per batch and only its nonce is patched, so
+    // hashing neither re-reads the block nor goes through its hash cache. The
+    // Argon2d memory comes from this thread's arena and is reused by every hash.
+    const size_t nonce_offset = BEGIN(block.nNonce) - BEGIN(block.nVersion);
+    memcpy(_header, BEGIN(block.nVersion), BLOCK_HEADER_HASHED_SIZE);
+
     int64_t hashes_done = 0;
+    uint32_t nonce = block.nNonce;
+    uint256 hash;
     while (true) {
-        uint256 hash = block.GetHash();
+        memcpy(_header + nonce_offset, &nonce, sizeof(nonce));
+        Argon2d_Phase1_Hash(_header, BLOCK_HEADER_HASHED_SIZE, hash.begin());
         if (UintToArith256(hash) <= _hash_target) {
+            block.nNonce = nonce;
+            block.CacheHash(hash);
             this->ProcessFoundSolution(block, hash);
             break;
         }
-        block.nNonce += 1;
+        nonce += 1;
         hashes_done += 1;
-        if ((block.nNonce & 0xFF) == 0)
+        if ((nonce & 0xFF) == 0) {
+            block.nNonce = nonce;
             break;
+        }
     }
     return hashes_done;
 }
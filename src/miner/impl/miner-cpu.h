@@ -6,6 +6,7 @@
 #define DYNAMIC_MINER_IMPL_CPU_H
 
 #include "miner/internal/miner-base.h"
+#include "primitives/block.h"
 
 
 /**
@@ -31,6 +32,10 @@ public:
 
 protected:
     virtual int64_t TryMineBlock(CBlock& block) override;
+
+private:
+    // Serialized header being mined, only the nonce changes between hashes
+    unsigned char _header[BLOCK_HEADER_HASHED_SIZE];
 };
 
 #endif // DYNAMIC_MINER_IMPL_CPU_H
@@ -6,6 +6,38 @@
 #include "miner/internal/hash-rate-counter.h"
 #include "utiltime.h"
 
+#include <algorithm>
+
+
+HashRateCounterRef HashRateCounter::MakeChild()
+{
+    HashRateCounterRef child = std::make_shared<HashRateCounter>(shared_from_this());
+    std::lock_guard<std::mutex> guard(_children_mutex);
+    // Drop children of miner threads that were shut down, even if the rates are never polled
+    _children.erase(std::remove_if(_children.begin(), _children.end(),
+                        [](const std::weak_ptr<HashRateCounter>& ref) { return ref.expired(); }),
+        _children.end());
+    _children.push_back(child);
+    return child;
+}
+
+std::vector<int64_t> HashRateCounter::GetChildRates()
+{
+    std::vector<int64_t> rates;
+    std::lock_guard<std::mutex> guard(_children_mutex);
+    auto it = _children.begin();
+    while (it != _children.end()) {
+        HashRateCounterRef child = it->lock();
+        if (!child) {
+            // Miner thread was shut down
+            it = _children.erase(it);
+            continue;
+        }
+        rates.push_back(*child);
+        ++it;
+    }
+    return rates;
+}
 
 void HashRateCounter::Increment(int64_t amount)
 {
@@ -7,6 +7,8 @@
 
 #include <atomic>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 
 struct HashRateCounter;
@@ -23,6 +25,10 @@ private:
 
     HashRateCounterRef _parent;
 
+    // Child counters, e.g. one per miner thread of a group
+    std::mutex _children_mutex;
+    std::vector<std::weak_ptr<HashRateCounter> > _children;
+
 public:
     explicit HashRateCounter() : _parent(nullptr){};
     explicit HashRateCounter(HashRateCounterRef parent) : _parent(parent){};
@@ -31,7 +37,10 @@ public:
     operator int64_t() { return _count_per_sec; };
 
     // Creates new child counter
-    HashRateCounterRef MakeChild() { return std::make_shared<HashRateCounter>(shared_from_this()); }
+    HashRateCounterRef MakeChild();
+
+    // Returns hash rates per second of the child counters still in use
+    std::vector<int64_t> GetChildRates();
 
     // Increments counter
     void Increment(int64_t amount);
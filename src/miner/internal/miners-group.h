@@ -43,6 +43,9 @@ public:
 
     // Gets hash rate of all threads in the group
     int64_t GetHashRate() const { return *this->_ctx->counter; };
+
+    // Gets hash rate of each thread in the group
+    std::vector<int64_t> GetThreadHashRates() const { return this->_ctx->counter->GetChildRates(); };
 };
 
 
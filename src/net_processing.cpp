@@ -939,11 +939,14 @@ bool static AlreadyHave(const CInv& inv) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
     }
 
     case MSG_DYNODE_PAYMENT_VOTE:
-        return dnpayments.mapDynodePaymentVotes.count(inv.hash);
+        return dnpayments.HasPaymentVote(inv.hash);
 
     case MSG_DYNODE_PAYMENT_BLOCK: {
         BlockMap::iterator mi = mapBlockIndex.find(inv.hash);
-        return mi != mapBlockIndex.end() && dnpayments.mapDynodeBlocks.find(mi->second->nHeight) != dnpayments.mapDynodeBlocks.end();
+        if (mi == mapBlockIndex.end())
+            return false;
+        LOCK(cs_mapDynodeBlocks);
+        return dnpayments.GetBlockPayees(mi->second->nHeight) != NULL;
     }
 
     case MSG_DYNODE_ANNOUNCE:
@@ -1170,23 +1173,19 @@ void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParam
                 }
 
                 if (!push && inv.type == MSG_DYNODE_PAYMENT_VOTE) {
-                    if (dnpayments.HasVerifiedPaymentVote(inv.hash)) {
-                        connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::DYNODEPAYMENTVOTE, dnpayments.mapDynodePaymentVotes[inv.hash]));
+                    CDynodePaymentVote vote;
+                    if (dnpayments.GetVerifiedPaymentVote(inv.hash, vote)) {
+                        connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::DYNODEPAYMENTVOTE, vote));
                         push = true;
                     }
                 }
 
                 if (!push && inv.type == MSG_DYNODE_PAYMENT_BLOCK) {
                     BlockMap::iterator mi = mapBlockIndex.find(inv.hash);
-                    LOCK(cs_mapDynodeBlocks);
-                    if (mi != mapBlockIndex.end() && dnpayments.mapDynodeBlocks.count(mi->second->nHeight)) {
-                        BOOST_FOREACH (CDynodePayee& payee, dnpayments.mapDynodeBlocks[mi->second->nHeight].vecPayees) {
-                            std::vector<uint256> vecVoteHashes = payee.GetVoteHashes();
-                            BOOST_FOREACH (uint256& hash, vecVoteHashes) {
-                                if (dnpayments.HasVerifiedPaymentVote(hash)) {
-                                    connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::DYNODEPAYMENTVOTE, dnpayments.mapDynodePaymentVotes[hash]));
-                                }
-                            }
+                    std::vector<CDynodePaymentVote> vecVotes;
+                    if (mi != mapBlockIndex.end() && dnpayments.GetBlockVotes(mi->second->nHeight, vecVotes)) {
+                        for (const auto& vote : vecVotes) {
+                            connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::DYNODEPAYMENTVOTE, vote));
                         }
                         push = true;
                     }
@@ -2383,6 +2382,11 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             return true;
         }
 
+        // hash the headers up front, in parallel and outside cs_main, so neither the
+        // checks below nor ProcessNewBlockHeaders need to hash them again
+        std::vector<uint256> vHeaderHashes;
+        GetBlockHeaderHashes(headers, vHeaderHashes);
+
         const CBlockIndex* pindexLast = NULL;
         {
             LOCK(cs_main);
@@ -2400,14 +2404,14 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                 nodestate->nUnconnectingHeaders++;
                 connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::GETHEADERS, chainActive.GetLocator(pindexBestHeader), uint256()));
                 LogPrint("net", "received header %s: missing prev block %s, sending getheaders (%d) to end (peer=%d, nUnconnectingHeaders=%d)\n",
-                    headers[0].GetHash().ToString(),
+                    vHeaderHashes[0].ToString(),
                     headers[0].hashPrevBlock.ToString(),
                     pindexBestHeader->nHeight,
                     pfrom->id, nodestate->nUnconnectingHeaders);
                 // Set hashLastUnknownBlock for this peer, so that if we
                 // eventually get the headers - even from a different peer -
                 // we can use this peer to download.
-                UpdateBlockAvailability(pfrom->GetId(), headers.back().GetHash());
+                UpdateBlockAvailability(pfrom->GetId(), vHeaderHashes.back());
 
                 if (nodestate->nUnconnectingHeaders % MAX_UNCONNECTING_HEADERS == 0) {
                     Misbehaving(pfrom->GetId(), 20);
@@ -2415,18 +2419,16 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                 return true;
             }
 
-            uint256 hashLastBlock;
-            for (const CBlockHeader& header : headers) {
-                if (!hashLastBlock.IsNull() && header.hashPrevBlock != hashLastBlock) {
+            for (unsigned int n = 1; n < headers.size(); n++) {
+                if (headers[n].hashPrevBlock != vHeaderHashes[n - 1]) {
                     Misbehaving(pfrom->GetId(), 20);
                     return error("non-continuous headers sequence");
                 }
-                hashLastBlock = header.GetHash();
             }
         }
 
         CValidationState state;
-        if (!ProcessNewBlockHeaders(headers, state, chainparams, &pindexLast)) {
+        if (!ProcessNewBlockHeaders(headers, state, chainparams, &pindexLast, &vHeaderHashes)) {
             int nDoS;
             if (state.IsInvalid(nDoS)) {
                 if (nDoS > 0) {
@@ -2693,59 +2695,8 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
     else if (strCommand == NetMsgType::VGPMESSAGE) {
         CVGPMessage message;
         vRecv >> message;
-        CUnsignedVGPMessage unsignedMessage(message.vchMsg);
-
-        LogPrint("bdap", "%s -- VGP message received: size = %d, SubjectID = %s, MessageID = %s, HashID = %s \n", 
-                        __func__, message.vchMsg.size(), unsignedMessage.SubjectID.ToString(), unsignedMessage.MessageID.ToString(), message.GetHash().ToString());
-
-        std::string strErrorMessage = "";
-        int statusBan = message.ProcessMessage(strErrorMessage);
-        if (strErrorMessage.size() > 0)
-        {
-            LogPrint("bdap", "%s -- Error processing message. Hash %s,  MessageID %s, SubjectID %s, Error %s\n", __func__, 
-                                message.GetHash().ToString(), unsignedMessage.MessageID.ToString(), unsignedMessage.SubjectID.ToString(), strErrorMessage);
-        }
-        if (statusBan == 0)
-        {
-            // Relay
-            pfrom->setKnown.insert(message.GetHash());
-            {
-                connman.ForEachNode([&message, &connman](CNode* pnode) {
-                    message.RelayTo(pnode, connman);
-                });
-            }
-        }
-        else if (statusBan > 0)
-        {
-            Misbehaving(pfrom->GetId(), statusBan);
-        }
-        else if (statusBan == -1)
-        {
-            LogPrint("bdap", "%s -- Duplicate message recieved. Hash %s,  MessageID %s, SubjectID %s\n", __func__, 
-                                message.GetHash().ToString(), unsignedMessage.MessageID.ToString(), unsignedMessage.SubjectID.ToString());
-        }
-        else if (statusBan == -2)
-        {
-            LogPrint("bdap", "%s -- Message either too old or timestamp is in the future. Hash %s,  MessageID %s, SubjectID %s\n", __func__, 
-                                message.GetHash().ToString(), unsignedMessage.MessageID.ToString(), unsignedMessage.SubjectID.ToString());
-        }
-        else if (statusBan == -3)
-        {
-            LogPrint("bdap", "%s -- Timestamp is greater than relay until time. Hash %s,  MessageID %s, SubjectID %s\n", __func__, 
-                                message.GetHash().ToString(), unsignedMessage.MessageID.ToString(), unsignedMessage.SubjectID.ToString());
-            Misbehaving(pfrom->GetId(), 10); // there is no reason to have a timestamp greater than the relay until time so ban node.
-        }
-        else if (statusBan == -4)
-        {
-            LogPrint("bdap", "%s -- Relay time is too much.  max relay is 120 seconds. Hash %s,  MessageID %s, SubjectID %s\n", __func__, 
-                                message.GetHash().ToString(), unsignedMessage.MessageID.ToString(), unsignedMessage.SubjectID.ToString());
-            Misbehaving(pfrom->GetId(), 10); // there is no reason to have longer relay until time span so ban node.
-        }
-        else
-        {
-            LogPrintf("%s -- Unkown ProcessMessage status. Hash %s,  MessageID %s, SubjectID %s\n", __func__, 
-                                message.GetHash().ToString(), unsignedMessage.MessageID.ToString(), unsignedMessage.SubjectID.ToString());
-        }
+        // signature, proof of work and decryption are done on the VGP message verification threads
+        ProcessVGPMessage(pfrom->GetId(), message, connman);
     }
 
     else if (strCommand == NetMsgType::FILTERLOAD) {
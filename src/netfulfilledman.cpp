@@ -13,69 +13,129 @@
 
 CNetFulfilledRequestManager netfulfilledman;
 
-void CNetFulfilledRequestManager::AddFulfilledRequest(const CService& addr, const std::string& strRequest)
+/** Interned request names, ids are indexes into vNames */
+struct fulfilledreq_names_t {
+    CCriticalSection cs;
+    std::unordered_map<std::string, int> mapIds;
+    std::vector<std::string> vNames;
+};
+
+static fulfilledreq_names_t& GetRequestNames()
+{
+    // constructed on first use, request ids are taken during static initialization
+    static fulfilledreq_names_t names;
+    return names;
+}
+
+int CNetFulfilledRequestManager::GetRequestId(const std::string& strRequest)
+{
+    fulfilledreq_names_t& names = GetRequestNames();
+    LOCK(names.cs);
+    std::pair<std::unordered_map<std::string, int>::iterator, bool> ret = names.mapIds.emplace(strRequest, (int)names.vNames.size());
+    if (ret.second)
+        names.vNames.push_back(strRequest);
+    return ret.first->second;
+}
+
+std::string CNetFulfilledRequestManager::GetRequestName(int nRequestId)
+{
+    fulfilledreq_names_t& names = GetRequestNames();
+    LOCK(names.cs);
+    return names.vNames.at(nRequestId);
+}
+
+CService CNetFulfilledRequestManager::GetSquashedAddr(const CService& addr)
+{
+    return Params().AllowMultiplePorts() ? addr : CService(addr, 0);
+}
+
+void CNetFulfilledRequestManager::AddFulfilledRequest(const CService& addrSquashed, int nRequestId, int64_t nExpireTime)
+{
+    AssertLockHeld(cs_mapFulfilledRequests);
+    fulfilledreq_key_t key(addrSquashed, nRequestId);
+    // requests expiring in a passed slot are filed in the next one to be visited
+    int64_t nTick = std::max(nExpireTime / WHEEL_SLOT_SECONDS, nWheelTick);
+    std::pair<fulfilledreqmap_t::iterator, bool> ret = mapFulfilledRequests.emplace(key, fulfilledreq_t());
+    fulfilledreq_t& request = ret.first->second;
+    request.nExpireTime = nExpireTime;
+    if (ret.second || request.nWheelTick != nTick) {
+        request.nWheelTick = nTick;
+        vWheel[nTick % WHEEL_SIZE].push_back(wheel_entry_t(key, nTick));
+    }
+}
+
+void CNetFulfilledRequestManager::AddFulfilledRequest(const CService& addr, int nRequestId)
 {
     LOCK(cs_mapFulfilledRequests);
-    CService addrSquashed = Params().AllowMultiplePorts() ? addr : CService(addr, 0);
-    mapFulfilledRequests[addrSquashed][strRequest] = GetTime() + Params().FulfilledRequestExpireTime();
+    AddFulfilledRequest(GetSquashedAddr(addr), nRequestId, GetTime() + Params().FulfilledRequestExpireTime());
 }
 
-bool CNetFulfilledRequestManager::HasFulfilledRequest(const CService& addr, const std::string& strRequest)
+void CNetFulfilledRequestManager::AddFulfilledRequest(const CService& addr, const std::string& strRequest)
+{
+    AddFulfilledRequest(addr, GetRequestId(strRequest));
+}
+
+bool CNetFulfilledRequestManager::HasFulfilledRequest(const CService& addr, int nRequestId)
 {
     LOCK(cs_mapFulfilledRequests);
-    CService addrSquashed = Params().AllowMultiplePorts() ? addr : CService(addr, 0);
-    fulfilledreqmap_t::iterator it = mapFulfilledRequests.find(addrSquashed);
+    fulfilledreqmap_t::const_iterator it = mapFulfilledRequests.find(fulfilledreq_key_t(GetSquashedAddr(addr), nRequestId));
 
-    return it != mapFulfilledRequests.end() &&
-           it->second.find(strRequest) != it->second.end() &&
-           it->second[strRequest] > GetTime();
+    return it != mapFulfilledRequests.end() && it->second.nExpireTime > GetTime();
+}
+
+bool CNetFulfilledRequestManager::HasFulfilledRequest(const CService& addr, const std::string& strRequest)
+{
+    return HasFulfilledRequest(addr, GetRequestId(strRequest));
 }
 
 void CNetFulfilledRequestManager::RemoveFulfilledRequest(const CService& addr, const std::string& strRequest)
 {
     LOCK(cs_mapFulfilledRequests);
-    CService addrSquashed = Params().AllowMultiplePorts() ? addr : CService(addr, 0);
-    fulfilledreqmap_t::iterator it = mapFulfilledRequests.find(addrSquashed);
-
-    if (it != mapFulfilledRequests.end()) {
-        it->second.erase(strRequest);
-    }
+    // the wheel entry is dropped as stale when its slot is visited
+    mapFulfilledRequests.erase(fulfilledreq_key_t(GetSquashedAddr(addr), GetRequestId(strRequest)));
 }
 
 void CNetFulfilledRequestManager::CheckAndRemove()
 {
     LOCK(cs_mapFulfilledRequests);
 
-    int64_t now = GetTime();
-    fulfilledreqmap_t::iterator it = mapFulfilledRequests.begin();
+    int64_t nNowTick = GetTime() / WHEEL_SLOT_SECONDS;
 
-    while (it != mapFulfilledRequests.end()) {
-        fulfilledreqmapentry_t::iterator it_entry = it->second.begin();
-        while (it_entry != it->second.end()) {
-            if (now > it_entry->second) {
-                it->second.erase(it_entry++);
-            } else {
-                ++it_entry;
+    // visit the slots of the ticks passed since the last run, each slot at most once
+    int64_t nFirstTick = std::max(nWheelTick, nNowTick - WHEEL_SIZE);
+    for (int64_t nTick = nFirstTick; nTick < nNowTick; nTick++) {
+        int nSlot = nTick % WHEEL_SIZE;
+        std::vector<wheel_entry_t>& vSlot = vWheel[nSlot];
+        std::vector<wheel_entry_t> vKeep;
+        for (const wheel_entry_t& entry : vSlot) {
+            fulfilledreqmap_t::iterator it = mapFulfilledRequests.find(entry.first);
+            // removed or filed under another tick since
+            if (it == mapFulfilledRequests.end() || it->second.nWheelTick != entry.second)
+                continue;
+            if (entry.second <= nTick) {
+                mapFulfilledRequests.erase(it);
+                continue;
             }
+            // filed for a later turn of the wheel
+            vKeep.push_back(entry);
         }
-        if (it->second.size() == 0) {
-            mapFulfilledRequests.erase(it++);
-        } else {
-            ++it;
-        }
+        vSlot.swap(vKeep);
     }
+    nWheelTick = std::max(nWheelTick, nNowTick);
 }
 
 void CNetFulfilledRequestManager::Clear()
 {
     LOCK(cs_mapFulfilledRequests);
     mapFulfilledRequests.clear();
+    for (auto& wheelSlot : vWheel)
+        wheelSlot.clear();
 }
 
 std::string CNetFulfilledRequestManager::ToString() const
 {
     std::ostringstream info;
-    info << "Nodes with fulfilled requests: " << (int)mapFulfilledRequests.size();
+    info << "Fulfilled requests: " << (int)mapFulfilledRequests.size();
     return info.str();
 }
 
@@ -84,4 +144,3 @@ void CNetFulfilledRequestManager::DoMaintenance()
     if (ShutdownRequested()) return;
      CheckAndRemove();
 }
-
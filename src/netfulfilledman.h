@@ -9,39 +9,97 @@
 #define DYNAMIC_NETFULFILLEDMAN_H
 
 #include "netaddress.h"
+#include "saltedhasher.h"
 #include "serialize.h"
 #include "sync.h"
 
+#include <unordered_map>
+
 class CNetFulfilledRequestManager;
 extern CNetFulfilledRequestManager netfulfilledman;
 
+class SaltedFulfilledRequestHasher : private SaltedHasherBase
+{
+public:
+    size_t operator()(const std::pair<CService, int>& key) const
+    {
+        std::vector<unsigned char> vchAddr = key.first.GetKey();
+        return GetHasher().Write(vchAddr.data(), vchAddr.size()).Write((uint64_t)key.second).Finalize();
+    }
+};
+
 // Fulfilled requests are used to prevent nodes from asking for the same data on sync
 // and from being banned for doing so too often.
+//
+// Requests are kept in a hash table keyed by address and request id, where request names
+// are interned to ids once (see GetRequestId), so lookups do no string comparisons.
+// Expiry uses a timing wheel: every request is filed in the slot of the minute it expires
+// in, and CheckAndRemove only visits the slots that have passed since its last run.
 class CNetFulfilledRequestManager
 {
 private:
-    typedef std::map<std::string, int64_t> fulfilledreqmapentry_t;
-    typedef std::map<CService, fulfilledreqmapentry_t> fulfilledreqmap_t;
+    typedef std::pair<CService, int> fulfilledreq_key_t;
+
+    struct fulfilledreq_t {
+        int64_t nExpireTime;
+        // wheel tick the request is filed under, wheel entries of the key for other ticks are stale
+        int64_t nWheelTick;
+    };
+
+    // a request key and the wheel tick it was filed under
+    typedef std::pair<fulfilledreq_key_t, int64_t> wheel_entry_t;
+
+    typedef std::unordered_map<fulfilledreq_key_t, fulfilledreq_t, SaltedFulfilledRequestHasher> fulfilledreqmap_t;
+
+    // seconds covered by one wheel slot and number of slots, later ticks wrap around
+    static const int64_t WHEEL_SLOT_SECONDS = 60;
+    static const int WHEEL_SIZE = 64;
 
     //keep track of what node has/was asked for and when
     fulfilledreqmap_t mapFulfilledRequests;
+    std::vector<std::vector<wheel_entry_t> > vWheel;
+    // the wheel has been advanced up to this tick
+    int64_t nWheelTick;
     CCriticalSection cs_mapFulfilledRequests;
 
+    static CService GetSquashedAddr(const CService& addr);
+    static std::string GetRequestName(int nRequestId);
+
+    void AddFulfilledRequest(const CService& addrSquashed, int nRequestId, int64_t nExpireTime);
     void RemoveFulfilledRequest(const CService& addr, const std::string& strRequest);
 
 public:
-    CNetFulfilledRequestManager() {}
+    CNetFulfilledRequestManager() : vWheel(WHEEL_SIZE), nWheelTick(0) {}
 
     ADD_SERIALIZE_METHODS;
 
+    // stored as address -> request name -> expiry time, as before requests were interned
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action)
     {
         LOCK(cs_mapFulfilledRequests);
-        READWRITE(mapFulfilledRequests);
+        std::map<CService, std::map<std::string, int64_t> > mapRequests;
+        if (!ser_action.ForRead()) {
+            for (const auto& pair : mapFulfilledRequests)
+                mapRequests[pair.first.first][GetRequestName(pair.first.second)] = pair.second.nExpireTime;
+        }
+        READWRITE(mapRequests);
+        if (ser_action.ForRead()) {
+            mapFulfilledRequests.clear();
+            for (auto& wheelSlot : vWheel)
+                wheelSlot.clear();
+            for (const auto& pairAddr : mapRequests)
+                for (const auto& pairRequest : pairAddr.second)
+                    AddFulfilledRequest(pairAddr.first, GetRequestId(pairRequest.first), pairRequest.second);
+        }
     }
 
+    /// Get the id of a request name, the same for every call with that name
+    static int GetRequestId(const std::string& strRequest);
+
+    void AddFulfilledRequest(const CService& addr, int nRequestId);
     void AddFulfilledRequest(const CService& addr, const std::string& strRequest);
+    bool HasFulfilledRequest(const CService& addr, int nRequestId);
     bool HasFulfilledRequest(const CService& addr, const std::string& strRequest);
 
     void CheckAndRemove();
@@ -11,9 +11,45 @@
 #include "tinyformat.h"
 #include "utilstrencodings.h"
 
+static thread_local uint64_t nBlockHeaderHashes = 0;
+
+uint64_t GetBlockHeaderHashCount()
+{
+    return nBlockHeaderHashes;
+}
+
+CBlockHeader& CBlockHeader::operator=(const CBlockHeader& header)
+{
+    nVersion = header.nVersion;
+    hashPrevBlock = header.hashPrevBlock;
+    hashMerkleRoot = header.hashMerkleRoot;
+    nTime = header.nTime;
+    nBits = header.nBits;
+    nNonce = header.nNonce;
+    std::atomic_store(&hashCache, std::atomic_load(&header.hashCache));
+    return *this;
+}
+
 uint256 CBlockHeader::GetHash() const
 {
-    return hash_Argon2d(BEGIN(nVersion), END(nNonce), 1);
+    static_assert(sizeof(nVersion) + sizeof(hashPrevBlock) + sizeof(hashMerkleRoot) + sizeof(nTime) + sizeof(nBits) + sizeof(nNonce) == BLOCK_HEADER_HASHED_SIZE,
+        "unexpected block header size");
+    std::shared_ptr<const CBlockHeaderHashCache> cache = std::atomic_load(&hashCache);
+    if (cache && memcmp(cache->vchHeader, BEGIN(nVersion), BLOCK_HEADER_HASHED_SIZE) == 0)
+        return cache->hash;
+
+    nBlockHeaderHashes++;
+    uint256 hash = hash_Argon2d(BEGIN(nVersion), END(nNonce), 1);
+    CacheHash(hash);
+    return hash;
+}
+
+void CBlockHeader::CacheHash(const uint256& hash) const
+{
+    std::shared_ptr<CBlockHeaderHashCache> cache = std::make_shared<CBlockHeaderHashCache>();
+    memcpy(cache->vchHeader, BEGIN(nVersion), BLOCK_HEADER_HASHED_SIZE);
+    cache->hash = hash;
+    std::atomic_store(&hashCache, std::shared_ptr<const CBlockHeaderHashCache>(cache));
 }
 
 std::string CBlock::ToString() const
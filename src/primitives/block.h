@@ -12,6 +12,17 @@
 #include "uint256.h"
 #include "utilstrencodings.h"
 
+#include <memory>
+
+/** Size of the header fields hashed for proof of work, nVersion through nNonce */
+static const unsigned int BLOCK_HEADER_HASHED_SIZE = 80;
+
+/** Memory-only record of a header hash and the header fields it was computed from */
+struct CBlockHeaderHashCache {
+    unsigned char vchHeader[BLOCK_HEADER_HASHED_SIZE];
+    uint256 hash;
+};
+
 /** Nodes collect new transactions into a block, hash them into a hash tree,
  * and scan through nonce values to make the block's hash satisfy proof-of-work
  * requirements.  When they solve the proof-of-work, they broadcast the block
@@ -30,11 +41,23 @@ public:
     uint32_t nBits;
     uint32_t nNonce;
 
+private:
+    // memory only, reused by GetHash() while the fields are unchanged
+    mutable std::shared_ptr<const CBlockHeaderHashCache> hashCache;
+
+public:
     CBlockHeader()
     {
         SetNull();
     }
 
+    CBlockHeader(const CBlockHeader& header)
+    {
+        *this = header;
+    }
+
+    CBlockHeader& operator=(const CBlockHeader& header);
+
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
@@ -56,6 +79,7 @@ public:
         nTime = 0;
         nBits = 0;
         nNonce = 0;
+        std::atomic_store(&hashCache, std::shared_ptr<const CBlockHeaderHashCache>());
     }
 
     bool IsNull() const
@@ -63,7 +87,10 @@ public:
         return (nBits == 0);
     }
 
+    /** Returns the Argon2d hash of the header, computing it only when the fields changed since the last one */
     uint256 GetHash() const;
+    /** Record the already known hash of the header's current fields, e.g. from the block index */
+    void CacheHash(const uint256& hash) const;
 
     int64_t GetBlockTime() const
     {
@@ -114,20 +141,16 @@ public:
 
     CBlockHeader GetBlockHeader() const
     {
-        CBlockHeader block;
-        block.nVersion = nVersion;
-        block.hashPrevBlock = hashPrevBlock;
-        block.hashMerkleRoot = hashMerkleRoot;
-        block.nTime = nTime;
-        block.nBits = nBits;
-        block.nNonce = nNonce;
-        return block;
+        return *this;
     }
 
     std::string ToString() const;
 };
 
 
+/** Number of block header hashes computed by this thread, not counting those answered from a cache */
+uint64_t GetBlockHeaderHashCount();
+
 /** Describes a place in the block chain to another node such that if the
  * other node doesn't have the same branch, it can find a recent common trunk.
  * The further back it is, the further before the fork it may be.
@@ -926,6 +926,7 @@ UniValue getgovernanceinfo(const JSONRPCRequest& request)
                             "  \"lastsuperblock\": xxxxx,                (numeric) the block number of the last superblock\n"
                             "  \"nextsuperblock\": xxxxx,                (numeric) the block number of the next superblock\n"
                             "  \"maxgovobjdatasize\": xxxxx,             (numeric) maximum governance object data size in bytes\n"
+                            "  \"unverifiedvotes\": xxxxx,               (numeric) the number of cached votes whose signatures are still being verified after startup\n"
                             "}\n"
                             "\nExamples:\n" +
             HelpExampleCli("getgovernanceinfo", "") + HelpExampleRpc("getgovernanceinfo", ""));
@@ -947,6 +948,7 @@ UniValue getgovernanceinfo(const JSONRPCRequest& request)
     obj.push_back(Pair("lastsuperblock", nLastSuperblock));
     obj.push_back(Pair("nextsuperblock", nNextSuperblock));
     obj.push_back(Pair("maxgovobjdatasize", MAX_GOVERNANCE_OBJECT_DATA_SIZE));
+    obj.push_back(Pair("unverifiedvotes", governance.GetLoadedVotesUnverified()));
 
     return obj;
 }
@@ -17,6 +17,7 @@
 #include "fluid/fluid.h"
 #include "fluid/fluiddb.h"
 #include "fluid/fluidmint.h"
+#include "hash.h"
 #include "init.h"
 #include "miner/miner.h"
 #include "net.h"
@@ -419,7 +420,9 @@ UniValue getmininginfo(const JSONRPCRequest& request)
             "  \"chain\": \"xxxx\",         (string) current network name as defined in BIP70 (main, test, regtest)\n"
             "  \"hashespersec\": n          (numeric) The recent hashes per second when generation is on (will return 0 if generation is off)\n"
             "  \"cpuhashespersec\": n       (numeric) The recent CPU hashes per second when generation is on (will return 0 if generation is off)\n"
+            "  \"cputhreadhashespersec\": [n, ...] (array) The recent hashes per second of each CPU miner thread\n"
             "  \"gpuhashespersec\": n       (numeric) The recent GPU hashes per second when generation is on (will return 0 if generation is off)\n"
+            "  \"argon2d\": \"xxxx\",        (string) The Argon2d fill-block implementation in use (sse2, ssse3, avx2, avx512f)\n"
             "}\n"
             "\nExamples:\n" +
             HelpExampleCli("getmininginfo", "") + HelpExampleRpc("getmininginfo", ""));
@@ -441,7 +444,12 @@ UniValue getmininginfo(const JSONRPCRequest& request)
     obj.push_back(Pair("generate", getgenerate(request)));
     obj.push_back(Pair("hashespersec", gethashespersec(request)));
     obj.push_back(Pair("cpuhashespersec", getcpuhashespersec(request)));
+    UniValue threadRates(UniValue::VARR);
+    for (int64_t rate : GetCPUThreadHashRates())
+        threadRates.push_back(rate);
+    obj.push_back(Pair("cputhreadhashespersec", threadRates));
     obj.push_back(Pair("gpuhashespersec", getgpuhashespersec(request)));
+    obj.push_back(Pair("argon2d", argon2d_impl_name()));
     return obj;
 }
 
@@ -5,6 +5,7 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "bdap/vgpmessage.h"
 #include "chainparams.h"
 #include "clientversion.h"
 #include "net.h"
@@ -406,6 +407,12 @@ UniValue getnetworkinfo(const JSONRPCRequest& request)
                             "  }\n"
                             "  ,...\n"
                             "  ]\n"
+                            "  \"vgpmessagelog\": {                     (json object) recently received VGP message filter\n"
+                            "    \"entries\": xxxxx,                    (numeric) message hashes currently tracked\n"
+                            "    \"lookups\": xxxxx,                    (numeric) messages checked against the filter\n"
+                            "    \"hits\": xxxxx,                       (numeric) duplicate messages that were filtered\n"
+                            "    \"hitrate\": x.xxx                     (numeric) fraction of lookups that were duplicates\n"
+                            "  }\n"
                             "  \"warnings\": \"...\"                    (string) any network warnings\n"
                             "}\n"
                             "\nExamples:\n" +
@@ -439,6 +446,15 @@ UniValue getnetworkinfo(const JSONRPCRequest& request)
         }
     }
     obj.push_back(Pair("localaddresses", localAddresses));
+    size_t nMessageLogEntries = 0;
+    uint64_t nMessageLogLookups = 0, nMessageLogHits = 0;
+    GetRecentMessageLogStats(nMessageLogEntries, nMessageLogLookups, nMessageLogHits);
+    UniValue messageLog(UniValue::VOBJ);
+    messageLog.push_back(Pair("entries", (uint64_t)nMessageLogEntries));
+    messageLog.push_back(Pair("lookups", nMessageLogLookups));
+    messageLog.push_back(Pair("hits", nMessageLogHits));
+    messageLog.push_back(Pair("hitrate", nMessageLogLookups > 0 ? (double)nMessageLogHits / nMessageLogLookups : 0.0));
+    obj.push_back(Pair("vgpmessagelog", messageLog));
     obj.push_back(Pair("warnings", GetWarnings("statusbar")));
     return obj;
 }
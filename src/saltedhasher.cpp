@@ -0,0 +1,12 @@
+// Copyright (c) 2016-2021 Duality Blockchain Solutions Developers
+// Copyright (c) 2009-2021 The Bitcoin Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "saltedhasher.h"
+
+#include "random.h"
+
+#include <limits>
+
+SaltedHasherBase::SaltedHasherBase() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
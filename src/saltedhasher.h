@@ -0,0 +1,42 @@
+// Copyright (c) 2016-2021 Duality Blockchain Solutions Developers
+// Copyright (c) 2009-2021 The Bitcoin Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DYNAMIC_SALTEDHASHER_H
+#define DYNAMIC_SALTEDHASHER_H
+
+#include "hash.h"
+#include "uint256.h"
+
+#include <stdint.h>
+
+/**
+ * Random SipHash keys for the hashers of unordered containers keyed by data peers
+ * can choose, so they can't announce colliding keys. Hashers for other key types
+ * derive from it and hash with GetHasher().
+ */
+class SaltedHasherBase
+{
+protected:
+    /** Salt */
+    const uint64_t k0, k1;
+
+    SaltedHasherBase();
+
+    CSipHasher GetHasher() const
+    {
+        return CSipHasher(k0, k1);
+    }
+};
+
+class SaltedTxidHasher : private SaltedHasherBase
+{
+public:
+    size_t operator()(const uint256& txid) const
+    {
+        return SipHashUint256(k0, k1, txid);
+    }
+};
+
+#endif // DYNAMIC_SALTEDHASHER_H
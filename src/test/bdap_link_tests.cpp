@@ -12,7 +12,14 @@
 #include "util.h"
 #include "utilstrencodings.h"
 #include "test/test_dynamic.h"
+#include "bdap/domainentrydb.h"
 #include "bdap/linking.h"
+#include "bdap/linkingdb.h"
+#include "consensus/validation.h"
+#include "policy/policy.h"
+#include "primitives/block.h"
+#include "random.h"
+#include "validation.h"
 
 
 #include <string>
@@ -43,4 +50,114 @@ BOOST_AUTO_TEST_CASE(bdap_link_test1)
 
 }
 
+// A new link request transaction for vchPubKey paying opAmount as the link deposit
+static CTransactionRef MakeLinkRequestTx(const std::string& strPubKey, const CAmount opAmount)
+{
+    CMutableTransaction tx;
+    tx.nVersion = BDAP_TX_VERSION;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(GetRandHash(), 0);
+    std::vector<unsigned char> vchPubKey(strPubKey.begin(), strPubKey.end());
+    std::vector<unsigned char> vchSharedPubKey(DHT_HEX_PUBLIC_KEY_LENGTH, 'b');
+    CScript scriptOp;
+    scriptOp << CScript::EncodeOP_N(OP_BDAP_NEW) << CScript::EncodeOP_N(OP_BDAP_LINK_REQUEST)
+             << vchPubKey << vchSharedPubKey << (int64_t)DEFAULT_LINK_EXPIRE_TIME << OP_2DROP << OP_2DROP << OP_DROP << OP_TRUE;
+    CScript scriptData;
+    scriptData << OP_RETURN << std::vector<unsigned char>(64, 'd');
+    tx.vout.push_back(CTxOut(opAmount, scriptOp));
+    tx.vout.push_back(CTxOut(100 * COIN, scriptData));
+    return MakeTransactionRef(tx);
+}
+
+BOOST_FIXTURE_TEST_CASE(bdap_link_connect_inputs, TestingSetup)
+{
+    pDomainEntryDB = new CDomainEntryDB(1 << 20, true, true, false);
+    pLinkDB = new CLinkDB(1 << 20, true, true, false);
+    std::string strPubKey1(DHT_HEX_PUBLIC_KEY_LENGTH, '1');
+    std::string strPubKey2(DHT_HEX_PUBLIC_KEY_LENGTH, '2');
+    std::string strPubKey3(DHT_HEX_PUBLIC_KEY_LENGTH, '3');
+    std::string strBadFee = "ValidateBDAPInputs: CheckLinkTx failed: Invalid BDAP fee amount for a new BDAP link request";
+    CBlock block;
+    uint256 txid;
+
+    // independent requests are validated on the check threads and written in block order
+    std::vector<CTransactionRef> vTx;
+    vTx.push_back(MakeLinkRequestTx(strPubKey1, BDAP_CREDIT));
+    vTx.push_back(MakeLinkRequestTx(strPubKey2, BDAP_CREDIT));
+    CValidationState state;
+    BOOST_CHECK(ConnectBDAPInputs(vTx, block, state, 1));
+    BOOST_CHECK(GetLinkIndex(std::vector<unsigned char>(strPubKey1.begin(), strPubKey1.end()), txid));
+    BOOST_CHECK(txid == vTx[0]->GetHash());
+    BOOST_CHECK(GetLinkIndex(std::vector<unsigned char>(strPubKey2.begin(), strPubKey2.end()), txid));
+    BOOST_CHECK(txid == vTx[1]->GetHash());
+
+    // a failing queued request reports its own reject reason and DoS score
+    vTx.clear();
+    vTx.push_back(MakeLinkRequestTx(strPubKey3, BDAP_CREDIT));
+    vTx.push_back(MakeLinkRequestTx(strPubKey2, 0));
+    state = CValidationState();
+    int nDoS = 0;
+    BOOST_CHECK(!ConnectBDAPInputs(vTx, block, state, 2));
+    BOOST_CHECK(state.IsInvalid(nDoS));
+    BOOST_CHECK_EQUAL(nDoS, 100);
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), strBadFee);
+    BOOST_CHECK(GetLinkIndex(std::vector<unsigned char>(strPubKey3.begin(), strPubKey3.end()), txid));
+    BOOST_CHECK(txid == vTx[0]->GetHash());
+
+    // as with serial validation, the requests before the failing one are written and the ones after it are not
+    std::string strPubKey4(DHT_HEX_PUBLIC_KEY_LENGTH, '4');
+    std::string strPubKey5(DHT_HEX_PUBLIC_KEY_LENGTH, '5');
+    std::string strPubKey6(DHT_HEX_PUBLIC_KEY_LENGTH, '6');
+    vTx.clear();
+    vTx.push_back(MakeLinkRequestTx(strPubKey4, BDAP_CREDIT));
+    vTx.push_back(MakeLinkRequestTx(strPubKey5, 0));
+    vTx.push_back(MakeLinkRequestTx(strPubKey6, BDAP_CREDIT));
+    state = CValidationState();
+    BOOST_CHECK(!ConnectBDAPInputs(vTx, block, state, 3));
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), strBadFee);
+    BOOST_CHECK(GetLinkIndex(std::vector<unsigned char>(strPubKey4.begin(), strPubKey4.end()), txid));
+    BOOST_CHECK(txid == vTx[0]->GetHash());
+    BOOST_CHECK(!GetLinkIndex(std::vector<unsigned char>(strPubKey5.begin(), strPubKey5.end()), txid));
+    BOOST_CHECK(!GetLinkIndex(std::vector<unsigned char>(strPubKey6.begin(), strPubKey6.end()), txid));
+
+    // the serial path leaves the same records behind
+    std::string strPubKey7(DHT_HEX_PUBLIC_KEY_LENGTH, '7');
+    std::string strPubKey8(DHT_HEX_PUBLIC_KEY_LENGTH, '8');
+    std::string strPubKey9(DHT_HEX_PUBLIC_KEY_LENGTH, '9');
+    vTx.clear();
+    vTx.push_back(MakeLinkRequestTx(strPubKey7, BDAP_CREDIT));
+    vTx.push_back(MakeLinkRequestTx(strPubKey8, 0));
+    vTx.push_back(MakeLinkRequestTx(strPubKey9, BDAP_CREDIT));
+    state = CValidationState();
+    bool fSerialValid = true;
+    for (const CTransactionRef& ptx : vTx) {
+        if (!ValidateBDAPInputs(ptx, state, block, false, 3, 2)) {
+            fSerialValid = false;
+            break;
+        }
+    }
+    BOOST_CHECK(!fSerialValid);
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), strBadFee);
+    BOOST_CHECK(GetLinkIndex(std::vector<unsigned char>(strPubKey7.begin(), strPubKey7.end()), txid));
+    BOOST_CHECK(!GetLinkIndex(std::vector<unsigned char>(strPubKey8.begin(), strPubKey8.end()), txid));
+    BOOST_CHECK(!GetLinkIndex(std::vector<unsigned char>(strPubKey9.begin(), strPubKey9.end()), txid));
+
+    // a request reusing a key of the run is validated inline and reports the same way
+    vTx.clear();
+    vTx.push_back(MakeLinkRequestTx(strPubKey3, BDAP_CREDIT));
+    vTx.push_back(MakeLinkRequestTx(strPubKey3, 0));
+    state = CValidationState();
+    BOOST_CHECK(!ConnectBDAPInputs(vTx, block, state, 4));
+    BOOST_CHECK(state.IsInvalid(nDoS));
+    BOOST_CHECK_EQUAL(nDoS, 100);
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), strBadFee);
+    BOOST_CHECK(GetLinkIndex(std::vector<unsigned char>(strPubKey3.begin(), strPubKey3.end()), txid));
+    BOOST_CHECK(txid == vTx[0]->GetHash());
+
+    delete pLinkDB;
+    pLinkDB = NULL;
+    delete pDomainEntryDB;
+    pDomainEntryDB = NULL;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
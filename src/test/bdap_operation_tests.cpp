@@ -0,0 +1,166 @@
+// Copyright (c) 2016-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "base58.h"
+#include "bdap/fees.h"
+#include "bdap/utils.h"
+#include "key.h"
+#include "primitives/transaction.h"
+#include "script/script.h"
+#include "script/standard.h"
+#include "utilstrencodings.h"
+
+#include "test/test_dynamic.h"
+
+#include <boost/test/unit_test.hpp>
+
+// the cached decode must give the same answers as the per field helpers it replaced
+static void CheckDecodeMatchesHelpers(const CMutableTransaction& mtx)
+{
+    CTransactionRef tx = MakeTransactionRef(mtx);
+    CBDAPTxOperationRef operation = GetBDAPTxOperation(tx);
+    BOOST_CHECK(GetBDAPTxOperation(tx) == operation); // served from the cache
+
+    CBDAPTxOperation decoded;
+    DecodeBDAPTxOperation(tx, decoded);
+    BOOST_CHECK_EQUAL(decoded.fOperation, operation->fOperation);
+    BOOST_CHECK_EQUAL(decoded.nDataOut, operation->nDataOut);
+
+    CScript scriptOp;
+    vchCharString vvchArgs;
+    int op1 = -1, op2 = -1;
+    bool fOperation = GetBDAPOpScript(tx, scriptOp, vvchArgs, op1, op2);
+    BOOST_CHECK_EQUAL(operation->fOperation, fOperation);
+    if (fOperation) {
+        BOOST_CHECK(operation->scriptOp == scriptOp);
+        BOOST_CHECK(operation->vvchArgs == vvchArgs);
+        BOOST_CHECK_EQUAL(operation->op1, op1);
+        BOOST_CHECK_EQUAL(operation->op2, op2);
+        BOOST_CHECK_EQUAL(operation->strOpType, GetBDAPOpTypeString(op1, op2));
+    }
+
+    CharString vchData, vchHash;
+    int nOut = -1;
+    bool fData = GetBDAPData(tx, vchData, vchHash, nOut);
+    BOOST_CHECK_EQUAL(operation->fData, fData);
+    BOOST_CHECK_EQUAL(operation->nDataOut, nOut);
+    if (fData) {
+        BOOST_CHECK(operation->vchData == vchData);
+        BOOST_CHECK(operation->vchHash == vchHash);
+    }
+
+    CScript scriptData;
+    bool fDataScript = GetBDAPDataScript(tx, scriptData);
+    BOOST_CHECK_EQUAL(operation->fDataScript, fDataScript);
+    if (fDataScript)
+        BOOST_CHECK(operation->scriptData == scriptData);
+
+    CAmount dataAmount = 0, opAmount = 0;
+    bool fAmounts = ExtractAmountsFromTx(tx, dataAmount, opAmount);
+    BOOST_CHECK_EQUAL(operation->fAmounts, fAmounts);
+    if (fAmounts) {
+        BOOST_CHECK_EQUAL(operation->dataAmount, dataAmount);
+        BOOST_CHECK_EQUAL(operation->opAmount, opAmount);
+    }
+}
+
+static CScript MakeOpScript(const int op1, const int op2, const CScript& scriptDestination)
+{
+    CScript scriptOp;
+    scriptOp << CScript::EncodeOP_N(op1) << CScript::EncodeOP_N(op2)
+             << vchFromString("alice@public.bdap.io") << vchFromString("pubkey") << vchFromString("1Month")
+             << OP_2DROP << OP_2DROP << OP_DROP;
+    scriptOp += scriptDestination;
+    return scriptOp;
+}
+
+BOOST_FIXTURE_TEST_SUITE(bdap_operation_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(bdap_operation_decode_cache_test)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    CScript scriptDestination = GetScriptForDestination(key.GetPubKey().GetID());
+    CScript scriptOp = MakeOpScript(OP_BDAP_NEW, OP_BDAP_ACCOUNT_ENTRY, scriptDestination);
+    CScript scriptData = CScript() << OP_RETURN << std::vector<unsigned char>(80, 0x42);
+
+    // a complete operation with change before it
+    CMutableTransaction mtx;
+    mtx.vout.push_back(CTxOut(5 * COIN, scriptDestination));
+    mtx.vout.push_back(CTxOut(1 * COIN, scriptOp));
+    mtx.vout.push_back(CTxOut(2 * COIN, scriptData));
+    CheckDecodeMatchesHelpers(mtx);
+    CBDAPTxOperationRef operation = GetBDAPTxOperation(MakeTransactionRef(mtx));
+    BOOST_CHECK(operation->fOperation && operation->fData && operation->fAmounts);
+    BOOST_CHECK_EQUAL(operation->nDataOut, 2);
+    BOOST_CHECK_EQUAL(operation->opAmount, 1 * COIN);
+    BOOST_CHECK_EQUAL(operation->dataAmount, 2 * COIN);
+
+    // two operation outputs: the first script and the last amount are used
+    CMutableTransaction mtxTwoOps = mtx;
+    mtxTwoOps.vout.push_back(CTxOut(3 * COIN, MakeOpScript(OP_BDAP_MODIFY, OP_BDAP_ACCOUNT_ENTRY, scriptDestination)));
+    CheckDecodeMatchesHelpers(mtxTwoOps);
+
+    // no outputs at all
+    CheckDecodeMatchesHelpers(CMutableTransaction());
+
+    // a plain payment
+    CMutableTransaction mtxPlain;
+    mtxPlain.vout.push_back(CTxOut(5 * COIN, scriptDestination));
+    CheckDecodeMatchesHelpers(mtxPlain);
+}
+
+BOOST_AUTO_TEST_CASE(bdap_operation_decode_malformed_test)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    CScript scriptDestination = GetScriptForDestination(key.GetPubKey().GetID());
+    CScript scriptData = CScript() << OP_RETURN << std::vector<unsigned char>(80, 0x42);
+
+    std::vector<CScript> vBadOps;
+    // truncated after the first op code
+    vBadOps.push_back(CScript() << CScript::EncodeOP_N(OP_BDAP_NEW));
+    // unknown operation and unknown object type
+    vBadOps.push_back(MakeOpScript(OP_BDAP_NEW, 16, scriptDestination));
+    vBadOps.push_back(CScript() << OP_16 << CScript::EncodeOP_N(OP_BDAP_ACCOUNT_ENTRY) << vchFromString("x") << OP_DROP);
+    // no drop after the arguments
+    vBadOps.push_back(CScript() << CScript::EncodeOP_N(OP_BDAP_NEW) << CScript::EncodeOP_N(OP_BDAP_ACCOUNT_ENTRY) << vchFromString("x"));
+    // a push that runs past the end of the script
+    CScript scriptTruncatedPush = CScript() << CScript::EncodeOP_N(OP_BDAP_NEW) << CScript::EncodeOP_N(OP_BDAP_ACCOUNT_ENTRY);
+    scriptTruncatedPush.push_back(OP_PUSHDATA1);
+    scriptTruncatedPush.push_back(0x50);
+    scriptTruncatedPush.push_back(0x01);
+    vBadOps.push_back(scriptTruncatedPush);
+
+    for (const CScript& scriptBadOp : vBadOps) {
+        CMutableTransaction mtx;
+        mtx.vout.push_back(CTxOut(1 * COIN, scriptBadOp));
+        mtx.vout.push_back(CTxOut(2 * COIN, scriptData));
+        CheckDecodeMatchesHelpers(mtx);
+        BOOST_CHECK(!GetBDAPTxOperation(MakeTransactionRef(mtx))->fOperation);
+    }
+
+    CScript scriptOp = MakeOpScript(OP_BDAP_NEW, OP_BDAP_ACCOUNT_ENTRY, scriptDestination);
+    std::vector<CScript> vBadData;
+    // too short to be a BDAP data output but still unspendable
+    vBadData.push_back(CScript() << OP_RETURN << std::vector<unsigned char>(8, 0x42));
+    // nothing after OP_RETURN
+    vBadData.push_back(CScript() << OP_RETURN);
+    // a data push that runs past the end of the script
+    CScript scriptTruncatedData = CScript() << OP_RETURN;
+    scriptTruncatedData.push_back(OP_PUSHDATA1);
+    scriptTruncatedData.push_back(0xff);
+    scriptTruncatedData.insert(scriptTruncatedData.end(), (CScript::size_type)60, (unsigned char)0x42);
+    vBadData.push_back(scriptTruncatedData);
+
+    for (const CScript& scriptBadData : vBadData) {
+        CMutableTransaction mtx;
+        mtx.vout.push_back(CTxOut(1 * COIN, scriptOp));
+        mtx.vout.push_back(CTxOut(2 * COIN, scriptBadData));
+        CheckDecodeMatchesHelpers(mtx);
+        BOOST_CHECK(!GetBDAPTxOperation(MakeTransactionRef(mtx))->fData);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
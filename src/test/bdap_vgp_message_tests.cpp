@@ -42,7 +42,9 @@
 
 #include <univalue.h>
 
+#include <boost/bind.hpp>
 #include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
 
 //bdap_vgp_message_tests
 
@@ -261,4 +263,174 @@ BOOST_AUTO_TEST_CASE(bdap_vgp_message_test1)
 
 }
 
+static CVGPMessage MakeStoreMessage(const uint256& subjectID, const std::string& strType, const std::string& strSender, const int64_t nTimeStamp, const bool fKeepLast)
+{
+    CUnsignedVGPMessage unsignedMessage(subjectID, GetRandHash(), vchFromString("pubkey"), nTimeStamp, nTimeStamp + 60);
+    unsignedMessage.fEncrypted = false;
+    // same layout as the plain text message payload
+    CDataStream ssData(SER_NETWORK, PROTOCOL_VERSION);
+    ssData << 1 << vchFromString(strType) << vchFromString("value") << vchFromString(strSender) << fKeepLast;
+    unsignedMessage.vchMessageData = std::vector<unsigned char>(ssData.begin(), ssData.end());
+    return CVGPMessage(unsignedMessage);
+}
+
+BOOST_AUTO_TEST_CASE(bdap_vgp_message_store_test)
+{
+    CVGPMessageStore store;
+    uint256 subject1 = GetRandHash();
+    uint256 subject2 = GetRandHash();
+    int64_t nTime = 1600000000;
+
+    CVGPMessage message1 = MakeStoreMessage(subject1, "chat", "alice", nTime, false);
+    BOOST_CHECK(store.Add(message1));
+    BOOST_CHECK(!store.Add(message1)); // duplicate
+    BOOST_CHECK(store.Add(MakeStoreMessage(subject1, "chat", "bob", nTime + 1, false)));
+    BOOST_CHECK(store.Add(MakeStoreMessage(subject2, "status", "alice", nTime + 2, true)));
+    BOOST_CHECK_EQUAL(store.Size(), 3U);
+
+    // keep-last replaces the older message from the same type and sender, and ignores older ones
+    BOOST_CHECK(store.Add(MakeStoreMessage(subject2, "status", "alice", nTime + 10, true)));
+    BOOST_CHECK(!store.Add(MakeStoreMessage(subject2, "status", "alice", nTime + 5, true)));
+    BOOST_CHECK_EQUAL(store.Size(), 3U);
+
+    std::vector<CUnsignedVGPMessage> vBySubject;
+    store.GetBySubject(subject1, vBySubject);
+    BOOST_CHECK_EQUAL(vBySubject.size(), 2U);
+
+    bool fKeepLast = false;
+    std::vector<CVGPMessage> vByType;
+    store.GetByType(vchFromString("chat"), vchFromString("bob"), vByType, fKeepLast);
+    BOOST_CHECK_EQUAL(vByType.size(), 1U);
+    BOOST_CHECK(!fKeepLast);
+    vByType.clear();
+    store.GetByType(std::vector<unsigned char>(), vchFromString("carol"), vByType, fKeepLast);
+    BOOST_CHECK_EQUAL(vByType.size(), 3U);
+    BOOST_CHECK(fKeepLast);
+
+    fKeepLast = false;
+    std::vector<CVGPMessage> vBySender;
+    store.GetBySubjectAndSender(subject2, vchFromString("alice"), vchFromString("status"), vBySender, fKeepLast);
+    BOOST_CHECK_EQUAL(vBySender.size(), 1U);
+    BOOST_CHECK(fKeepLast);
+    BOOST_CHECK_EQUAL(CUnsignedVGPMessage(vBySender[0].vchMsg).nTimeStamp, nTime + 10);
+
+    // expiry removes old messages but keeps the latest keep-last message
+    store.Expire(nTime + KEEP_MY_MESSAGE_ALIVE_SECONDS + 1);
+    BOOST_CHECK_EQUAL(store.Size(), 2U);
+    store.Expire(nTime + KEEP_MY_MESSAGE_ALIVE_SECONDS + 1000);
+    BOOST_CHECK_EQUAL(store.Size(), 1U);
+    vBySubject.clear();
+    store.GetBySubject(subject1, vBySubject);
+    BOOST_CHECK(vBySubject.empty());
+}
+
+BOOST_AUTO_TEST_CASE(bdap_vgp_message_log_test)
+{
+    CVGPMessageLog log(KEEP_MESSAGE_LOG_ALIVE_SECONDS, MESSAGE_LOG_BUCKETS);
+    int64_t nTime = 1600000000;
+    uint256 hash1 = GetRandHash();
+    uint256 hash2 = GetRandHash();
+
+    BOOST_CHECK(!log.CheckAndInsert(hash1, nTime));
+    BOOST_CHECK(log.CheckAndInsert(hash1, nTime + 1));
+    BOOST_CHECK(!log.CheckAndInsert(hash2, nTime + 100));
+    // still remembered at the end of the keep alive window
+    BOOST_CHECK(log.CheckAndInsert(hash1, nTime + KEEP_MESSAGE_LOG_ALIVE_SECONDS));
+    size_t nEntries;
+    uint64_t nLookups, nHits;
+    log.GetStats(nTime + KEEP_MESSAGE_LOG_ALIVE_SECONDS, nEntries, nLookups, nHits);
+    BOOST_CHECK_EQUAL(nEntries, 2U);
+    BOOST_CHECK_EQUAL(nLookups, 4U);
+    BOOST_CHECK_EQUAL(nHits, 2U);
+
+    // the first bucket has rotated out, the second hash is still live
+    int64_t nLater = nTime + KEEP_MESSAGE_LOG_ALIVE_SECONDS + (KEEP_MESSAGE_LOG_ALIVE_SECONDS / MESSAGE_LOG_BUCKETS) * 2;
+    BOOST_CHECK(!log.CheckAndInsert(hash1, nLater));
+    BOOST_CHECK(log.CheckAndInsert(hash2, nLater));
+
+    // an erased hash is accepted again
+    log.Erase(hash2);
+    BOOST_CHECK(!log.CheckAndInsert(hash2, nLater));
+
+    // expired buckets are not counted even if nothing was inserted since
+    log.GetStats(nLater + KEEP_MESSAGE_LOG_ALIVE_SECONDS * 2, nEntries, nLookups, nHits);
+    BOOST_CHECK_EQUAL(nEntries, 0U);
+    BOOST_CHECK_EQUAL(nLookups, 7U);
+}
+
+struct QueueRecorder
+{
+    boost::mutex mutex;
+    boost::condition_variable cond;
+    std::vector<uint256> vHandled;
+    bool fRelease = false;
+
+    void Handle(const NodeId nodeId, const uint256& messageHash, const CVGPMessage& message)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        vHandled.push_back(messageHash);
+        cond.notify_all();
+        while (!fRelease)
+            cond.wait(lock);
+    }
+
+    void WaitForHandled(const size_t nCount)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while (vHandled.size() < nCount)
+            cond.wait(lock);
+    }
+
+    void Release()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        fRelease = true;
+        cond.notify_all();
+    }
+};
+
+BOOST_AUTO_TEST_CASE(bdap_vgp_message_queue_test)
+{
+    CVGPMessageQueue queue(3);
+    CVGPMessageLog log(KEEP_MESSAGE_LOG_ALIVE_SECONDS, MESSAGE_LOG_BUCKETS);
+    int64_t nTime = 1600000000;
+    std::vector<CVGPMessage> vMessages;
+    std::vector<uint256> vHashes;
+    for (int i = 0; i < 5; i++) {
+        vMessages.push_back(MakeStoreMessage(GetRandHash(), "chat", "alice", nTime + i, false));
+        vHashes.push_back(vMessages.back().GetHash());
+        BOOST_CHECK(!log.CheckAndInsert(vHashes.back(), nTime));
+    }
+
+    // without a worker the caller has to verify in place
+    BOOST_CHECK(QueueVGPMessage(queue, log, 1, vHashes[0], vMessages[0]) == CVGPMessageQueue::PUSH_NO_WORKERS);
+    BOOST_CHECK(log.CheckAndInsert(vHashes[0], nTime));
+
+    QueueRecorder recorder;
+    boost::thread worker(boost::bind(&CVGPMessageQueue::Thread, &queue,
+        CVGPMessageQueue::Handler(boost::bind(&QueueRecorder::Handle, &recorder, _1, _2, _3))));
+
+    // the worker holds the first message, the next three fill the queue
+    while (queue.Push(1, vHashes[0], vMessages[0]) == CVGPMessageQueue::PUSH_NO_WORKERS)
+        MilliSleep(1);
+    recorder.WaitForHandled(1);
+    for (int i = 1; i < 4; i++)
+        BOOST_CHECK(QueueVGPMessage(queue, log, 1, vHashes[i], vMessages[i]) == CVGPMessageQueue::PUSH_QUEUED);
+
+    // a full queue drops the message and forgets its hash so a resend is checked again
+    BOOST_CHECK(QueueVGPMessage(queue, log, 1, vHashes[4], vMessages[4]) == CVGPMessageQueue::PUSH_FULL);
+    BOOST_CHECK(!log.CheckAndInsert(vHashes[4], nTime));
+    BOOST_CHECK(log.CheckAndInsert(vHashes[3], nTime));
+
+    // queued messages are handled in the order they were pushed
+    recorder.Release();
+    recorder.WaitForHandled(4);
+    worker.interrupt();
+    worker.join();
+    BOOST_CHECK(std::vector<uint256>(vHashes.begin(), vHashes.begin() + 4) == recorder.vHandled);
+
+    // the worker unregisters when it is interrupted
+    BOOST_CHECK(queue.Push(1, vHashes[4], vMessages[4]) == CVGPMessageQueue::PUSH_NO_WORKERS);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
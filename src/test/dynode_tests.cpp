@@ -0,0 +1,352 @@
+// Copyright (c) 2016-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "activedynode.h"
+#include "dynode-payments.h"
+#include "dynode-sync.h"
+#include "dynode.h"
+#include "dynodeman.h"
+#include "flat-database.h"
+#include "fluid/fluiddb.h"
+
+#include "key.h"
+#include "netbase.h"
+#include "random.h"
+#include "timedata.h"
+#include "utiltime.h"
+#include "validation.h"
+
+#include "test/test_dynamic.h"
+
+#include <boost/test/unit_test.hpp>
+
+struct DynodeRegtestingSetup : public TestingSetup {
+    DynodeRegtestingSetup() : TestingSetup(CBaseChainParams::REGTEST) {}
+    ~DynodeRegtestingSetup() { dnodeman.Clear(); }
+};
+
+BOOST_FIXTURE_TEST_SUITE(dynode_tests, DynodeRegtestingSetup)
+
+BOOST_AUTO_TEST_CASE(dynode_update_reindex_test)
+{
+    CKey keyCollateral, keyDynode, keyDynodeNew;
+    keyCollateral.MakeNewKey(true);
+    keyDynode.MakeNewKey(true);
+    keyDynodeNew.MakeNewKey(true);
+    COutPoint outpoint(GetRandHash(), 0);
+    CService addr = LookupNumeric("1.2.3.4", 12345);
+    CService addrNew = LookupNumeric("1.2.3.5", 12345);
+
+    // a known Dynode whose last broadcast is old enough to be replaced
+    CDynode dn(addr, outpoint, keyCollateral.GetPubKey(), keyDynode.GetPubKey(), PROTOCOL_VERSION);
+    dn.sigTime = GetAdjustedTime() - DYNODE_MIN_DNB_SECONDS - 1;
+    BOOST_CHECK(dnodeman.Add(dn));
+
+    dynode_info_t infoDn;
+    BOOST_CHECK(dnodeman.GetDynodeInfo(keyDynode.GetPubKey(), infoDn));
+    BOOST_CHECK(!dnodeman.GetDynodeInfo(keyDynodeNew.GetPubKey(), infoDn));
+
+    // a second broadcast for it announcing a new key and addr
+    CDynodeBroadcast dnb(addrNew, outpoint, keyCollateral.GetPubKey(), keyDynodeNew.GetPubKey(), PROTOCOL_VERSION);
+    BOOST_CHECK(dnb.Sign(keyCollateral));
+
+    int nDos = 0;
+    BOOST_CHECK(dnodeman.CheckDnbAndUpdateDynodeList(NULL, dnb, nDos, *connman));
+    BOOST_CHECK_EQUAL(nDos, 0);
+
+    // the entry is found by its new key only
+    BOOST_CHECK(!dnodeman.GetDynodeInfo(keyDynode.GetPubKey(), infoDn));
+    BOOST_CHECK(dnodeman.GetDynodeInfo(keyDynodeNew.GetPubKey(), infoDn));
+    BOOST_CHECK(infoDn.outpoint == outpoint);
+    BOOST_CHECK(infoDn.addr == addrNew);
+    BOOST_CHECK_EQUAL(infoDn.sigTime, dnb.sigTime);
+
+    // an update for our own Dynode is taken right away and makes ManageState
+    // look it up by the key it was just broadcasted with
+    fDynodeMode = true;
+    activeDynode.pubKeyDynode = keyDynode.GetPubKey();
+    SetMockTime(dnb.sigTime + 1);
+    CDynodeBroadcast dnbOurs(addr, outpoint, keyCollateral.GetPubKey(), keyDynode.GetPubKey(), PROTOCOL_VERSION);
+    BOOST_CHECK(dnbOurs.Sign(keyCollateral));
+    BOOST_CHECK(dnodeman.CheckDnbAndUpdateDynodeList(NULL, dnbOurs, nDos, *connman));
+    BOOST_CHECK(activeDynode.strNotCapableReason != "Dynode not in Dynode list");
+    BOOST_CHECK(dnodeman.GetDynodeInfo(keyDynode.GetPubKey(), infoDn));
+    BOOST_CHECK(infoDn.addr == addr);
+    BOOST_CHECK(!dnodeman.GetDynodeInfo(keyDynodeNew.GetPubKey(), infoDn));
+    SetMockTime(0);
+    activeDynode.pubKeyDynode = CPubKey();
+    fDynodeMode = false;
+}
+
+struct DynodeChainSetup : public TestChain100Setup {
+    ~DynodeChainSetup()
+    {
+        dnodeman.Clear();
+        dynodeSync.Reset();
+        dnpayments.Clear();
+    }
+
+    // advance the sync until nAsset is done
+    void SyncPast(int nAsset)
+    {
+        while (dynodeSync.GetAssetID() <= nAsset)
+            dynodeSync.SwitchToNextAsset(*connman);
+    }
+
+    // a Dynode whose collateral is the coinbase of block nBlock, or an unknown outpoint if nBlock is -1
+    CDynode MakeDynode(int nBlock, const CKey& keyCollateral, int nProtocolVersion = PROTOCOL_VERSION)
+    {
+        CKey keyDynode;
+        keyDynode.MakeNewKey(true);
+        COutPoint outpoint(nBlock < 0 ? GetRandHash() : coinbaseTxns[nBlock].GetHash(), 0);
+        CService addr = LookupNumeric(strprintf("1.2.3.%d", nBlock + 2).c_str(), 12345);
+        CDynode dn(addr, outpoint, keyCollateral.GetPubKey(), keyDynode.GetPubKey(), nProtocolVersion);
+        dn.sigTime = GetAdjustedTime() - DYNODE_MIN_DNB_SECONDS - 1;
+        return dn;
+    }
+};
+
+static size_t CountRanks(int nMinProtocol = 0)
+{
+    CDynodeMan::rank_pair_vec_t vecDynodeRanks;
+    dnodeman.GetDynodeRanks(vecDynodeRanks, -1, nMinProtocol);
+    return vecDynodeRanks.size();
+}
+
+BOOST_FIXTURE_TEST_CASE(dynode_rank_cache_test, DynodeChainSetup)
+{
+    SyncPast(DYNODE_SYNC_LIST);
+    CKey keyCollateral;
+    keyCollateral.MakeNewKey(true);
+
+    // a table is cached by the first lookup and dropped when an entry is added
+    CDynode dnA = MakeDynode(0, keyCollateral);
+    CDynode dnSpent = MakeDynode(-1, keyCollateral);
+    BOOST_CHECK(dnodeman.Add(dnA));
+    BOOST_CHECK(dnodeman.Add(dnSpent));
+    BOOST_CHECK_EQUAL(CountRanks(), 2U);
+    BOOST_CHECK(dnodeman.CheckIndexes());
+    CDynode dnB = MakeDynode(1, keyCollateral);
+    BOOST_CHECK(dnodeman.Add(dnB));
+    BOOST_CHECK(dnodeman.CheckIndexes());
+    BOOST_CHECK_EQUAL(CountRanks(), 3U);
+
+    // ... when an entry whose collateral is gone is removed
+    dnodeman.CheckAndRemove(*connman);
+    BOOST_CHECK(!dnodeman.Has(dnSpent.outpoint));
+    BOOST_CHECK(dnodeman.CheckIndexes());
+    BOOST_CHECK_EQUAL(CountRanks(), 2U);
+
+    // ... and when a broadcast updates the protocol version tables are filtered by
+    CDynode dnOld = MakeDynode(2, keyCollateral, PROTOCOL_VERSION - 1);
+    BOOST_CHECK(dnodeman.Add(dnOld));
+    BOOST_CHECK_EQUAL(CountRanks(PROTOCOL_VERSION), 2U);
+    BOOST_CHECK_EQUAL(CountRanks(), 3U);
+    BOOST_CHECK(dnodeman.CheckIndexes());
+
+    CDynodeBroadcast dnb(dnOld.addr, dnOld.outpoint, keyCollateral.GetPubKey(), dnOld.pubKeyDynode, PROTOCOL_VERSION);
+    BOOST_CHECK(dnb.Sign(keyCollateral));
+    int nDos = 0;
+    BOOST_CHECK(dnodeman.CheckDnbAndUpdateDynodeList(NULL, dnb, nDos, *connman));
+    BOOST_CHECK(dnodeman.CheckIndexes());
+    BOOST_CHECK_EQUAL(CountRanks(PROTOCOL_VERSION), 3U);
+}
+
+// record nVotes verified payment votes for payee at nHeight, as if they were read back from the journal
+static std::vector<CDynodePaymentVote> AddPaymentVotes(const CScript& payee, int nHeight, int nVotes)
+{
+    std::vector<CDynodePaymentVote> vecVotes;
+    for (int i = 0; i < nVotes; i++) {
+        CDynodePaymentVote vote(COutPoint(GetRandHash(), 0), nHeight, payee);
+        // any signature makes the vote count as verified
+        vote.vchSig.assign(65, 1);
+        dnpayments.AddJournalVote(vote);
+        vecVotes.push_back(vote);
+    }
+    return vecVotes;
+}
+
+// record two payment votes for payee at nHeight and pay it in the coinbase of that block
+static void PayDynode(const CScript& payee, int nHeight)
+{
+    AddPaymentVotes(payee, nHeight, 2);
+
+    CMutableTransaction coinbase;
+    coinbase.vout.push_back(CTxOut(GetFluidDynodeReward(nHeight), payee));
+    CBlock block;
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    LOCK(cs_main);
+    dnpayments.coinbasePayees.AddBlock(block, chainActive[nHeight]);
+}
+
+BOOST_FIXTURE_TEST_CASE(dynode_update_last_paid_test, DynodeChainSetup)
+{
+    SyncPast(DYNODE_SYNC_DNW);
+    CKey keyA, keyB;
+    keyA.MakeNewKey(true);
+    keyB.MakeNewKey(true);
+    CDynode dnA = MakeDynode(0, keyA);
+    CDynode dnB = MakeDynode(1, keyB);
+    BOOST_CHECK(dnodeman.Add(dnA));
+    BOOST_CHECK(dnodeman.Add(dnB));
+
+    const CBlockIndex* pindexTip;
+    {
+        LOCK(cs_main);
+        pindexTip = chainActive.Tip();
+    }
+    const int nTip = pindexTip->nHeight;
+    PayDynode(GetScriptForDestination(keyA.GetPubKey().GetID()), nTip - 1);
+    PayDynode(GetScriptForDestination(keyB.GetPubKey().GetID()), nTip - 3);
+
+    // both payments are found in one walk and the payment queue is re-keyed for them
+    dnodeman.UpdateLastPaid(pindexTip);
+    std::map<COutPoint, CDynode> mapDynodes = dnodeman.GetFullDynodeMap();
+    BOOST_CHECK_EQUAL(mapDynodes[dnA.outpoint].GetLastPaidBlock(), nTip - 1);
+    BOOST_CHECK_EQUAL(mapDynodes[dnB.outpoint].GetLastPaidBlock(), nTip - 3);
+    BOOST_CHECK(dnodeman.CheckIndexes());
+
+    // a later payment moves the entry again, an older one is ignored
+    PayDynode(GetScriptForDestination(keyB.GetPubKey().GetID()), nTip);
+    PayDynode(GetScriptForDestination(keyA.GetPubKey().GetID()), nTip - 2);
+    dnodeman.UpdateLastPaid(pindexTip);
+    mapDynodes = dnodeman.GetFullDynodeMap();
+    BOOST_CHECK_EQUAL(mapDynodes[dnA.outpoint].GetLastPaidBlock(), nTip - 1);
+    BOOST_CHECK_EQUAL(mapDynodes[dnB.outpoint].GetLastPaidBlock(), nTip);
+    BOOST_CHECK(dnodeman.CheckIndexes());
+}
+
+BOOST_FIXTURE_TEST_CASE(dynode_payments_window_test, DynodeChainSetup)
+{
+    SyncPast(DYNODE_SYNC_LIST);
+    CKey keyA, keyB;
+    keyA.MakeNewKey(true);
+    keyB.MakeNewKey(true);
+    CScript payeeA = GetScriptForDestination(keyA.GetPubKey().GetID());
+    CScript payeeB = GetScriptForDestination(keyB.GetPubKey().GetID());
+
+    // a tip far enough ahead for the storage window to start at block 95 of the test chain
+    CBlockIndex indexTip;
+    indexTip.nHeight = 95 + dnpayments.GetStorageLimit();
+    dnpayments.UpdatedBlockTip(&indexTip, *connman);
+
+    std::vector<CDynodePaymentVote> vecVotesOld = AddPaymentVotes(payeeA, 94, 1);
+    std::vector<CDynodePaymentVote> vecVotesLow = AddPaymentVotes(payeeA, 96, 1);
+    std::vector<CDynodePaymentVote> vecVotesWinner = AddPaymentVotes(payeeB, 97, DNPAYMENTS_SIGNATURES_REQUIRED);
+    BOOST_CHECK_EQUAL(dnpayments.GetBlockCount(), 3);
+    BOOST_CHECK_EQUAL(dnpayments.GetVoteCount(), 2 + DNPAYMENTS_SIGNATURES_REQUIRED);
+
+    // a Dynode votes once per height
+    BOOST_CHECK(dnpayments.UpdateLastVote(vecVotesOld[0]));
+    BOOST_CHECK(!dnpayments.UpdateLastVote(vecVotesOld[0]));
+    BOOST_CHECK(dnpayments.UpdateLastVote(vecVotesLow[0]));
+    int nLastVote = 0;
+    BOOST_CHECK(dnpayments.GetLastVote(vecVotesOld[0].dynodeOutpoint, nLastVote));
+    BOOST_CHECK_EQUAL(nLastVote, 94);
+
+    // the unknown heights of the chain in the window and the one with too few votes are asked for,
+    // neither the clear winner nor the height below the window
+    std::vector<CInv> vToFetch;
+    dnpayments.GetLowDataPaymentBlocks(vToFetch);
+    std::set<uint256> setToFetch, setExpected;
+    for (const auto& inv : vToFetch)
+        setToFetch.insert(inv.hash);
+    {
+        LOCK(cs_main);
+        for (int nHeight : {96, 98, 99, 100})
+            setExpected.insert(chainActive[nHeight]->GetBlockHash());
+    }
+    BOOST_CHECK(setToFetch == setExpected);
+    BOOST_CHECK_EQUAL(vToFetch.size(), setExpected.size());
+
+    // the height below the window goes with its votes and the Dynode which voted only there
+    dnpayments.CheckAndRemove();
+    CScript payeeRet;
+    BOOST_CHECK(!dnpayments.GetBlockPayee(94, payeeRet));
+    BOOST_CHECK(!dnpayments.HasPaymentVote(vecVotesOld[0].GetHash()));
+    BOOST_CHECK(!dnpayments.GetLastVote(vecVotesOld[0].dynodeOutpoint, nLastVote));
+    BOOST_CHECK(dnpayments.UpdateLastVote(vecVotesOld[0]));
+    BOOST_CHECK(dnpayments.HasVerifiedPaymentVote(vecVotesLow[0].GetHash()));
+    BOOST_CHECK(dnpayments.GetLastVote(vecVotesLow[0].dynodeOutpoint, nLastVote));
+    BOOST_CHECK(dnpayments.GetBlockPayee(97, payeeRet));
+    BOOST_CHECK(payeeRet == payeeB);
+    BOOST_CHECK_EQUAL(dnpayments.GetBlockCount(), 2);
+    BOOST_CHECK_EQUAL(dnpayments.GetVoteCount(), 1 + DNPAYMENTS_SIGNATURES_REQUIRED);
+
+    // the window moves on with the tip
+    indexTip.nHeight = 97 + dnpayments.GetStorageLimit();
+    dnpayments.UpdatedBlockTip(&indexTip, *connman);
+    dnpayments.CheckAndRemove();
+    BOOST_CHECK(!dnpayments.HasPaymentVote(vecVotesLow[0].GetHash()));
+    BOOST_CHECK(!dnpayments.GetLastVote(vecVotesLow[0].dynodeOutpoint, nLastVote));
+    BOOST_CHECK_EQUAL(dnpayments.GetBlockCount(), 1);
+    BOOST_CHECK_EQUAL(dnpayments.GetVoteCount(), DNPAYMENTS_SIGNATURES_REQUIRED);
+
+    // the slot of a height is taken over by a newer height and
+    // a vote for an older height than the one holding its slot is dropped
+    std::vector<CDynodePaymentVote> vecVotesNew = AddPaymentVotes(payeeA, 97 + dnpayments.GetStorageLimit() + DNPAYMENTS_FUTURE_BLOCKS + 1, 1);
+    BOOST_CHECK(dnpayments.HasPaymentVote(vecVotesNew[0].GetHash()));
+    BOOST_CHECK(!dnpayments.HasPaymentVote(vecVotesWinner[0].GetHash()));
+    BOOST_CHECK(!dnpayments.GetBlockPayee(97, payeeRet));
+    AddPaymentVotes(payeeB, 97, 1);
+    BOOST_CHECK(!dnpayments.GetBlockPayee(97, payeeRet));
+    BOOST_CHECK_EQUAL(dnpayments.GetBlockCount(), 1);
+    BOOST_CHECK_EQUAL(dnpayments.GetVoteCount(), 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(dynode_payments_journal_replay_test, DynodeChainSetup)
+{
+    boost::filesystem::path pathJournal = GetDataDir() / "dnpayments.dat.log";
+    CFlatJournalDB<CDynodePayments> flatdb("dnpayments.dat", "magicDynodePaymentsCache");
+    CKey keyA, keyB;
+    keyA.MakeNewKey(true);
+    keyB.MakeNewKey(true);
+    CScript payeeA = GetScriptForDestination(keyA.GetPubKey().GetID());
+    CScript payeeB = GetScriptForDestination(keyB.GetPubKey().GetID());
+
+    std::vector<CDynodePaymentVote> vecVotes;
+    auto AddVote = [&vecVotes](const CScript& payee, int nHeight) {
+        CDynodePaymentVote vote(COutPoint(GetRandHash(), 0), nHeight, payee);
+        vote.vchSig.assign(65, 1);
+        BOOST_CHECK(dnpayments.AddOrUpdatePaymentVote(vote));
+        vecVotes.push_back(vote);
+    };
+
+    // the first dump writes a snapshot, later ones append the votes added since
+    for (int i = 0; i < DNPAYMENTS_SIGNATURES_TOTAL; i++)
+        AddVote(payeeA, 110);
+    BOOST_CHECK(flatdb.Dump(dnpayments));
+    BOOST_CHECK(!boost::filesystem::exists(pathJournal));
+    AddVote(payeeB, 110);
+    AddVote(payeeB, 111);
+    BOOST_CHECK(flatdb.Dump(dnpayments));
+    AddVote(payeeB, 110);
+    BOOST_CHECK(flatdb.Dump(dnpayments));
+    BOOST_CHECK(boost::filesystem::exists(pathJournal));
+
+    // replaying the journal on top of the snapshot counts every vote once, like AddOrUpdatePaymentVote did
+    std::string strPayments110 = dnpayments.GetRequiredPaymentsString(110);
+    std::string strPayments111 = dnpayments.GetRequiredPaymentsString(111);
+    dnpayments.Clear();
+    BOOST_CHECK(flatdb.Load(dnpayments));
+    BOOST_CHECK_EQUAL(dnpayments.GetVoteCount(), (int)vecVotes.size());
+    BOOST_CHECK_EQUAL(dnpayments.GetBlockCount(), 2);
+    for (const auto& vote : vecVotes)
+        BOOST_CHECK(dnpayments.HasVerifiedPaymentVote(vote.GetHash()));
+    BOOST_CHECK_EQUAL(dnpayments.GetRequiredPaymentsString(110), strPayments110);
+    BOOST_CHECK_EQUAL(dnpayments.GetRequiredPaymentsString(111), strPayments111);
+    CScript payeeRet;
+    BOOST_CHECK(dnpayments.GetBlockPayee(110, payeeRet));
+    BOOST_CHECK(payeeRet == payeeA);
+
+    // nothing was left to write after the load, a vote added later is found after the next one
+    AddVote(payeeB, 111);
+    BOOST_CHECK(flatdb.Dump(dnpayments));
+    dnpayments.Clear();
+    BOOST_CHECK(flatdb.Load(dnpayments));
+    BOOST_CHECK_EQUAL(dnpayments.GetVoteCount(), (int)vecVotes.size());
+    BOOST_CHECK(dnpayments.HasVerifiedPaymentVote(vecVotes.back().GetHash()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
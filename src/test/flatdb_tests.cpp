@@ -0,0 +1,145 @@
+// Copyright (c) 2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "flat-database.h"
+
+#include "test/test_dynamic.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(flatdb_tests, TestingSetup)
+
+/** Minimal journaled cache: a map whose changed keys are tracked until written */
+class CFlatTestCache
+{
+public:
+    std::map<int, int> mapValues;
+    std::set<int> setDirty;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(mapValues);
+    }
+
+    template <typename Stream>
+    void SerializeJournal(Stream& s)
+    {
+        std::map<int, int> mapChanged;
+        for (int nKey : setDirty)
+            mapChanged[nKey] = mapValues.at(nKey);
+        s << mapChanged;
+        setDirty.clear();
+    }
+
+    template <typename Stream>
+    void UnserializeJournal(Stream& s)
+    {
+        std::map<int, int> mapChanged;
+        s >> mapChanged;
+        for (const auto& pair : mapChanged)
+            mapValues[pair.first] = pair.second;
+    }
+
+    void Set(int nKey, int nValue)
+    {
+        mapValues[nKey] = nValue;
+        setDirty.insert(nKey);
+    }
+
+    void ClearJournal() { setDirty.clear(); }
+    void Clear()
+    {
+        mapValues.clear();
+        setDirty.clear();
+    }
+    void CheckAndRemove() {}
+    std::string ToString() const { return strprintf("Values: %d", (int)mapValues.size()); }
+};
+
+static CFlatTestCache LoadTestCache()
+{
+    CFlatTestCache cache;
+    CFlatJournalDB<CFlatTestCache> flatdb("flattest.dat", "magicFlatTestCache");
+    BOOST_CHECK(flatdb.Load(cache));
+    BOOST_CHECK(cache.setDirty.empty());
+    return cache;
+}
+
+BOOST_AUTO_TEST_CASE(flatdb_journal)
+{
+    boost::filesystem::path pathDB = GetDataDir() / "flattest.dat";
+    boost::filesystem::path pathJournal = GetDataDir() / "flattest.dat.log";
+    CFlatJournalDB<CFlatTestCache> flatdb("flattest.dat", "magicFlatTestCache");
+
+    // the first dump writes a snapshot
+    CFlatTestCache cache;
+    for (int i = 0; i < 100; i++)
+        cache.Set(i, i);
+    BOOST_CHECK(flatdb.Dump(cache));
+    BOOST_CHECK(cache.setDirty.empty());
+    BOOST_CHECK(boost::filesystem::exists(pathDB));
+    BOOST_CHECK(!boost::filesystem::exists(pathJournal));
+    BOOST_CHECK(LoadTestCache().mapValues == cache.mapValues);
+
+    // later dumps only append what changed
+    uint64_t nSnapshotSize = boost::filesystem::file_size(pathDB);
+    cache.Set(5, 50);
+    cache.Set(200, 2);
+    BOOST_CHECK(flatdb.Dump(cache));
+    cache.Set(6, 60);
+    BOOST_CHECK(flatdb.Dump(cache));
+    BOOST_CHECK_EQUAL(boost::filesystem::file_size(pathDB), nSnapshotSize);
+    BOOST_CHECK(boost::filesystem::exists(pathJournal));
+    BOOST_CHECK(LoadTestCache().mapValues == cache.mapValues);
+
+    // a torn entry at the end of the journal is ignored
+    {
+        FILE* file = fopen(pathJournal.string().c_str(), "ab");
+        CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
+        fileout << (uint32_t)1000;
+        fileout << std::string("partial");
+    }
+    BOOST_CHECK(LoadTestCache().mapValues == cache.mapValues);
+    // ... and cut off, so entries appended afterwards are found
+    cache.Set(9, 90);
+    BOOST_CHECK(flatdb.Dump(cache));
+    BOOST_CHECK(LoadTestCache().mapValues == cache.mapValues);
+
+    // the snapshot is rewritten once the journal has grown as large as it
+    int i = 1000;
+    while (boost::filesystem::exists(pathJournal) && i < 2000) {
+        cache.Set(i, i);
+        BOOST_CHECK(flatdb.Dump(cache));
+        i++;
+    }
+    BOOST_CHECK(!boost::filesystem::exists(pathJournal));
+    BOOST_CHECK(boost::filesystem::file_size(pathDB) > nSnapshotSize);
+    BOOST_CHECK(LoadTestCache().mapValues == cache.mapValues);
+
+    // journal entries written on top of an older snapshot are not applied
+    cache.Set(7, 70);
+    BOOST_CHECK(flatdb.Dump(cache));
+    boost::filesystem::copy_file(pathJournal, GetDataDir() / "flattest.old");
+    boost::filesystem::remove(pathDB);
+    cache.Set(7, 71);
+    BOOST_CHECK(flatdb.Dump(cache));
+    boost::filesystem::rename(GetDataDir() / "flattest.old", pathJournal);
+    CFlatTestCache cacheLoaded = LoadTestCache();
+    BOOST_CHECK(cacheLoaded.mapValues == cache.mapValues);
+
+    // a snapshot which was not loaded or written through the journal is replaced, not appended to
+    CFlatTestCache cacheOther;
+    cacheOther.Set(1, 2);
+    CFlatDB<CFlatTestCache> flatdbPlain("flattest.dat", "magicFlatTestCache");
+    BOOST_CHECK(flatdbPlain.Dump(cacheOther));
+    cache.Set(8, 80);
+    BOOST_CHECK(flatdb.Dump(cache));
+    BOOST_CHECK(!boost::filesystem::exists(pathJournal));
+    BOOST_CHECK(LoadTestCache().mapValues == cache.mapValues);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
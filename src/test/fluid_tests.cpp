@@ -0,0 +1,404 @@
+// Copyright (c) 2019-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "fluid/fluid.h"
+#include "fluid/fluiddb.h"
+#include "fluid/fluiddynode.h"
+#include "fluid/fluidindex.h"
+#include "fluid/fluidmint.h"
+#include "hash.h"
+#include "key.h"
+#include "primitives/block.h"
+#include "random.h"
+#include "util.h"
+#include "validation.h"
+
+#include "test/test_dynamic.h"
+#include "utilstrencodings.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(fluid_tests, BasicTestingSetup)
+
+static std::vector<unsigned char> ScriptKey(const std::string& strScript)
+{
+    return std::vector<unsigned char>(strScript.begin(), strScript.end());
+}
+
+BOOST_AUTO_TEST_CASE(fluid_reward_schedule_test)
+{
+    CFluidRewardSchedule schedule;
+    CAmount nReward = 0;
+    BOOST_CHECK(!schedule.GetReward(100, nReward));
+
+    schedule.Add(ScriptKey("reward a"), 10, 5 * COIN, false);
+    schedule.Add(ScriptKey("reward b"), 20, 7 * COIN, false);
+    BOOST_CHECK_EQUAL(schedule.Size(), 2U);
+
+    // a record applies from two blocks above the block that set it
+    BOOST_CHECK(!schedule.GetReward(11, nReward));
+    BOOST_CHECK(schedule.GetReward(12, nReward));
+    BOOST_CHECK_EQUAL(nReward, 5 * COIN);
+    BOOST_CHECK(schedule.GetReward(21, nReward));
+    BOOST_CHECK_EQUAL(nReward, 5 * COIN);
+    BOOST_CHECK(schedule.GetReward(22, nReward));
+    BOOST_CHECK_EQUAL(nReward, 7 * COIN);
+    BOOST_CHECK(schedule.GetReward(1000, nReward));
+    BOOST_CHECK_EQUAL(nReward, 7 * COIN);
+
+    // re-adding a script moves its record, as a database overwrite would
+    schedule.Add(ScriptKey("reward b"), 30, 7 * COIN, false);
+    BOOST_CHECK_EQUAL(schedule.Size(), 2U);
+    BOOST_CHECK(schedule.GetReward(31, nReward));
+    BOOST_CHECK_EQUAL(nReward, 5 * COIN);
+
+    // records at height zero never apply
+    schedule.Add(ScriptKey("reward c"), 0, 9 * COIN, false);
+    BOOST_CHECK(!schedule.GetReward(5, nReward));
+
+    // a record that failed to parse disables the schedule until it is overwritten
+    schedule.Add(ScriptKey("reward d"), 40, -1, true);
+    BOOST_CHECK(!schedule.GetReward(1000, nReward));
+    schedule.Add(ScriptKey("reward d"), 40, 3 * COIN, false);
+    BOOST_CHECK(schedule.GetReward(1000, nReward));
+    BOOST_CHECK_EQUAL(nReward, 3 * COIN);
+
+    schedule.Clear();
+    BOOST_CHECK_EQUAL(schedule.Size(), 0U);
+    BOOST_CHECK(!schedule.GetReward(1000, nReward));
+}
+
+BOOST_AUTO_TEST_CASE(fluid_instruction_index_test)
+{
+    CFluidInstructionIndex index;
+    CFluidBlockInstructions instructions;
+    BOOST_CHECK(!index.GetBlockInstructions(10, instructions));
+
+    CFluidBlockInstructions minting;
+    minting.nBlockTime = 1000;
+    minting.vMintScripts.push_back(CScript() << OP_MINT);
+
+    index.ConnectBlock(10, CFluidBlockInstructions());
+    index.ConnectBlock(11, minting);
+    index.ConnectBlock(12, CFluidBlockInstructions());
+
+    // covered blocks without instructions are answered as empty
+    BOOST_CHECK(index.GetBlockInstructions(10, instructions));
+    BOOST_CHECK(instructions.IsEmpty());
+    BOOST_CHECK(!index.GetBlockInstructions(9, instructions));
+    BOOST_CHECK(!index.GetBlockInstructions(13, instructions));
+
+    BOOST_CHECK(index.GetBlockInstructions(11, instructions));
+    BOOST_CHECK_EQUAL(instructions.nBlockTime, 1000);
+    BOOST_CHECK_EQUAL(instructions.vMintScripts.size(), 1U);
+
+    // disconnecting drops the block and everything above it
+    index.DisconnectBlock(11);
+    BOOST_CHECK(!index.GetBlockInstructions(11, instructions));
+    BOOST_CHECK(!index.GetBlockInstructions(12, instructions));
+    BOOST_CHECK(index.GetBlockInstructions(10, instructions));
+    index.ConnectBlock(11, CFluidBlockInstructions());
+    BOOST_CHECK(index.GetBlockInstructions(11, instructions));
+    BOOST_CHECK(instructions.IsEmpty());
+
+    // a block that does not extend the covered range starts a new one
+    index.ConnectBlock(20, minting);
+    BOOST_CHECK(!index.GetBlockInstructions(10, instructions));
+    BOOST_CHECK(index.GetBlockInstructions(20, instructions));
+    BOOST_CHECK(!instructions.IsEmpty());
+
+    // disconnecting below a range empties it
+    index.DisconnectBlock(20);
+    BOOST_CHECK(!index.GetBlockInstructions(19, instructions));
+    BOOST_CHECK(!index.GetBlockInstructions(20, instructions));
+}
+
+BOOST_AUTO_TEST_CASE(fluid_block_instructions_test)
+{
+    std::vector<unsigned char> vchData(8, 0x42);
+    CMutableTransaction mtx;
+    mtx.vout.push_back(CTxOut(0, CScript() << OP_MINT << vchData));
+    mtx.vout.push_back(CTxOut(0, CScript() << OP_REWARD_MINING << vchData));
+    mtx.vout.push_back(CTxOut(0, CScript() << OP_REWARD_DYNODE << vchData));
+    mtx.vout.push_back(CTxOut(0, CScript() << OP_SWAP_SOVEREIGN_ADDRESS << vchData));
+    mtx.vout.push_back(CTxOut(0, CScript() << OP_BDAP_REVOKE << vchData));
+    mtx.vout.push_back(CTxOut(1 * COIN, CScript() << OP_TRUE));
+    mtx.vout.push_back(CTxOut(0, CScript()));
+    CMutableTransaction mtxMint;
+    mtxMint.vout.push_back(CTxOut(0, CScript() << OP_MINT << vchData << vchData));
+
+    CBlock block;
+    block.nTime = 1000;
+    block.vtx.push_back(MakeTransactionRef(mtx));
+    block.vtx.push_back(MakeTransactionRef(mtxMint));
+
+    // every kind of instruction is collected, in block order
+    CFluidBlockInstructions instructions;
+    instructions.SetBlock(block);
+    BOOST_CHECK_EQUAL(instructions.nBlockTime, 1000);
+    BOOST_REQUIRE_EQUAL(instructions.vMintScripts.size(), 2U);
+    BOOST_CHECK(instructions.vMintScripts[0] == mtx.vout[0].scriptPubKey);
+    BOOST_CHECK(instructions.vMintScripts[1] == mtxMint.vout[0].scriptPubKey);
+    BOOST_REQUIRE_EQUAL(instructions.vMiningScripts.size(), 1U);
+    BOOST_CHECK(instructions.vMiningScripts[0] == mtx.vout[1].scriptPubKey);
+    BOOST_REQUIRE_EQUAL(instructions.vDynodeScripts.size(), 1U);
+    BOOST_CHECK(instructions.vDynodeScripts[0] == mtx.vout[2].scriptPubKey);
+    BOOST_REQUIRE_EQUAL(instructions.vSovereignScripts.size(), 1U);
+    BOOST_CHECK(instructions.vSovereignScripts[0] == mtx.vout[3].scriptPubKey);
+    BOOST_REQUIRE_EQUAL(instructions.vBanScripts.size(), 1U);
+    BOOST_CHECK(instructions.vBanScripts[0] == mtx.vout[4].scriptPubKey);
+
+    // a block with only a non mint instruction is still kept by the index
+    CMutableTransaction mtxBan;
+    mtxBan.vout.push_back(mtx.vout[4]);
+    CBlock blockBan;
+    blockBan.vtx.push_back(MakeTransactionRef(mtxBan));
+    CFluidBlockInstructions instructionsBan;
+    instructionsBan.SetBlock(blockBan);
+    BOOST_CHECK(!instructionsBan.IsEmpty());
+    BOOST_CHECK(instructionsBan.vMintScripts.empty());
+
+    CFluidInstructionIndex index;
+    index.ConnectBlock(5, instructionsBan);
+    BOOST_CHECK(index.GetBlockInstructions(5, instructions));
+    BOOST_CHECK_EQUAL(instructions.vBanScripts.size(), 1U);
+
+    // reusing an instance for another block starts from scratch
+    instructions.SetBlock(blockBan);
+    BOOST_CHECK(instructions.vMintScripts.empty());
+    BOOST_CHECK_EQUAL(instructions.vBanScripts.size(), 1U);
+}
+
+static CFluidMint MakeMintRecord(const std::string& strScript, const unsigned int nHeight)
+{
+    CFluidMint fluidMint;
+    fluidMint.FluidScript = ScriptKey(strScript);
+    fluidMint.MintAmount = nHeight * COIN;
+    fluidMint.txHash = GetRandHash();
+    fluidMint.nHeight = nHeight;
+    return fluidMint;
+}
+
+// the highest record found by walking the whole database
+static unsigned int ScanLastMintHeight(CFluidMintDB& db)
+{
+    std::vector<CFluidMint> vMints;
+    BOOST_CHECK(db.GetAllFluidMintRecords(vMints));
+    unsigned int nHeight = 0;
+    for (const CFluidMint& fluidMint : vMints)
+        nHeight = std::max(nHeight, fluidMint.nHeight);
+    return nHeight;
+}
+
+BOOST_AUTO_TEST_CASE(fluid_mint_last_record_test)
+{
+    pFluidMintDB = new CFluidMintDB(1 << 20, true, true, false);
+    CFluidMint fluidMint;
+    BOOST_CHECK(!GetMintingInstructions(1, fluidMint));
+
+    CFluidMint mintA = MakeMintRecord("mint a", 10);
+    CFluidMint mintB = MakeMintRecord("mint b", 20);
+    BOOST_CHECK(pFluidMintDB->AddFluidMintEntry(mintA, OP_MINT));
+    BOOST_CHECK(pFluidMintDB->AddFluidMintEntry(mintB, OP_MINT));
+
+    // the kept last record matches a scan of the database
+    BOOST_CHECK(pFluidMintDB->GetLastFluidMintRecord(fluidMint));
+    BOOST_CHECK_EQUAL(fluidMint.nHeight, ScanLastMintHeight(*pFluidMintDB));
+    BOOST_CHECK(GetMintingInstructions(21, fluidMint));
+    BOOST_CHECK_EQUAL(fluidMint.MintAmount, 20 * COIN);
+
+    // a record above the queried height hides the record at it
+    BOOST_CHECK(!GetMintingInstructions(11, fluidMint));
+
+    // a record below the last one leaves it in place
+    BOOST_CHECK(pFluidMintDB->AddFluidMintEntry(MakeMintRecord("mint c", 15), OP_MINT));
+    BOOST_CHECK(pFluidMintDB->GetLastFluidMintRecord(fluidMint));
+    BOOST_CHECK_EQUAL(fluidMint.nHeight, 20U);
+    BOOST_CHECK_EQUAL(fluidMint.nHeight, ScanLastMintHeight(*pFluidMintDB));
+
+    // the last record written again higher up, then lower down than another record
+    mintB.nHeight = 25;
+    BOOST_CHECK(pFluidMintDB->AddFluidMintEntry(mintB, OP_MINT));
+    BOOST_CHECK(pFluidMintDB->GetLastFluidMintRecord(fluidMint));
+    BOOST_CHECK_EQUAL(fluidMint.nHeight, 25U);
+    BOOST_CHECK_EQUAL(fluidMint.nHeight, ScanLastMintHeight(*pFluidMintDB));
+    mintB.nHeight = 12;
+    BOOST_CHECK(pFluidMintDB->AddFluidMintEntry(mintB, OP_MINT));
+    BOOST_CHECK(pFluidMintDB->GetLastFluidMintRecord(fluidMint));
+    BOOST_CHECK_EQUAL(fluidMint.nHeight, 15U);
+    BOOST_CHECK_EQUAL(fluidMint.nHeight, ScanLastMintHeight(*pFluidMintDB));
+    BOOST_CHECK(GetMintingInstructions(16, fluidMint));
+    BOOST_CHECK(fluidMint.FluidScript == ScriptKey("mint c"));
+
+    delete pFluidMintDB;
+    pFluidMintDB = NULL;
+}
+
+BOOST_FIXTURE_TEST_CASE(fluid_reward_load_test, TestingSetup)
+{
+    boost::filesystem::create_directories(GetDataDir() / "blocks");
+    CFluidDynode fluidDynode;
+    fluidDynode.FluidScript = ScriptKey("reward a");
+    fluidDynode.DynodeReward = 5 * COIN;
+    fluidDynode.nHeight = 10;
+    fluidDynode.txHash = GetRandHash();
+
+    CFluidDynodeDB* pdb = new CFluidDynodeDB(1 << 20, false, true, false);
+    BOOST_CHECK(pdb->AddFluidDynodeEntry(fluidDynode, OP_REWARD_DYNODE));
+    delete pdb;
+
+    // the schedule is rebuilt from the records on disk
+    CAmount nReward = 0;
+    pdb = new CFluidDynodeDB(1 << 20, false, false, false);
+    BOOST_CHECK(pdb->GetLastFluidDynodeReward(nReward, 100));
+    BOOST_CHECK_EQUAL(nReward, 5 * COIN);
+
+    // a record that does not parse gives the standard reward after a restart, as the database scan did
+    BOOST_CHECK(pdb->Write(std::make_pair(std::string("script"), ScriptKey("reward b")), std::string("x")));
+    delete pdb;
+    pdb = new CFluidDynodeDB(1 << 20, false, false, false);
+    BOOST_CHECK(!pdb->GetLastFluidDynodeReward(nReward, 100));
+    delete pdb;
+}
+
+// the per sovereign recovery CheckIfQuorumExists did before the signers were cached
+static bool UncachedTokenQuorum(const std::string& consentToken, const std::vector<std::string>& fluidSovereigns, std::string& message, const bool individual, std::vector<CDynamicAddress>& vKeys)
+{
+    std::pair<CDynamicAddress, bool> keyOne, keyTwo, keyThree;
+    keyOne.second = false, keyTwo.second = false;
+    keyThree.second = false;
+
+    for (const std::string& address : fluidSovereigns) {
+        CDynamicAddress attemptKey, xAddress(address);
+
+        if (!xAddress.IsValid())
+            return false;
+
+        if (fluid.GenericVerifyInstruction(consentToken, attemptKey, message, 1) && xAddress == attemptKey)
+            keyOne = std::make_pair(attemptKey.ToString(), true);
+        if (fluid.GenericVerifyInstruction(consentToken, attemptKey, message, 2) && xAddress == attemptKey)
+            keyTwo = std::make_pair(attemptKey.ToString(), true);
+        if (fluid.GenericVerifyInstruction(consentToken, attemptKey, message, 3) && xAddress == attemptKey)
+            keyThree = std::make_pair(attemptKey.ToString(), true);
+    }
+    vKeys.clear();
+    vKeys.push_back(keyOne.first);
+    vKeys.push_back(keyTwo.first);
+    vKeys.push_back(keyThree.first);
+
+    bool fValid = (keyOne.first.ToString() != keyTwo.first.ToString() && keyTwo.first.ToString() != keyThree.first.ToString() && keyOne.first.ToString() != keyThree.first.ToString());
+
+    if (individual)
+        return (keyOne.second || keyTwo.second || keyThree.second);
+    else if (fValid)
+        return (keyOne.second && keyTwo.second && keyThree.second);
+
+    return false;
+}
+
+static std::string SignTokenDigest(const CKey& key, const std::string& strMessage)
+{
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << strMessageMagic;
+    ss << strMessage;
+    std::vector<unsigned char> vchSig;
+    BOOST_CHECK(key.SignCompact(ss.GetHash(), vchSig));
+    return EncodeBase64(&vchSig[0], vchSig.size());
+}
+
+static std::string MakeConsentToken(const std::string& strMessage, const std::vector<std::string>& vDigests)
+{
+    std::string strToken = strMessage;
+    for (const std::string& digest : vDigests)
+        strToken += PrimaryDelimiter + digest;
+    return "OP_MINT " + fluid.StringToHex(strToken);
+}
+
+// checks the cached quorum both on a miss and on a hit, and returns its answer
+static bool CheckQuorumMatchesUncached(const std::string& consentToken, const std::vector<std::string>& fluidSovereigns, const bool individual)
+{
+    std::string strExpected;
+    std::vector<CDynamicAddress> vExpected;
+    bool fExpected = UncachedTokenQuorum(consentToken, fluidSovereigns, strExpected, individual, vExpected);
+
+    for (int i = 0; i < 2; i++) {
+        std::string strMessage;
+        std::vector<CDynamicAddress> vKeys;
+        BOOST_CHECK_EQUAL(fluid.CheckTokenQuorum(consentToken, fluidSovereigns, strMessage, individual, vKeys), fExpected);
+        BOOST_CHECK_EQUAL(strMessage, strExpected);
+        BOOST_REQUIRE_EQUAL(vKeys.size(), vExpected.size());
+        for (unsigned int j = 0; j < vKeys.size(); j++)
+            BOOST_CHECK_EQUAL(vKeys[j].ToString(), vExpected[j].ToString());
+    }
+    return fExpected;
+}
+
+BOOST_AUTO_TEST_CASE(fluid_token_quorum_cache_test)
+{
+    std::vector<CKey> vKeys(4);
+    std::vector<std::string> vSovereigns;
+    for (unsigned int i = 0; i < vKeys.size(); i++) {
+        vKeys[i].MakeNewKey(true);
+        if (i < 3)
+            vSovereigns.push_back(CDynamicAddress(vKeys[i].GetPubKey().GetID()).ToString());
+    }
+
+    const std::string strMessage = fluid.StringToHex("1000$1600000000$DAddress");
+    const std::string strOther = fluid.StringToHex("2000$1600000000$DAddress");
+    std::string sigOne = SignTokenDigest(vKeys[0], strMessage);
+    std::string sigTwo = SignTokenDigest(vKeys[1], strMessage);
+    std::string sigThree = SignTokenDigest(vKeys[2], strMessage);
+    std::string sigOutsider = SignTokenDigest(vKeys[3], strMessage);
+
+    // all three sovereigns
+    std::string token = MakeConsentToken(strMessage, {sigOne, sigTwo, sigThree});
+    BOOST_CHECK(CheckQuorumMatchesUncached(token, vSovereigns, false));
+    BOOST_CHECK(CheckQuorumMatchesUncached(token, vSovereigns, true));
+
+    // digests past the third are never looked at
+    token = MakeConsentToken(strMessage, {sigThree, sigOne, sigTwo, sigOutsider});
+    BOOST_CHECK(CheckQuorumMatchesUncached(token, vSovereigns, false));
+
+    // a signer who is not a sovereign, or the same sovereign twice
+    token = MakeConsentToken(strMessage, {sigOne, sigOutsider, sigThree});
+    BOOST_CHECK(!CheckQuorumMatchesUncached(token, vSovereigns, false));
+    BOOST_CHECK(CheckQuorumMatchesUncached(token, vSovereigns, true));
+    token = MakeConsentToken(strMessage, {sigOne, sigOne, sigTwo});
+    BOOST_CHECK(!CheckQuorumMatchesUncached(token, vSovereigns, false));
+    BOOST_CHECK(CheckQuorumMatchesUncached(token, vSovereigns, true));
+
+    // a digest over another message recovers some other key
+    token = MakeConsentToken(strMessage, {sigOne, sigTwo, SignTokenDigest(vKeys[2], strOther)});
+    BOOST_CHECK(!CheckQuorumMatchesUncached(token, vSovereigns, false));
+
+    // too few digests
+    token = MakeConsentToken(strMessage, {sigOne, sigTwo});
+    BOOST_CHECK(!CheckQuorumMatchesUncached(token, vSovereigns, false));
+    BOOST_CHECK(CheckQuorumMatchesUncached(token, vSovereigns, true));
+    token = MakeConsentToken(strMessage, {});
+    BOOST_CHECK(!CheckQuorumMatchesUncached(token, vSovereigns, true));
+
+    // digests that are not base64, are empty or are not a compact signature
+    token = MakeConsentToken(strMessage, {"!!not base64!!", "", EncodeBase64("short")});
+    BOOST_CHECK(!CheckQuorumMatchesUncached(token, vSovereigns, true));
+
+    // a payload that is not hex, or is empty
+    BOOST_CHECK(!CheckQuorumMatchesUncached("OP_MINT zz@" + sigOne, vSovereigns, true));
+    BOOST_CHECK(!CheckQuorumMatchesUncached("OP_MINT ", vSovereigns, true));
+
+    // the same token checked against a sovereign set that lacks one of its signers
+    std::vector<std::string> vOtherSovereigns = vSovereigns;
+    vOtherSovereigns[2] = CDynamicAddress(vKeys[3].GetPubKey().GetID()).ToString();
+    token = MakeConsentToken(strMessage, {sigOne, sigTwo, sigThree});
+    BOOST_CHECK(!CheckQuorumMatchesUncached(token, vOtherSovereigns, false));
+    BOOST_CHECK(CheckQuorumMatchesUncached(token, vOtherSovereigns, true));
+
+    // a token without a payload throws on both paths
+    std::string strUnused;
+    std::vector<CDynamicAddress> vUnused;
+    BOOST_CHECK_THROW(UncachedTokenQuorum("OP_MINT", vSovereigns, strUnused, false, vUnused), std::out_of_range);
+    BOOST_CHECK_THROW(fluid.CheckTokenQuorum("OP_MINT", vSovereigns, strUnused, false, vUnused), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,312 @@
+// Copyright (c) 2016-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "base58.h"
+#include "clientversion.h"
+#include "dynode-sync.h"
+#include "dynode.h"
+#include "dynodeman.h"
+#include "governance-exceptions.h"
+#include "governance-object.h"
+#include "governance-vote.h"
+#include "governance-votedb.h"
+#include "governance.h"
+#include "key.h"
+#include "netbase.h"
+#include "random.h"
+#include "streams.h"
+#include "utilstrencodings.h"
+#include "utiltime.h"
+
+#include "test/test_dynamic.h"
+
+#include <boost/test/unit_test.hpp>
+
+struct GovernanceRegtestingSetup : public TestingSetup {
+    GovernanceRegtestingSetup() : TestingSetup(CBaseChainParams::REGTEST) {}
+    ~GovernanceRegtestingSetup()
+    {
+        SetMockTime(0);
+        governance.Clear();
+        dnodeman.Clear();
+    }
+};
+
+struct GovernanceChainSetup : public TestChain100Setup {
+    ~GovernanceChainSetup()
+    {
+        SetMockTime(0);
+        governance.Clear();
+        dnodeman.Clear();
+        dynodeSync.Reset();
+    }
+};
+
+// a proposal running for a month from nTime
+static CGovernanceObject MakeProposal(int64_t nTime)
+{
+    CKey keyPayee;
+    keyPayee.MakeNewKey(true);
+    std::string strData = strprintf("{\"end_epoch\": %d, \"name\": \"vote-test\", \"payment_address\": \"%s\", \"payment_amount\": 10, \"start_epoch\": %d, \"type\": %d, \"url\": \"http://duality.solutions/vote-test\"}",
+        nTime + 30 * 24 * 60 * 60, CDynamicAddress(keyPayee.GetPubKey().GetID()).ToString(), nTime, GOVERNANCE_OBJECT_PROPOSAL);
+    return CGovernanceObject(uint256(), 1, nTime, GetRandHash(), HexStr(strData));
+}
+
+// load an object the way governance.dat is loaded, its collateral is not checked there
+static void LoadGovernanceObject(const CGovernanceObject& govobj)
+{
+    // splice it into the journal entry of an empty manager
+    CGovernanceManager govmanEmpty;
+    CDataStream ssEmpty(SER_DISK, CLIENT_VERSION);
+    govmanEmpty.SerializeJournal(ssEmpty);
+    std::string strVersion;
+    std::vector<uint256> vecRemoved;
+    std::vector<CGovernanceObject> vecChanged;
+    ssEmpty >> strVersion >> vecRemoved >> vecChanged;
+    vecChanged.push_back(govobj);
+
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << strVersion << vecRemoved << vecChanged;
+    ss += ssEmpty;
+    governance.UnserializeJournal(ss);
+    governance.InitOnLoad();
+}
+
+static CGovernanceVote MakeVote(const COutPoint& outpoint, const uint256& nParentHash, vote_signal_enum_t eSignal, vote_outcome_enum_t eOutcome, int64_t nTime, const CKey& keyDynode)
+{
+    CGovernanceVote vote(outpoint, nParentHash, eSignal, eOutcome);
+    vote.SetTime(nTime);
+    BOOST_CHECK(vote.Sign(keyDynode, keyDynode.GetPubKey()));
+    return vote;
+}
+
+// the counts kept up to date as votes come and go must match a recount
+static void CheckFundingCounts(const CGovernanceObject* pgovobj, int nYes, int nNo)
+{
+    BOOST_CHECK(!pgovobj->IsSetVoteCountsDirty());
+    BOOST_CHECK(pgovobj->CheckVoteCounts());
+    BOOST_CHECK_EQUAL(pgovobj->GetYesCount(VOTE_SIGNAL_FUNDING), nYes);
+    BOOST_CHECK_EQUAL(pgovobj->GetNoCount(VOTE_SIGNAL_FUNDING), nNo);
+}
+
+BOOST_FIXTURE_TEST_SUITE(governance_votes_tests, GovernanceRegtestingSetup)
+
+BOOST_AUTO_TEST_CASE(governance_vote_file_remove_test)
+{
+    uint256 nParentHash = GetRandHash();
+    COutPoint outpointA(GetRandHash(), 0);
+    COutPoint outpointB(GetRandHash(), 0);
+    CGovernanceVote voteA(outpointA, nParentHash, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES);
+    CGovernanceVote voteA2(outpointA, nParentHash, VOTE_SIGNAL_VALID, VOTE_OUTCOME_NO);
+    CGovernanceVote voteB(outpointB, nParentHash, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_NO);
+
+    CGovernanceObjectVoteFile fileVotes;
+    fileVotes.AddVote(voteA);
+    fileVotes.AddVote(voteA2);
+    fileVotes.AddVote(voteB);
+    BOOST_CHECK_EQUAL(fileVotes.GetVoteCount(), 3);
+
+    // only the vote itself goes, the other votes of its dynode stay
+    BOOST_CHECK(fileVotes.RemoveVote(voteA.GetHash()));
+    BOOST_CHECK(!fileVotes.HasVote(voteA.GetHash()));
+    BOOST_CHECK(fileVotes.HasVote(voteA2.GetHash()));
+    BOOST_CHECK(fileVotes.HasVote(voteB.GetHash()));
+    BOOST_CHECK_EQUAL(fileVotes.GetVoteCount(), 2);
+
+    // a vote which is not in the file
+    BOOST_CHECK(!fileVotes.RemoveVote(voteA.GetHash()));
+    BOOST_CHECK_EQUAL(fileVotes.GetVoteCount(), 2);
+
+    std::vector<CGovernanceVote> vecVotes = fileVotes.GetVotes();
+    BOOST_CHECK_EQUAL(vecVotes.size(), 2U);
+    BOOST_CHECK(vecVotes[0] == voteA2);
+    BOOST_CHECK(vecVotes[1] == voteB);
+
+    // the count and index survive a round trip
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << fileVotes;
+    CGovernanceObjectVoteFile fileVotesLoaded;
+    ss >> fileVotesLoaded;
+    BOOST_CHECK_EQUAL(fileVotesLoaded.GetVoteCount(), 2);
+    BOOST_CHECK(!fileVotesLoaded.HasVote(voteA.GetHash()));
+    BOOST_CHECK(fileVotesLoaded.RemoveVote(voteB.GetHash()));
+    BOOST_CHECK_EQUAL(fileVotesLoaded.GetVoteCount(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(governance_verify_loaded_votes_test)
+{
+    int64_t nNow = GetTime();
+    SetMockTime(nNow);
+
+    CGovernanceObject govobjProposal = MakeProposal(nNow);
+    uint256 nHash = govobjProposal.GetHash();
+    LoadGovernanceObject(govobjProposal);
+    BOOST_CHECK(governance.HaveObjectForHash(nHash));
+
+    CKey keyCollateral, keyDynodeA, keyDynodeANew, keyDynodeB;
+    keyCollateral.MakeNewKey(true);
+    keyDynodeA.MakeNewKey(true);
+    keyDynodeANew.MakeNewKey(true);
+    keyDynodeB.MakeNewKey(true);
+    COutPoint outpointA(GetRandHash(), 0);
+    COutPoint outpointB(GetRandHash(), 0);
+    CService addrA = LookupNumeric("1.2.3.4", 12345);
+    CService addrB = LookupNumeric("1.2.3.5", 12345);
+    CDynode dnA(addrA, outpointA, keyCollateral.GetPubKey(), keyDynodeA.GetPubKey(), PROTOCOL_VERSION);
+    CDynode dnB(addrB, outpointB, keyCollateral.GetPubKey(), keyDynodeB.GetPubKey(), PROTOCOL_VERSION);
+    dnA.sigTime = nNow - DYNODE_MIN_DNB_SECONDS - 1;
+    dnB.sigTime = nNow - DYNODE_MIN_DNB_SECONDS - 1;
+    BOOST_CHECK(dnodeman.Add(dnA));
+    BOOST_CHECK(dnodeman.Add(dnB));
+
+    // dynode A votes before and after the broadcast below, changing its funding vote once
+    CGovernanceVote voteValidA = MakeVote(outpointA, nHash, VOTE_SIGNAL_VALID, VOTE_OUTCOME_YES, nNow - 10, keyDynodeA);
+    CGovernanceVote voteFundingA = MakeVote(outpointA, nHash, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES, nNow + 60, keyDynodeA);
+    CGovernanceVote voteFundingANew = MakeVote(outpointA, nHash, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_NO, nNow + 120, keyDynodeA);
+    CGovernanceVote voteFundingB = MakeVote(outpointB, nHash, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES, nNow + 60, keyDynodeB);
+    for (const CGovernanceVote& vote : {voteValidA, voteFundingA, voteFundingANew, voteFundingB}) {
+        CGovernanceException exception;
+        BOOST_CHECK_MESSAGE(governance.ProcessVoteAndRelay(vote, exception, *connman), exception.GetMessage());
+    }
+
+    CGovernanceObject* pgovobj = governance.FindGovernanceObject(nHash);
+    BOOST_REQUIRE(pgovobj);
+    BOOST_CHECK_EQUAL(pgovobj->GetYesCount(VOTE_SIGNAL_FUNDING), 1);
+    BOOST_CHECK_EQUAL(pgovobj->GetNoCount(VOTE_SIGNAL_FUNDING), 1);
+    BOOST_CHECK_EQUAL(pgovobj->GetYesCount(VOTE_SIGNAL_VALID), 1);
+
+    // dynode A is broadcasted again with a new key, its votes no longer verify
+    CDynodeBroadcast dnb(addrA, outpointA, keyCollateral.GetPubKey(), keyDynodeANew.GetPubKey(), PROTOCOL_VERSION);
+    BOOST_CHECK(dnb.Sign(keyCollateral));
+    int nDos = 0;
+    BOOST_CHECK(dnodeman.CheckDnbAndUpdateDynodeList(NULL, dnb, nDos, *connman));
+    dynode_info_t infoDn;
+    BOOST_CHECK(dnodeman.GetDynodeInfo(outpointA, infoDn));
+    BOOST_CHECK(infoDn.pubKeyDynode == keyDynodeANew.GetPubKey());
+    BOOST_CHECK_EQUAL(infoDn.sigTime, nNow);
+    BOOST_CHECK(!voteValidA.CheckSignature(infoDn.pubKeyDynode, true));
+
+    governance.VerifyLoadedVotes();
+    BOOST_CHECK_EQUAL(governance.GetLoadedVotesUnverified(), 0);
+
+    // the vote cast before the broadcast is skipped, the later ones of A are dropped
+    BOOST_CHECK(governance.HaveVoteForHash(voteValidA.GetHash()));
+    BOOST_CHECK(!governance.HaveVoteForHash(voteFundingA.GetHash()));
+    BOOST_CHECK(!governance.HaveVoteForHash(voteFundingANew.GetHash()));
+    BOOST_CHECK(governance.HaveVoteForHash(voteFundingB.GetHash()));
+    BOOST_CHECK_EQUAL(pgovobj->GetVoteFile().GetVotes().size(), 2U);
+
+    // removing the superseded vote leaves the current one, removing the current one drops it from the counts
+    BOOST_CHECK_EQUAL(pgovobj->GetYesCount(VOTE_SIGNAL_FUNDING), 1);
+    BOOST_CHECK_EQUAL(pgovobj->GetNoCount(VOTE_SIGNAL_FUNDING), 0);
+    BOOST_CHECK_EQUAL(pgovobj->GetYesCount(VOTE_SIGNAL_VALID), 1);
+    vote_rec_t voteRecord;
+    BOOST_CHECK(pgovobj->GetCurrentDNVotes(outpointA, voteRecord));
+    BOOST_CHECK_EQUAL(voteRecord.mapInstances.size(), 1U);
+    BOOST_CHECK(voteRecord.mapInstances.count(VOTE_SIGNAL_VALID));
+
+    // dropped votes are remembered as invalid
+    CGovernanceException exception;
+    BOOST_CHECK(!governance.ProcessVoteAndRelay(voteFundingANew, exception, *connman));
+    BOOST_CHECK_EQUAL(exception.GetType(), GOVERNANCE_EXCEPTION_PERMANENT_ERROR);
+}
+
+BOOST_FIXTURE_TEST_CASE(governance_vote_counts_test, GovernanceChainSetup)
+{
+    int64_t nNow = GetTime();
+    SetMockTime(nNow);
+
+    CGovernanceObject govobjProposal = MakeProposal(nNow);
+    uint256 nHash = govobjProposal.GetHash();
+    LoadGovernanceObject(govobjProposal);
+    CGovernanceObject* pgovobj = governance.FindGovernanceObject(nHash);
+    BOOST_REQUIRE(pgovobj);
+
+    // counts read from disk are recounted on their first use
+    BOOST_CHECK(pgovobj->IsSetVoteCountsDirty());
+    BOOST_CHECK(pgovobj->CheckVoteCounts());
+    BOOST_CHECK_EQUAL(pgovobj->GetYesCount(VOTE_SIGNAL_FUNDING), 0);
+    CheckFundingCounts(pgovobj, 0, 0);
+
+    // two dynodes with collateral and one whose collateral is gone
+    CKey keyCollateral, keyDynodeA, keyDynodeB, keyDynodeBNew, keyDynodeSpent;
+    keyCollateral.MakeNewKey(true);
+    keyDynodeA.MakeNewKey(true);
+    keyDynodeB.MakeNewKey(true);
+    keyDynodeBNew.MakeNewKey(true);
+    keyDynodeSpent.MakeNewKey(true);
+    COutPoint outpointA(coinbaseTxns[0].GetHash(), 0);
+    COutPoint outpointB(coinbaseTxns[1].GetHash(), 0);
+    COutPoint outpointSpent(GetRandHash(), 0);
+    CService addrB = LookupNumeric("1.2.3.5", 12345);
+    CDynode dnA(LookupNumeric("1.2.3.4", 12345), outpointA, keyCollateral.GetPubKey(), keyDynodeA.GetPubKey(), PROTOCOL_VERSION);
+    CDynode dnB(addrB, outpointB, keyCollateral.GetPubKey(), keyDynodeB.GetPubKey(), PROTOCOL_VERSION);
+    CDynode dnSpent(LookupNumeric("1.2.3.6", 12345), outpointSpent, keyCollateral.GetPubKey(), keyDynodeSpent.GetPubKey(), PROTOCOL_VERSION);
+    for (CDynode* pdn : {&dnA, &dnB, &dnSpent}) {
+        pdn->sigTime = nNow - DYNODE_MIN_DNB_SECONDS - 1;
+        BOOST_CHECK(dnodeman.Add(*pdn));
+    }
+
+    // ProcessVote: new votes, a changed vote and a vote failing its signature check,
+    // which leaves an empty vote instance behind
+    CGovernanceVote voteFundingA = MakeVote(outpointA, nHash, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES, nNow - 20, keyDynodeA);
+    CGovernanceVote voteFundingANew = MakeVote(outpointA, nHash, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_NO, nNow - 10, keyDynodeA);
+    CGovernanceVote voteValidA = MakeVote(outpointA, nHash, VOTE_SIGNAL_VALID, VOTE_OUTCOME_YES, nNow - 10, keyDynodeA);
+    CGovernanceVote voteFundingB = MakeVote(outpointB, nHash, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_NO, nNow + 60, keyDynodeB);
+    CGovernanceVote voteFundingSpent = MakeVote(outpointSpent, nHash, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES, nNow - 10, keyDynodeSpent);
+    CGovernanceException exception;
+    BOOST_CHECK(governance.ProcessVoteAndRelay(voteFundingA, exception, *connman));
+    CheckFundingCounts(pgovobj, 1, 0);
+    BOOST_CHECK(governance.ProcessVoteAndRelay(voteFundingANew, exception, *connman));
+    CheckFundingCounts(pgovobj, 0, 1);
+    BOOST_CHECK(governance.ProcessVoteAndRelay(voteValidA, exception, *connman));
+    BOOST_CHECK(governance.ProcessVoteAndRelay(voteFundingB, exception, *connman));
+    BOOST_CHECK(governance.ProcessVoteAndRelay(voteFundingSpent, exception, *connman));
+    CheckFundingCounts(pgovobj, 1, 2);
+    CGovernanceVote voteDeleteBBad = MakeVote(outpointB, nHash, VOTE_SIGNAL_DELETE, VOTE_OUTCOME_YES, nNow + 60, keyDynodeA);
+    BOOST_CHECK(!governance.ProcessVoteAndRelay(voteDeleteBBad, exception, *connman));
+    BOOST_CHECK(pgovobj->CheckVoteCounts());
+    BOOST_CHECK_EQUAL(pgovobj->GetYesCount(VOTE_SIGNAL_DELETE), 0);
+    BOOST_CHECK_EQUAL(pgovobj->CountMatchingVotes(VOTE_SIGNAL_DELETE, VOTE_OUTCOME_NONE), 1);
+    // an obsolete vote changes nothing
+    BOOST_CHECK(!governance.ProcessVoteAndRelay(MakeVote(outpointA, nHash, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_ABSTAIN, nNow - 30, keyDynodeA), exception, *connman));
+    CheckFundingCounts(pgovobj, 1, 2);
+    BOOST_CHECK_EQUAL(pgovobj->GetAbstainCount(VOTE_SIGNAL_FUNDING), 0);
+
+    // RemoveInvalidVote: B is broadcasted with a new key, so its funding vote is dropped
+    CDynodeBroadcast dnb(addrB, outpointB, keyCollateral.GetPubKey(), keyDynodeBNew.GetPubKey(), PROTOCOL_VERSION);
+    BOOST_CHECK(dnb.Sign(keyCollateral));
+    int nDos = 0;
+    BOOST_CHECK(dnodeman.CheckDnbAndUpdateDynodeList(NULL, dnb, nDos, *connman));
+    governance.VerifyLoadedVotes();
+    BOOST_CHECK(!governance.HaveVoteForHash(voteFundingB.GetHash()));
+    CheckFundingCounts(pgovobj, 1, 1);
+    BOOST_CHECK_EQUAL(pgovobj->CountMatchingVotes(VOTE_SIGNAL_DELETE, VOTE_OUTCOME_NONE), 1);
+
+    // ClearDynodeVotes: the dynode whose collateral is gone is removed along with its votes
+    while (dynodeSync.GetAssetID() <= DYNODE_SYNC_LIST)
+        dynodeSync.SwitchToNextAsset(*connman);
+    dnodeman.CheckAndRemove(*connman);
+    BOOST_CHECK(!dnodeman.Has(outpointSpent));
+    BOOST_CHECK(dnodeman.Has(outpointA));
+    BOOST_CHECK(dnodeman.Has(outpointB));
+    governance.UpdateCachesAndClean();
+    BOOST_CHECK(!governance.HaveVoteForHash(voteFundingSpent.GetHash()));
+    CheckFundingCounts(pgovobj, 0, 1);
+    BOOST_CHECK_EQUAL(pgovobj->GetYesCount(VOTE_SIGNAL_VALID), 1);
+
+    // deserialize: the loaded counts are recounted on their first use and match the ones written
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << *pgovobj;
+    CGovernanceObject govobjLoaded;
+    ss >> govobjLoaded;
+    BOOST_CHECK(govobjLoaded.IsSetVoteCountsDirty());
+    BOOST_CHECK(govobjLoaded.CheckVoteCounts());
+    BOOST_CHECK_EQUAL(govobjLoaded.GetYesCount(VOTE_SIGNAL_FUNDING), 0);
+    CheckFundingCounts(&govobjLoaded, 0, 1);
+    BOOST_CHECK_EQUAL(govobjLoaded.GetYesCount(VOTE_SIGNAL_VALID), 1);
+    BOOST_CHECK_EQUAL(govobjLoaded.CountMatchingVotes(VOTE_SIGNAL_DELETE, VOTE_OUTCOME_NONE), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
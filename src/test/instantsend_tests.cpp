@@ -0,0 +1,269 @@
+// Copyright (c) 2016-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainparams.h"
+#include "clientversion.h"
+#include "dynode-sync.h"
+#include "dynode.h"
+#include "dynodeman.h"
+#include "instantsend.h"
+#include "key.h"
+#include "net.h"
+#include "netbase.h"
+#include "protocol.h"
+#include "random.h"
+#include "streams.h"
+#include "utiltime.h"
+#include "validation.h"
+
+#include "test/test_dynamic.h"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+struct InstantSendChainSetup : public TestChain100Setup {
+    ~InstantSendChainSetup()
+    {
+        instantsend.Clear();
+        dnodeman.Clear();
+        dynodeSync.Reset();
+    }
+};
+
+// a lock request spending the first output of txPrev
+static CTxLockRequest MakeLockRequest(const CTransaction& txPrev, CAmount nFee = CENT)
+{
+    BOOST_REQUIRE(txPrev.vout[0].nValue > nFee);
+    CMutableTransaction mtx;
+    mtx.vin.push_back(CTxIn(COutPoint(txPrev.GetHash(), 0)));
+    mtx.vout.push_back(CTxOut(txPrev.vout[0].nValue - nFee, txPrev.vout[0].scriptPubKey));
+    return CTxLockRequest(mtx);
+}
+
+static CTxLockVote MakeLockVote(const uint256& txHash, const COutPoint& outpoint, const COutPoint& outpointDynode, const CKey& keyDynode)
+{
+    CTxLockVote vote(txHash, outpoint, outpointDynode);
+    BOOST_CHECK(vote.Sign(keyDynode, keyDynode.GetPubKey()));
+    return vote;
+}
+
+// process the lock requests, then the votes through the queue thread's batch or one message at a time,
+// returns whether each request got locked and its signature count
+static std::vector<int> ApplyLockVotes(const std::vector<CTxLockRequest>& vecRequests, const std::vector<CTxLockVote>& vecVotes, bool fBatch, CConnman& connman)
+{
+    instantsend.Clear();
+    for (const auto& txLockRequest : vecRequests) {
+        BOOST_CHECK(instantsend.ProcessTxLockRequest(txLockRequest, connman));
+    }
+
+    if (fBatch) {
+        std::vector<std::pair<NodeId, CTxLockVote> > vecQueued;
+        for (const auto& vote : vecVotes) {
+            vecQueued.push_back(std::make_pair(NodeId(0), vote));
+        }
+        instantsend.ProcessTxLockVoteBatch(vecQueued, connman);
+    } else {
+        // the queue thread is not running, so each vote is processed before ProcessMessage returns
+        CAddress addr(LookupNumeric("10.0.0.1", 12345), NODE_NONE);
+        CNode dummyNode(0, NODE_NETWORK, 0, INVALID_SOCKET, addr, 0, 0, "", true);
+        dummyNode.SetSendVersion(PROTOCOL_VERSION);
+        dummyNode.nVersion = PROTOCOL_VERSION;
+        for (const auto& vote : vecVotes) {
+            CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+            ss << vote;
+            instantsend.ProcessMessage(&dummyNode, NetMsgType::TXLOCKVOTE, ss, connman);
+        }
+    }
+
+    std::vector<int> vecResults;
+    for (const auto& txLockRequest : vecRequests) {
+        vecResults.push_back(instantsend.IsLockedInstantSendTransaction(txLockRequest.GetHash()));
+        vecResults.push_back(instantsend.GetTransactionLockSignatures(txLockRequest.GetHash()));
+    }
+    return vecResults;
+}
+
+// read an InstantSend cache holding an empty lock candidate for txHash, as created
+// when enough votes for it arrived before its lock request
+static void LoadVotedLockCandidate(const uint256& txHash, const COutPoint& outpoint)
+{
+    CTxLockCandidate txLockCandidate;
+    txLockCandidate.AddOutPointLock(outpoint);
+    for (int i = 0; i < COutPointLock::SIGNATURES_REQUIRED; i++) {
+        BOOST_CHECK(txLockCandidate.AddVote(CTxLockVote(txHash, outpoint, COutPoint(GetRandHash(), 0))));
+    }
+
+    CDataStream ssEmpty(SER_DISK, CLIENT_VERSION);
+    ssEmpty << instantsend;
+    std::string strVersion;
+    ssEmpty >> strVersion;
+
+    std::map<uint256, CTxLockRequest> mapLockRequests;
+    std::map<uint256, CTxLockVote> mapTxLockVotes;
+    std::map<uint256, CTxLockCandidate> mapTxLockCandidates;
+    mapTxLockCandidates.emplace(txHash, txLockCandidate);
+    std::map<COutPoint, std::set<uint256> > mapVotedOutpoints;
+    mapVotedOutpoints[outpoint].insert(txHash);
+    std::map<COutPoint, uint256> mapLockedOutpoints;
+    std::map<COutPoint, int64_t> mapDynodeOrphanVotes;
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << strVersion << mapLockRequests << mapLockRequests << mapTxLockVotes << mapTxLockVotes << mapTxLockCandidates
+       << mapVotedOutpoints << mapLockedOutpoints << mapDynodeOrphanVotes << chainActive.Height();
+    ss >> instantsend;
+}
+
+BOOST_FIXTURE_TEST_SUITE(instantsend_tests, InstantSendChainSetup)
+
+BOOST_AUTO_TEST_CASE(instantsend_lock_index_test)
+{
+    CTxLockRequest txLockRequest = MakeLockRequest(coinbaseTxns[1]);
+    CTxLockRequest txLockRequestNew = MakeLockRequest(coinbaseTxns[2]);
+    uint256 txHash = txLockRequest.GetHash();
+    uint256 txHashNew = txLockRequestNew.GetHash();
+    COutPoint outpoint = txLockRequest.tx->vin[0].prevout;
+    COutPoint outpointNew = txLockRequestNew.tx->vin[0].prevout;
+    uint256 hashLocked;
+
+    // deserialize: a candidate without its lock request is not indexed yet
+    LoadVotedLockCandidate(txHash, outpoint);
+    BOOST_CHECK(instantsend.CheckLockIndex());
+    BOOST_CHECK(!instantsend.HasTxLockRequest(txHash));
+    BOOST_CHECK(!instantsend.GetLockedOutPointTxHash(outpoint, hashLocked));
+
+    // CreateTxLockCandidate fills in the request, and as the votes are there LockTransactionInputs locks it
+    BOOST_CHECK(instantsend.ProcessTxLockRequest(txLockRequest, *connman));
+    BOOST_CHECK(instantsend.CheckLockIndex());
+    BOOST_CHECK(instantsend.HasTxLockRequest(txHash));
+    BOOST_CHECK(instantsend.GetLockedOutPointTxHash(outpoint, hashLocked));
+    BOOST_CHECK(hashLocked == txHash);
+    BOOST_CHECK(instantsend.IsLockedInstantSendTransaction(txHash));
+
+    // CreateTxLockCandidate for a new request without votes
+    BOOST_CHECK(instantsend.ProcessTxLockRequest(txLockRequestNew, *connman));
+    BOOST_CHECK(instantsend.CheckLockIndex());
+    BOOST_CHECK(instantsend.HasTxLockRequest(txHashNew));
+    BOOST_CHECK(!instantsend.GetLockedOutPointTxHash(outpointNew, hashLocked));
+    BOOST_CHECK(!instantsend.IsLockedInstantSendTransaction(txHashNew));
+
+    // deserialize: the index is rebuilt from the loaded maps
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << instantsend;
+    instantsend.Clear();
+    BOOST_CHECK(!instantsend.HasTxLockRequest(txHash));
+    ss >> instantsend;
+    BOOST_CHECK(instantsend.CheckLockIndex());
+    BOOST_CHECK(instantsend.HasTxLockRequest(txHash));
+    BOOST_CHECK(instantsend.HasTxLockRequest(txHashNew));
+    BOOST_CHECK(instantsend.IsLockedInstantSendTransaction(txHash));
+
+    // CheckAndRemove: the lock expires nInstantSendKeepLock blocks after it was mined
+    while (dynodeSync.GetAssetID() <= DYNODE_SYNC_LIST)
+        dynodeSync.SwitchToNextAsset(*connman);
+    instantsend.SyncTransaction(*txLockRequest.tx, chainActive.Tip(), 0);
+    CBlockIndex indexExpired;
+    indexExpired.nHeight = chainActive.Height() + Params().GetConsensus().nInstantSendKeepLock + 1;
+    instantsend.UpdatedBlockTip(&indexExpired);
+    instantsend.CheckAndRemove();
+    BOOST_CHECK(instantsend.CheckLockIndex());
+    BOOST_CHECK(!instantsend.HasTxLockRequest(txHash));
+    BOOST_CHECK(!instantsend.GetLockedOutPointTxHash(outpoint, hashLocked));
+    BOOST_CHECK(!instantsend.IsLockedInstantSendTransaction(txHash));
+    BOOST_CHECK(instantsend.HasTxLockRequest(txHashNew));
+}
+
+BOOST_AUTO_TEST_CASE(instantsend_vote_batch_test)
+{
+    while (dynodeSync.GetAssetID() <= DYNODE_SYNC_LIST)
+        dynodeSync.SwitchToNextAsset(*connman);
+
+    // fewer dynodes than COutPointLock::SIGNATURES_TOTAL, so all of them are in the quorum
+    const int nDynodes = COutPointLock::SIGNATURES_REQUIRED + 1;
+    CKey keyCollateral;
+    keyCollateral.MakeNewKey(true);
+    std::vector<CKey> vecKeys(nDynodes);
+    std::vector<COutPoint> vecOutpoints;
+    for (int i = 0; i < nDynodes; i++) {
+        vecKeys[i].MakeNewKey(true);
+        vecOutpoints.push_back(COutPoint(GetRandHash(), 0));
+        CDynode dn(LookupNumeric(strprintf("1.2.3.%d", i + 1).c_str(), 12345), vecOutpoints[i], keyCollateral.GetPubKey(), vecKeys[i].GetPubKey(), PROTOCOL_VERSION);
+        BOOST_CHECK(dnodeman.Add(dn));
+    }
+
+    // two lock requests spending the same outpoint
+    CTxLockRequest txLockRequest = MakeLockRequest(coinbaseTxns[1]);
+    CTxLockRequest txLockRequestConflicting = MakeLockRequest(coinbaseTxns[1], 2 * CENT);
+    uint256 txHash = txLockRequest.GetHash();
+    uint256 txHashConflicting = txLockRequestConflicting.GetHash();
+    COutPoint outpoint = txLockRequest.tx->vin[0].prevout;
+    std::vector<CTxLockRequest> vecRequests = {txLockRequest, txLockRequestConflicting};
+
+    // votes with bad signatures are dropped by both paths, these also move the votes below across
+    // the slices the batch is applied in
+    std::vector<CTxLockVote> vecVotes;
+    CKey keyWrong;
+    keyWrong.MakeNewKey(true);
+    for (int i = 0; i < 45; i++) {
+        vecVotes.push_back(MakeLockVote(GetRandHash(), outpoint, vecOutpoints[i % nDynodes], keyWrong));
+    }
+    for (int i = 0; i < COutPointLock::SIGNATURES_REQUIRED - 1; i++) {
+        vecVotes.push_back(MakeLockVote(txHash, outpoint, vecOutpoints[i], vecKeys[i]));
+    }
+    CTxLockVote voteLast = MakeLockVote(txHash, outpoint, vecOutpoints[COutPointLock::SIGNATURES_REQUIRED - 1], vecKeys[COutPointLock::SIGNATURES_REQUIRED - 1]);
+    // the first dynode also votes for the conflicting request, which marks both as attacked
+    CTxLockVote voteConflicting = MakeLockVote(txHashConflicting, outpoint, vecOutpoints[0], vecKeys[0]);
+
+    // the lock completes if its last vote comes before the conflicting one
+    std::vector<CTxLockVote> vecVotesLockFirst(vecVotes);
+    vecVotesLockFirst.push_back(voteLast);
+    vecVotesLockFirst.push_back(voteConflicting);
+    std::vector<int> vecSerial = ApplyLockVotes(vecRequests, vecVotesLockFirst, false, *connman);
+    std::vector<int> vecBatch = ApplyLockVotes(vecRequests, vecVotesLockFirst, true, *connman);
+    BOOST_CHECK(vecSerial == vecBatch);
+    BOOST_CHECK(instantsend.IsLockedInstantSendTransaction(txHash));
+    BOOST_CHECK(!instantsend.IsLockedInstantSendTransaction(txHashConflicting));
+
+    // and does not if the conflicting vote comes first
+    std::vector<CTxLockVote> vecVotesConflictFirst(vecVotes);
+    vecVotesConflictFirst.push_back(voteConflicting);
+    vecVotesConflictFirst.push_back(voteLast);
+    vecSerial = ApplyLockVotes(vecRequests, vecVotesConflictFirst, false, *connman);
+    vecBatch = ApplyLockVotes(vecRequests, vecVotesConflictFirst, true, *connman);
+    BOOST_CHECK(vecSerial == vecBatch);
+    BOOST_CHECK(!instantsend.IsLockedInstantSendTransaction(txHash));
+    BOOST_CHECK(!instantsend.IsLockedInstantSendTransaction(txHashConflicting));
+}
+
+BOOST_AUTO_TEST_CASE(instantsend_vote_queue_push_test)
+{
+    const size_t nMaxSize = 2;
+    CTxLockVoteQueue queue(nMaxSize, 1);
+    CTxLockVote vote(GetRandHash(), COutPoint(GetRandHash(), 0), COutPoint(GetRandHash(), 0));
+
+    // no queue thread, the caller processes the vote itself
+    BOOST_CHECK(!queue.Push(0, vote));
+
+    size_t nPushed = 0;
+    boost::thread thread;
+    {
+        // the queue thread takes one vote and waits for cs_main to apply it, the rest stay queued
+        LOCK(cs_main);
+        thread = boost::thread(std::bind(&CTxLockVoteQueue::Thread, &queue));
+        for (int i = 0; i < 1000 && nPushed < nMaxSize + 1; i++) {
+            if (queue.Push(0, vote))
+                nPushed++;
+            else
+                MilliSleep(10);
+        }
+        BOOST_CHECK_EQUAL(nPushed, nMaxSize + 1);
+
+        // full, the caller processes the vote itself
+        BOOST_CHECK(!queue.Push(0, vote));
+    }
+
+    thread.interrupt();
+    thread.join();
+    BOOST_CHECK(!queue.Push(0, vote));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
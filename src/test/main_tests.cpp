@@ -4,6 +4,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "chainparams.h"
+#include "hash.h"
 #include "validation.h"
 #include "net.h"
 
@@ -30,4 +31,59 @@ BOOST_AUTO_TEST_CASE(test_combiner_all)
     Test.disconnect(&ReturnTrue);
     BOOST_CHECK(Test());
 }
+BOOST_FIXTURE_TEST_CASE(block_header_hashes, TestChain100Setup)
+{
+    std::vector<CBlockHeader> headers;
+    {
+        LOCK(cs_main);
+        for (int i = 1; i <= chainActive.Height(); i++)
+            headers.push_back(chainActive[i]->GetBlockHeader());
+    }
+    CBlockHeader unknown = headers.back();
+    unknown.nNonce++;
+    headers.push_back(unknown);
+
+    // known headers come from the block index, the unknown one is hashed
+    std::vector<uint256> vHashes;
+    GetBlockHeaderHashes(headers, vHashes);
+    BOOST_CHECK_EQUAL(vHashes.size(), headers.size());
+    for (unsigned int i = 0; i < headers.size(); i++)
+        BOOST_CHECK(vHashes[i] == hash_Argon2d(BEGIN(headers[i].nVersion), END(headers[i].nNonce), 1));
+
+    LOCK(cs_main);
+    BOOST_CHECK(LookupKnownHeader(headers[49]) == chainActive[50]);
+    BOOST_CHECK(LookupKnownHeader(unknown) == NULL);
+    BOOST_CHECK(GetBlockHeaderHash(headers[49]) == chainActive[50]->GetBlockHash());
+}
+
+BOOST_AUTO_TEST_CASE(block_header_hash_cache)
+{
+    CBlockHeader header;
+    header.nVersion = 1;
+    header.nTime = 1;
+    header.nBits = 0x207fffff;
+    uint64_t nStart = GetBlockHeaderHashCount();
+    uint256 hash = header.GetHash();
+    BOOST_CHECK(header.GetHash() == hash);
+    BOOST_CHECK_EQUAL(GetBlockHeaderHashCount() - nStart, 1U);
+
+    // copies reuse the hash
+    CBlock block(header);
+    BOOST_CHECK(block.GetHash() == hash);
+    BOOST_CHECK(block.GetBlockHeader().GetHash() == hash);
+    BOOST_CHECK_EQUAL(GetBlockHeaderHashCount() - nStart, 1U);
+
+    // changing any field means hashing again
+    block.nNonce++;
+    uint256 hashChanged = block.GetHash();
+    BOOST_CHECK(hashChanged != hash);
+    BOOST_CHECK(hashChanged == hash_Argon2d(BEGIN(block.nVersion), END(block.nNonce), 1));
+    BOOST_CHECK_EQUAL(GetBlockHeaderHashCount() - nStart, 2U);
+    block.nNonce--;
+    BOOST_CHECK(block.GetHash() == hash);
+    BOOST_CHECK_EQUAL(GetBlockHeaderHashCount() - nStart, 3U);
+    BOOST_CHECK(header.GetHash() == hash);
+    BOOST_CHECK_EQUAL(GetBlockHeaderHashCount() - nStart, 3U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
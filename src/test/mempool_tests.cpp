@@ -583,4 +583,33 @@ BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest)
     SetMockTime(0);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolFluidInstructionTest)
+{
+    TestMemPoolEntryHelper entry;
+    CTxMemPool pool(CFeeRate(0));
+
+    CMutableTransaction txFluid;
+    txFluid.vin.resize(1);
+    txFluid.vin[0].scriptSig = CScript() << OP_11;
+    txFluid.vout.resize(2);
+    txFluid.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    txFluid.vout[0].nValue = 10 * COIN;
+    txFluid.vout[1].scriptPubKey = CScript() << OP_MINT << ParseHex("abcdef");
+    txFluid.vout[1].nValue = 0;
+
+    // the same instruction under another opcode is a duplicate
+    CScript scriptSame = CScript() << OP_REWARD_MINING << ParseHex("abcdef");
+    CScript scriptOther = CScript() << OP_MINT << ParseHex("012345");
+    uint256 txid;
+    BOOST_CHECK(!pool.existsFluidInstruction(scriptSame, txid));
+
+    pool.addUnchecked(txFluid.GetHash(), entry.FromTx(txFluid));
+    BOOST_CHECK(pool.existsFluidInstruction(scriptSame, txid));
+    BOOST_CHECK(txid == txFluid.GetHash());
+    BOOST_CHECK(!pool.existsFluidInstruction(scriptOther, txid));
+
+    pool.removeRecursive(txFluid);
+    BOOST_CHECK(!pool.existsFluidInstruction(scriptSame, txid));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,60 @@
+// Copyright (c) 2016-2021 Duality Blockchain Solutions Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "netfulfilledman.h"
+
+#include "chainparams.h"
+#include "netbase.h"
+#include "utiltime.h"
+
+#include "test/test_dynamic.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(netfulfilledman_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(netfulfilledman_expiry_test)
+{
+    CNetFulfilledRequestManager fulfilledman;
+    CService addr = LookupNumeric("1.2.3.4", 12345);
+    const int64_t nExpire = Params().FulfilledRequestExpireTime();
+    // start of a wheel slot
+    const int64_t nStart = 1600000020;
+
+    SetMockTime(nStart);
+    fulfilledman.AddFulfilledRequest(addr, "request");
+    fulfilledman.CheckAndRemove();
+    BOOST_CHECK_EQUAL(fulfilledman.ToString(), "Fulfilled requests: 1");
+
+    // asked again later, the entry filed for the first expiry is stale
+    SetMockTime(nStart + 5 * 60);
+    fulfilledman.AddFulfilledRequest(addr, "request");
+    fulfilledman.CheckAndRemove();
+
+    SetMockTime(nStart + nExpire + 60);
+    fulfilledman.CheckAndRemove();
+    BOOST_CHECK(fulfilledman.HasFulfilledRequest(addr, "request"));
+    BOOST_CHECK_EQUAL(fulfilledman.ToString(), "Fulfilled requests: 1");
+
+    SetMockTime(nStart + 5 * 60 + nExpire + 60);
+    fulfilledman.CheckAndRemove();
+    BOOST_CHECK(!fulfilledman.HasFulfilledRequest(addr, "request"));
+    BOOST_CHECK_EQUAL(fulfilledman.ToString(), "Fulfilled requests: 0");
+
+    // kept through every tick before the one it expires in
+    SetMockTime(nStart + 2 * nExpire);
+    fulfilledman.AddFulfilledRequest(addr, "request");
+    for (int64_t nTime = nStart + 2 * nExpire; nTime < nStart + 3 * nExpire; nTime += 60) {
+        SetMockTime(nTime);
+        fulfilledman.CheckAndRemove();
+        BOOST_CHECK_EQUAL(fulfilledman.ToString(), "Fulfilled requests: 1");
+    }
+    SetMockTime(nStart + 3 * nExpire + 60);
+    fulfilledman.CheckAndRemove();
+    BOOST_CHECK_EQUAL(fulfilledman.ToString(), "Fulfilled requests: 0");
+
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
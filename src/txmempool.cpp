@@ -10,6 +10,7 @@
 #include "clientversion.h"
 #include "consensus/consensus.h"
 #include "consensus/validation.h"
+#include "fluid/fluid.h"
 #include "instantsend.h"
 #include "policy/fees.h"
 #include "policy/policy.h"
@@ -434,6 +435,45 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry& entry,
     vTxHashes.emplace_back(hash, newit);
     newit->vTxHashesIdx = vTxHashes.size() - 1;
 
+    addFluidInstructions(tx);
+
+    return true;
+}
+
+void CTxMemPool::addFluidInstructions(const CTransaction& tx)
+{
+    const uint256 txhash = tx.GetHash();
+    for (const CTxOut& txout : tx.vout) {
+        if (IsTransactionFluid(txout.scriptPubKey))
+            mapFluidInstructions[GetFluidInstructionHash(txout.scriptPubKey)].push_back(txhash);
+    }
+}
+
+void CTxMemPool::removeFluidInstructions(const CTransaction& tx)
+{
+    const uint256 txhash = tx.GetHash();
+    for (const CTxOut& txout : tx.vout) {
+        if (!IsTransactionFluid(txout.scriptPubKey))
+            continue;
+        mapFluidInstructionIndex::iterator it = mapFluidInstructions.find(GetFluidInstructionHash(txout.scriptPubKey));
+        if (it == mapFluidInstructions.end())
+            continue;
+        std::vector<uint256>::iterator itTx = std::find(it->second.begin(), it->second.end(), txhash);
+        if (itTx != it->second.end())
+            it->second.erase(itTx);
+        if (it->second.empty())
+            mapFluidInstructions.erase(it);
+    }
+}
+
+bool CTxMemPool::existsFluidInstruction(const CScript& fluidScript, uint256& txidRet) const
+{
+    LOCK(cs);
+    mapFluidInstructionIndex::const_iterator it = mapFluidInstructions.find(GetFluidInstructionHash(fluidScript));
+    if (it == mapFluidInstructions.end())
+        return false;
+
+    txidRet = it->second.front();
     return true;
 }
 
@@ -678,6 +718,7 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     const uint256 hash = it->GetTx().GetHash();
     BOOST_FOREACH (const CTxIn& txin, it->GetTx().vin)
         mapNextTx.erase(txin.prevout);
+    removeFluidInstructions(it->GetTx());
 
     if (vTxHashes.size() > 1) {
         vTxHashes[it->vTxHashesIdx] = std::move(vTxHashes.back());
@@ -850,6 +891,7 @@ void CTxMemPool::_clear()
     mapLinks.clear();
     mapTx.clear();
     mapNextTx.clear();
+    mapFluidInstructions.clear();
     totalTxSize = 0;
     cachedInnerUsage = 0;
     lastRollingFeeUpdate = GetTime();
@@ -1221,7 +1263,7 @@ size_t CTxMemPool::DynamicMemoryUsage() const
 {
     LOCK(cs);
     // Estimate the overhead of mapTx to be 15 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(mapLinks) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage;
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(mapLinks) + memusage::DynamicUsage(vTxHashes) + memusage::DynamicUsage(mapFluidInstructions) + cachedInnerUsage;
 }
 
 double CTxMemPool::UsedMemoryShare() const
@@ -1404,4 +1446,3 @@ bool CTxMemPool::TransactionWithinChainLimit(const uint256& txid, size_t chainLi
                                     it->GetCountWithDescendants() < chainLimit);
 }
 
-SaltedTxidHasher::SaltedTxidHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
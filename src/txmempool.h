@@ -21,6 +21,7 @@
 #include "indirectmap.h"
 #include "primitives/transaction.h"
 #include "random.h"
+#include "saltedhasher.h"
 #include "spentindex.h"
 #include "sync.h"
 
@@ -350,21 +351,6 @@ enum class MemPoolRemovalReason {
     REPLACED     //! Removed for replacement
 };
 
-class SaltedTxidHasher
-{
-private:
-    /** Salt */
-    const uint64_t k0, k1;
-
-public:
-    SaltedTxidHasher();
-
-    size_t operator()(const uint256& txid) const
-    {
-        return SipHashUint256(k0, k1, txid);
-    }
-};
-
 /**
  * CTxMemPool stores valid-according-to-the-current-best-chain transactions
  * that may be included in the next block.
@@ -531,9 +517,16 @@ private:
     typedef std::map<uint256, std::vector<CSpentIndexKey> > mapSpentIndexInserted;
     mapSpentIndexInserted mapSpentInserted;
 
+    // hash of a pending fluid instruction without its opcode -> transactions carrying it
+    typedef std::map<uint256, std::vector<uint256> > mapFluidInstructionIndex;
+    mapFluidInstructionIndex mapFluidInstructions;
+
     void UpdateParent(txiter entry, txiter parent, bool add);
     void UpdateChild(txiter entry, txiter child, bool add);
 
+    void addFluidInstructions(const CTransaction& tx);
+    void removeFluidInstructions(const CTransaction& tx);
+
     std::vector<indexed_transaction_set::const_iterator> GetSortedDepthAndScore() const;
 
 public:
@@ -677,6 +670,9 @@ public:
         return (it != mapTx.end() && outpoint.n < it->GetTx().vout.size());
     }
 
+    /** Returns true if a transaction carrying the same fluid instruction is in the mempool */
+    bool existsFluidInstruction(const CScript& fluidScript, uint256& txidRet) const;
+
     CTransactionRef get(const uint256& hash) const;
     TxMempoolInfo info(const uint256& hash) const;
     std::vector<TxMempoolInfo> infoAll() const;
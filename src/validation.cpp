@@ -31,6 +31,7 @@
 #include "fluid/fluid.h"
 #include "fluid/fluiddb.h"
 #include "fluid/fluiddynode.h"
+#include "fluid/fluidindex.h"
 #include "fluid/fluidmining.h"
 #include "fluid/fluidmint.h"
 #include "hash.h"
@@ -808,7 +809,7 @@ static bool IsCurrentForFeeEstimation()
 }
 
 // Check if BDAP entry is valid
-bool ValidateBDAPInputs(const CTransactionRef& tx, CValidationState& state, const CCoinsViewCache& inputs, const CBlock& block, bool fJustCheck, int nHeight, bool bSanity)
+bool ValidateBDAPInputs(const CTransactionRef& tx, CValidationState& state, const CBlock& block, bool fJustCheck, int nHeight, int nTipHeight, bool bSanity, CBDAPWriteBatch* pWrites)
 {
     if (!CheckDomainEntryDB())
         return true;
@@ -817,16 +818,17 @@ bool ValidateBDAPInputs(const CTransactionRef& tx, CValidationState& state, cons
     if (fJustCheck && (IsInitialBlockDownload() || RPCIsInWarmup(&statusRpc)))
         return true;
 
-    std::vector<std::vector<unsigned char> > vvchBDAPArgs;
-    int op1 = -1;
-    int op2 = -1;
     if (nHeight == 0) {
-        nHeight = chainActive.Height() + 1;
+        nHeight = nTipHeight + 1;
     }
     bool bValid = false;
     if (tx->nVersion == BDAP_TX_VERSION) {
-        CScript scriptOp;
-        if (GetBDAPOpScript(tx, scriptOp, vvchBDAPArgs, op1, op2)) {
+        // decoded once per transaction and shared between mempool acceptance and block connection
+        CBDAPTxOperationRef operation = GetBDAPTxOperation(tx);
+        if (operation->fOperation) {
+            const int& op1 = operation->op1;
+            const int& op2 = operation->op2;
+            const std::vector<std::vector<unsigned char> >& vvchBDAPArgs = operation->vvchArgs;
             std::string errorMessage;
             if (vvchBDAPArgs.size() > 6) {
                 errorMessage = "Too many BDAP parameters in operation transactions.";
@@ -837,9 +839,9 @@ bool ValidateBDAPInputs(const CTransactionRef& tx, CValidationState& state, cons
                 return state.DoS(100, false, REJECT_INVALID, errorMessage);
             }
 
-            std::string strOpType = GetBDAPOpTypeString(op1, op2);
+            const std::string& strOpType = operation->strOpType;
             if (strOpType == "bdap_new_account" || strOpType == "bdap_update_account" || strOpType == "bdap_delete_account") {
-                bValid = CheckDomainEntryTx(tx, scriptOp, op1, op2, vvchBDAPArgs, fJustCheck, nHeight, block.nTime, bSanity, errorMessage);
+                bValid = CheckDomainEntryTx(tx, *operation, fJustCheck, nHeight, nTipHeight, block.nTime, bSanity, errorMessage, pWrites);
                 if (!bValid) {
                     errorMessage = "ValidateBDAPInputs: " + errorMessage;
                     return state.DoS(100, false, REJECT_INVALID, errorMessage);
@@ -850,13 +852,14 @@ bool ValidateBDAPInputs(const CTransactionRef& tx, CValidationState& state, cons
             else if (strOpType == "bdap_new_link_request") {
                 std::vector<unsigned char> vchPubKey = vvchBDAPArgs[0];
                 LogPrint("bdap", "%s -- New Link Request vchPubKey = %s\n", __func__, stringFromVch(vchPubKey));
-                bValid = CheckLinkTx(tx, op1, op2, vvchBDAPArgs, fJustCheck, nHeight, block.nTime, bSanity, errorMessage);
+                bValid = CheckLinkTx(tx, *operation, fJustCheck, nHeight, nTipHeight, block.nTime, bSanity, errorMessage, pWrites);
                 if (!bValid) {
                     errorMessage = "ValidateBDAPInputs: CheckLinkTx failed: " + errorMessage;
                     return state.DoS(100, false, REJECT_INVALID, errorMessage);
                 }
+                // outside of fJustCheck the index was just pointed at tx, or will be once queued writes are applied
                 uint256 txid;
-                if (GetLinkIndex(vchPubKey, txid)) {
+                if (fJustCheck && GetLinkIndex(vchPubKey, txid)) {
                     if (txid != tx->GetHash()) {
                         errorMessage = "Link request public key already used.";
                         LogPrintf("%s -- %s\n", __func__, errorMessage);
@@ -868,13 +871,14 @@ bool ValidateBDAPInputs(const CTransactionRef& tx, CValidationState& state, cons
             else if (strOpType == "bdap_new_link_accept") {
                 std::vector<unsigned char> vchPubKey = vvchBDAPArgs[0];
                 LogPrint("bdap", "%s -- New Link Accept vchPubKey = %s\n", __func__, stringFromVch(vchPubKey));
-                bValid = CheckLinkTx(tx, op1, op2, vvchBDAPArgs, fJustCheck, nHeight, block.nTime, bSanity, errorMessage);
+                bValid = CheckLinkTx(tx, *operation, fJustCheck, nHeight, nTipHeight, block.nTime, bSanity, errorMessage, pWrites);
                 if (!bValid) {
                     errorMessage = "ValidateBDAPInputs: CheckLinkTx failed: " + errorMessage;
                     return state.DoS(100, false, REJECT_INVALID, errorMessage);
                 }
+                // outside of fJustCheck the index was just pointed at tx, or will be once queued writes are applied
                 uint256 txid;
-                if (GetLinkIndex(vchPubKey, txid)) {
+                if (fJustCheck && GetLinkIndex(vchPubKey, txid)) {
                     if (txid != tx->GetHash()) {
                         errorMessage = "Link accept public key already used.";
                         return state.DoS(100, false, REJECT_INVALID, errorMessage);
@@ -892,7 +896,7 @@ bool ValidateBDAPInputs(const CTransactionRef& tx, CValidationState& state, cons
                 return true;
             }
             else if (strOpType == "bdap_new_audit") {
-                bValid = CheckAuditTx(tx, scriptOp, op1, op2, vvchBDAPArgs, fJustCheck, nHeight, block.nTime, bSanity, errorMessage);
+                bValid = CheckAuditTx(tx, *operation, fJustCheck, nHeight, nTipHeight, block.nTime, bSanity, errorMessage);
                 if (!bValid) {
                     errorMessage = "ValidateBDAPInputs: " + errorMessage;
                     return state.DoS(100, false, REJECT_INVALID, errorMessage);
@@ -903,7 +907,7 @@ bool ValidateBDAPInputs(const CTransactionRef& tx, CValidationState& state, cons
                 return true;
             }
             else if (strOpType == "bdap_new_certificate" || strOpType == "bdap_approve_certificate") {
-                bValid = CheckCertificateTx(tx, scriptOp, op1, op2, vvchBDAPArgs, fJustCheck, nHeight, block.nTime, bSanity, errorMessage);
+                bValid = CheckCertificateTx(tx, *operation, fJustCheck, nHeight, nTipHeight, block.nTime, bSanity, errorMessage);
                 if (!bValid) {
                     errorMessage = "ValidateBDAPInputs: " + errorMessage;
                     return state.DoS(100, false, REJECT_INVALID, errorMessage);
@@ -1695,7 +1699,7 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const C
                 __func__, hash.ToString(), FormatStateMessage(state));
         }
 
-        if (tx.nVersion == BDAP_TX_VERSION && !ValidateBDAPInputs(ptx, state, view, CBlock(), true, chainActive.Height())) {
+        if (tx.nVersion == BDAP_TX_VERSION && !ValidateBDAPInputs(ptx, state, CBlock(), true, chainActive.Height(), chainActive.Height())) {
             return false;
         }
 
@@ -1854,7 +1858,7 @@ bool GetTransaction(const uint256& hash, CTransactionRef& txOut, const Consensus
             } catch (const std::exception& e) {
                 return error("%s: Deserialize or I/O error - %s", __func__, e.what());
             }
-            hashBlock = header.GetHash();
+            hashBlock = GetBlockHeaderHash(header);
             if (txOut->GetHash() != hash)
                 return error("%s: txid mismatch", __func__);
             return true;
@@ -1912,7 +1916,8 @@ bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHea
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams)
+/** Read a block from disk without checking its header */
+static bool ReadBlockDataFromDisk(CBlock& block, const CDiskBlockPos& pos)
 {
     block.SetNull();
 
@@ -1927,6 +1932,13 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus:
     } catch (const std::exception& e) {
         return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
     }
+    return true;
+}
+
+bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams)
+{
+    if (!ReadBlockDataFromDisk(block, pos))
+        return false;
 
     // Check the header
     if (!CheckProofOfWork(block.GetHash(), block.nBits, consensusParams))
@@ -1935,13 +1947,27 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus:
     return true;
 }
 
+/** Whether header carries the same fields as pindex, and so has its hash and already checked proof of work */
+static bool IsHeaderOfIndex(const CBlockHeader& header, const CBlockIndex* pindex)
+{
+    return header.nVersion == pindex->nVersion &&
+           header.hashPrevBlock == (pindex->pprev ? pindex->pprev->GetBlockHash() : uint256()) &&
+           header.hashMerkleRoot == pindex->hashMerkleRoot &&
+           header.nTime == pindex->nTime &&
+           header.nBits == pindex->nBits &&
+           header.nNonce == pindex->nNonce;
+}
+
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
 {
-    if (!ReadBlockFromDisk(block, pindex->GetBlockPos(), consensusParams))
+    if (!ReadBlockDataFromDisk(block, pindex->GetBlockPos()))
         return false;
-    if (block.GetHash() != pindex->GetBlockHash())
-        return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
+    // The proof of work of the index entry was checked when it was accepted, so a
+    // header matching the entry does not need to be hashed again
+    if (!IsHeaderOfIndex(block, pindex))
+        return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): header doesn't match index for %s at %s",
             pindex->ToString(), pindex->GetBlockPos().ToString());
+    block.CacheHash(pindex->GetBlockHash());
     return true;
 }
 
@@ -2099,6 +2125,13 @@ bool CScriptCheck::operator()()
     return true;
 }
 
+bool CBDAPCheck::operator()()
+{
+    if (!ValidateBDAPInputs(ptx, *pstate, *pblock, false, nHeight, nTipHeight, false, pWrites))
+        return error("CBDAPCheck(): ValidateBDAPInputs on %s failed with %s", ptx->GetHash().ToString(), FormatStateMessage(*pstate));
+    return true;
+}
+
 int GetSpendHeight(const CCoinsViewCache& inputs)
 {
     LOCK(cs_main);
@@ -2600,6 +2633,200 @@ void ThreadScriptCheck()
     scriptcheckqueue.Thread();
 }
 
+static CCheckQueue<CBDAPCheck> bdapcheckqueue(16);
+
+void ThreadBDAPCheck()
+{
+    RenameThread("dynamic-bdapch");
+    bdapcheckqueue.Thread();
+}
+
+static CCheckQueue<CHeaderHashCheck> headerhashcheckqueue(8);
+
+void ThreadHeaderHashCheck()
+{
+    RenameThread("dynamic-hdrhash");
+    headerhashcheckqueue.Thread();
+}
+
+bool CHeaderHashCheck::operator()()
+{
+    *phash = pheader->GetHash();
+    return true;
+}
+
+CBlockIndex* LookupKnownHeader(const CBlockHeader& header)
+{
+    AssertLockHeld(cs_main);
+    BlockMap::iterator mi = mapBlockIndex.find(header.hashPrevBlock);
+    if (mi == mapBlockIndex.end() || !mi->second)
+        return NULL;
+
+    // a header is only looked for among the children of its parent on the active
+    // and best header chains, which covers blocks downloaded after their headers
+    CBlockIndex* pindexPrev = mi->second;
+    CBlockIndex* pindex = chainActive[pindexPrev->nHeight + 1];
+    if (pindex && pindex->pprev == pindexPrev && IsHeaderOfIndex(header, pindex))
+        return pindex;
+    pindex = pindexBestHeader ? pindexBestHeader->GetAncestor(pindexPrev->nHeight + 1) : NULL;
+    if (pindex && pindex->pprev == pindexPrev && IsHeaderOfIndex(header, pindex))
+        return pindex;
+    return NULL;
+}
+
+uint256 GetBlockHeaderHash(const CBlockHeader& header)
+{
+    {
+        LOCK(cs_main);
+        const CBlockIndex* pindex = LookupKnownHeader(header);
+        if (pindex) {
+            header.CacheHash(pindex->GetBlockHash());
+            return pindex->GetBlockHash();
+        }
+    }
+    return header.GetHash();
+}
+
+void GetBlockHeaderHashes(const std::vector<CBlockHeader>& headers, std::vector<uint256>& vHashes)
+{
+    vHashes.assign(headers.size(), uint256());
+    std::vector<CHeaderHashCheck> vChecks;
+    {
+        LOCK(cs_main);
+        for (unsigned int i = 0; i < headers.size(); i++) {
+            const CBlockIndex* pindex = LookupKnownHeader(headers[i]);
+            if (pindex) {
+                vHashes[i] = pindex->GetBlockHash();
+                headers[i].CacheHash(vHashes[i]);
+            } else
+                vChecks.push_back(CHeaderHashCheck(headers[i], vHashes[i]));
+        }
+    }
+
+    // hash the remaining headers without holding cs_main
+    if (nScriptCheckThreads && vChecks.size() > 1) {
+        CCheckQueueControl<CHeaderHashCheck> control(&headerhashcheckqueue);
+        control.Add(vChecks);
+        control.Wait();
+    } else {
+        for (CHeaderHashCheck& check : vChecks)
+            check();
+    }
+}
+
+typedef std::pair<std::string, std::vector<unsigned char> > BDAPCheckKey;
+
+/**
+ * Get the database keys a BDAP operation reads and writes, for operations that can be
+ * validated on the BDAP check threads. Returns false for operations that must run in
+ * block order on the calling thread, e.g. because they look up earlier transactions
+ * under cs_main or read records other than their own.
+ */
+static bool GetBDAPCheckKeys(const CBDAPTxOperation& operation, std::vector<BDAPCheckKey>& vKeys)
+{
+    const vchCharString& vvchArgs = operation.vvchArgs;
+    if (operation.strOpType == "bdap_new_account" && vvchArgs.size() == 3) {
+        vKeys.push_back(std::make_pair(std::string("dc"), vvchArgs[0]));
+        vKeys.push_back(std::make_pair(std::string("pk"), vvchArgs[1]));
+        return true;
+    }
+    if ((operation.strOpType == "bdap_new_link_request" || operation.strOpType == "bdap_new_link_accept") && vvchArgs.size() >= 1 && vvchArgs.size() <= 3) {
+        vKeys.push_back(std::make_pair(std::string("pubkey"), vvchArgs[0]));
+        if (vvchArgs.size() > 1)
+            vKeys.push_back(std::make_pair(std::string("pubkey"), vvchArgs[1]));
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Validate the queued BDAP transactions on the check threads, then apply their database writes in block order.
+ * On failure state is set from the first failing transaction in block order, and the writes of the transactions
+ * before it are applied, as serial validation would have done.
+ */
+static bool FlushBDAPChecks(std::vector<CTransactionRef>& vQueued, const CBlock& block, CValidationState& state, int nHeight, int nTipHeight)
+{
+    if (vQueued.empty())
+        return true;
+
+    std::vector<CBDAPWriteBatch> vWrites(vQueued.size());
+    std::vector<CValidationState> vStates(vQueued.size());
+    bool fValid;
+    {
+        CCheckQueueControl<CBDAPCheck> control(&bdapcheckqueue);
+        std::vector<CBDAPCheck> vChecks;
+        vChecks.reserve(vQueued.size());
+        for (unsigned int i = 0; i < vQueued.size(); i++)
+            vChecks.push_back(CBDAPCheck(vQueued[i], block, nHeight, nTipHeight, vWrites[i], vStates[i]));
+        control.Add(vChecks);
+        fValid = control.Wait();
+    }
+    if (!fValid) {
+        // the check threads skip the remaining checks after a failure, so transactions before
+        // the first recorded failure may not have run; validate them here to find the earliest
+        // and write the ones before it
+        for (unsigned int i = 0; i < vQueued.size(); i++) {
+            if (!vStates[i].IsValid()) {
+                state = vStates[i];
+                return false;
+            }
+            CBDAPWriteBatch writes;
+            if (!ValidateBDAPInputs(vQueued[i], state, block, false, nHeight, nTipHeight, false, &writes))
+                return false;
+            if (!writes.Apply())
+                return state.Error("bdap-write-failed");
+        }
+        vQueued.clear();
+        return true;
+    }
+    for (CBDAPWriteBatch& writes : vWrites) {
+        if (!writes.Apply())
+            return state.Error("bdap-write-failed");
+    }
+    vQueued.clear();
+    return true;
+}
+
+/**
+ * Validate the BDAP transactions of a block being connected. Runs of operations that do not
+ * share a database key are validated concurrently against the state before the run, which
+ * gives the same result as validating them one by one; any other operation ends the run and
+ * is validated on this thread once all earlier writes are applied.
+ */
+bool ConnectBDAPInputs(const std::vector<CTransactionRef>& vBDAPTx, const CBlock& block, CValidationState& state, int nHeight)
+{
+    int nTipHeight;
+    {
+        LOCK(cs_main);
+        nTipHeight = chainActive.Height();
+    }
+    std::vector<CTransactionRef> vQueued;
+    std::set<BDAPCheckKey> setKeys;
+    for (const CTransactionRef& ptx : vBDAPTx) {
+        CBDAPTxOperationRef operation = GetBDAPTxOperation(ptx);
+        if (!operation->fOperation)
+            continue;
+
+        std::vector<BDAPCheckKey> vKeys;
+        bool fQueue = !ptx->IsCoinBase() && GetBDAPCheckKeys(*operation, vKeys);
+        for (const BDAPCheckKey& key : vKeys) {
+            if (fQueue && !setKeys.insert(key).second)
+                fQueue = false;
+        }
+        if (fQueue) {
+            vQueued.push_back(ptx);
+            continue;
+        }
+
+        if (!FlushBDAPChecks(vQueued, block, state, nHeight, nTipHeight))
+            return false;
+        setKeys.clear();
+        if (!ValidateBDAPInputs(ptx, state, block, false, nHeight, nTipHeight))
+            return false;
+    }
+    return FlushBDAPChecks(vQueued, block, state, nHeight, nTipHeight);
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -2783,6 +3010,9 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
     std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
+    // BDAP operations are validated after the loop on the BDAP check threads when connecting for real
+    bool fParallelBDAPChecks = !fJustCheck && nScriptCheckThreads;
+    std::vector<CTransactionRef> vBDAPTx;
 
     for (unsigned int i = 0; i < block.vtx.size(); i++) {
         const CTransaction& tx = *block.vtx[i];
@@ -2906,11 +3136,13 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
             }
         }
 
-        CCoinsViewCache viewCoinCache(pcoinsTip);
-        CTransactionRef ptx = MakeTransactionRef(tx);
-
-        if (tx.nVersion == BDAP_TX_VERSION && !ValidateBDAPInputs(ptx, state, viewCoinCache, block, fJustCheck, pindex->nHeight)) {
-            return error("ConnectBlock(): ValidateBDAPInputs on block %s failed\n", block.GetHash().ToString());
+        if (tx.nVersion == BDAP_TX_VERSION) {
+            if (fParallelBDAPChecks) {
+                vBDAPTx.push_back(block.vtx[i]);
+            } else {
+                if (!ValidateBDAPInputs(block.vtx[i], state, block, fJustCheck, pindex->nHeight, chainActive.Height()))
+                    return error("ConnectBlock(): ValidateBDAPInputs on block %s failed\n", block.GetHash().ToString());
+            }
         }
 
         CTxUndo undoDummy;
@@ -2922,6 +3154,8 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
         vPos.push_back(std::make_pair(tx.GetHash(), pos));
         pos.nTxOffset += ::GetSerializeSize(tx, SER_DISK, CLIENT_VERSION);
     }
+    if (!vBDAPTx.empty() && !ConnectBDAPInputs(vBDAPTx, block, state, pindex->nHeight))
+        return error("ConnectBlock(): ValidateBDAPInputs on block %s failed\n", block.GetHash().ToString());
     int64_t nTime3 = GetTimeMicros();
     nTimeConnect += nTime3 - nTime2;
     LogPrint("bench", "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs]\n", (unsigned)block.vtx.size(), 0.001 * (nTime3 - nTime2), 0.001 * (nTime3 - nTime2) / block.vtx.size(), nInputs <= 1 ? 0 : 0.001 * (nTime3 - nTime2) / (nInputs - 1), nTimeConnect * 0.000001);
@@ -2974,6 +3208,9 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
         }
     }
 
+    CFluidBlockInstructions fluidInstructions;
+    fluidInstructions.SetBlock(block);
+    // fluid instructions are always checked, but only written when the block is actually connected
     for (unsigned int i = 0; i < block.vtx.size(); i++) {
         const CTransaction& tx = *block.vtx[i];
         CScript scriptFluid;
@@ -2987,7 +3224,8 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
                     if (!CheckSignatureQuorum(fluidDynode.FluidScript, strError)) {
                         return state.DoS(0, error("ConnectBlock(DYN): %s", strError), REJECT_INVALID, "invalid-fluid-dynode-address-signature");
                     }
-                    pFluidDynodeDB->AddFluidDynodeEntry(fluidDynode, OP_REWARD_DYNODE);
+                    if (!fJustCheck)
+                        pFluidDynodeDB->AddFluidDynodeEntry(fluidDynode, OP_REWARD_DYNODE);
                 }
             } else if (OpCode == OP_REWARD_MINING) {
                 CFluidMining fluidMining(scriptFluid);
@@ -2997,7 +3235,8 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
                     if (!CheckSignatureQuorum(fluidMining.FluidScript, strError)) {
                         return state.DoS(0, error("ConnectBlock(DYN): %s", strError), REJECT_INVALID, "invalid-fluid-mining-address-signature");
                     }
-                    pFluidMiningDB->AddFluidMiningEntry(fluidMining, OP_REWARD_MINING);
+                    if (!fJustCheck)
+                        pFluidMiningDB->AddFluidMiningEntry(fluidMining, OP_REWARD_MINING);
                 }
             } else if (OpCode == OP_MINT) {
                 CFluidMint fluidMint(scriptFluid);
@@ -3007,7 +3246,8 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
                     if (!CheckSignatureQuorum(fluidMint.FluidScript, strError)) {
                         return state.DoS(0, error("ConnectBlock(DYN): %s", strError), REJECT_INVALID, "invalid-fluid-mint-address-signature");
                     }
-                    pFluidMintDB->AddFluidMintEntry(fluidMint, OP_MINT);
+                    if (!fJustCheck)
+                        pFluidMintDB->AddFluidMintEntry(fluidMint, OP_MINT);
                 }
             } else if (OpCode == OP_BDAP_REVOKE) {
                 if (!CheckSignatureQuorum(FluidScriptToCharVector(scriptFluid), strError))
@@ -3022,7 +3262,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
 
                 int64_t nTimeStamp;
                 std::vector<std::vector<unsigned char>> vSovereignAddresses;
-                if (fluid.ExtractTimestampWithAddresses("OP_BDAP_REVOKE", scriptFluid, nTimeStamp, vSovereignAddresses)) {
+                if (!fJustCheck && fluid.ExtractTimestampWithAddresses("OP_BDAP_REVOKE", scriptFluid, nTimeStamp, vSovereignAddresses)) {
                     for (const CDomainEntry& entry : vBanAccounts) {
                         LogPrintf("%s -- Fluid command banning account %s\n", __func__, entry.GetFullObjectPath());
                         if (!DeleteDomainEntry(entry))
@@ -3070,6 +3310,9 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     if (fJustCheck)
         return true;
 
+    fluidIndex.ConnectBlock(pindex->nHeight, fluidInstructions);
+    dnpayments.coinbasePayees.AddBlock(block, pindex);
+
     // Write undo information to disk
     if (pindex->GetUndoPos().IsNull() || !pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
         if (pindex->GetUndoPos().IsNull()) {
@@ -3336,6 +3579,7 @@ bool static DisconnectTip(CValidationState& state, const CChainParams& chainpara
         bool flushed = view.Flush();
         assert(flushed);
     }
+    fluidIndex.DisconnectBlock(pindexDelete->nHeight);
     LogPrint("bench", "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * 0.001);
     // Write the chain state to disk, if necessary.
     if (!FlushStateToDisk(state, FLUSH_STATE_IF_NEEDED))
@@ -4059,9 +4303,14 @@ bool FindUndoPos(CValidationState& state, int nFile, CDiskBlockPos& pos, unsigne
 }
 
 bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW)
+{
+    return CheckBlockHeader(block, fCheckPOW ? GetBlockHeaderHash(block) : uint256(), state, consensusParams, fCheckPOW);
+}
+
+bool CheckBlockHeader(const CBlockHeader& block, const uint256& hash, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW)
 {
     // Check proof of work matches claimed amount
-    if (fCheckPOW && !CheckProofOfWork(block.GetHash(), block.nBits, consensusParams))
+    if (fCheckPOW && !CheckProofOfWork(hash, block.nBits, consensusParams))
         return state.DoS(50, false, REJECT_INVALID, "high-hash", false, "proof of work failed");
 
     // Check timestamp
@@ -4197,9 +4446,9 @@ static bool CheckIndexAgainstCheckpoint(const CBlockIndex* pindexPrev, CValidati
 bool ContextualCheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev, int64_t nAdjustedTime)
 {
     int nHeight = (pindexPrev->nHeight + 1);
-    uint256 hash = block.GetHash();
 
-    if (hash == Params().GetConsensus().hashGenesisBlock)
+    // only a header without a parent needs hashing to tell whether it is the genesis block
+    if (block.hashPrevBlock.IsNull() && block.GetHash() == Params().GetConsensus().hashGenesisBlock)
         return true;
 
     if (block.nBits != GetNextWorkRequired(pindexPrev, block, consensusParams)) {
@@ -4286,11 +4535,10 @@ bool ContextualCheckBlock(const CBlock& block, CValidationState& state, const Co
     return true;
 }
 
-static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+static bool AcceptBlockHeader(const CBlockHeader& block, const uint256& hash, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
-    uint256 hash = block.GetHash();
     BlockMap::iterator miSelf = mapBlockIndex.find(hash);
     CBlockIndex* pindex = NULL;
 
@@ -4309,7 +4557,7 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, chainparams.GetConsensus()))
+        if (!CheckBlockHeader(block, hash, state, chainparams.GetConsensus()))
             return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
 
         // Get prev block index
@@ -4343,13 +4591,19 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
 }
 
 // Exposed wrapper for AcceptBlockHeader
-bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex)
+bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, const std::vector<uint256>* pvHashes)
 {
+    std::vector<uint256> vHashes;
+    if (!pvHashes) {
+        GetBlockHeaderHashes(headers, vHashes);
+        pvHashes = &vHashes;
+    }
+    assert(pvHashes->size() == headers.size());
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        for (unsigned int i = 0; i < headers.size(); i++) {
             CBlockIndex* pindex = NULL; // Use a temp pindex instead of ppindex to avoid a const_cast
-            if (!AcceptBlockHeader(header, state, chainparams, &pindex)) {
+            if (!AcceptBlockHeader(headers[i], (*pvHashes)[i], state, chainparams, &pindex)) {
                 return false;
             }
             if (ppindex) {
@@ -4373,7 +4627,7 @@ static bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidation
     CBlockIndex* pindexDummy = NULL;
     CBlockIndex*& pindex = ppindex ? *ppindex : pindexDummy;
 
-    if (!AcceptBlockHeader(block, state, chainparams, &pindex))
+    if (!AcceptBlockHeader(block, GetBlockHeaderHash(block), state, chainparams, &pindex))
         return false;
 
     // Try to process all requested blocks that we don't have, but only
@@ -4455,6 +4709,7 @@ static bool IsSuperMajority(int minVersion, const CBlockIndex* pstart, unsigned
 
 bool ProcessNewBlock(const CChainParams& chainparams, const std::shared_ptr<const CBlock> pblock, bool fForceProcessing, bool* fNewBlock)
 {
+    uint64_t nHeaderHashesStart = GetBlockHeaderHashCount();
     {
         CBlockIndex* pindex = NULL;
         if (fNewBlock)
@@ -4484,6 +4739,7 @@ bool ProcessNewBlock(const CChainParams& chainparams, const std::shared_ptr<cons
         return error("%s: ActivateBestChain failed", __func__);
 
     LogPrint("validation", "%s : ACCEPTED\n", __func__);
+    LogPrint("bench", "    - Argon2d header hashes computed: %u\n", GetBlockHeaderHashCount() - nHeaderHashesStart);
     return true;
 }
 
@@ -37,6 +37,7 @@
 
 class CBloomFilter;
 class CBlockIndex;
+class CBDAPWriteBatch;
 class CBlockTreeDB;
 class CChainParams;
 class CCoinsViewDB;
@@ -261,8 +262,9 @@ bool ProcessNewBlock(const CChainParams& chainparams, const std::shared_ptr<cons
  * @param[out] state This may be set to an Error state if any error occurred processing them
  * @param[in]  chainparams The params for the chain we want to connect to
  * @param[out] ppindex If set, the pointer will be set to point to the last new block index object for the given headers
+ * @param[in]  pvHashes If set, the hashes of the headers as returned by GetBlockHeaderHashes, otherwise they are computed here
  */
-bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex = NULL);
+bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex = NULL, const std::vector<uint256>* pvHashes = NULL);
 
 /** Check whether enough disk space is available for an incoming block */
 bool CheckDiskSpace(uint64_t nAdditionalBytes = 0);
@@ -282,6 +284,10 @@ bool LoadBlockIndex(const CChainParams& chainparams);
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the BDAP checking thread */
+void ThreadBDAPCheck();
+/** Run an instance of the block header hashing thread */
+void ThreadHeaderHashCheck();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Format a string that describes several potential problems detected by the core.
@@ -336,8 +342,17 @@ void PruneAndFlush();
 /** Prune block files up to a given height */
 void PruneBlockFilesManual(int nPruneUpToHeight);
 
-/** Checks inputs for a BDAP transaction. */
-bool ValidateBDAPInputs(const CTransactionRef& tx, CValidationState& state, const CCoinsViewCache& inputs, const CBlock& block, bool fJustCheck, int nHeight, bool bSanity = false);
+/**
+ * Checks inputs for a BDAP transaction.
+ * nTipHeight is the active chain height read by the caller under cs_main, so the check does not touch chainActive.
+ * If pWrites is not NULL, account and link database writes are queued there instead of being applied.
+ */
+bool ValidateBDAPInputs(const CTransactionRef& tx, CValidationState& state, const CBlock& block, bool fJustCheck, int nHeight, int nTipHeight, bool bSanity = false, CBDAPWriteBatch* pWrites = NULL);
+/**
+ * Validate the BDAP transactions of a block being connected, in block order, and apply their
+ * database writes. Independent operations are validated on the BDAP check threads.
+ */
+bool ConnectBDAPInputs(const std::vector<CTransactionRef>& vBDAPTx, const CBlock& block, CValidationState& state, int nHeight);
 /** (try to) add transaction to memory pool
  * plTxnReplaced will be appended to with all transactions replaced from mempool **/
 
@@ -482,6 +497,68 @@ public:
     ScriptError GetScriptError() const { return error; }
 };
 
+/**
+ * Closure representing the validation of one BDAP transaction in a block being connected
+ * Note that this stores references to the block, the write batch and the validation state
+ */
+class CBDAPCheck
+{
+private:
+    CTransactionRef ptx;
+    const CBlock* pblock;
+    int nHeight;
+    int nTipHeight;
+    CBDAPWriteBatch* pWrites;
+    CValidationState* pstate;
+
+public:
+    CBDAPCheck() : pblock(NULL), nHeight(0), nTipHeight(0), pWrites(NULL), pstate(NULL) {}
+    CBDAPCheck(const CTransactionRef& ptxIn, const CBlock& blockIn, int nHeightIn, int nTipHeightIn, CBDAPWriteBatch& writesIn, CValidationState& stateIn) : ptx(ptxIn),
+                                                                                                                                           pblock(&blockIn), nHeight(nHeightIn), nTipHeight(nTipHeightIn), pWrites(&writesIn), pstate(&stateIn) {}
+
+    bool operator()();
+
+    void swap(CBDAPCheck& check)
+    {
+        ptx.swap(check.ptx);
+        std::swap(pblock, check.pblock);
+        std::swap(nHeight, check.nHeight);
+        std::swap(nTipHeight, check.nTipHeight);
+        std::swap(pWrites, check.pWrites);
+        std::swap(pstate, check.pstate);
+    }
+};
+
+/**
+ * Closure representing the proof-of-work hash of one block header, so a batch of
+ * headers can be hashed on the header hashing threads.
+ */
+class CHeaderHashCheck
+{
+private:
+    const CBlockHeader* pheader;
+    uint256* phash;
+
+public:
+    CHeaderHashCheck() : pheader(NULL), phash(NULL) {}
+    CHeaderHashCheck(const CBlockHeader& headerIn, uint256& hashIn) : pheader(&headerIn), phash(&hashIn) {}
+
+    bool operator()();
+
+    void swap(CHeaderHashCheck& check)
+    {
+        std::swap(pheader, check.pheader);
+        std::swap(phash, check.phash);
+    }
+};
+
+/** Find the block index entry built from exactly this header, if it is on the active or best header chain */
+CBlockIndex* LookupKnownHeader(const CBlockHeader& header);
+/** Get the proof-of-work hash of a header, taking it from the block index when the header is already known */
+uint256 GetBlockHeaderHash(const CBlockHeader& header);
+/** Get the proof-of-work hashes of a batch of headers, hashing the unknown ones in parallel */
+void GetBlockHeaderHashes(const std::vector<CBlockHeader>& headers, std::vector<uint256>& vHashes);
+
 bool GetTimestampIndex(const unsigned int& high, const unsigned int& low, std::vector<uint256>& hashes);
 bool GetSpentIndex(CSpentIndexKey& key, CSpentIndexValue& value);
 bool GetAddressIndex(uint160 addressHash, int type, std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex, int start = 0, int end = 0);
@@ -500,6 +577,7 @@ void ReprocessBlocks(int nBlocks);
 
 /** Context-independent validity checks */
 bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true);
+bool CheckBlockHeader(const CBlockHeader& block, const uint256& hash, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true);
 bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true, bool fCheckMerkleRoot = true);
 
 /** Context-dependent validity checks */